@@ -0,0 +1,110 @@
+/**
+ * @file asrc_servo.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ASRCピッチ制御 (キュー水位サーボ)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note ASRC経路(I2S)では従来のキューオーバーフロー救済処置(水位 QUEUE_DEPTH-1 で1サンプル間引き)を置き換える。(USB経路は間引きを残す)
+ *       制御対象 : 1パケット当たり水位は frame_len / pitch - (Core1消費) だけ増えるため、ピッチ変化に対し積分器となる。
+ *         水位誤差 e [sample] に対する補正 c = Kp * e + Ki * Σe (ピッチ単位) とし、pitch = ff - c を出力する。
+ *         ループゲイン G = frame_len (相対ピッチ1当たりの出力サンプル数) として
+ *           Kp = 2ζωn / G, Ki = ωn^2 / G   (ωn = 2π ASRC_SERVO_BW_HZ x 1ms)
+ *       定常状態では積分項がフィードフォワード(LRCK計測)の誤差を吸収し、水位は目標に収束する。
+ *       水位は Core1 の変換完了通知からの補間値のため、PDM_FEED_N 単位の量子化がループに入らない。
+ *       補正量は ±ASRC_SERVO_RANGE_PPM に制限し、制限中は積分を止める(ワインドアップ防止)。
+ *       Core1 停止中(ミュート中)は積分をクリアし、フィードフォワードのみを出力する。
+ *       固定小数点
+ *         水位・誤差 : QUEUE_FILL_FRAC(8)bit
+ *         比例項     : e(Q8) x kp >> 16         -> ピッチ(Q22)
+ *         積分項     : Σ e(Q8) x ki >> 32       -> ピッチ(Q22)
+ */
+
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "simple_queue.h"
+#include "dsp.h"
+#include "asrc_servo.h"
+
+#define ASRC_SERVO_KP_BIT		16
+#define ASRC_SERVO_KI_BIT		32
+#define ASRC_SERVO_RANGE		((int32_t)(((int64_t)ASRC_SERVO_RANGE_PPM << ASRC_SERVO_FRAC_BIT) / 1000000))
+
+static uint32_t servo_ff_raw;		// フィードフォワード 最新計測値 (0 : 未計測)
+static int32_t	servo_ff;			// フィードフォワード 平滑化後 (ピッチ << 8)
+static int32_t	servo_target;		// 目標水位 (Q8)
+static int32_t	servo_fill[2];		// 水位 平滑化 1段目, 2段目 (Q8)
+static int64_t	servo_i;			// 積分項
+static int32_t	servo_kp;
+static int32_t	servo_ki;
+static asrc_servo_state_t servo_state;
+
+// 1パケット(1ms)当たりの ASRC 入力サンプル数 (前段オーバーサンプリング後のレート)
+// get_osr() は fs の 48k/44.1k 倍数を返すため、オーバーサンプリング比は 8 / get_osr(fs) となる
+uint asrc_servo_frame_len(uint fs){
+	return fs * (8 / get_osr(fs)) / 1000;
+}
+
+// 初期化 (フォーマット更新時)
+// pitch : 初期ピッチ(公称値), target : 目標水位[sample], frame_len : 1パケット当たりの ASRC 入力サンプル数
+void asrc_servo_reset(uint32_t pitch, uint target, uint frame_len){
+	const double wn = 2.0 * M_PI * ASRC_SERVO_BW_HZ / 1000.0;
+	const double one = (double)(1u << ASRC_SERVO_FRAC_BIT) / (1 << QUEUE_FILL_FRAC);	// ピッチ(Q22) / 水位(Q8)
+	servo_kp = (int32_t)(2.0 * ASRC_SERVO_ZETA * wn / frame_len * one * (1u << ASRC_SERVO_KP_BIT) + 0.5);
+	servo_ki = (int32_t)(wn * wn / frame_len * one * (double)(1ull << ASRC_SERVO_KI_BIT) + 0.5);
+	servo_ff_raw = 0;
+	servo_ff = (int32_t)(pitch << 8);
+	servo_fill[0] = 0;
+	servo_fill[1] = 0;
+	servo_i = 0;
+	asrc_servo_set_target(target);
+	servo_state = (asrc_servo_state_t){.pitch = pitch, .ff = pitch};
+}
+
+// 目標水位[sample]
+void asrc_servo_set_target(uint target){
+	servo_target = (int32_t)(target << QUEUE_FILL_FRAC);
+}
+
+// 周波数推定値の入力 (asrc_pitch_update() 更新時) 初回はそのまま採用する
+void asrc_servo_set_ff(uint32_t pitch){
+	if (servo_ff_raw == 0) servo_ff = (int32_t)(pitch << 8);
+	else                   servo_ff += ((int32_t)(pitch << 8) - servo_ff) >> ASRC_SERVO_FF_SHIFT;
+	servo_ff_raw = pitch;
+}
+
+// ピッチ更新 (1パケット毎) playing, fill : queue_get_fill() の戻り値・水位(Q8)
+uint32_t asrc_servo_update(bool playing, int32_t fill){
+	const uint32_t ff = (uint32_t)(servo_ff + 128) >> 8;
+	if (!playing) {
+		servo_fill[0] = fill;
+		servo_fill[1] = fill;
+		servo_i = 0;
+		servo_state = (asrc_servo_state_t){.pitch = ff, .ff = ff, .err = (servo_target - fill) >> QUEUE_FILL_FRAC};
+		return ff;
+	}
+	servo_fill[0] += (fill - servo_fill[0]) >> ASRC_SERVO_FILL_SHIFT;
+	servo_fill[1] += (servo_fill[0] - servo_fill[1]) >> ASRC_SERVO_FILL_SHIFT;
+	const int32_t e = servo_target - servo_fill[1];
+	const int32_t p = (int32_t)(((int64_t)e * servo_kp) >> ASRC_SERVO_KP_BIT);
+	const int64_t i = servo_i + (int64_t)e * servo_ki;
+	int32_t c = p + (int32_t)(i >> ASRC_SERVO_KI_BIT);
+	bool locked = true;
+	if (c > ASRC_SERVO_RANGE) {
+		c = ASRC_SERVO_RANGE;
+		locked = false;
+	} else if (c < -ASRC_SERVO_RANGE) {
+		c = -ASRC_SERVO_RANGE;
+		locked = false;
+	}
+	if (locked || ((i > servo_i) != (c > 0))) servo_i = i;	// 制限中は制限を深める方向に積分しない
+
+	const uint32_t pitch = ff - c;
+	servo_state = (asrc_servo_state_t){.pitch = pitch, .ff = ff, .err = e >> QUEUE_FILL_FRAC, .corr = c, .locked = locked};
+	return pitch;
+}
+
+// 制御状態 (デバッグ表示・シミュレーション用)
+void asrc_servo_get_state(asrc_servo_state_t* p_state){
+	*p_state = servo_state;
+}
@@ -0,0 +1,35 @@
+#ifndef _ASRC_SERVO_H_
+#define _ASRC_SERVO_H_
+
+/* ASRCピッチ制御 (キュー水位サーボ)
+ 周波数推定 : asrc_pitch_update() の LRCK長周期計測ピッチ(count_long由来)を IIR で平滑化し、フィードフォワードとする
+ 位相推定   : queue_get_fill() のキュー水位(サンプル数)を 2段 IIR で平滑化する
+ ループ     : 水位誤差(目標 - 水位)の PI制御(2次ループ)でフィードフォワードピッチを補正する
+ ピッチを下げると ASRC の出力サンプル数が増え、水位が上がる。
+ 1パケット(≒1ms)毎に asrc_servo_update() を呼ぶこと (ループ帯域・ゲインはパケット周期を前提に計算する)。
+*/
+#include "pico.h"
+
+#define ASRC_SERVO_FRAC_BIT		22		// ピッチの小数部bit数 (dsp.c ASRC_FRAC_BIT と合わせること)
+#define ASRC_SERVO_BW_HZ		0.1		// ループ固有周波数[Hz]
+#define ASRC_SERVO_ZETA			0.8		// ループ減衰係数
+#define ASRC_SERVO_RANGE_PPM	1000	// フィードフォワードからの補正範囲[ppm]
+#define ASRC_SERVO_FILL_SHIFT	6		// 水位 IIR 係数 1/64 x2段 (1ms毎 : fc≒2.5Hz, 到着ジッタの除去)
+#define ASRC_SERVO_FF_SHIFT		2		// 周波数推定 IIR 係数 1/4 (asrc_pitch_update() 更新毎)
+
+typedef struct {
+	uint32_t	pitch;		// 出力ピッチ
+	uint32_t	ff;			// フィードフォワードピッチ (平滑化後)
+	int32_t		err;		// 水位誤差 目標 - 水位 [sample] (平滑化後)
+	int32_t		corr;		// 補正量 (ピッチ単位, 正 : ピッチを下げる)
+	bool		locked;		// 再生中・補正範囲内
+} asrc_servo_state_t;
+
+uint asrc_servo_frame_len(uint fs);
+void asrc_servo_reset(uint32_t pitch, uint target, uint frame_len);
+void asrc_servo_set_target(uint target);
+void asrc_servo_set_ff(uint32_t pitch);
+uint32_t asrc_servo_update(bool playing, int32_t fill);
+void asrc_servo_get_state(asrc_servo_state_t* p_state);
+
+#endif
@@ -52,7 +52,7 @@ void all_gpio_init(void){
 	gpio_config(PIN_GP13       , GPIO_OUT, 0, 0, 0, GPIO_DRIVE_STRENGTH_2MA, GPIO_SLEW_RATE_SLOW);
 	gpio_config(PIN_GP18       , GPIO_OUT, 0, 0, 0, GPIO_DRIVE_STRENGTH_2MA, GPIO_SLEW_RATE_SLOW);
 	gpio_config(PIN_GP26       , GPIO_OUT, 0, 0, 0, GPIO_DRIVE_STRENGTH_2MA, GPIO_SLEW_RATE_SLOW);
-	gpio_config(PIN_GP27       , GPIO_OUT, 0, 0, 0, GPIO_DRIVE_STRENGTH_2MA, GPIO_SLEW_RATE_SLOW);
+	gpio_config(PIN_LOW_LATENCY, GPIO_IN , 0, 1, 0, GPIO_DRIVE_STRENGTH_2MA, GPIO_SLEW_RATE_SLOW);	// 低遅延モード選択
 
 	// PDM出力関連(GPIO14~17)
 	// pdm_output.c(Core1)側で実施
@@ -149,6 +149,12 @@ uint get_dip(void){
 }
 
 
+// 低遅延モード選択端子 GND短絡(L)で true
+bool get_low_latency_strap(void){
+    return !gpio_get(PIN_LOW_LATENCY);
+}
+
+
 // PDM fs系列切替処理 _HR2までは pdm_output.c に実装
 // 旧set_pdm_fs_gpio(uint fs)を bool group_48k対応にしたもの
 void set_dac_fs_group_48k(bool group_48k){
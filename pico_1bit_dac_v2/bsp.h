@@ -6,9 +6,10 @@ void set_pico_onboard_led(bool value);
 bool get_pico_usb_vbus_status(void);
 void set_dac_fs_group_48k(bool group_48k);
 uint get_dip(void);
+bool get_low_latency_strap(void);
 
-// システムクロック周波数指定 
-#define CLK_SYS	((uint32_t)208800000)
+// システムクロック周波数指定 (CLK_SYS, PLL設定, PIO PWM周期, 真の再生周波数 : host/clock_plan_gen で生成)
+#include "clock_plan.h"
 #define DEFAULT_FS      44100           // Source Sampling Frequency[Hz]
 #define DEFAULT_BIT_DEPTH  16
 #define N_CH            2               // Number of Audio Channel
@@ -33,6 +34,7 @@ uint get_dip(void);
 #define PIN_GP18            18                  // Debug / RFU
 #define PIN_GP26            26                  // Debug / RFU
 #define PIN_GP27            27                  // Debug / RFU
+#define PIN_LOW_LATENCY     27                  // 低遅延モード選択 (起動時 GND短絡で低遅延、プルアップ)
 #define PIN_OUTPUT_RP       14                  // RCh P
 #define PIN_OUTPUT_RN       15                  // RCh N
 #define PIN_OUTPUT_LP       16                  // LCh P
@@ -93,4 +95,16 @@ uint get_dip(void);
 #define GP28	28
 #define GP29	29
 
+
+/* SRAMバンク配置 (RP2040 SRAM0~3 : 256KB ワード単位ストライプ, SRAM4 : scratch_x 4KB, SRAM5 : scratch_y 4KB)
+ 既定のリンカ配置では全変数がストライプ領域に置かれ、Core0・Core1・DMA が同じバンクで競合し得る。
+ サンプル毎に参照する小さな状態はコア専用バンクに置く。
+   CORE1_HOT : scratch_x (SRAM4) Core1 スタックと同居 (ΔΣ状態・後段オーバーサンプラ遅延データ列 等)
+   CORE0_HOT : scratch_y (SRAM5) Core0 スタックと同居 (hbf遅延データ列・ストリーミング中間バッファ・ASRC過去データ 等)
+ キュースロット・dsp_buf・DMAバッファ等の大きな領域はストライプ領域(既定)に置き、アクセスを4バンクに分散する。
+ 各バンクの空き(スタック 各2KB を除く約2KB)に収まること。配置と大きさはビルド時に mem_map_report.cmake が出力・検査する。
+*/
+#define CORE0_HOT(group)	__scratch_y(group)
+#define CORE1_HOT(group)	__scratch_x(group)
+
 #endif
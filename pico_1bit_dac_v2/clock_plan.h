@@ -0,0 +1,42 @@
+/**
+ * @file clock_plan.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief クロック計画 システムクロック(PLL)・PIO PWM周期・真の再生周波数
+ * @version 0.01
+ * @date 2026-10-17
+ * @note host/clock_plan_gen -w で生成する。直接編集しないこと。
+ *       PWM周期は PWM_CYCLE_MIN(68) + 延長 [pio clk] (4/5bit : 1周期, 6bit : 半周期)
+ *       Core1 見積もり最大 471 cycle/sample (384kHz 周期 544 cycle の 86.6%)
+ *
+ *         fs        true fs [Hz]      error
+ *       384000        383823.529   -459.6ppm
+ *       352800        352702.703   -275.8ppm
+ *       192000        191911.765   -459.6ppm
+ *       176400        176351.351   -275.8ppm
+ *        96000         95955.882   -459.6ppm
+ *        88200         88175.676   -275.8ppm
+ *        48000         47977.941   -459.6ppm
+ *        44100         44087.838   -275.8ppm
+ */
+#ifndef _CLOCK_PLAN_H_
+#define _CLOCK_PLAN_H_
+
+// システムクロック PLL_SYS = 12MHz * FBDIV / (POSTDIV1 * POSTDIV2)  (REFDIV = 1)
+#define CLK_SYS                    ((uint32_t)208800000)
+#define CLOCK_PLAN_VCO_HZ          1044000000u
+#define CLOCK_PLAN_FBDIV           87
+#define CLOCK_PLAN_POSTDIV1        5
+#define CLOCK_PLAN_POSTDIV2        1
+
+// PIO PWM  (6bit は PWM周期 x2, pacemaker は PIO分周 x2)
+#define CLOCK_PLAN_PIO_DIV         1       // PIOクロック分周 (整数)
+#define CLOCK_PLAN_PWM_CYCLE_48    68      // PWM周期 [pio clk] 48k系   (PIN_FS48 = 1)
+#define CLOCK_PLAN_PWM_CYCLE_44    74      // PWM周期 [pio clk] 44.1k系 (PIN_FS48 = 0)
+#define CLOCK_PLAN_PWM_PAD_48      0       // PWM_CYCLE_MIN からの延長 [pio clk]
+#define CLOCK_PLAN_PWM_PAD_44      6
+
+// 真の再生周波数 [Hz]  div : 1サンプル当たりの PWM周期数 (4/5bit換算 384k : 8, 192k : 16, 96k : 32, 48k : 64)
+#define CLOCK_PLAN_TRUE_FS_48(div) (CLK_SYS / (double)(CLOCK_PLAN_PIO_DIV * CLOCK_PLAN_PWM_CYCLE_48) / (div))
+#define CLOCK_PLAN_TRUE_FS_44(div) (CLK_SYS / (double)(CLOCK_PLAN_PIO_DIV * CLOCK_PLAN_PWM_CYCLE_44) / (div))
+
+#endif
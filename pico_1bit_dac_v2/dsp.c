@@ -5,27 +5,35 @@
  * @version 0.01
  * @date 2023-02-21
  * @note 旧名称 oversampler.c
- *       dsp処理を集結 : oversampler, volume, asrc 周波数管理関数等  
+ *       dsp処理を集結 : oversampler, volume, asrc, DoP 周波数管理関数等  
  */
 
-// 連結ハーフバンドフィルタの処理時間計測時に1とする
-#if 0
-#define DEBUG_PIN(x, y) gpio_put((x), (y))
-#else
-#define DEBUG_PIN(x, y)	/*処理なし*/
-#endif
-
 #include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
 #include "pico/stdlib.h"
 #include "hardware/interp.h"
 
 #include "bsp.h"
 #include "simple_queue.h"
+#include "prof.h"
+#include "dsp.h"
+#include "hbf_coef.h"
+#include "iir_coef.h"
 
 // クランプ幅:24.5bit (3.52dBFS 最大入力振幅の±1.5倍)
 #define CLAMP_MAX ((+1 << 23) + (+1 << 22) - 1)
 #define CLAMP_MIN ((-1 << 23) + (-1 << 22) )
 
+// 前段オーバーサンプラ方式選択 0:連結ハーフバンド(hbf1~3) 1:単段ポリフェーズFIR(pfir)
+#define OVERSAMPLER_TYPE 0
+
+// 連結ハーフバンドの処理順 0:段毎(段毎にフレーム全体を処理) 1:縦型ストリーミング(入力1サンプル毎に全段を通す)
+#define HBF_STREAM 1
+
+// 入力fs別フィルタプロファイル 0:全fsで hbf1 から連結 1:入力fsに合わせた段から連結 (88.2kHz以上は hbf1 を使わない)
+#define HBF_FS_PROFILE 1
+
 // Interp1 ハードクランプ初期化
 // 各オーバーサンプラのフィルタ処理後のレベルクリップに利用
 void interp1_hw_clamp_init(void){
@@ -51,10 +59,10 @@ void interp1_hw_clamp_init(void){
 	interp1->accum[1] = 0;        // 未使用
 }
 
-inline int32_t clamp(int32_t x){
+static inline int32_t clamp(int32_t x){
 #if 1	// ハードウェアclamp (interp1利用)
 	interp1->accum[0] = x;
-	return interp1->peek[0];
+	return interp_peek_lane_result(interp1, 0);
 #else	// ソフトウェアclamp
   #if 1 
 	return (x > CLAMP_MAX) ? CLAMP_MAX : (x < CLAMP_MIN) ? CLAMP_MIN : x;
@@ -73,6 +81,11 @@ inline int32_t clamp(int32_t x){
 #endif
 }
 
+// ソフトウェアclamp Core1用 (Core1 の interp1 は量子化器・ビットストリーマとして使用中のため)
+static inline int32_t clamp_sw(int32_t x){
+	return (x > CLAMP_MAX) ? CLAMP_MAX : (x < CLAMP_MIN) ? CLAMP_MIN : x;
+}
+
 
 // Interp0 ブレントモード初期化
 // ASRCのサンプル間αブレンドに使用
@@ -97,6 +110,118 @@ void interp0_blender_init(void){
 }
 
 
+/* 音量処理 (オーバーサンプラ初段の入力読込みに統合)
+ volume() の別パス(フレーム全体の読出し・書込み)を廃し、初段(hbf1 / pfir / 0段時のコピー)の入力読込み時に
+ d = (d * mul) >> shift を行う。音量変更は volume_set() でランプ(VOL_BLOCK_N サンプル毎にゲイン更新)とし、
+ 即時切替によるクリック・ジッパーノイズを防ぐ。
+   直線ランプ : ゲイン g を ブロック毎に (g1 - g0) / ブロック数 ずつ変化させる
+   指数ランプ : ゲイン g を ブロック毎に (g1 / g0)^(1 / ブロック数) 倍する (dB直線。g0, g1 の一方が0の場合は直線)
+ ランプ中のゲインは Q32 (uint64_t) で保持し、ブロック毎に乗数 VOL_MUL_BIT bit・シフトに正規化する
+ (24bit PCM x 8bit 乗数で32bit乗算に収まる)。ランプ最終ブロックは目標の mul/shift そのものとし、
+ 定常状態の出力は volume() + オーバーサンプラと一致する。
+ ゲイン1 (mul = 1, shift = 0) かつランプなしの場合は音量処理なしの初段を使う(I2Sソース)。
+*/
+#define VOL_BLOCK_N		8		// ランプ中のゲイン更新間隔[sample]
+#define VOL_RAMP_TYPE	0		// 既定のランプ方式 0:直線 1:指数(dB直線)
+#define VOL_G_FRAC		32		// ランプ中のゲイン g の小数部bit数
+#define VOL_MUL_BIT		8		// ランプ中の乗数ビット長
+#define VOL_R_FRAC		16		// 指数ランプ比の小数部bit数
+
+typedef struct {
+	int32_t		mul;		// 現ブロックの乗数
+	uint		shift;		// 現ブロックのシフト
+	int32_t		mul1;		// 目標乗数
+	uint		shift1;		// 目標シフト
+	uint64_t	g;			// ランプ中のゲイン (Q32)
+	int64_t		step;		// 直線ランプ ブロック毎の増分 (Q32)
+	uint32_t	ratio;		// 指数ランプ ブロック毎の比 (Q16, 0 : 直線)
+	uint		block_n;	// ランプ残りブロック数 (0 : ランプなし)
+	uint		cnt;		// 現ブロックの残りサンプル数
+	uint		type;		// ランプ方式
+} vol_ramp_t;
+
+static vol_ramp_t CORE0_HOT("vol") vol = {.mul = 1, .shift = 0, .mul1 = 1, .shift1 = 0, .type = VOL_RAMP_TYPE};
+
+// mul/shift -> ゲイン(Q32)
+static uint64_t vol_gain(int32_t mul, uint shift){
+	if (mul <= 0) return 0;
+	return (shift <= VOL_G_FRAC) ? (uint64_t)mul << (VOL_G_FRAC - shift) : (uint64_t)mul >> (shift - VOL_G_FRAC);
+}
+
+// 次ブロックのゲイン ランプ最終ブロックは目標値とする
+static void vol_next_block(void){
+	if (vol.block_n <= 1) {
+		vol.mul = vol.mul1;
+		vol.shift = vol.shift1;
+		vol.block_n = 0;
+		return;
+	}
+	vol.block_n--;
+	if (vol.ratio) vol.g = (vol.g * vol.ratio) >> VOL_R_FRAC;
+	else           vol.g += vol.step;
+	// 乗数を VOL_MUL_BIT bit に正規化
+	uint msb = 0;
+	for(uint64_t g = vol.g >> 1; g; g >>= 1) msb++;
+	int shift = VOL_G_FRAC + (VOL_MUL_BIT - 1) - (int)msb;
+	if (shift < 0)  shift = 0;
+	if (shift > 31) shift = 31;
+	vol.mul = (int32_t)(vol.g >> (VOL_G_FRAC - shift));
+	vol.shift = (uint)shift;
+	vol.cnt = VOL_BLOCK_N;
+}
+
+// 音量の即時設定 (ランプなし)
+void volume_reset(int32_t mul, uint shift){
+	vol.mul = vol.mul1 = mul;
+	vol.shift = vol.shift1 = shift;
+	vol.block_n = 0;
+}
+
+// 音量の設定 ramp_n : ランプ長[sample] (VOL_BLOCK_N 未満は即時) 目標と同じ場合は何もしない
+// ランプ中の再設定は現在のゲインから新しい目標へランプする
+void volume_set(int32_t mul, uint shift, uint ramp_n){
+	if ((mul == vol.mul1) && (shift == vol.shift1)) return;
+	const uint64_t g0 = vol.block_n ? vol.g : vol_gain(vol.mul, vol.shift);
+	const uint64_t g1 = vol_gain(mul, shift);
+	vol.mul1 = mul;
+	vol.shift1 = shift;
+	vol.block_n = ramp_n / VOL_BLOCK_N;
+	if (vol.block_n == 0) {
+		volume_reset(mul, shift);
+		return;
+	}
+	vol.g = g0;
+	vol.step = ((int64_t)g1 - (int64_t)g0) / (int64_t)vol.block_n;
+	vol.ratio = 0;
+	if ((vol.type == 1) && g0 && g1) {
+		vol.ratio = (uint32_t)lround(pow((double)g1 / (double)g0, 1.0 / vol.block_n) * (1 << VOL_R_FRAC));
+	}
+	vol.block_n++;		// 初回の vol_next_block() で1ブロック目のゲインとする
+	vol_next_block();
+}
+
+// ランプ方式 0:直線 1:指数 (以降の volume_set() に適用)
+void volume_set_ramp_type(uint type){
+	vol.type = type;
+}
+
+// 音量処理が不要 (ゲイン1・ランプなし)
+bool volume_is_unity(void){
+	return (vol.block_n == 0) && (vol.mul == 1) && (vol.shift == 0);
+}
+
+// 入力読込み時の音量処理 ブロック先頭で呼び、*p_n を現ブロックの残りサンプル数に制限して乗数・シフトを返す
+static inline __attribute__((always_inline)) void vol_block_begin(uint* p_n, int32_t* p_mul, uint* p_shift){
+	if (vol.block_n && (*p_n > vol.cnt)) *p_n = vol.cnt;
+	*p_mul = vol.mul;
+	*p_shift = vol.shift;
+}
+
+// ブロック終了 n : 処理したサンプル数
+static inline __attribute__((always_inline)) void vol_block_end(uint n){
+	if (vol.block_n && ((vol.cnt -= n) == 0)) vol_next_block();
+}
+
 // 48kHz系列フラグ取得 fs=44.1k~768kの範囲で下位7bitが必ず0である性質を利用
 bool get_group_48k(uint fs){
 	return ((fs & 0x7f) == 0);
@@ -110,204 +235,509 @@ uint get_osr(uint fs){
 
 // 真の再生周波数取得
 // DAC再生周波数はシステムクロック(clk_sys)の整数分周で生成するため、理想周波数に対し誤差を持つ。この周波数を取得する。
+// 分周比(PWM周期)・誤差は clock_plan.h (host/clock_plan_gen で生成) による。
 float get_true_playback_fs(uint fs){
 	switch(fs) {
-//								clk_sys   div   ratio		true fs				error	
-		case 384000:	return (CLK_SYS / 68.0 /  8);	// = 383823.529...Hz, -460ppm
-		case 352800:	return (CLK_SYS / 74.0 /  8);	// = 352702.702...Hz, -276ppm
-		case 192000:	return (CLK_SYS / 68.0 / 16);	// = 191911.764...Hz, -460ppm
-		case 176400:	return (CLK_SYS / 74.0 / 16);	// = 176351.351...Hz, -276ppm
-		case  96000:	return (CLK_SYS / 68.0 / 32);	// =  95955.882...Hz, -460ppm
-		case  88200:	return (CLK_SYS / 74.0 / 32);	// =  88175.675...Hz, -276ppm
-		case  48000:	return (CLK_SYS / 68.0 / 64);	// =  47977.941...Hz, -460ppm
+//								PWM周期 x PWM周期数/sample
+		case 384000:	return CLOCK_PLAN_TRUE_FS_48( 8);
+		case 352800:	return CLOCK_PLAN_TRUE_FS_44( 8);
+		case 192000:	return CLOCK_PLAN_TRUE_FS_48(16);
+		case 176400:	return CLOCK_PLAN_TRUE_FS_44(16);
+		case  96000:	return CLOCK_PLAN_TRUE_FS_48(32);
+		case  88200:	return CLOCK_PLAN_TRUE_FS_44(32);
+		case  48000:	return CLOCK_PLAN_TRUE_FS_48(64);
 		case  44100:
-		default:		return (CLK_SYS / 74.0 / 64);	// =  44087.837...Hz, -276ppm
+		default:		return CLOCK_PLAN_TRUE_FS_44(64);
 	}
 }
 
-#define HBF3_TAP_N	11						// HBFフィルタの元のタップ数
-#define HBF3_ITAP_N	((HBF3_TAP_N + 1) / 2)	// 補間用フィルタ(φ1)のタップ数
-void hbf3_x2_oversampler(
+/* ハーフバンド x2 オーバーサンプラ エンジン
+ hbf1~3 は係数表 hbf_spec[] の1行で定義し、共通カーネル hbf_x2_run() を段毎に展開して生成する。
+ カーネルは always_inline で係数表(定数)ごと展開されるため、タップ数・係数・アキュムレータ幅は
+ コンパイル時に確定する。出力は従来の手書き展開版とビット一致する (host/hbf_exact_check で確認)。
+ アキュムレータ幅は係数と入力最大値から段毎に決定する。
+   先頭から Σ|k[i]| * 2 * in_max ≦ INT32_MAX を満たすタップ対までを32bitで積和し、
+   以降のタップ対のみ64bitに乗り換える(M0+では64bit積和が __aeabi_lmul 呼び出しとなり高価なため)。
+ 係数変更は host/hbf_design で hbf_coef.h を再生成し、段の追加は係数表と hbf_spec[] の1行を追加し、HBF_X2_OVERSAMPLER() で関数を生成する。
+*/
+#define HBF_IN_MAX_PCM		(1 << 23)							// 24bit PCM入力の最大値 (hbf1入力)
+#define HBF_IN_MAX_CLAMP	(-CLAMP_MIN)						// clamp()出力の最大値 (hbf2以降の入力)
+
+// 係数表 (タップ数 HBFn_TAP_N・係数ビット長 HBFn_K_BIT_W・係数 HBFn_K) は host/hbf_design が段毎の仕様から生成する
+#define HBF1_ITAP_N	((HBF1_TAP_N + 1) / 2)	// 補間用フィルタ(φ1)のタップ数
+#define HBF2_ITAP_N	((HBF2_TAP_N + 1) / 2)
+#define HBF3_ITAP_N	((HBF3_TAP_N + 1) / 2)
+static const int32_t hbf1_k[HBF1_ITAP_N / 2] = HBF1_K;
+static const int32_t hbf2_k[HBF2_ITAP_N / 2] = HBF2_K;
+static const int32_t hbf3_k[HBF3_ITAP_N / 2] = HBF3_K;
+
+// ハーフバンドフィルタ諸元
+typedef struct {
+	const int32_t* k;	// 補間係数 (前半のみ)
+	uint itap_n;		// 補間用フィルタ(φ1)のタップ数
+	uint k_bit_w;		// 係数ビット長
+	int32_t in_max;		// 入力データ絶対値の最大値 (アキュムレータ幅決定用)
+} hbf_spec_t;
+
+static const hbf_spec_t hbf_spec[HBF_STAGE_N] = {
+	//	係数表	タップ数		係数ビット長		入力最大値
+	{hbf1_k,	HBF1_ITAP_N,	HBF1_K_BIT_W,	HBF_IN_MAX_PCM  },
+	{hbf2_k,	HBF2_ITAP_N,	HBF2_K_BIT_W,	HBF_IN_MAX_CLAMP},
+	{hbf3_k,	HBF3_ITAP_N,	HBF3_K_BIT_W,	HBF_IN_MAX_CLAMP},
+};
+
+// 32bitで積和可能な先頭タップ対数 (ヘッドルーム解析)
+static inline __attribute__((always_inline)) uint hbf_mac32_n(const hbf_spec_t* hs){
+	int64_t acc_max = 0;
+	uint n = 0;
+	#pragma GCC unroll 16
+	for(uint i = 0; i < hs->itap_n / 2; i++){
+		acc_max += (int64_t)abs(hs->k[i]) * 2 * hs->in_max;
+		if (acc_max <= INT32_MAX) n = i + 1;
+	}
+	return n;
+}
+
+// 補間データ演算 z : 当該chの遅延データ列(タップ位置t) 左右対称タップ対を積和し係数ビット長で右シフト
+// hw_clamp : true = interp1 clamp (Core0), false = ソフトウェアclamp (Core1)
+static inline __attribute__((always_inline)) int32_t hbf_x2_mac(const hbf_spec_t* hs, const int32_t* z, const bool hw_clamp){
+	const int32_t* const k = hs->k;
+	const uint n = hs->itap_n;
+	const uint mac32_n = hbf_mac32_n(hs);
+	int32_t d = 0;
+	#pragma GCC unroll 16
+	for(uint i = 0; i < mac32_n; i++) d += k[i] * (int32_t)(z[i] + z[n - 1 - i]);		// 32bit積和
+	if (mac32_n == n / 2) return hw_clamp ? clamp(d >> hs->k_bit_w) : clamp_sw(d >> hs->k_bit_w);
+	int64_t x = (int64_t)d;																// 以降演算結果が32bit幅を超えるため64bitに乗り換え
+	#pragma GCC unroll 16
+	for(uint i = mac32_n; i < n / 2; i++) x += k[i] * (int64_t)(z[i] + z[n - 1 - i]);	// 64bit積和
+	return hw_clamp ? clamp(x >> hs->k_bit_w) : clamp_sw(x >> hs->k_bit_w);
+}
+
+// 1入力サンプル(L/R)の x2 オーバーサンプル z[itap_n*4] : Ch0,Ch1 各々2重化した遅延データ列, *p_t : 遅延タップ位置
+// p_o へ L,R(実データ), L,R(補間データ) の4ワードを出力する (入力は呼出し側で読込み済みのため p_o は入力と重なってよい)
+static inline __attribute__((always_inline)) void hbf_x2_step(
+	const hbf_spec_t* hs, int32_t* z, uint* p_t, int32_t d0, int32_t d1, int32_t* p_o, const bool hw_clamp)
+{
+	const uint n = hs->itap_n;
+	uint t = *p_t;
+	////////////////////////////////////////////// Ch0 Oversampler
+	z[t    ] = d0;									// 第1遅延データ更新
+	z[t + n] = d0;									// 第2遅延データ更新
+	p_o[0] = z[t + n / 2];							// 中央遅延データを実データとして出力
+	p_o[2] = hbf_x2_mac(hs, &z[t], hw_clamp);		// 補間データを出力
+	t += 2 * n;										// タップ位置をCh1部に移動
+
+	////////////////////////////////////////////// Ch1 Oversampler
+	z[t    ] = d1;									// 第1遅延データ更新
+	z[t + n] = d1;									// 第2遅延データ更新
+	p_o[1] = z[t + n / 2];							// 中央遅延データを実データとして出力
+	p_o[3] = hbf_x2_mac(hs, &z[t], hw_clamp);		// 補間データを出力
+	t -= 2 * n;										// タップ位置をCh0部に移動
+
+	if (t == 0)	t = n - 1;							// タップが先頭に戻ったら最終タップに戻す
+	else		t--;								// 1タップずらす
+	*p_t = t;
+}
+
+// x2 オーバーサンプラ共通カーネル z[itap_n*4] : Ch0,Ch1 各々2重化した遅延データ列
+static inline __attribute__((always_inline)) void hbf_x2_run(
+	const hbf_spec_t* hs,
+	int32_t* z,			// 遅延データ列
+	uint* p_t,			// 遅延タップ位置
 	int32_t *p_i,		// 24bit input data pointer  : L1,R1,L2,R2,L3,R3,,Ln,Rn (n=*p_len)
 	int32_t *p_o,		// 24bit output data pointer : L1,R1,L2,R2,L3,R3,,Lm,Rm (m=*p_len *2)
-	uint *p_len			// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+	uint *p_len,		// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+	const bool hw_clamp,// true : interp1 clamp (Core0), false : ソフトウェアclamp (Core1)
+	const bool use_vol	// true : 入力読込み時に音量処理 (初段)
 ){
-	const uint k_bit_w = 7;								// 固定係数ビット長定義
-	const int32_t k[HBF3_ITAP_N / 2] = {
-//		-10, +74/*, +74, -10*/};						// 固定係数定義 偶数番はゼロのため省略、左右対称のため後半省略
-		2, -14, +76/*, +76, -14, 2*/};					// 固定係数定義 偶数番はゼロのため省略、左右対称のため後半省略
-	static uint t = 0;									// 遅延タップ位置宣言 連続利用のためstaticとする
-	static int32_t z[HBF3_ITAP_N * 4];					// 遅延データ列宣言 連続利用のためstaticとする
+	uint t = *p_t;
 	uint len = *p_len;									// ローカル変数に処置ループ長を取得
 
 	if (len == 0) {										// 遅延データ列とタップ位置をリセット
 		t = 0;
-		for(uint c = 0; c < HBF3_ITAP_N * 4; c++) z[c] = 0;
-	} else {											// オーバーサンプル処理
-		while(len--){
-			////////////////////////////////////////////// Ch0 Oversampler
-			int32_t d = *p_i++;							// 入力データ取得
-			z[t               ] = d;					// 第1遅延データ更新
-			z[t + HBF3_ITAP_N ] = d;					// 第2遅延データ更新
-			*p_o = z[t + HBF3_ITAP_N / 2];				// 中央遅延データを実データとして出力
-			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
-
-			// 補間データ演算
-			d  = k[ 0] * (int32_t)(d        +z[t + 5]);	// d  = k0*(tap0 + tap10)
-			d += k[ 1] * (int32_t)(z[t + 1] +z[t + 4]);	// d += k1*(tap2 + tap8)
-			d += k[ 2] * (int32_t)(z[t + 2] +z[t + 3]);	// d += k1*(tap4 + tap6)
-														// 演算結果は32bit幅に収まるため64bit演算に移行する必要なし
-			d = clamp(d >> k_bit_w);					// 演算結果を係数ビット長で右シフトし指定値でクランプし補間データ完成
-			*p_o--	= d;								// 補間データを出力、出力ポインタをCh1実データ位置へ移動
-			t += 2 * HBF3_ITAP_N;						// タップ位置をCh1部に移動
-
-			////////////////////////////////////////////// Ch1 Oversampler
-			d = *p_i++;									// 入力データ取得
-			z[t               ] = d;					// 第1遅延データ更新
-			z[t + HBF3_ITAP_N ] = d;					// 第2遅延データ更新
-			*p_o = z[t + HBF3_ITAP_N / 2];				// 中央遅延データを実データとして出力
-			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
-
-			// 補間データ演算
-			d  = k[ 0] * (int32_t)(d        +z[t + 5]);	// d  = k0*(tap0 + tap10)
-			d += k[ 1] * (int32_t)(z[t + 1] +z[t + 4]);	// d += k1*(tap2 + tap8)
-			d += k[ 2] * (int32_t)(z[t + 2] +z[t + 3]);	// d += k1*(tap4 + tap6)
-														// 演算結果は32bit幅に収まるため64bit演算に移行する必要なし
-			d = clamp(d >> k_bit_w);					// 演算結果を係数ビット長で右シフトし指定値でクランプし補間データ完成
-			*p_o++	= d;								// 補間データを出力、出力ポインタをCh0実データ位置へ移動
-			t -= 2 * HBF3_ITAP_N;						// タップ位置をCh0部に移動
-
-			if (t == 0)	t = HBF3_ITAP_N - 1;			// タップが先頭に戻ったら最終タップに戻す
-			else		t--;							// 1タップずらす
+		for(uint c = 0; c < hs->itap_n * 4; c++) z[c] = 0;
+	} else while(len) {									// オーバーサンプル処理 (音量ランプ中はブロック毎)
+		uint blk = len;
+		int32_t mul = 1;
+		uint shift = 0;
+		if (use_vol) vol_block_begin(&blk, &mul, &shift);
+		len -= blk;
+		if (use_vol) vol_block_end(blk);				// ブロック分を先に計上 (乗数・シフトは取得済み)
+		while(blk--){
+			int32_t d0 = *p_i++;						// 入力データ取得
+			int32_t d1 = *p_i++;
+			if (use_vol) {								// 音量処理
+				d0 = (d0 * mul) >> shift;
+				d1 = (d1 * mul) >> shift;
+			}
+			hbf_x2_step(hs, z, &t, d0, d1, p_o, hw_clamp);
+			p_o += 4;
 		}
 	}
+	*p_t = t;
 	*p_len *= 2;										// オーバーサンプリングで倍増したデータ数に更新
 }
 
+// hbf_spec[stage] の x2 オーバーサンプラ関数 name() (Core0)、name_vol() (Core0 音量処理統合版)、name_core1() (Core1) を生成
+// 音量処理統合版は初段用で、遅延データ列を name() と共有する (入力fsにより初段となる段が異なるため全段に用意する)
+// Core1版は後段分担(os_split)用で、遅延データ列を別に持ちソフトウェアclampを使う (両コアから同時に呼んでよい)
+// 遅延データ列は各コア専用バンクに置く (Core0 : scratch_y, Core1 : scratch_x)
+#define HBF_X2_OVERSAMPLER(name, stage, itap_n)									\
+static uint name##_t = 0;								/* 遅延タップ位置 */	\
+static int32_t CORE0_HOT("hbf") name##_z[(itap_n) * 4];	/* 遅延データ列 */		\
+static uint name##_core1_t = 0;															\
+static int32_t CORE1_HOT("hbf") name##_core1_z[(itap_n) * 4];							\
+void name(int32_t *p_i, int32_t *p_o, uint *p_len){								\
+	hbf_x2_run(&hbf_spec[stage], name##_z, &name##_t, p_i, p_o, p_len, true, false);	\
+}																				\
+void name##_vol(int32_t *p_i, int32_t *p_o, uint *p_len){						\
+	hbf_x2_run(&hbf_spec[stage], name##_z, &name##_t, p_i, p_o, p_len, true, true);	\
+}																				\
+void name##_core1(int32_t *p_i, int32_t *p_o, uint *p_len){						\
+	hbf_x2_run(&hbf_spec[stage], name##_core1_z, &name##_core1_t, p_i, p_o, p_len, false, false);	\
+}
+
+HBF_X2_OVERSAMPLER(hbf1_x2_oversampler, 0, HBF1_ITAP_N)
+HBF_X2_OVERSAMPLER(hbf2_x2_oversampler, 1, HBF2_ITAP_N)
+HBF_X2_OVERSAMPLER(hbf3_x2_oversampler, 2, HBF3_ITAP_N)
+
+typedef void (*hbf_x2_func_t)(int32_t *p_i, int32_t *p_o, uint *p_len);
+static const hbf_x2_func_t hbf_x2_core0[HBF_STAGE_N] = {hbf1_x2_oversampler,       hbf2_x2_oversampler,       hbf3_x2_oversampler      };
+static const hbf_x2_func_t hbf_x2_vol[HBF_STAGE_N]   = {hbf1_x2_oversampler_vol,   hbf2_x2_oversampler_vol,   hbf3_x2_oversampler_vol  };
+static const hbf_x2_func_t hbf_x2_core1[HBF_STAGE_N] = {hbf1_x2_oversampler_core1, hbf2_x2_oversampler_core1, hbf3_x2_oversampler_core1};
+
+/* 連結ハーフバンド 縦型ストリーミング版 (HBF_STREAM = 1)
+ 段毎版は各段がフレーム全体を処理し、中間fs(96/192kHz等)のフレームを dsp_buf へ書き込み、次段が読み戻す。
+ ストリーミング版は入力を HBF_STREAM_CHUNK_N サンプル毎に初段 -> .. -> hbf3 へ通し、最終段の出力のみ p_o へ書き込む。
+ 中間データは段毎の小バッファ hbf_stream_s1, s2 (チャンク分) だけとなり、dsp_buf の中間fs領域は使用しない。
+   段毎版     : 入力 -> [hbf1] -> 96k frame -> [hbf2] -> 192k frame -> [hbf3] -> 出力
+   ストリーム : 入力 -> ([hbf1] -> s1 -> [hbf2] -> s2 -> [hbf3] -> 出力) x チャンク数
+ 各段のカーネル・遅延データ列は段毎版(Core0)と同じで、段内の処理順も変わらないため出力はビット一致する。
+ 1サンプル毎に全段を通す構成はレジスタ不足で段毎の状態の退避・復帰が増え(M0+)、段毎版より遅くなるためチャンク単位とした。
+ 出力位置は段毎版の最終段と同じく入力位置の手前に収まり、未処理の入力を上書きしない。
+ 1段の場合は段毎版と同一のため、2段以上(入力 44.1~96kHz)で使う。処理量・中間データ量は host/hbf_stream_bench を参照。
+ 初段は入力fsにより異なる(hbf_get_first_stage())。中間データは初段からの段順に s1, s2 を使う。
+*/
+static int32_t CORE0_HOT("hbf") hbf_stream_s1[HBF_STREAM_CHUNK_N * 2 * N_CH];	// 初段出力 (チャンク分)
+static int32_t CORE0_HOT("hbf") hbf_stream_s2[HBF_STREAM_CHUNK_N * 4 * N_CH];	// 2段目出力 (3段時)
+
+// hbf(first+1) から n 段(2~3)の縦型ストリーミング連結 use_vol : 初段入力読込み時に音量処理
+void hbf_stream_oversampler(int32_t* p_i, int32_t* p_o, uint* p_len, uint first, uint n, bool use_vol){
+	uint len = *p_len;
+	while(len){
+		uint c = (len < HBF_STREAM_CHUNK_N) ? len : HBF_STREAM_CHUNK_N;
+		len -= c;
+		int32_t* const p_o2 = (n == 3) ? hbf_stream_s2 : p_o;
+		uint c_o = c;
+		(use_vol ? hbf_x2_vol : hbf_x2_core0)[first](p_i, hbf_stream_s1, &c_o);
+		hbf_x2_core0[first + 1](hbf_stream_s1, p_o2, &c_o);
+		if (n == 3) hbf_x2_core0[first + 2](hbf_stream_s2, p_o, &c_o);
+		p_i += c * N_CH;
+		p_o += c_o * N_CH;
+	}
+	*p_len <<= n;
+}
+
+// 段毎の積和構成 (32bit/64bit タップ対数) ベンチマーク・サイクル見積もり用
+void hbf_get_mac_n(uint stage, uint* p_mac32_n, uint* p_mac64_n){
+	const hbf_spec_t* hs = &hbf_spec[stage];
+	*p_mac32_n = hbf_mac32_n(hs);
+	*p_mac64_n = hs->itap_n / 2 - *p_mac32_n;
+}
+
+
+/* 単段ポリフェーズFIRオーバーサンプラ (pfir)
+ 連結ハーフバンドフィルタ hbf1~3 と等価なインパルス応答を持つFIRを1段で実行し、
+ 入力fsから352.8/384kHzへ x2/x4/x8 で直接補間する。
+   x8 : H(z) = Hbf1(z^4)・Hbf2(z^2)・Hbf3(z)
+   x4 : H(z) = Hbf2(z^2)・Hbf3(z)	(HBF_FS_PROFILE = 0 : Hbf1(z^2)・Hbf2(z))
+   x2 : H(z) = Hbf3(z)				(HBF_FS_PROFILE = 0 : Hbf1(z))
+ 係数は dsp_init() 時に hbf1~3 の係数表から合成し PFIR_COEF_BIT に再量子化する。
+ 通過域・阻止域特性、群遅延は連結ハーフバンドと一致する(係数再量子化・中間丸めの差を除く)。
+ 64bit演算を避けるため入力データを上位/下位に分割し、各々32bit幅で積和する。
+   x = xh * 2^PFIR_DATA_SPLIT + xl, Σk・x = (Σk・xh) * 2^PFIR_DATA_SPLIT + Σk・xl
+   位相毎の Σ|k| < 2^17 (x8), |xh| < 2^12.5, 0 ≦ xl < 2^12 より、各積和は 2^30 未満に収まる。
+ 積和回数は連結ハーフバンドより多い(中間レートでの計算結果を再利用できないため)。
+ 処理量の比較は host/oversampler_bench を参照。
+*/
+#define PFIR_COEF_BIT	16							// 再量子化後の係数ビット長
+#define PFIR_DATA_SPLIT	12							// 入力データ分割ビット位置
+#define PFIR_PHASE_MAX	8							// 最大補間比
+#if HBF_FS_PROFILE											// 等価インパルス応答長 (x2 : hbf3, x4 : hbf2-hbf3)
+#define PFIR_X2_LEN		(2 * HBF3_ITAP_N)
+#define PFIR_X4_LEN		((2 * HBF2_ITAP_N - 1) * 2 + 2 * HBF3_ITAP_N)
+#else														// 等価インパルス応答長 (x2 : hbf1, x4 : hbf1-hbf2)
+#define PFIR_X2_LEN		(2 * HBF1_ITAP_N)
+#define PFIR_X4_LEN		((2 * HBF1_ITAP_N - 1) * 2 + 2 * HBF2_ITAP_N)
+#endif
+#define PFIR_X8_LEN		((2 * HBF1_ITAP_N - 1) * 4 + (2 * HBF2_ITAP_N - 1) * 2 + 2 * HBF3_ITAP_N)
+#define PFIR_X2_TAP_N	((PFIR_X2_LEN + 1) / 2)		// 1位相当たりのタップ数
+#define PFIR_X4_TAP_N	((PFIR_X4_LEN + 3) / 4)
+#define PFIR_X8_TAP_N	((PFIR_X8_LEN + 7) / 8)
+#define PFIR_TAP_MAX	PFIR_X8_TAP_N
 
-#define HBF2_TAP_N	15						// HBFフィルタの元のタップ数
-#define HBF2_ITAP_N	((HBF2_TAP_N + 1) / 2)	// 補間用フィルタ(φ1)のタップ数
-void hbf2_x2_oversampler(
+// pfir 補間比毎の係数セット
+typedef struct {
+	uint l;								// 補間比(位相数)
+	uint j;								// 1位相当たりのタップ数(遅延データ長)
+	uint8_t k_top[PFIR_PHASE_MAX];		// 位相毎の先頭有効タップ位置
+	uint8_t k_n[PFIR_PHASE_MAX];		// 位相毎の有効タップ数
+	const int32_t* k[PFIR_PHASE_MAX];	// 位相毎の係数列先頭
+} pfir_set_t;
+
+static int32_t pfir_k[PFIR_X2_TAP_N * 2 + PFIR_X4_TAP_N * 4 + PFIR_X8_TAP_N * 8];	// 全係数セットの係数列
+static pfir_set_t pfir_set[3] = {						// x2, x4, x8
+	{.l = 2, .j = PFIR_X2_TAP_N},
+	{.l = 4, .j = PFIR_X4_TAP_N},
+	{.l = 8, .j = PFIR_X8_TAP_N},
+};
+static uint pfir_t = 0;									// 遅延タップ位置
+static int32_t pfir_zh[N_CH][PFIR_TAP_MAX * 2];			// 遅延データ列(上位) 2重化してリング処理を省略
+static int32_t pfir_zl[N_CH][PFIR_TAP_MAX * 2];			// 遅延データ列(下位)
+
+// ハーフバンド補間フィルタのインパルス応答 h[n] (n = 0 ~ 2*itap_n-1, 補間後レート)
+// 偶数番は中央(n = itap_n)の実データ通過分のみ 1<<k_bit_w、奇数番は補間係数
+static int32_t hbf_impulse(const hbf_spec_t* hs, int n){
+	if ((n < 0) || (n >= (int)(2 * hs->itap_n))) return 0;
+	if (n == (int)hs->itap_n) return 1 << hs->k_bit_w;
+	if ((n & 1) == 0) return 0;
+	uint j = n / 2;
+	return (j < hs->itap_n / 2) ? hs->k[j] : hs->k[hs->itap_n - 1 - j];
+}
+
+// hbf_spec[s] ~ hbf_spec[end-1] 連結時の等価インパルス応答 (最終段出力レート)
+static int64_t hbf_cascade_impulse(uint s, uint end, int n){
+	const hbf_spec_t* hs = &hbf_spec[s];
+	if (s == end - 1) return hbf_impulse(hs, n);
+	int r = 1 << (end - 1 - s);							// 当段出力から最終段出力までのアップサンプル比
+	int64_t sum = 0;
+	for(int a = 0; a < (int)(2 * hs->itap_n); a++){
+		int32_t h = hbf_impulse(hs, a);
+		if (h != 0) sum += h * hbf_cascade_impulse(s + 1, end, n - r * a);
+	}
+	return sum;
+}
+
+// pfir 係数合成
+// 等価インパルス応答を位相分解・再量子化し、位相毎にDCゲインが 1<<PFIR_COEF_BIT となるよう補正する
+// (位相間のゲイン差は入力fsのイメージとして現れるため)
+void pfir_init(void){
+	int32_t* pk = pfir_k;
+	for(uint n_stage = 1; n_stage <= 3; n_stage++){
+		pfir_set_t* ps = &pfir_set[n_stage - 1];
+		const uint first = HBF_FS_PROFILE ? HBF_STAGE_N - n_stage : 0;	// 連結する段 (hbf_get_first_stage() と同じ)
+		uint q_bit = 0;										// 合成係数のビット長
+		for(uint s = first; s < first + n_stage; s++) q_bit += hbf_spec[s].k_bit_w;
+
+		for(uint p = 0; p < ps->l; p++){
+			int32_t e[PFIR_TAP_MAX] = {0};
+			int32_t sum = 0;
+			uint j_max = 0;
+			for(uint j = 0; j < ps->j; j++){
+				int64_t h = hbf_cascade_impulse(first, first + n_stage, ps->l * j + p);
+				if (q_bit > PFIR_COEF_BIT)	e[j] = (int32_t)((h + ((int64_t)1 << (q_bit - PFIR_COEF_BIT - 1))) >> (q_bit - PFIR_COEF_BIT));
+				else						e[j] = (int32_t)(h << (PFIR_COEF_BIT - q_bit));
+				sum += e[j];
+				if (abs(e[j]) > abs(e[j_max])) j_max = j;
+			}
+			e[j_max] += (1 << PFIR_COEF_BIT) - sum;			// DCゲイン補正
+
+			uint top = 0, end = ps->j;						// 前後のゼロ係数を除外
+			while((top < end) && (e[top] == 0)) top++;
+			while((end > top) && (e[end - 1] == 0)) end--;
+			ps->k_top[p] = top;
+			ps->k_n[p] = end - top;
+			ps->k[p] = pk;
+			for(uint j = top; j < end; j++) *pk++ = e[j];
+		}
+	}
+}
+
+// pfir 有効タップ数 (1入力サンプル・1ch当たりの積和回数 / 2)
+uint pfir_get_tap_n(uint l){
+	uint n = 0;
+	for(uint i = 0; i < 3; i++){
+		if (pfir_set[i].l != l) continue;
+		for(uint p = 0; p < l; p++) n += pfir_set[i].k_n[p];
+	}
+	return n;
+}
+
+// 上位/下位積和結果の合成と係数ビット長の右シフト
+// (ah * 2^PFIR_DATA_SPLIT + al) >> PFIR_COEF_BIT を32bit演算のまま行う
+static inline int32_t pfir_round(int32_t ah, int32_t al){
+	const uint sh = PFIR_COEF_BIT - PFIR_DATA_SPLIT;
+	return (ah >> sh) + ((((ah & ((1 << sh) - 1)) << PFIR_DATA_SPLIT) + al) >> PFIR_COEF_BIT);
+}
+
+static inline __attribute__((always_inline)) void pfir_run(
 	int32_t *p_i,		// 24bit input data pointer  : L1,R1,L2,R2,L3,R3,,Ln,Rn (n=*p_len)
-	int32_t *p_o,		// 24bit output data pointer : L1,R1,L2,R2,L3,R3,,Lm,Rm (m=*p_len *2)
-	uint *p_len			// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+	int32_t *p_o,		// 24bit output data pointer : L1,R1,L2,R2,L3,R3,,Lm,Rm (m=*p_len *l)
+	uint *p_len,		// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+	uint l,				// 補間比 2,4,8
+	const bool use_vol	// true : 入力読込み時に音量処理
 ){
-	const uint k_bit_w = 10;							// 固定係数ビット長定義
-	const int32_t k[HBF2_ITAP_N / 2] = {
-		  -8, +43,-149,+626/*,+626,-149, +43,  -8*/};	// 固定係数定義 偶数番は0,後半は左右対称のため省略
-	static uint t = 0;									// 遅延タップ位置宣言 連続利用のためstaticとする
-	static int32_t z[HBF2_ITAP_N * 4];  				// 遅延データ列宣言 連続利用のためstaticとする
-	uint len = *p_len;									// ローカル変数に処置ループ長を取得
+	const pfir_set_t* ps = &pfir_set[(l >= 8) ? 2 : (l >= 4) ? 1 : 0];
+	const uint j = ps->j;
+	uint t = pfir_t;
+	uint len = *p_len;
 
 	if (len == 0) {										// 遅延データ列とタップ位置をリセット
 		t = 0;
-		for(uint c = 0; c < HBF2_ITAP_N * 4; c++) z[c] = 0;
-	} else {											// オーバーサンプル処理
-		while(len--){
-			////////////////////////////////////////////// Ch0 Oversampler
-			int32_t d = *p_i++;							// 入力データ取得
-			z[t              ] = d;						// 第1遅延データ更新
-			z[t + HBF2_ITAP_N] = d;						// 第2遅延データ更新
-			*p_o = z[t + HBF2_ITAP_N / 2];				// 中央遅延データを実データとして出力
-			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
-
-			// 補間データ演算
-			d  = k[ 0] *          (d        +z[t + 7]);	// k0 * (tap0 + tap14)
-			d += k[ 1] *          (z[t + 1] +z[t + 6]);	// k2 * (tap2 + tap12)
-			int64_t x  = (int64_t)d;					// 以降演算結果が32bit幅を超えるため64bitに乗り換え
-			x += k[ 2] * (int64_t)(z[t + 2] +z[t + 5]);	// k4 * (tap4 + tap10)
-			x += k[ 3] * (int64_t)(z[t + 3] +z[t + 4]);	// k6 * (tap6 + tap8)
-			d = clamp(x >> k_bit_w);					// 64bit長演算結果を係数ビット長で右シフトし32bit幅に戻した後、指定値でクランプし補間データ完成
-			*p_o--	= d;								// 補間データを出力、出力ポインタをCh1実データ位置へ移動
-			t += 2 * HBF2_ITAP_N;						// タップ位置をCh1部に移動
-
-			////////////////////////////////////////////// Ch1 Oversampler
-			d = *p_i++;									// 入力データ取得
-			z[t              ] = d;						// 第1遅延データ更新
-			z[t + HBF2_ITAP_N] = d;						// 第2遅延データ更新
-			*p_o = z[t + HBF2_ITAP_N / 2];				// 中央遅延データを実データとして出力
-			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
-
-			// 補間データ演算
-			d  = k[ 0] *          (d        +z[t + 7]);	// k0 * (tap0 + tap14)
-			d += k[ 1] *          (z[t + 1] +z[t + 6]);	// k2 * (tap2 + tap12)
-			x  = (int64_t)d;							// 以降演算結果が32bit幅を超えるため64bitに乗り換え
-			x += k[ 2] * (int64_t)(z[t + 2] +z[t + 5]);	// k4 * (tap4 + tap10)
-			x += k[ 3] * (int64_t)(z[t + 3] +z[t + 4]);	// k6 * (tap6 + tap8)
-			d = clamp(x >> k_bit_w);					// 64bit長演算結果を係数ビット長で右シフトし32bit幅に戻した後、指定値でクランプし補間データ完成
-			*p_o++	= d;								// 補間データを出力、出力ポインタをCh0実データ位置へ移動
-			t -= 2 * HBF2_ITAP_N;						// タップ位置をCh0部に移動
-
-			if (t == 0)	t = HBF2_ITAP_N - 1;			// タップが先頭に戻ったら最終タップに戻す
+		for(uint c = 0; c < PFIR_TAP_MAX * 2; c++){
+			pfir_zh[0][c] = 0;	pfir_zh[1][c] = 0;
+			pfir_zl[0][c] = 0;	pfir_zl[1][c] = 0;
+		}
+	} else while(len) {									// 音量ランプ中はブロック毎
+		uint blk = len;
+		int32_t mul = 1;
+		uint shift = 0;
+		if (use_vol) vol_block_begin(&blk, &mul, &shift);
+		len -= blk;
+		if (use_vol) vol_block_end(blk);
+		while(blk--){
+			for(uint c = 0; c < N_CH; c++){
+				int32_t d = *p_i++;						// 入力データ取得、上位/下位に分割して遅延データ更新
+				if (use_vol) d = (d * mul) >> shift;	// 音量処理
+				int32_t* zh = &pfir_zh[c][t];
+				int32_t* zl = &pfir_zl[c][t];
+				zh[0] = zh[j] = d >> PFIR_DATA_SPLIT;
+				zl[0] = zl[j] = d & ((1 << PFIR_DATA_SPLIT) - 1);
+
+				for(uint p = 0; p < ps->l; p++){		// 位相毎の補間データ演算
+					const int32_t* k  = ps->k[p];
+					const int32_t* xh = &zh[ps->k_top[p]];
+					const int32_t* xl = &zl[ps->k_top[p]];
+					int32_t ah = 0;
+					int32_t al = 0;
+					for(uint n = ps->k_n[p]; n > 0; n--){
+						int32_t kn = *k++;
+						ah += kn * *xh++;
+						al += kn * *xl++;
+					}
+					p_o[p * N_CH + c] = clamp(pfir_round(ah, al));
+				}
+			}
+			p_o += ps->l * N_CH;
+			if (t == 0)	t = j - 1;						// タップが先頭に戻ったら最終タップに戻す
 			else		t--;							// 1タップずらす
 		}
 	}
-	*p_len *= 2;										// データ長がオーバーサンプリングで倍増するため更新
+	pfir_t = t;
+	*p_len *= l;
 }
 
+void pfir_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len, uint l){
+	pfir_run(p_i, p_o, p_len, l, false);
+}
+
+// 音量処理統合版 (OVERSAMPLER_TYPE = 1 の初段)
+void pfir_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len, uint l){
+	pfir_run(p_i, p_o, p_len, l, true);
+}
+
+/* 低遅延オーバーサンプラ (iir1~3, os_filter_set(OS_FILTER_LOW_DELAY))
+ hbf1~3 は直線位相のため、段毎に ITAP_N 出力サンプルの群遅延を持つ (44.1kHz入力の3段で計 約244us)。
+ iir1~3 は hbf1~3 と同じ段毎の仕様を満たすポリフェーズ全域通過型ハーフバンドIIR(楕円特性)で、群遅延を 1/5 程度とする。
+   H(z) = (A0(z^2) + z^-1 A1(z^2)) / 2,  Ap(z) = Π (a + z^-1) / (1 + a z^-1)
+   x2 補間は入力レートで行い、A0 の出力を偶数番(hbf の実データ位置)、A1 の出力を奇数番(補間データ位置)とする。
+ 位相は非直線で、群遅延は周波数により異なり通過域端で増加する。os_get_group_delay_us() は DC の群遅延を返す。
+ 全域通過段 y[n] = a (x[n] - y[n-1]) + x[n-1] は、差分を上位/下位に分割して pfir と同じ32bit積和・合成(pfir_round())を行う。
+ 差分の最大値(段入出力の L1ノルムから算出)が 2^(31 - IIR_A_BIT + PFIR_DATA_SPLIT) 未満に収まることは host/iir_design で確認している。
+ Core1版は持たず、低遅延フィルタでは Core1 分担(os_split)を行わない (処理量は hbf より少ない, host/low_delay_bench)。
+ 係数は host/iir_design が段毎の仕様から設計し、iir_coef.h に生成する。
+*/
+_Static_assert(IIR_A_BIT == PFIR_COEF_BIT, "IIR_A_BIT == PFIR_COEF_BIT");
+static const int32_t iir1_a[IIR1_A_N] = IIR1_A;
+static const int32_t iir2_a[IIR2_A_N] = IIR2_A;
+static const int32_t iir3_a[IIR3_A_N] = IIR3_A;
+
+// 全域通過型ハーフバンドIIR諸元
+typedef struct {
+	const int32_t* a;	// 全域通過係数 (偶数番 : A0, 奇数番 : A1)
+	uint a_n;			// 全域通過段数
+} iir_spec_t;
+
+static const iir_spec_t iir_spec[HBF_STAGE_N] = {
+	{iir1_a,	IIR1_A_N},
+	{iir2_a,	IIR2_A_N},
+	{iir3_a,	IIR3_A_N},
+};
+
+// 全域通過段 s[0] : x[n-1], s[1] : y[n-1]
+static inline __attribute__((always_inline)) int32_t iir_allpass(int32_t a, int32_t x, int32_t* s){
+	const int32_t d = x - s[1];
+	const int32_t y = pfir_round(a * (d >> PFIR_DATA_SPLIT), a * (d & ((1 << PFIR_DATA_SPLIT) - 1))) + s[0];
+	s[0] = x;
+	s[1] = y;
+	return y;
+}
 
-#define HBF1_TAP_N	31
-#define HBF1_ITAP_N	((HBF1_TAP_N + 1) / 2)
-void hbf1_x2_oversampler(
+// x2 オーバーサンプラ共通カーネル z[N_CH][a_n][2] : ch毎・全域通過段毎の状態
+static inline __attribute__((always_inline)) void iir_x2_run(
+	const iir_spec_t* is,
+	int32_t* z,			// 全域通過段の状態
 	int32_t *p_i,		// 24bit input data pointer  : L1,R1,L2,R2,L3,R3,,Ln,Rn (n=*p_len)
 	int32_t *p_o,		// 24bit output data pointer : L1,R1,L2,R2,L3,R3,,Lm,Rm (m=*p_len *2)
-	uint *p_len			// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+	uint *p_len,		// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+	const bool use_vol	// true : 入力読込み時に音量処理 (初段)
 ){
-	const uint k_bit_w = 12;
-	const int32_t k[HBF1_ITAP_N /2] = {
-		-2,+10,-32,+81,-177,+360,-762,+2570};			// 12-bit 16tap
-	static uint t = 0;
-	static int32_t z[HBF1_ITAP_N * 4];
+	const uint n = is->a_n;
 	uint len = *p_len;
-	if (len == 0) {
-		// Clear Delayed Data
-		t = 0;
-		for(uint c=0; c < HBF1_ITAP_N*4; c++) z[c] = 0;
-	} else {
-		while(len--){
-			// Ch0 Oversampler
-			int32_t d = *p_i++;
-			z[t              ] = d;
-			z[t + HBF1_ITAP_N] = d;
-			*p_o = z[t + HBF1_ITAP_N / 2];
-			p_o	+= 2;
-
-			d  = k[ 0] * (int32_t)(d        +z[t +15]);
-			d += k[ 1] * (int32_t)(z[t + 1] +z[t +14]);
-			d += k[ 2] * (int32_t)(z[t + 2] +z[t +13]);
-			d += k[ 3] * (int32_t)(z[t + 3] +z[t +12]);
-			int64_t x  = (int64_t)d;
-			x += k[ 4] * (int64_t)(z[t + 4] +z[t +11]);
-			x += k[ 5] * (int64_t)(z[t + 5] +z[t +10]);
-			x += k[ 6] * (int64_t)(z[t + 6] +z[t + 9]);
-			x += k[ 7] * (int64_t)(z[t + 7] +z[t + 8]);
-			*p_o--	= clamp(x >> k_bit_w);
-			t += 2 * HBF1_ITAP_N;
-
-			// Ch1 Oversampler
-			d = *p_i++;
-			z[t              ] = d;
-			z[t + HBF1_ITAP_N] = d;
-			*p_o = z[t + HBF1_ITAP_N / 2];
-			p_o	+= 2;
-
-			d  = k[ 0] * (int32_t)(d        +z[t +15]);
-			d += k[ 1] * (int32_t)(z[t + 1] +z[t +14]);
-			d += k[ 2] * (int32_t)(z[t + 2] +z[t +13]);
-			d += k[ 3] * (int32_t)(z[t + 3] +z[t +12]);
-			x  = (int64_t)d;
-			x += k[ 4] * (int64_t)(z[t + 4] +z[t +11]);
-			x += k[ 5] * (int64_t)(z[t + 5] +z[t +10]);
-			x += k[ 6] * (int64_t)(z[t + 6] +z[t + 9]);
-			x += k[ 7] * (int64_t)(z[t + 7] +z[t + 8]);
-			*p_o++	= clamp(x >> k_bit_w);
-			t -= 2 * HBF1_ITAP_N;
-			
-			if (t == 0)	t = HBF1_ITAP_N - 1;
-			else		t--;
+
+	if (len == 0) {										// 状態をリセット
+		for(uint c = 0; c < N_CH * n * 2; c++) z[c] = 0;
+	} else while(len) {									// 音量ランプ中はブロック毎
+		uint blk = len;
+		int32_t mul = 1;
+		uint shift = 0;
+		if (use_vol) vol_block_begin(&blk, &mul, &shift);
+		len -= blk;
+		if (use_vol) vol_block_end(blk);
+		while(blk--){
+			int32_t d[N_CH];
+			for(uint c = 0; c < N_CH; c++){				// 入力データ取得 (p_o は入力と重なってよい)
+				d[c] = *p_i++;
+				if (use_vol) d[c] = (d[c] * mul) >> shift;	// 音量処理
+			}
+			for(uint c = 0; c < N_CH; c++){
+				int32_t* s = &z[c * n * 2];
+				int32_t e = d[c];
+				int32_t o = d[c];
+				#pragma GCC unroll 8
+				for(uint i = 0; i < n; i += 2) e = iir_allpass(is->a[i], e, &s[i * 2]);	// A0
+				#pragma GCC unroll 8
+				for(uint i = 1; i < n; i += 2) o = iir_allpass(is->a[i], o, &s[i * 2]);	// A1
+				p_o[c]        = clamp(e);				// 偶数番
+				p_o[N_CH + c] = clamp(o);				// 奇数番
+			}
+			p_o += 2 * N_CH;
 		}
 	}
-	*p_len *= 2;
+	*p_len *= 2;										// オーバーサンプリングで倍増したデータ数に更新
+}
+
+// iir_spec[stage] の x2 オーバーサンプラ関数 name() (Core0)、name_vol() (Core0 音量処理統合版) を生成
+#define IIR_X2_OVERSAMPLER(name, stage, a_n)										\
+static int32_t CORE0_HOT("iir") name##_z[N_CH * (a_n) * 2];	/* 全域通過段の状態 */	\
+void name(int32_t *p_i, int32_t *p_o, uint *p_len){								\
+	iir_x2_run(&iir_spec[stage], name##_z, p_i, p_o, p_len, false);				\
+}																				\
+void name##_vol(int32_t *p_i, int32_t *p_o, uint *p_len){						\
+	iir_x2_run(&iir_spec[stage], name##_z, p_i, p_o, p_len, true);				\
+}
+
+IIR_X2_OVERSAMPLER(iir1_x2_oversampler, 0, IIR1_A_N)
+IIR_X2_OVERSAMPLER(iir2_x2_oversampler, 1, IIR2_A_N)
+IIR_X2_OVERSAMPLER(iir3_x2_oversampler, 2, IIR3_A_N)
+
+static const hbf_x2_func_t iir_x2_core0[HBF_STAGE_N] = {iir1_x2_oversampler,     iir2_x2_oversampler,     iir3_x2_oversampler    };
+static const hbf_x2_func_t iir_x2_vol[HBF_STAGE_N]   = {iir1_x2_oversampler_vol, iir2_x2_oversampler_vol, iir3_x2_oversampler_vol};
+
+// 段毎の全域通過段数 ベンチマーク・サイクル見積もり用
+uint iir_get_a_n(uint stage){
+	return iir_spec[stage].a_n;
 }
 
 // 各オーバーサンプラのリセット
@@ -318,40 +748,49 @@ void hbf_oversampler_reset(void){
 	hbf1_x2_oversampler(null_buf, null_buf, &null_len);
 	hbf2_x2_oversampler(null_buf, null_buf, &null_len);
 	hbf3_x2_oversampler(null_buf, null_buf, &null_len);
+	iir1_x2_oversampler(null_buf, null_buf, &null_len);
+	iir2_x2_oversampler(null_buf, null_buf, &null_len);
+	iir3_x2_oversampler(null_buf, null_buf, &null_len);
+	pfir_oversampler(null_buf, null_buf, &null_len, 8);
 }
 
-// 音量処理関数
+// 音量処理関数 (別パス版 : ベンチマーク・比較用。再生処理はオーバーサンプラ初段で音量処理する)
 // 従来の64bit演算を32bit化し高速化を行っている
 void volume(int32_t* buf, uint32_t sample_num, int32_t mul, uint shift){
+	PROF_BEGIN(PROF_VOLUME);
 	int32_t d;			// work data
 	while(sample_num --){
 		d = *buf;	*buf++ = (d * mul) >> shift;	// Volume処理
 		d = *buf;	*buf++ = (d * mul) >> shift;	// Volume処理
 	}
+	PROF_END(PROF_VOLUME);
 }
 
 /* オーバーサンプリング、音量処理用バッファ宣言
  384k用バッファを宣言。中間処理で必要な 192,96,48kHz用バッファは個別に持たず、
  384k用バッファ領域を共有しRAMサイズを節約。x2オーバーサンプリング時、使用済
  ソースデータを完成後のデータで上書きしている。
- topの2ワードは、前回最終データを書き込み、ASRCのOverlap処理用としている
+ HBF_STREAM = 1 で連結2段以上の場合は中間fs領域を使わず(hbf_stream_oversampler())、入力fs領域と384k領域(ASRC入力)のみ使う。
+ topの ASRC_OVERLAP ワードは、ASRCが過去データ(最長カーネルのタップ数-1サンプル分)を書き戻すOverlap領域としている
  dsp_buf_top  (0)    -+-------+                               +-------+
                       |Overlap| <- for ASRC                   |       |
- dsp_buf_384k (0/8+2)-+-------+                               +-------+
+ dsp_buf_384k (0/8+OV)+-------+                               +-------+
                       |       |                         x2    |       |
                       |       |                     OverSamp. |       |
                       |       |               x2        +---> |       |
- dsp_buf_192k (4/8+2)_|_ _ _ _|     x2    OverSamp.  ___:___  |  384k |
+ dsp_buf_192k (4/8+OV)|_ _ _ _|     x2    OverSamp.  ___:___  |  384k |
                       |       | OverSamp.     +---> |       | |       |
- dsp_buf_96k  (6/8+2)_|_ _ _ _|     +--->  ___:___  |  192k | |       |
- dsp_buf_48k  (7/8+2)_|_ _ _ _|  ___:___  |  96k  | |       | |       |
+ dsp_buf_96k  (6/8+OV)|_ _ _ _|     +--->  ___:___  |  192k | |       |
+ dsp_buf_48k  (7/8+OV)|_ _ _ _|  ___:___  |  96k  | |       | |       |
                       |_______| |__48k__| |_______| |_______| |_______|
 */
-static int32_t dsp_buf_top[QUEUE_WIDTH +2] = {0};	// 384kHz用 QUEUE_WIDTHと同サイズで準備 +2はASRC処理用Overlap領域
-int32_t* const dsp_buf_384k	= &dsp_buf_top[QUEUE_WIDTH * 0 / 8 +2];	// 384kHz用 (領域共有)
-int32_t* const dsp_buf_192k	= &dsp_buf_top[QUEUE_WIDTH * 4 / 8 +2];	// 192kHz用 (領域共有)
-int32_t* const dsp_buf_96k	= &dsp_buf_top[QUEUE_WIDTH * 6 / 8 +2];	//  96kHz用 (領域共有)
-int32_t* const dsp_buf_48k	= &dsp_buf_top[QUEUE_WIDTH * 7 / 8 +2];	//  48kHz用 (領域共有)
+#define ASRC_SINC_TAP_N	32								// ASRC 窓付きsincのタップ数 (最長カーネル、入力fs 20kHz通過・28kHz阻止に必要な長さ)
+#define ASRC_OVERLAP	((ASRC_SINC_TAP_N - 1) * N_CH)	// ASRC Overlap領域 [word]
+static int32_t dsp_buf_top[QUEUE_WIDTH + ASRC_OVERLAP] = {0};	// 384kHz用 QUEUE_WIDTHと同サイズで準備 +ASRC_OVERLAPはASRC処理用Overlap領域
+int32_t* const dsp_buf_384k	= &dsp_buf_top[QUEUE_WIDTH * 0 / 8 + ASRC_OVERLAP];	// 384kHz用 (領域共有)
+int32_t* const dsp_buf_192k	= &dsp_buf_top[QUEUE_WIDTH * 4 / 8 + ASRC_OVERLAP];	// 192kHz用 (領域共有)
+int32_t* const dsp_buf_96k	= &dsp_buf_top[QUEUE_WIDTH * 6 / 8 + ASRC_OVERLAP];	//  96kHz用 (領域共有)
+int32_t* const dsp_buf_48k	= &dsp_buf_top[QUEUE_WIDTH * 7 / 8 + ASRC_OVERLAP];	//  48kHz用 (領域共有)
 
 // fs(サンプリング周波数)に応じたバッファポインタを返す関数
 int32_t* get_dsp_buf_pointer(uint fs){
@@ -372,87 +811,439 @@ int32_t* get_dsp_buf_pointer(uint fs){
 	}
 }
 
+// L/Rデータ列のコピー (出力先が同一の場合は処理なし)
+static void dsp_copy(const int32_t* p_i, int32_t* p_o, uint len){
+	if (p_i == p_o) return;
+	for(uint c = 0; c < len * N_CH; c++) p_o[c] = p_i[c];
+}
+
+// 音量処理付きコピー (0段時の初段) p_i == p_o の場合はその場で処理する
+static void vol_copy(const int32_t* p_i, int32_t* p_o, uint len){
+	while(len){
+		uint blk = len;
+		int32_t mul;
+		uint shift;
+		vol_block_begin(&blk, &mul, &shift);
+		len -= blk;
+		vol_block_end(blk);
+		for(uint c = 0; c < blk * N_CH; c++) p_o[c] = (p_i[c] * mul) >> shift;
+		p_i += blk * N_CH;
+		p_o += blk * N_CH;
+	}
+}
+
+// サブフレーム処理 (低遅延モード) 入力バッファ上の offset サンプル目から len サンプルを入力バッファ先頭へ移動する
+// パケットを2分割以上して先頭から順に hbf_oversampler() へ渡す場合、各段の出力(倍長)は次段入力位置の手前に収まり、
+// 未処理の入力データを上書きしない。(例 48k : 96k出力 6/8 + 2/8 x 1/2 ≦ 7/8)
+// 移動は前方(アドレスの小さい方)へのため、先頭からのコピーでよい。
+void dsp_buf_advance(uint fs, uint offset, uint len){
+	int32_t* p = get_dsp_buf_pointer(fs);
+	if (offset == 0) return;
+	for(uint c = 0; c < len * N_CH; c++) p[c] = p[offset * N_CH + c];
+}
+
 // 連結ハーフバンドフィルタによるオーバーサンプリング処理
 // hbf1~3 の連結数を切り替え、x2 ~ x8 オーバーサンプリングを構成、全fs入力を352.8/384kHzに統一
+// HBF_FS_PROFILE = 1 : 各段は段の入力fs用に設計した係数(hbf_coef.h)のため、入力fsに合わせた段から連結する
 // 3段 ( 44k1, 48k)->[hbf1]-( 88k2/ 96k)->[hbf2]-(176k4/192k)->[hbf3]-+-(352k8/384k)-->
-// 2段 ( 88k2, 96k)---------------------->[hbf1]-(176k4/192k)->[hbf2]-+
-// 1段 (176k4,192k)------------------------------(176k4/192k)->[hbf1]-+
+// 2段 ( 88k2, 96k)---------------------->[hbf2]-(176k4/192k)->[hbf3]-+
+// 1段 (176k4,192k)------------------------------------------->[hbf3]-+
 // 0段 (352k8,384k)---------------------------------------------------+
+// HBF_FS_PROFILE = 0 : 全fsで hbf1 から連結する (2段 : hbf1-hbf2, 1段 : hbf1)
 //
 // len(データ長)はオーバーサンプリング処理回数により2^Nに増加するため、ポインタ渡しとして処理後の長さに書き換える
 // 元々はUSBの_as_audio_packet内の処理だったが、I2S側でも使用するため関数化した
-void hbf_oversampler(int32_t** buf, uint *p_len, uint fs){
-	DEBUG_PIN(PIN_GP12, 1);
-	switch(fs){
-	  case 384000 :
-	  case 352800 :
-		// 0段 オーバーサンプリングせずに終了
-		break;
-	  case 192000 :
-	  case 176400 :
-		// 1段
-		hbf1_x2_oversampler(dsp_buf_192k, dsp_buf_384k, p_len);	DEBUG_PIN(PIN_GP12, 0);
-		break;
-	  case  96000 :
-	  case  88200 :
-		// 2段
-		hbf1_x2_oversampler(dsp_buf_96k,  dsp_buf_192k, p_len);	DEBUG_PIN(PIN_GP12, 0);
-		hbf2_x2_oversampler(dsp_buf_192k, dsp_buf_384k, p_len);	DEBUG_PIN(PIN_GP12, 1);
-		break;
-	  case  48000 :
-	  case  44100 :
-	  default     :
-		// 3段
-		hbf1_x2_oversampler(dsp_buf_48k,  dsp_buf_96k,  p_len);	DEBUG_PIN(PIN_GP12, 0);
-		hbf2_x2_oversampler(dsp_buf_96k,  dsp_buf_192k, p_len);	DEBUG_PIN(PIN_GP12, 1);
-		hbf3_x2_oversampler(dsp_buf_192k, dsp_buf_384k, p_len);	DEBUG_PIN(PIN_GP12, 0);
-		break;
-	}
-	DEBUG_PIN(PIN_GP12, 0);
-	*buf = dsp_buf_384k;
-}
-
-
-// ASRC 固定小数点精度の定義
+// 最終段は p_out (キュースロット、または後段ASRCの入力 dsp_buf_384k) へ直接出力する。0段の場合のみ p_out へコピーする
+// os_split_set() で後段を Core1 に分担させた場合は、Core0 分担の最終段で終了する (出力fs = 352.8/384kHz >> split)
+// 音量処理は初段(hbf / pfir / 0段時のコピー)の入力読込み時に行う (volume_set())
+// HBF_STREAM = 1 の場合、Core0 分担が2段以上なら hbf_stream_oversampler() で全段を1パスで処理する
+// 低遅延フィルタ(os_filter_set(OS_FILTER_LOW_DELAY))の場合は hbf1~3 の代わりに iir1~3 を同じ段構成で段毎に処理する
+
+static const prof_stage_t hbf_prof[HBF_STAGE_N] = {PROF_HBF1, PROF_HBF2, PROF_HBF3};
+
+static uint os_split = 0;		// Core1 が分担する後段数 (Core0 のフォーマット更新時に設定)
+static uint os_filter = OS_FILTER_LINEAR;	// オーバーサンプリングフィルタ (os_filter_set())
+
+void hbf_oversampler(int32_t** buf, uint *p_len, uint fs, int32_t* p_out){
+#if (OVERSAMPLER_TYPE == 1)
+	// 単段ポリフェーズFIRにより x1~x8 を1パスで処理 (後段分担なし)
+	uint osr = get_osr(fs);
+	uint l = (osr >= 8) ? 1 : (osr >= 4) ? 2 : (osr >= 2) ? 4 : 8;
+	if (l > 1) {
+		PROF_BEGIN(PROF_PFIR);
+		if (volume_is_unity()) pfir_oversampler(get_dsp_buf_pointer(fs), p_out, p_len, l);
+		else                   pfir_oversampler_vol(get_dsp_buf_pointer(fs), p_out, p_len, l);
+		PROF_END(PROF_PFIR);
+	} else if (volume_is_unity()) {
+		dsp_copy(dsp_buf_384k, p_out, *p_len);
+	} else {
+		vol_copy(dsp_buf_384k, p_out, *p_len);
+	}
+#else
+	// Core0 分担段 初段 ~ n0段目 段毎の出力は次段fsのバッファ、最終段は p_out
+	// 2段以上は縦型ストリーミング(HBF_STREAM = 1)で中間fsのバッファを使わず p_out へ出力する
+	// 音量処理は初段(hbf または 0段時のコピー)の入力読込み時に行う
+	// 分担段数はフォーマット更新時の fs で設定されるため、次のフォーマット更新までに fs が変わり段数を超える場合は 0段とする
+	const uint n = hbf_get_stage_n(fs);
+	const uint n0 = (n > os_split) ? n - os_split : 0;
+	const uint first = hbf_get_first_stage(fs);
+	const bool use_vol = !volume_is_unity();
+	int32_t* p_i = get_dsp_buf_pointer(fs);
+	if (n0 == 0) {
+		if (use_vol) vol_copy(p_i, p_out, *p_len);
+		else         dsp_copy(p_i, p_out, *p_len);
+	}
+	if (os_filter == OS_FILTER_LOW_DELAY) {
+		// 低遅延フィルタ iir(first+1) ~ 段毎 (Core1 分担なし)
+		PROF_BEGIN(PROF_IIR);
+		for(uint i = 0; i < n0; i++){
+			int32_t* p_o = (i == n0 - 1) ? p_out : get_dsp_buf_pointer(fs << (i + 1));
+			if ((i == 0) && use_vol) iir_x2_vol[first](p_i, p_o, p_len);
+			else                     iir_x2_core0[first + i](p_i, p_o, p_len);
+			p_i = p_o;
+		}
+		PROF_END(PROF_IIR);
+		*buf = p_out;
+		return;
+	}
+#if HBF_STREAM
+	if (n0 >= 2) {
+		PROF_BEGIN(PROF_HBF_STREAM);
+		hbf_stream_oversampler(p_i, p_out, p_len, first, n0, use_vol);
+		PROF_END(PROF_HBF_STREAM);
+		*buf = p_out;
+		return;
+	}
+#endif
+	for(uint i = 0; i < n0; i++){
+		int32_t* p_o = (i == n0 - 1) ? p_out : get_dsp_buf_pointer(fs << (i + 1));
+		uint32_t t = prof_now();
+		if ((i == 0) && use_vol) hbf_x2_vol[first](p_i, p_o, p_len);
+		else                     hbf_x2_core0[first + i](p_i, p_o, p_len);
+		prof_record(hbf_prof[first + i], (prof_now() - t) & PROF_TICK_MASK);
+		p_i = p_o;
+	}
+#endif
+	*buf = p_out;
+}
+
+/* Core0/Core1 のオーバーサンプリング分担 (os_split)
+ 入力fsから352.8/384kHzまでの連結ハーフバンド n 段のうち、後段 split 段(OS_SPLIT_MAX以下)を Core1 が分担する。
+ キューは 352.8/384kHz >> split のデータを運び、Core1 は PDM_FEED_N 毎に後段を処理してから PWM変換する。
+   例 48k, split = 1 : Core0 [hbf1]-[hbf2]-(192k)-> queue ->Core1 [hbf3]-(384k)-[x4/x8 補間・ΔΣ]
+ ASRC(I2S)は Core0 最終段の出力fs(キューのfs)で動作する。
+ 分担は os_split_select() が段毎の処理サイクル(os_cost_t)から最も負荷の高いコアの負荷が最小となるよう選ぶ。
+ キュースロットには分担を表すタグ(os_split_set()の戻り値)を付け、Core1 は取り出したスロットのタグで後段を処理する。
+ (キューに残る旧フォーマットのスロットも旧分担のまま処理される)
+ タグ : bit 0~3 分担段数, bit 4~7 Core1 先頭段(hbf番号-1), bit 8~ フォーマット更新毎の通番
+ Core1 はタグが変わった時に後段の遅延データ列をリセットする。
+*/
+#define OS_SPLIT_TAG(split, first, seq)	((split) | ((first) << 4) | ((seq) << 8))
+#define OS_SPLIT_TAG_SPLIT(tag)			((tag) & 0xf)
+#define OS_SPLIT_TAG_FIRST(tag)			(((tag) >> 4) & 0xf)
+
+// 入力fs から352.8/384kHzまでの連結ハーフバンド段数
+uint hbf_get_stage_n(uint fs){
+	const uint osr = get_osr(fs);
+	return (osr >= 8) ? 0 : (osr >= 4) ? 1 : (osr >= 2) ? 2 : 3;
+}
+
+// 入力fs の連結ハーフバンド初段 (0~2 = hbf1~3, 0段時は HBF_STAGE_N)
+// HBF_FS_PROFILE = 1 : hbf1~3 は各々 44.1k/88.2k/176.4k系入力用(遷移帯域 20kHz ~ 入力fs-20kHz)に設計しているため、
+// n 段の場合は後段 n 段を使う。88.2k以上の入力は 44.1k用の急峻な hbf1 を通さず、短い hbf2/hbf3 から始める
+// フォーマット更新時の os_split_set() でキュースロットのタグ(Core1 先頭段)にも反映する
+uint hbf_get_first_stage(uint fs){
+#if HBF_FS_PROFILE
+	return HBF_STAGE_N - hbf_get_stage_n(fs);
+#else
+	return (hbf_get_stage_n(fs) == 0) ? HBF_STAGE_N : 0;
+#endif
+}
+
+// オーバーサンプリングフィルタの設定 (Core0) OS_FILTER_LINEAR : 直線位相 hbf1~3, OS_FILTER_LOW_DELAY : 低遅延 iir1~3
+// 切替後はフォーマット更新と同じ手順(dsp_reset(), os_split_select(), os_split_set())で再設定すること
+// OVERSAMPLER_TYPE = 1 (pfir) は直線位相のみ
+void os_filter_set(uint filter){
+#if (OVERSAMPLER_TYPE == 1)
+	filter = OS_FILTER_LINEAR;
+#endif
+	os_filter = (filter == OS_FILTER_LOW_DELAY) ? OS_FILTER_LOW_DELAY : OS_FILTER_LINEAR;
+}
+
+uint os_filter_get(void){
+	return os_filter;
+}
+
+// 入力fs のオーバーサンプリングフィルタの群遅延[us] (現在のフィルタ、入力fs -> 352.8/384kHz)
+// ホスト側の遅延補正用。段毎の群遅延[段の出力サンプル]の和
+//   直線位相 : ITAP_N (全周波数で一定)
+//   低遅延   : τ0 + τ1 + 1/2 (DC の値, τp = Σ (1 - a) / (1 + a) は Ap の DC群遅延[段の入力サンプル])
+// Core1 分担(os_split)の有無によらない。pfir (OVERSAMPLER_TYPE = 1) は連結ハーフバンドと同じ
+// ASRC、Core1 の x8 補間・ΔΣ、キューの遅延は含まない
+float os_get_group_delay_us(uint fs){
+	const uint n = hbf_get_stage_n(fs);
+	const uint first = hbf_get_first_stage(fs);
+	float delay = 0;
+	for(uint i = 0; i < n; i++){
+		const uint s = first + i;
+		float d = (float)hbf_spec[s].itap_n;
+		if (os_filter == OS_FILTER_LOW_DELAY) {
+			d = 0.5f;
+			for(uint j = 0; j < iir_spec[s].a_n; j++){
+				const float a = (float)iir_spec[s].a[j] / (1 << IIR_A_BIT);
+				d += (1.0f - a) / (1.0f + a);
+			}
+		}
+		delay += d * 1e6f / (float)(fs << (i + 1));
+	}
+	return delay;
+}
+
+// 分担段数の設定 (Core0 フォーマット更新時) 戻り値はキュースロットのタグ (queue_set_tag())
+// 低遅延フィルタは Core1版を持たないため分担なしとする
+uint32_t os_split_set(uint fs, uint split){
+	static uint seq = 0;
+	const uint n = hbf_get_stage_n(fs);
+#if (OVERSAMPLER_TYPE == 1)
+	split = 0;
+#endif
+	if (os_filter == OS_FILTER_LOW_DELAY) split = 0;
+	if (split > OS_SPLIT_MAX) split = OS_SPLIT_MAX;
+	if (split > n) split = n;
+	os_split = split;
+	seq++;
+	return OS_SPLIT_TAG(split, hbf_get_first_stage(fs) + n - split, seq);
+}
+
+uint os_split_get(void){
+	return os_split;
+}
+
+// タグの分担段数
+uint os_split_get_tag_split(uint32_t tag){
+	return OS_SPLIT_TAG_SPLIT(tag);
+}
+
+// Core1 後段オーバーサンプリング
+// p_i(キュースロット) *p_len サンプルを tag の分担段数だけ x2 し、p_o (*p_len << split サンプル) へ出力する
+// 中間段は p_o の後方に置き、前方へ倍長で上書きしていく (dsp_buf と同様、未処理の入力を上書きしない)
+static uint32_t os_core1_tag = 0;	// Core1 が最後に処理したタグ
+
+// Core1版 hbf1~3 の遅延データ列リセット
+static void hbf_core1_reset(void){
+	int32_t null_buf[2];
+	for(uint i = 0; i < HBF_STAGE_N; i++){
+		uint null_len = 0;
+		hbf_x2_core1[i](null_buf, null_buf, &null_len);
+	}
+}
+
+void hbf_oversampler_core1(int32_t* p_i, int32_t* p_o, uint* p_len, uint32_t tag){
+	const uint split = OS_SPLIT_TAG_SPLIT(tag);
+	const uint first = OS_SPLIT_TAG_FIRST(tag);
+	if (tag != os_core1_tag) {	// 分担変更・フォーマット更新 後段の遅延データ列をリセット
+		hbf_core1_reset();
+		os_core1_tag = tag;
+	}
+	const uint len_o = *p_len << split;
+	for(uint i = 0; i < split; i++){
+		int32_t* p = (i == split - 1) ? p_o : &p_o[(len_o - (*p_len << 1)) * N_CH];
+		hbf_x2_core1[first + i](p_i, p, p_len);
+		p_i = p;
+	}
+}
+
+// 分担 split の各コア負荷[cycle/入力サンプル]
+void os_split_load(uint fs, uint split, const os_cost_t* cost, uint* p_load0, uint* p_load1){
+	const uint n = hbf_get_stage_n(fs);
+	if (split > n) split = n;
+	const uint n0 = n - split;
+	const uint first = hbf_get_first_stage(fs);
+	uint load0 = cost->volume + (cost->asrc << n0);
+	uint load1 = cost->pcm2pwm << n;
+	for(uint i = 0; i < n0; i++) load0 += cost->hbf[first + i][0] << i;
+	for(uint i = n0; i < n; i++) load1 += cost->hbf[first + i][1] << i;
+	*p_load0 = load0;
+	*p_load1 = load1;
+}
+
+// 分担段数の選択 : 負荷の高いコアの負荷が最小となる分担 (同値の場合は分担段数の少ない方)
+uint os_split_select(uint fs, const os_cost_t* cost){
+	uint best = 0;
+#if (OVERSAMPLER_TYPE == 0)
+	if (os_filter == OS_FILTER_LOW_DELAY) return 0;	// 低遅延フィルタは分担なし
+	const uint n = hbf_get_stage_n(fs);
+	uint best_load = UINT32_MAX;
+	for(uint split = 0; (split <= OS_SPLIT_MAX) && (split <= n); split++){
+		uint load0, load1;
+		os_split_load(fs, split, cost, &load0, &load1);
+		const uint load = (load0 > load1) ? load0 : load1;
+		if (load < best_load) {
+			best = split;
+			best_load = load;
+		}
+	}
+#endif
+	return best;
+}
+
+
+
+/* ASRC (Asynchronous Sampling Rate Converter)
+ 入力データ列を pitch (10.22固定小数点, 入力サンプル数/出力サンプル) 刻みでリサンプリングする。
+ 補間カーネルは ASRC_TYPE で選択する。各カーネルは個別の関数としても公開し、host/asrc_bench で比較する。
+   0 : 直線補間       2点。interp0 blendモード、αは asrc_pos小数部の上位8bit (従来方式)
+   1 : 3次Lagrange    4点。Farrow構造の係数多項式を出力フレーム毎に1回評価し、L/Rで共用する
+   2 : 窓付きsinc     ASRC_SINC_TAP_N点。ポリフェーズ係数表の隣接位相間を直線補間して係数を求める
+ カーネル1,2 の積和は pfir と同様に入力データを上位/下位に分割し、32bit幅で行う(64bit積和を避ける)。
+ 過去データ(タップ数-1サンプル分)は asrc_hist に保持し、処理前に入力バッファ先頭の手前へ書き戻す。
+ このため入力バッファの手前 ASRC_OVERLAP ワードは作業領域として書き換えられる。
+ pitch は入出力fsの比であり処理レートに依存しないため、カーネル自体は hbf_oversampler の前段(入力fs)でも動作する。
+ ASRC は Core0 のオーバーサンプリング最終段の出力、すなわちキューのfs (352.8/384kHz >> os_split) で実行する。
+ 分担なしは 352.8/384kHz段、分担時は 176.4/192kHz段(split = 1)・88.2/96kHz段(split = 2) となり、処理量は 1/2^split に減る。
+ ASRCで増える1サンプルはキューのfsの1サンプルで、スロット幅(QUEUE_SLOT_WIDTH : 最大サンプル数 x8 +1)に収まる。
+ Core1 の後段分担はこれを 2^split サンプルに展開するが、スロットから PDM_FEED_N >> split サンプル毎に読み出して
+ PWM変換へ渡すため、キュー幅(QUEUE_WIDTH)の制約を受けない。
+ 入力fs(hbf の前段)で実行すると、増えた1サンプルが Core0 の残り段で x2^n0 されスロット幅を超え得るため行わない。
+ 選定結果 (host/asrc_bench, pitch +460ppm, -6dBFS, 分担なし)
+   384kHz段 直線補間 : 32cycle/frame  5.9%  イメージ -48dBc@20kHz
+   384kHz段 3次      : 170cycle/frame 31%   イメージ -82dBc@20kHz, -101dBc@10kHz  <- 採用
+   384kHz段 sinc32   : 1188cycle/frame 218% (処理不可)
+   48kHz段  sinc32   : 1188cycle/frame 27%  イメージ -76dBc@20kHz, -87dBc@10kHz (係数16bit量子化で -90dBc 程度が下限)
+*/
+#define ASRC_TYPE		1	// 0:直線補間 1:3次Lagrange 2:窓付きsinc
+
 #define	ASRC_FRAC_BIT	22
-#define ASRC_ALPHA_BIT	 8
+#define ASRC_ALPHA_BIT	 8						// 直線補間 αビット長 (interp0 blend)
+#define ASRC_MU_BIT		14						// 3次Lagrange 位相μビット長
+#define ASRC_COEF_BIT	PFIR_COEF_BIT			// 補間係数ビット長 (pfir と同じ上位/下位分割積和を使う)
+#define ASRC_SINC_PHASE_BIT	6					// 窓付きsinc 係数表の位相数 2^6
+#define ASRC_SINC_PHASE_N	(1 << ASRC_SINC_PHASE_BIT)
+#define ASRC_SINC_SUB_BIT	14					// 窓付きsinc 位相間補間ビット長
+#define ASRC_SINC_CUTOFF	1.0					// 窓付きsinc 遮断周波数 (入力ナイキスト周波数比)
+#define ASRC_SINC_BETA		8.5					// 窓付きsinc Kaiser窓 β
 
 // ASRCのリサンプリング位置とバッファ
+// 出力先は呼出し側が与える(キュースロット QUEUE_SLOT_WIDTH ワード、入力サンプル数+1まで出力する)
 static uint32_t	asrc_pos = 0;
-static int32_t asrc_buf[QUEUE_WIDTH + 2];
+static int32_t CORE0_HOT("asrc") asrc_hist[ASRC_OVERLAP];					// 過去データ L,R,,
+static int32_t asrc_sinc_k[ASRC_SINC_PHASE_N + 1][ASRC_SINC_TAP_N];	// 窓付きsinc 位相毎の係数 (+1 : 位相間補間用)
 
-/**
- * ASRC処理
- * ASRC:Asynchronous Sampling Rate Converter
- * fpn_delta : 10.22 整数部10bit、小数部22bit
- */
-void asrc(int32_t** buf, uint* p_len, uint32_t pitch)
+// 0次第1種変形ベッセル関数 (Kaiser窓用)
+static double bessel_i0(double x){
+	double sum = 1.0, t = 1.0;
+	for(uint k = 1; k < 32; k++){
+		t *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += t;
+	}
+	return sum;
+}
+
+// 窓付きsinc 係数表生成
+// 位相p の補間点はタップ ASRC_SINC_TAP_N/2-1 から p/ASRC_SINC_PHASE_N 後方。位相毎にDCゲインを 1<<ASRC_COEF_BIT に補正する
+static void asrc_init(void){
+	const double half = ASRC_SINC_TAP_N / 2;
+	for(uint p = 0; p <= ASRC_SINC_PHASE_N; p++){
+		int32_t sum = 0;
+		uint k_max = 0;
+		for(uint k = 0; k < ASRC_SINC_TAP_N; k++){
+			double t = (double)k - (half - 1) - (double)p / ASRC_SINC_PHASE_N;
+			double x = M_PI * ASRC_SINC_CUTOFF * t;
+			double h = (t == 0) ? ASRC_SINC_CUTOFF : ASRC_SINC_CUTOFF * sin(x) / x;
+			double r = t / half;
+			h *= (fabs(r) < 1.0) ? bessel_i0(ASRC_SINC_BETA * sqrt(1.0 - r * r)) / bessel_i0(ASRC_SINC_BETA) : 0.0;
+			asrc_sinc_k[p][k] = (int32_t)lround(h * (1 << ASRC_COEF_BIT));
+			sum += asrc_sinc_k[p][k];
+			if (abs(asrc_sinc_k[p][k]) > abs(asrc_sinc_k[p][k_max])) k_max = k;
+		}
+		asrc_sinc_k[p][k_max] += (1 << ASRC_COEF_BIT) - sum;		// DCゲイン補正
+	}
+}
+
+// 3次Lagrange補間係数 w[0~3] (Farrow構造の係数多項式) frac : asrc_pos小数部
+// 補間点は w[1](x0) と w[2](x1) の間、μ = frac
+//  w[0] = -μ(μ-1)(μ-2)/6, w[1] = (μ+1)(μ-1)(μ-2)/2, w[2] = -(μ+1)μ(μ-2)/2, w[3] = (μ+1)μ(μ-1)/6
+static inline __attribute__((always_inline)) void asrc_cubic_coef(uint32_t frac, int32_t* w){
+	const int32_t one = 1 << ASRC_MU_BIT;
+	const int32_t div6 = 65536 / 6;										// 1/6 (16bit)
+	const int32_t m = frac >> (ASRC_FRAC_BIT - ASRC_MU_BIT);
+	const int32_t a = (m * (m - one)) >> ASRC_MU_BIT;					// μ(μ-1)      |a| ≦ 2^12
+	const int32_t b = ((m + one) * (m - 2 * one)) >> ASRC_MU_BIT;		// (μ+1)(μ-2)  |b| ≦ 2.25*2^14
+	const uint sh = ASRC_COEF_BIT - ASRC_MU_BIT;
+	w[0] = -(((a * (m - 2 * one)) >> ASRC_MU_BIT) * div6 >> 16) << sh;
+	w[3] =  (((a * (m + one    )) >> ASRC_MU_BIT) * div6 >> 16) << sh;
+	if (m < one / 2) {													// DCゲイン補正 (絶対値の大きい係数で吸収)
+		w[2] = -(((b * m) >> ASRC_MU_BIT) >> 1) << sh;
+		w[1] = (1 << ASRC_COEF_BIT) - w[0] - w[2] - w[3];
+	} else {
+		w[1] =  (((b * (m - one)) >> ASRC_MU_BIT) >> 1) << sh;
+		w[2] = (1 << ASRC_COEF_BIT) - w[0] - w[1] - w[3];
+	}
+}
+
+// 窓付きsinc補間係数 w[0~ASRC_SINC_TAP_N-1] frac : asrc_pos小数部
+static inline __attribute__((always_inline)) void asrc_sinc_coef(uint32_t frac, int32_t* w){
+	const uint p = frac >> (ASRC_FRAC_BIT - ASRC_SINC_PHASE_BIT);
+	const int32_t s = (frac >> (ASRC_FRAC_BIT - ASRC_SINC_PHASE_BIT - ASRC_SINC_SUB_BIT)) & ((1 << ASRC_SINC_SUB_BIT) - 1);
+	const int32_t* k0 = asrc_sinc_k[p];
+	const int32_t* k1 = asrc_sinc_k[p + 1];
+	for(uint k = 0; k < ASRC_SINC_TAP_N; k++){
+		w[k] = k0[k] + (((k1[k] - k0[k]) * s) >> ASRC_SINC_SUB_BIT);
+	}
+}
+
+// 補間係数 w と入力データ列 p_i (L/Rインタリーブ) の積和
+// |Σw| ≦ 1.5*2^16, |x| < 2^24.5 より、上位(x>>12)/下位(x&0xfff)の各積和は 2^31 未満に収まる
+static inline __attribute__((always_inline)) int32_t asrc_mac(const int32_t* w, const int32_t* p_i, uint tap_n){
+	int32_t ah = 0;
+	int32_t al = 0;
+	#pragma GCC unroll 4
+	for(uint k = 0; k < tap_n; k++){
+		int32_t x = p_i[k * N_CH];
+		ah += w[k] * (x >> PFIR_DATA_SPLIT);
+		al += w[k] * (x & ((1 << PFIR_DATA_SPLIT) - 1));
+	}
+	return clamp(pfir_round(ah, al));
+}
+
+// ASRC共通処理 type : ASRC_TYPE, tap_n : カーネルのタップ数
+static inline __attribute__((always_inline)) void asrc_run(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out, uint type, uint tap_n)
 {
 	uint len_i = *p_len;	// ASRC入力データ数
 	uint len_o = 0;			// ASRC出力データ数
-	int32_t* p_i = *buf;		// ASRC入力ポインタ
-	int32_t* p_o = asrc_buf; 	// ASRC出力ポインタ
+	int32_t* p_o = p_out; 	// ASRC出力ポインタ
+	int32_t* const p_top = *buf - (tap_n - 1) * N_CH;	// 過去データを含む入力データ列の先頭
+	int32_t w[ASRC_SINC_TAP_N];
 
-	*buf -= 2;	// ASRC用にBUF先頭をオーバーラップ領域に移動
+	// 過去データを入力バッファ手前のオーバーラップ領域に書き戻す
+	for(uint c = 0; c < ASRC_OVERLAP; c++) (*buf)[(int)c - ASRC_OVERLAP] = asrc_hist[c];
 
 	// asrc_pos整数部が入力サンプル数未満の場合、処理繰り返し
 	while((asrc_pos >> ASRC_FRAC_BIT) < len_i) {
 		// ASRCリサンプリング位置計算
-		p_i = *buf + 2*(asrc_pos >> ASRC_FRAC_BIT);
+		const int32_t* p_i = p_top + N_CH * (asrc_pos >> ASRC_FRAC_BIT);
+		const uint32_t frac = asrc_pos & ((1 << ASRC_FRAC_BIT) - 1);
 
-		// asrc_posの小数部上位8bitをαブレンド値とする
-		interp0->accum[1]
-			= (asrc_pos >> (ASRC_FRAC_BIT - ASRC_ALPHA_BIT))&0xff;
+		if (type == 0) {
+			// asrc_posの小数部上位8bitをαブレンド値とする
+			interp0->accum[1] = frac >> (ASRC_FRAC_BIT - ASRC_ALPHA_BIT);
 
-		// Ch0処理 入力データ2点間のαブレンド値をバッファに出力 
-		interp0->base[0] = p_i[0];	// データb0
-		interp0->base[1] = p_i[2];	// データb1
-		*p_o++ =interp0->peek[1];	// (1-α)*b0 +α*b1
+			// Ch0処理 入力データ2点間のαブレンド値をバッファに出力
+			interp0->base[0] = p_i[0];	// データb0
+			interp0->base[1] = p_i[2];	// データb1
+			*p_o++ =interp_peek_lane_result(interp0, 1);	// (1-α)*b0 +α*b1
 
-		// Ch1処理 入力データ2点間のαブレンド値をバッファに出力 
-		interp0->base[0] = p_i[1];	// データb0
-		interp0->base[1] = p_i[3];	// データb1
-		*p_o++ =interp0->peek[1];	// (1-α)*b0 +α*b1
+			// Ch1処理 入力データ2点間のαブレンド値をバッファに出力
+			interp0->base[0] = p_i[1];	// データb0
+			interp0->base[1] = p_i[3];	// データb1
+			*p_o++ =interp_peek_lane_result(interp0, 1);	// (1-α)*b0 +α*b1
+		} else {
+			// 補間係数はL/R共通
+			if (type == 1)	asrc_cubic_coef(frac, w);
+			else			asrc_sinc_coef(frac, w);
+			*p_o++ = asrc_mac(w, &p_i[0], tap_n);
+			*p_o++ = asrc_mac(w, &p_i[1], tap_n);
+		}
 
 		len_o ++;			// ASRCデータ数更新
 		asrc_pos += pitch;	// ASRCポジション更新
@@ -461,31 +1252,263 @@ void asrc(int32_t** buf, uint* p_len, uint32_t pitch)
 	// 次回ASRCポジションを更新 処理済みのデータ長分を減算
 	asrc_pos -= (len_i << ASRC_FRAC_BIT);
 
-	// 
-	p_i = *buf;
-	p_i[0] = p_i[len_i * 2];
-	p_i[1] = p_i[len_i * 2 + 1];
+	// 入力データ列の末尾を次回の過去データとして保存 (len_i が短い場合も書き戻した過去データから連続する)
+	for(uint c = 0; c < ASRC_OVERLAP; c++) asrc_hist[c] = (*buf)[(int)(len_i * N_CH + c) - ASRC_OVERLAP];
 
 	// ASRCにより変化したデータ長とバッファポインタを返却
 	*p_len = len_o;
-	*buf = asrc_buf;
+	*buf = p_out;
+}
+
+// 各カーネル
+// buf : 入力データ列 (手前 ASRC_OVERLAP ワードは作業領域), pitch : 10.22 整数部10bit、小数部22bit, p_out : 出力先
+void asrc_linear(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out){ asrc_run(buf, p_len, pitch, p_out, 0, 2); }
+void asrc_cubic (int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out){ asrc_run(buf, p_len, pitch, p_out, 1, 4); }
+void asrc_sinc  (int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out){ asrc_run(buf, p_len, pitch, p_out, 2, ASRC_SINC_TAP_N); }
+
+/**
+ * ASRC処理
+ * ASRC:Asynchronous Sampling Rate Converter
+ * fpn_delta : 10.22 整数部10bit、小数部22bit
+ */
+void asrc(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out)
+{
+	PROF_BEGIN(PROF_ASRC);
+#if   (ASRC_TYPE == 2)
+	asrc_sinc(buf, p_len, pitch, p_out);
+#elif (ASRC_TYPE == 1)
+	asrc_cubic(buf, p_len, pitch, p_out);
+#else
+	asrc_linear(buf, p_len, pitch, p_out);
+#endif
+	PROF_END(PROF_ASRC);
+}
+
+// 選択中のASRCカーネル (ASRC_TYPE, タップ数) ベンチマーク・サイクル見積もり用
+void asrc_get_kernel(uint* p_type, uint* p_tap_n){
+	static const uint tap_n[3] = {2, 4, ASRC_SINC_TAP_N};
+	*p_type  = ASRC_TYPE;
+	*p_tap_n = tap_n[ASRC_TYPE];
 }
 
 void asrc_reset(void){
-	// asrc用オーバーラップ領域のクリア
-	dsp_buf_top[0] = 0;
-	dsp_buf_top[1] = 0;
+	// asrc用過去データのクリア
+	for(uint c = 0; c < ASRC_OVERLAP; c++) asrc_hist[c] = 0;
 	// asrcポジションのクリア
 	asrc_pos = 0;
 }
 
+/* DoP (DSD over PCM, DoP Open Standard 1.1) 入力
+ 176.4/192kHz (DSD64) または 352.8/384kHz (DSD128) の24bit PCMスロットで運ばれる DSDを検出し、
+ 連結ハーフバンド(hbf_oversampler)の代わりに FIR デシメーションで 352.8/384kHz の PCMへ変換する。
+ Core1 (後段x8・ΔΣ・PWM) は PCM入力と同じ処理となる。
+ スロット構成 (1ch, 24bit右詰め) : bit 23~16 マーカー 0x05/0xFA (フレーム毎に交互、L/R同一), bit 15~8 先のDSDバイト, bit 7~0 後のDSDバイト
+ (DSDバイトは MSB が時間的に先)
+ 検出 : マーカーが DOP_LOCK_N フレーム連続して正しい場合に DoPとする (PCMでは交互のマーカーは連続しない)。
+   ロック前の候補区間、および DoP中にマーカーが途切れたパケットはミュートする (DoPを PCMとして再生した雑音を出さない)
+ FIR : Kaiser窓 (β = DSD_FIR_BETA) 付き sinc、遮断周波数は出力ナイキスト周波数 (DSD_FIR_CUTOFF)。
+   1bit入力の積和はバイト単位の表引き (8タップ分の ±h の和) とし、係数の対称性から表は前半のみ持つ。
+   後半のバイト j はビット反転したバイトを前半の表 K-1-j で引く。
+       DSD64  : x1/8  48タップ (6バイト)  入力1フレーム当たり 2出力
+       DSD128 : x1/16 96タップ (12バイト) 入力1フレーム当たり 1出力
+   DCゲインは 1<<23 (DSD ±1 = 24bit フルスケール、SACD 0dB (変調度50%) は -6dBFS となる)
+ 音量処理は行わない (ビットパーフェクト入力のため)。
+*/
+#define DOP_MARKER_0	0x05
+#define DOP_MARKER_1	0xFA
+#define DOP_LOCK_N		32							// DoP 判定に必要な連続フレーム数
+#define DSD_FIR_BETA	7.0							// Kaiser窓 β (阻止域 -70dB 程度)
+#define DSD_FIR_CUTOFF	1.0							// 遮断周波数 (出力ナイキスト周波数比)
+#define DSD64_BYTE_N	6							// DSD64  FIR長 [byte] (x8 タップ)
+#define DSD128_BYTE_N	12							// DSD128 FIR長 [byte]
+#define DSD_BYTE_MAX	DSD128_BYTE_N
+#define DSD_SILENCE		0x69						// DSD無音パターン
+
+static int32_t dsd_lut64[DSD64_BYTE_N / 2][256];		// DSD64  バイト表 (前半)
+static int32_t dsd_lut128[DSD128_BYTE_N / 2][256];		// DSD128 バイト表 (前半)
+static uint8_t dsd_rev[256];							// ビット反転
+static uint8_t CORE0_HOT("dop") dsd_z[N_CH][DSD_BYTE_MAX * 2];	// 遅延データ列 2重化してリング処理を省略
+static uint dsd_t = 0;									// 遅延データ列の書込み位置
+static uint dop_lock_n = 0;								// マーカー連続フレーム数
+static uint8_t dop_marker = 0;							// 直前フレームのマーカー
+static bool dop_on = false;
+
+// バイト表生成 byte_n : FIR長[byte], lut : 前半 byte_n/2 バイト分
+// dec : デシメーション比 係数 h[n] (n = 0 が最も古いビット) を DCゲイン 1<<23 に正規化する
+static void dsd_lut_init(int32_t (*lut)[256], uint byte_n, uint dec){
+	const uint tap_n = byte_n * 8;
+	const double half = tap_n / 2.0;
+	const double fc = DSD_FIR_CUTOFF * 0.5 / dec;		// [入力fs]
+	double h[DSD_BYTE_MAX * 8];
+	double sum = 0.0;
+	for(uint n = 0; n < tap_n; n++){
+		double t = (double)n - (half - 0.5);
+		double x = 2.0 * M_PI * fc * t;
+		double r = t / half;
+		h[n] = sin(x) / x * bessel_i0(DSD_FIR_BETA * sqrt(1.0 - r * r)) / bessel_i0(DSD_FIR_BETA);
+		sum += h[n];
+	}
+	for(uint j = 0; j < byte_n / 2; j++){
+		for(uint b = 0; b < 256; b++){
+			double a = 0.0;
+			for(uint i = 0; i < 8; i++) a += ((b >> (7 - i)) & 1) ? h[8 * j + i] : -h[8 * j + i];
+			lut[j][b] = (int32_t)lround(a / sum * (1 << 23));
+		}
+	}
+}
+
+static void dop_init(void){
+	for(uint b = 0; b < 256; b++){
+		uint r = 0;
+		for(uint i = 0; i < 8; i++) r |= ((b >> i) & 1) << (7 - i);
+		dsd_rev[b] = (uint8_t)r;
+	}
+	dsd_lut_init(dsd_lut64, DSD64_BYTE_N, 8);
+	dsd_lut_init(dsd_lut128, DSD128_BYTE_N, 16);
+}
+
+// DoP 判定 (パケット毎、入力fsの受信バッファ) 戻り値 DOP_PCM / DOP_DSD / DOP_MUTE
+// DoP を運べない fs (DSD64 未満) は常に DOP_PCM
+uint dop_detect(const int32_t* buf, uint len, uint fs){
+	bool valid = (get_osr(fs) >= 4) && (len != 0);
+	for(uint i = 0; i < len && valid; i++){
+		const uint8_t m = (uint8_t)(buf[i * N_CH] >> 16);
+		valid = (m == (uint8_t)(buf[i * N_CH + 1] >> 16))
+			&& (m == DOP_MARKER_0 || m == DOP_MARKER_1)
+			&& (dop_lock_n == 0 || m != dop_marker);
+		dop_marker = m;
+		dop_lock_n++;
+	}
+	uint r;
+	if (!valid) {
+		r = dop_on ? DOP_MUTE : DOP_PCM;
+		dop_lock_n = 0;
+		dop_on = false;
+	} else {
+		if (dop_lock_n >= DOP_LOCK_N) {
+			dop_lock_n = DOP_LOCK_N;
+			dop_on = true;
+		}
+		r = dop_on ? DOP_DSD : DOP_MUTE;
+	}
+	return r;
+}
+
+// DoP 判定状態のリセット (フォーマット更新時)
+void dop_detect_reset(void){
+	dop_lock_n = 0;
+	dop_on = false;
+}
+
+// FIR 1出力 (1ch) w : 遅延データ列の窓 (古い順 byte_n バイト)
+static inline __attribute__((always_inline)) int32_t dsd_fir(const uint8_t* w, const int32_t (*lut)[256], uint byte_n){
+	int32_t acc = 0;
+	#pragma GCC unroll 6
+	for(uint j = 0; j < byte_n / 2; j++){
+		acc += lut[j][w[j]] + lut[j][dsd_rev[w[byte_n - 1 - j]]];
+	}
+	return clamp(acc);
+}
+
+// 遅延データ列へ1バイト追加 (L/R) 戻り値は追加後の窓の先頭位置
+static inline __attribute__((always_inline)) uint dsd_push(uint t, uint byte_n, uint8_t l, uint8_t r){
+	dsd_z[0][t] = dsd_z[0][t + byte_n] = l;
+	dsd_z[1][t] = dsd_z[1][t + byte_n] = r;
+	return (t + 1 >= byte_n) ? 0 : t + 1;
+}
+
+/**
+ * DoP デシメーション (hbf_oversampler() の代替)
+ * buf : 入力(fs)の受信バッファ, p_out : 出力先 (352.8/384kHz)
+ * DSD64 は入力1フレーム当たり2出力のため、p_out は後続の入力と重ならないこと (dsp_buf の配置では成立する)
+ * DSD128 は p_out = 入力 でもよい
+ */
+void dop_decimator(int32_t** buf, uint* p_len, uint fs, int32_t* p_out){
+	PROF_BEGIN(PROF_DOP);
+	const int32_t* p_i = *buf;
+	int32_t* p_o = p_out;
+	const uint len = *p_len;
+	uint t = dsd_t;
+	if (get_osr(fs) >= 8) {
+		for(uint i = 0; i < len; i++){
+			const int32_t l = p_i[0], r = p_i[1];
+			t = dsd_push(t, DSD128_BYTE_N, (uint8_t)(l >> 8), (uint8_t)(r >> 8));
+			t = dsd_push(t, DSD128_BYTE_N, (uint8_t)l, (uint8_t)r);
+			p_o[0] = dsd_fir(&dsd_z[0][t], dsd_lut128, DSD128_BYTE_N);
+			p_o[1] = dsd_fir(&dsd_z[1][t], dsd_lut128, DSD128_BYTE_N);
+			p_i += N_CH;
+			p_o += N_CH;
+		}
+		*p_len = len;
+	} else {
+		for(uint i = 0; i < len; i++){
+			const int32_t l = p_i[0], r = p_i[1];
+			t = dsd_push(t, DSD64_BYTE_N, (uint8_t)(l >> 8), (uint8_t)(r >> 8));
+			p_o[0] = dsd_fir(&dsd_z[0][t], dsd_lut64, DSD64_BYTE_N);
+			p_o[1] = dsd_fir(&dsd_z[1][t], dsd_lut64, DSD64_BYTE_N);
+			t = dsd_push(t, DSD64_BYTE_N, (uint8_t)l, (uint8_t)r);
+			p_o[2] = dsd_fir(&dsd_z[0][t], dsd_lut64, DSD64_BYTE_N);
+			p_o[3] = dsd_fir(&dsd_z[1][t], dsd_lut64, DSD64_BYTE_N);
+			p_i += N_CH;
+			p_o += N_CH * 2;
+		}
+		*p_len = len * 2;
+	}
+	dsd_t = t;
+	*buf = p_out;
+	PROF_END(PROF_DOP);
+}
+
+// 遅延データ列を DSD無音で初期化 (DSD64/DSD128 の切替時もここを通る)
+void dop_reset(void){
+	for(uint c = 0; c < N_CH; c++){
+		for(uint k = 0; k < DSD_BYTE_MAX * 2; k++) dsd_z[c][k] = DSD_SILENCE;
+	}
+	dsd_t = 0;
+}
+
 void dsp_reset(void){
 	hbf_oversampler_reset();
 	asrc_reset();
+	dop_reset();
 }
 
 void dsp_init(void){
 	interp1_hw_clamp_init();
 	interp0_blender_init();
+	pfir_init();
+	asrc_init();
+	dop_init();
 	dsp_reset();
-}
\ No newline at end of file
+}
+
+// 段毎の処理サイクル計測 (起動時 Core0、prof_init_core() 後)
+// 無音データで hbf1~3 (Core0版/Core1版), hbf1 音量処理統合版, asrc を OS_CAL_N サンプル処理し、1サンプル当たりの計時値を cost に格納する
+// 実機は SysTick のサイクル数、ホストは ns となる (tick_now(), PROF_ENABLE によらない)。計測後は各処理の状態をリセットする
+#define OS_CAL_N	48
+void os_split_calibrate(os_cost_t* cost){
+	static int32_t cal_buf[OS_CAL_N * N_CH * 4];
+	int32_t* p_i = &cal_buf[OS_CAL_N * N_CH * 2];	// 後半を入力、前半を出力とする
+	for(uint c = 0; c < OS_CAL_N * N_CH * 4; c++) cal_buf[c] = 0;
+	for(uint i = 0; i < HBF_STAGE_N; i++){
+		for(uint core = 0; core < 2; core++){
+			uint len = OS_CAL_N;
+			uint32_t t = tick_now();
+			((core == 0) ? hbf_x2_core0 : hbf_x2_core1)[i](p_i, cal_buf, &len);
+			cost->hbf[i][core] = ((tick_now() - t) & TICK_MASK) / OS_CAL_N;
+		}
+	}
+	// 音量処理 : hbf1 音量処理統合版と hbf1 の差
+	uint len = OS_CAL_N;
+	uint32_t t = tick_now();
+	hbf1_x2_oversampler_vol(p_i, cal_buf, &len);
+	const uint cyc_vol = ((tick_now() - t) & TICK_MASK) / OS_CAL_N;
+	cost->volume = (cyc_vol > cost->hbf[0][0]) ? cyc_vol - cost->hbf[0][0] : 0;
+	int32_t* buf = p_i;
+	len = OS_CAL_N;
+	t = tick_now();
+	asrc(&buf, &len, 1u << ASRC_FRAC_BIT, cal_buf);
+	cost->asrc = ((tick_now() - t) & TICK_MASK) / OS_CAL_N;
+	dsp_reset();
+	hbf_core1_reset();
+}
@@ -1,14 +1,84 @@
 #ifndef _DSP_H_
 #define _DSP_H_
 
+#define HBF_STAGE_N		3		// 連結ハーフバンド段数 (hbf1~3)
+#define OS_SPLIT_MAX	2		// Core1 が分担できる後段数
+#define VOLUME_RAMP_MS	5		// 音量変更のランプ時間[ms] (volume_set())
+#define HBF_STREAM_CHUNK_N	8	// 縦型ストリーミング連結の処理単位[入力サンプル] (hbf_stream_oversampler())
+
+// dop_detect() の判定結果
+#define DOP_PCM		0		// PCM
+#define DOP_DSD		1		// DoP (dop_decimator() で処理する)
+#define DOP_MUTE	2		// DoP ロック前・DoP 途切れ (パケットをミュートし PCMとして処理する)
+
+// オーバーサンプリングフィルタ (os_filter_set())
+#define OS_FILTER_LINEAR	0	// 直線位相 連結ハーフバンド hbf1~3 (既定)
+#define OS_FILTER_LOW_DELAY	1	// 低遅延 ポリフェーズ全域通過型ハーフバンドIIR iir1~3 (Core1 分担なし)
+
+// Core0/Core1 分担選択用の処理サイクル (os_split_calibrate() の計測値、またはサイクル見積もり)
+typedef struct {
+	uint	hbf[HBF_STAGE_N][2];	// hbf1~3 [段][0:Core0版 1:Core1版] 1入力サンプル(L/R)当たり
+	uint	volume;					// 初段の音量処理 1サンプル当たり (Core0, 入力fs)
+	uint	asrc;					// asrc() 1出力サンプル当たり (Core0, キューのfs)
+	uint	pcm2pwm;				// Core1 PWM変換・PIO供給 1サンプル当たり (352.8/384kHz)
+} os_cost_t;
+
 bool get_group_48k(uint fs);
 uint get_osr(uint fs);
 float get_true_playback_fs(uint fs);
+void hbf1_x2_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf2_x2_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf3_x2_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf1_x2_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf2_x2_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf3_x2_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf1_x2_oversampler_core1(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf2_x2_oversampler_core1(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf3_x2_oversampler_core1(int32_t *p_i, int32_t *p_o, uint *p_len);
+void hbf_stream_oversampler(int32_t* p_i, int32_t* p_o, uint* p_len, uint first, uint n, bool use_vol);
+void hbf_get_mac_n(uint stage, uint* p_mac32_n, uint* p_mac64_n);
+void iir1_x2_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len);
+void iir2_x2_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len);
+void iir3_x2_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len);
+void iir1_x2_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len);
+void iir2_x2_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len);
+void iir3_x2_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len);
+uint iir_get_a_n(uint stage);
+void pfir_init(void);
+uint pfir_get_tap_n(uint l);
+void pfir_oversampler(int32_t *p_i, int32_t *p_o, uint *p_len, uint l);
+void pfir_oversampler_vol(int32_t *p_i, int32_t *p_o, uint *p_len, uint l);
 void volume(int32_t* buf, uint32_t sample_num, int32_t mul, uint shift);
+void volume_reset(int32_t mul, uint shift);
+void volume_set(int32_t mul, uint shift, uint ramp_n);
+void volume_set_ramp_type(uint type);
+bool volume_is_unity(void);
 void hbf_oversampler_reset(void);
-void hbf_oversampler(int32_t** buf, uint *p_len, uint fs);
+void hbf_oversampler(int32_t** buf, uint *p_len, uint fs, int32_t* p_out);
+uint hbf_get_stage_n(uint fs);
+uint hbf_get_first_stage(uint fs);
+void os_filter_set(uint filter);
+uint os_filter_get(void);
+float os_get_group_delay_us(uint fs);
+uint32_t os_split_set(uint fs, uint split);
+uint os_split_get(void);
+uint os_split_get_tag_split(uint32_t tag);
+void hbf_oversampler_core1(int32_t* p_i, int32_t* p_o, uint* p_len, uint32_t tag);
+void os_split_load(uint fs, uint split, const os_cost_t* cost, uint* p_load0, uint* p_load1);
+uint os_split_select(uint fs, const os_cost_t* cost);
+void os_split_calibrate(os_cost_t* cost);
 int32_t* get_dsp_buf_pointer(uint fs);
-void asrc(int32_t** buf, uint* p_len, uint32_t pitch);
+void dsp_buf_advance(uint fs, uint offset, uint len);
+void asrc_linear(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out);
+void asrc_cubic(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out);
+void asrc_sinc(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out);
+void asrc(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out);
+void asrc_get_kernel(uint* p_type, uint* p_tap_n);
+void asrc_reset(void);
+uint dop_detect(const int32_t* buf, uint len, uint fs);
+void dop_detect_reset(void);
+void dop_decimator(int32_t** buf, uint* p_len, uint fs, int32_t* p_out);
+void dop_reset(void);
 void dsp_reset(void);
 void dsp_init(void);
 
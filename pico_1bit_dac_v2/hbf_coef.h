@@ -0,0 +1,37 @@
+/**
+ * @file hbf_coef.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 連結ハーフバンド hbf1~3 の係数表 (dsp.c)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note host/hbf_design -w で生成する。直接編集しないこと。
+ *       段毎の仕様(入力fs・通過域端・阻止域減衰量)を満たすタップ数・係数ビット長のうち Core0 見積もりサイクル最小
+ *       hbf2/hbf3 は 88.2/96kHz, 176.4/192kHz 入力時の初段を兼ねる (dsp.c HBF_FS_PROFILE)
+ *
+ *       stage  fs in   pass[kHz]  spec[dB]  taps  bit  att[dB]  MAC/out
+ *       hbf1   44100       15.0      75.0    31   12     77.2      4.0
+ *       hbf2   88200       20.0      65.0    15   10     73.5      2.0
+ *       hbf3  176400       20.0      60.0    11    6     64.9      1.5
+ */
+#ifndef _HBF_COEF_H_
+#define _HBF_COEF_H_
+
+// HBFn_TAP_N : 元のタップ数, HBFn_K_BIT_W : 係数ビット長 (係数和 = 2^bit)
+// HBFn_K     : 補間用フィルタ(φ1)の係数 偶数番はゼロのため省略、左右対称のため後半省略 (外側から)
+
+// hbf1 : 入力 44.1kHz, 通過域 15.0kHz, 阻止域 75.0dB 以上 (実現 77.2dB)
+#define HBF1_TAP_N		31
+#define HBF1_K_BIT_W	12
+#define HBF1_K			{-2, +10, -32, +81, -177, +360, -762, +2570}
+
+// hbf2 : 入力 88.2kHz, 通過域 20.0kHz, 阻止域 65.0dB 以上 (実現 73.5dB)
+#define HBF2_TAP_N		15
+#define HBF2_K_BIT_W	10
+#define HBF2_K			{-6, +38, -143, +623}
+
+// hbf3 : 入力 176.4kHz, 通過域 20.0kHz, 阻止域 60.0dB 以上 (実現 64.9dB)
+#define HBF3_TAP_N		11
+#define HBF3_K_BIT_W	6
+#define HBF3_K			{+1, -7, +38}
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file asrc_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ASRC補間カーネル比較ベンチマーク 直線補間 vs 3次Lagrange(Farrow) vs 窓付きsinc
+ * @version 0.01
+ * @date 2026-10-17
+ * @note カーネル毎・実行位置毎(hbf_oversampler後の384kHz / 前段の入力fs 48kHz)に以下を出力する。
+ *        ns/frame   : ホスト実測処理時間 (1出力フレーム L/R 当たり)
+ *        cyc/frame  : Cortex-M0+ 見積もりサイクル数 (host/cycle_model.h)
+ *        Core0[%]   : 見積もりCore0負荷 (ASRCのみ)
+ *        spur@f     : -6dBFS 正弦波 f を入力した時の、出力から正弦波成分を除いた残差レベル[dBc]
+ *                     入出力fs比が1に近いASRCでは、補間カーネルのイメージは f ± (入力fs - 出力fs) に折り返すため
+ *                     残差の大半はイメージ成分となる (イメージ除去量の指標)
+ *       ASRCピッチは I2S 48kHz 入力を DAC実再生周波数(CLK_SYS/68/64)で再生する条件 (+460ppm) とする。
+ *       usage : asrc_bench [packets]   default 200
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+#define BENCH_OVERLAP	64			// 入力バッファ手前の作業領域 [word] (ASRC_OVERLAP 以上)
+#define BENCH_SKIP		8			// 評価から除く先頭パケット数 (過去データの立ち上がり)
+#define BENCH_LEVEL		(1 << 22)	// -6dBFS
+
+typedef void (*asrc_func_t)(int32_t** buf, uint* p_len, uint32_t pitch, int32_t* p_out);
+
+typedef struct {
+	const char*	name;
+	asrc_func_t	func;
+	uint		type;				// ASRC_TYPE
+	uint		tap_n;
+} kernel_t;
+
+static const kernel_t kernel_list[] = {
+	{"linear", asrc_linear, 0,  2},
+	{"cubic",  asrc_cubic,  1,  4},
+	{"sinc",   asrc_sinc,   2, 32},
+};
+
+static const uint fs_list[] = {384000, 48000};			// ASRC実行fs (hbf_oversampler後 / 前段)
+static const double tone_list[] = {1000.0, 10000.0, 20000.0};
+
+static int32_t in_top[BENCH_OVERLAP + QUEUE_WIDTH];
+static int32_t* const in_buf = &in_top[BENCH_OVERLAP];
+static int32_t out_buf[QUEUE_SLOT_WIDTH];
+
+static uint cyc_kernel(const kernel_t* k){
+	switch(k->type){
+		case 2:  return cyc_asrc_sinc(k->tap_n);
+		case 1:  return cyc_asrc_cubic();
+		default: return cyc_asrc_linear();
+	}
+}
+
+// 3x3 連立方程式 (正規方程式) をガウス消去で解く
+static void solve3(double a[3][4], double x[3]){
+	for(int i = 0; i < 3; i++){
+		for(int j = i + 1; j < 3; j++){
+			double r = a[j][i] / a[i][i];
+			for(int k = i; k < 4; k++) a[j][k] -= r * a[i][k];
+		}
+	}
+	for(int i = 2; i >= 0; i--){
+		double s = a[i][3];
+		for(int k = i + 1; k < 3; k++) s -= a[i][k] * x[k];
+		x[i] = s / a[i][i];
+	}
+}
+
+// 1カーネル・1fs・1トーンの測定 残差レベル[dBc]を返し、処理時間を *p_ns に加算、出力フレーム数を *p_frames に加算
+static double measure(const kernel_t* k, uint fs, double tone, uint packets, uint32_t pitch, double* p_ns, double* p_frames){
+	const uint packet_len = fs / 1000;
+	const double w = 2.0 * M_PI * tone / fs;				// 入力1サンプル当たりの位相
+	const double wo = w * (double)pitch / (1 << 22);		// 出力1サンプル当たりの位相
+	double ata[3][4] = {{0}};
+	double yy = 0;
+	uint64_t phase_i = 0, m = 0;
+
+	asrc_reset();
+	for(uint p = 0; p < packets; p++){
+		for(uint i = 0; i < packet_len; i++){
+			int32_t s = (int32_t)lround(sin(w * (double)phase_i++) * BENCH_LEVEL);
+			in_buf[i * 2 + 0] = s;
+			in_buf[i * 2 + 1] = -s;
+		}
+		int32_t* buf = in_buf;
+		uint len = packet_len;
+		double t0 = now_ns();
+		k->func(&buf, &len, pitch, out_buf);
+		*p_ns += now_ns() - t0;
+		*p_frames += len;
+
+		// 出力を a*sin(wo*m) + b*cos(wo*m) + c に最小二乗フィット (Lch)
+		for(uint i = 0; i < len; i++, m++){
+			if (p < BENCH_SKIP) continue;
+			double v[3] = {sin(wo * m), cos(wo * m), 1.0};
+			double y = buf[i * 2];
+			for(int r = 0; r < 3; r++){
+				for(int c = 0; c < 3; c++) ata[r][c] += v[r] * v[c];
+				ata[r][3] += v[r] * y;
+			}
+			yy += y * y;
+		}
+	}
+	double x[3];
+	double a[3][4];
+	for(int r = 0; r < 3; r++) for(int c = 0; c < 4; c++) a[r][c] = ata[r][c];
+	solve3(a, x);
+	// 残差 = Σy^2 - Σ(フィット成分)・y, 信号 = 正弦波振幅^2/2 * サンプル数
+	double fit = x[0] * ata[0][3] + x[1] * ata[1][3] + x[2] * ata[2][3];
+	double sig = (x[0] * x[0] + x[1] * x[1]) / 2.0 * ata[2][2];
+	return 10.0 * log10((yy - fit) / sig + 1e-30);
+}
+
+int main(int argc, char* argv[]){
+	uint packets = (argc > 1) ? (uint)atoi(argv[1]) : 200;
+	const double ratio = 48000.0 / (CLK_SYS / 68.0 / 64);			// 入力fs / DAC実再生fs
+	const uint32_t pitch = (uint32_t)lround(ratio * (1 << 22));
+
+	printf("pico_1bit_dac_v2 asrc_bench : CLK_SYS = %.1fMHz, pitch = %.7f (%+.0fppm)\n\n",
+		CLK_SYS / 1e6, (double)pitch / (1 << 22), ((double)pitch / (1 << 22) - 1.0) * 1e6);
+	printf("  %-7s %-4s %7s %10s %10s %9s", "fs", "taps", "kernel", "ns/frame", "cyc/frame", "Core0[%]");
+	for(uint t = 0; t < sizeof(tone_list) / sizeof(tone_list[0]); t++){
+		printf("  spur@%2.0fk", tone_list[t] / 1000);
+	}
+	printf("\n");
+
+	host_set_core_num(0);
+	dsp_init();
+	for(uint f = 0; f < sizeof(fs_list) / sizeof(fs_list[0]); f++){
+		const uint fs = fs_list[f];
+		for(uint n = 0; n < sizeof(kernel_list) / sizeof(kernel_list[0]); n++){
+			const kernel_t* k = &kernel_list[n];
+			const uint cyc = cyc_kernel(k);
+			double ns = 0, frames = 0;
+			double spur[sizeof(tone_list) / sizeof(tone_list[0])];
+			for(uint t = 0; t < sizeof(tone_list) / sizeof(tone_list[0]); t++){
+				spur[t] = measure(k, fs, tone_list[t], packets, pitch, &ns, &frames);
+			}
+			printf("  %-7u %-4u %7s %10.2f %10u %9.2f", fs, k->tap_n, k->name, ns / frames, cyc, 100.0 * cyc / cyc_budget(fs));
+			for(uint t = 0; t < sizeof(tone_list) / sizeof(tone_list[0]); t++){
+				printf(" %9.1f", spur[t]);
+			}
+			printf("\n");
+		}
+	}
+	uint type, tap_n;
+	asrc_get_kernel(&type, &tap_n);
+	printf("\nselected (ASRC_TYPE = %u) : %s, %u taps, 384kHz\n", type, kernel_list[type].name, tap_n);
+	return 0;
+}
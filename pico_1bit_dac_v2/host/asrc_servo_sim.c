@@ -0,0 +1,283 @@
+/**
+ * @file asrc_servo_sim.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ASRCピッチ制御(キュー水位サーボ)シミュレーション 周波数ドリフト・ジッタのある I2S ソース
+ * @version 0.01
+ * @date 2026-10-17
+ * @note Core0(I2S受信 -> asrc -> キュー公開)と Core1(キュー -> PWM変換)を時刻順のイベントとして模擬し、
+ *       ファームウェアの simple_queue.c / asrc_servo.c / asrc() をそのまま動作させる。
+ *         ソース   : 48kHz x (1 + 偏差[ppm]) 48サンプル/パケット、パケット到着時刻に一様ジッタを加える
+ *                    パケット当たりの ASRC 入力サンプル数はファームウェアと同じ asrc_servo_frame_len() で求める
+ *                    asrc_pitch_update() 相当の周波数計測(1秒毎, LRCK長周期)に一様誤差を加える
+ *         Core1    : DAC実再生レート(CLK_SYS/68/8)で PDM_FEED_N サンプル毎に queue_consume() を通知する
+ *                    ミュート判定は pdm_output() と同じ (キュー長 0 でミュート、play_thr で解除) キューはロバストモード
+ *       シナリオ毎に サーボ(asrc_servo) と 従来方式(計測ピッチ + 水位 QUEUE_DEPTH-1 で1サンプル間引き) を比較する。
+ *        conv[s]  : 収束時間 (平滑化後の水位誤差が ±SIM_CONV_TOL サンプルに入り、以降外れない時刻)
+ *        mean/std/p-p : 収束後のキュー水位 (目標との差)[sample]  Core0 がパケット毎に計測した値
+ *        jit[ppm] : 収束後のピッチ変動 (1秒移動平均からの偏差の標準偏差, 1Hz程度以上の周波数変調成分)
+ *        drop     : 破棄サンプル数 (キュー満杯によるパケット破棄、従来方式の間引き)
+ *        urun     : 再生開始後のアンダーラン(ミュート)回数
+ *       サーボでいずれかのシナリオが 破棄・アンダーランあり/未収束 の場合は終了コード1を返す。
+ *       usage : asrc_servo_sim [seconds]   default 60
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "asrc_servo.h"
+#include "dsp.h"
+
+#define SIM_OVERLAP		64			// 入力バッファ手前の作業領域 [word] (ASRC_OVERLAP 以上)
+#define SIM_PACKET_N	48			// ソース 1パケットのサンプル数 (48kHz, 1ms)
+#define SIM_OSR			8
+#define SIM_FEED_N		48			// PDM_FEED_N
+#define SIM_MUTE_N		24			// pdm_output() 無音バッファ長
+#define SIM_FF_PACKETS	1000		// 周波数計測周期[パケット]
+#define SIM_CONV_TOL	16			// 収束判定 [sample]
+#define SIM_JIT_WIN		1000		// ピッチ変動 移動平均長[パケット]
+
+typedef struct {
+	const char*	name;
+	double		ppm;		// ソース偏差 [ppm]
+	double		drift_ppm;	// ドリフト振幅 [ppm] (正弦波)
+	double		drift_s;	// ドリフト周期 [s]
+	double		jitter_us;	// パケット到着ジッタ ±[us]
+	double		ff_ppm;		// 周波数計測誤差 ±[ppm]
+} scenario_t;
+
+static const scenario_t scenario_list[] = {
+	{"nominal",     0,    0,  0,   0,  0},
+	{"src +300ppm", 300,  0,  0,   0,  0},
+	{"src -500ppm", -500, 0,  0,   0,  0},
+	{"drift",       0,  100, 60,   0,  5},
+	{"jitter",      100,  0,  0, 200, 20},
+	{"all",        -200, 100, 60, 200, 20},
+};
+
+typedef struct {
+	double	conv;		// 収束時間 [s]
+	double	mean, std, pp;
+	double	jit;		// ピッチ変動 [ppm]
+	uint	drop;
+	uint	underrun;
+} sim_result_t;
+
+// Core1 モデル
+typedef struct {
+	double		t;			// 次イベント時刻
+	uint		pend;		// 変換中のサンプル数 (t で完了通知)
+	bool		mute;
+	bool		started;
+	int32_t*	buf;
+	uint32_t	len;
+	uint32_t	pos;
+	uint		underrun;
+} core1_t;
+
+static int32_t in_top[SIM_OVERLAP + QUEUE_WIDTH];
+static int32_t* const in_buf = &in_top[SIM_OVERLAP];
+
+static double fs_dac;		// DAC実再生レート (384kHz段)
+static uint frame_n;		// ASRC入力 1パケットのサンプル数 (ファームウェアと同じ asrc_servo_frame_len() で求める)
+
+static uint32_t sim_us(double t){
+	return (uint32_t)(uint64_t)(t * 1e6);
+}
+
+static double urand(void){
+	return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+// Core1 1イベント : 変換完了通知 -> ミュート判定・取出し -> 次の変換開始
+static void core1_step(core1_t* c){
+	if (c->pend) {
+		queue_consume(c->pend, sim_us(c->t));
+		c->pend = 0;
+	}
+	if (c->pos >= c->len) {
+		uint32_t queue_length = get_queue_length();
+		if ((queue_length == 0) && !c->mute) {
+			c->mute = true;
+			queue_reset();
+			if (c->started) c->underrun++;
+		} else if (queue_length >= queue_get_mode()->play_thr) {
+			c->mute = false;
+			c->started = true;
+		}
+		if (c->mute) {
+			c->t += SIM_MUTE_N / fs_dac;
+			return;
+		}
+		dequeue(&c->buf, &c->len);
+		c->pos = 0;
+	}
+	uint n = (c->len - c->pos < SIM_FEED_N) ? c->len - c->pos : SIM_FEED_N;
+	c->pos += n;
+	c->pend = n;
+	c->t += n / fs_dac;
+}
+
+static double stat_mean(const double* x, uint n){
+	double s = 0;
+	for(uint i = 0; i < n; i++) s += x[i];
+	return n ? s / n : 0;
+}
+
+static double stat_std(const double* x, uint n, double mean){
+	double s = 0;
+	for(uint i = 0; i < n; i++) s += (x[i] - mean) * (x[i] - mean);
+	return n ? sqrt(s / n) : 0;
+}
+
+static sim_result_t sim_run(const scenario_t* sc, bool servo, double seconds){
+	const uint packets = (uint)(seconds * 1000);
+	const uint32_t pitch_nominal = (uint32_t)lround(48000.0 * SIM_OSR / fs_dac * (1 << ASRC_SERVO_FRAC_BIT));
+	queue_init(QUEUE_MODE_ROBUST);
+	const uint target = queue_get_mode()->fill_target * frame_n;
+	double* fill_err = malloc(sizeof(double) * packets);
+	double* err_f = malloc(sizeof(double) * packets);
+	double* pitch_ppm = malloc(sizeof(double) * packets);
+	sim_result_t r = {0};
+
+	srand(1);
+	asrc_reset();
+	asrc_servo_reset(pitch_nominal, target, frame_n);
+	core1_t c1 = {.mute = true};
+
+	uint32_t pitch_meas = pitch_nominal;	// asrc_pitch_update() 相当
+	double t_src = 0;						// パケット到着時刻 (ジッタなし)
+	double t_meas = 0;
+	uint n_rec = 0;
+	for(uint p = 0; p < packets; p++){
+		const double ppm = sc->ppm + sc->drift_ppm * ((sc->drift_s > 0) ? sin(2.0 * M_PI * t_src / sc->drift_s) : 0);
+		t_src += SIM_PACKET_N / (48000.0 * (1.0 + ppm * 1e-6));
+		const double t_arrive = t_src + sc->jitter_us * 1e-6 * urand();
+		while (c1.t <= t_arrive) core1_step(&c1);
+
+		// 周波数計測 (LRCK長周期カウント)
+		if ((p + 1) % SIM_FF_PACKETS == 0) {
+			const double fs_src = SIM_FF_PACKETS * SIM_PACKET_N / (t_src - t_meas);
+			t_meas = t_src;
+			pitch_meas = (uint32_t)lround(fs_src * SIM_OSR / fs_dac * (1.0 + sc->ff_ppm * 1e-6 * urand()) * (1 << ASRC_SERVO_FRAC_BIT));
+			asrc_servo_set_ff(pitch_meas);
+		}
+
+		int32_t fill;
+		bool playing = queue_get_fill(sim_us(t_arrive), (uint32_t)fs_dac, &fill);
+		int32_t* q_buf = queue_acquire();
+		if (q_buf == NULL) {
+			r.drop += frame_n;
+			continue;
+		}
+		int32_t* buf = in_buf;
+		uint len = frame_n;
+		uint32_t pitch;
+		if (servo) {
+			pitch = asrc_servo_update(playing, fill);
+		} else {
+			pitch = pitch_meas;
+			if (get_queue_length() >= QUEUE_DEPTH - 1) {
+				len--;
+				r.drop++;
+			}
+		}
+		asrc(&buf, &len, pitch, q_buf);
+		queue_publish(len);
+
+		if (c1.started) {
+			asrc_servo_state_t st;
+			asrc_servo_get_state(&st);
+			fill_err[n_rec] = (double)fill / (1 << QUEUE_FILL_FRAC) - target;
+			err_f[n_rec] = servo ? st.err : -fill_err[n_rec];
+			pitch_ppm[n_rec] = ((double)pitch / (1 << ASRC_SERVO_FRAC_BIT) - 1.0) * 1e6;
+			n_rec++;
+		}
+	}
+	r.underrun = c1.underrun;
+
+	// 収束 : 平滑化後の誤差が許容範囲を外れた最後の時刻
+	uint conv = 0;
+	for(uint i = 0; i < n_rec; i++){
+		if (fabs(err_f[i]) > SIM_CONV_TOL) conv = i + 1;
+	}
+	r.conv = (packets - n_rec + conv) / 1000.0;
+	if (conv >= n_rec) {
+		r.conv = -1;
+		conv = 0;
+	}
+	const uint n = n_rec - conv;
+	r.mean = stat_mean(&fill_err[conv], n);
+	r.std = stat_std(&fill_err[conv], n, r.mean);
+	double lo = 1e30, hi = -1e30;
+	for(uint i = conv; i < n_rec; i++){
+		if (fill_err[i] < lo) lo = fill_err[i];
+		if (fill_err[i] > hi) hi = fill_err[i];
+	}
+	r.pp = n ? hi - lo : 0;
+	// ピッチ変動 : 中心1秒移動平均との差
+	double jit = 0;
+	uint jit_n = 0;
+	for(uint i = conv + SIM_JIT_WIN / 2; i + SIM_JIT_WIN / 2 < n_rec; i++){
+		double d = pitch_ppm[i] - stat_mean(&pitch_ppm[i - SIM_JIT_WIN / 2], SIM_JIT_WIN);
+		jit += d * d;
+		jit_n++;
+	}
+	r.jit = jit_n ? sqrt(jit / jit_n) : 0;
+	free(fill_err);
+	free(err_f);
+	free(pitch_ppm);
+	return r;
+}
+
+static void print_result(const sim_result_t* r){
+	if (r->conv < 0) printf(" %7s", "-");
+	else             printf(" %7.2f", r->conv);
+	printf(" %7.1f %6.1f %6.1f %8.2f %6u %5u", r->mean, r->std, r->pp, r->jit, r->drop, r->underrun);
+}
+
+int main(int argc, char* argv[]){
+	double seconds = (argc > 1) ? atof(argv[1]) : 60;
+	if (seconds < 5) seconds = 5;
+	fs_dac = CLK_SYS / 68.0 / 8;
+	frame_n = asrc_servo_frame_len(SIM_PACKET_N * 1000);
+	bool fail = false;
+
+	host_set_core_num(0);
+	dsp_init();
+
+	queue_init(QUEUE_MODE_ROBUST);
+	const uint fill_target = queue_get_mode()->fill_target;
+	printf("pico_1bit_dac_v2 asrc_servo_sim : DAC %.2fHz (384k), target %u samples (%u packets), %.0fs/scenario\n",
+		fs_dac, fill_target * frame_n, fill_target, seconds);
+	printf("servo : bw %.2fHz, zeta %.2f, range +-%uppm, frame_len %u (asrc_servo_frame_len(%u))\n\n",
+		ASRC_SERVO_BW_HZ, ASRC_SERVO_ZETA, ASRC_SERVO_RANGE_PPM, frame_n, SIM_PACKET_N * 1000);
+	// フレーム長は 1ms 分の x SIM_OSR 後のサンプル数であること (ループゲイン・目標水位の基準)
+	if (frame_n != SIM_PACKET_N * SIM_OSR) {
+		printf("NG (asrc_servo_frame_len() = %u, expected %u)\n", frame_n, SIM_PACKET_N * SIM_OSR);
+		return 1;
+	}
+	printf("  %-12s | %-54s | %-54s\n", "", "servo (asrc_servo)", "legacy (measured pitch + drop at QUEUE_DEPTH-1)");
+	printf("  %-12s |", "scenario");
+	for(uint k = 0; k < 2; k++){
+		printf(" %7s %7s %6s %6s %8s %6s %5s |", "conv[s]", "mean", "std", "p-p", "jit[ppm]", "drop", "urun");
+	}
+	printf("\n");
+
+	for(uint s = 0; s < sizeof(scenario_list) / sizeof(scenario_list[0]); s++){
+		const scenario_t* sc = &scenario_list[s];
+		sim_result_t r_servo = sim_run(sc, true, seconds);
+		sim_result_t r_legacy = sim_run(sc, false, seconds);
+		printf("  %-12s |", sc->name);
+		print_result(&r_servo);
+		printf(" |");
+		print_result(&r_legacy);
+		printf(" |\n");
+		if (r_servo.drop || r_servo.underrun || (r_servo.conv < 0) || (r_servo.conv > seconds / 2)) fail = true;
+	}
+	printf("\n%s\n", fail ? "NG (servo dropped samples / underrun / not converged)" : "OK");
+	return fail ? 1 : 0;
+}
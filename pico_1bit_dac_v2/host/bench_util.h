@@ -0,0 +1,47 @@
+/**
+ * @file bench_util.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ホストツール共通処理 (処理時間計測, FFT)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note ベンチマーク・検証ツールで共通に使う小関数。
+ *         now_ns() : ホスト実測時間 [ns] (CLOCK_MONOTONIC)
+ *         fft()    : 基数2 FFT (in-place, n は 2のべき乗)
+ */
+#ifndef _BENCH_UTIL_H_
+#define _BENCH_UTIL_H_
+
+#include <math.h>
+#include <complex.h>
+#include <time.h>
+#include "pico.h"
+
+static inline double now_ns(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// 基数2 FFT (in-place)
+static inline void fft(double complex* x, uint n){
+	for(uint i = 1, j = 0; i < n; i++){
+		uint bit = n >> 1;
+		for(; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j) { double complex t = x[i]; x[i] = x[j]; x[j] = t; }
+	}
+	for(uint len = 2; len <= n; len <<= 1){
+		double complex wl = cexp(-2.0 * I * M_PI / len);
+		for(uint i = 0; i < n; i += len){
+			double complex w = 1.0;
+			for(uint k = 0; k < len / 2; k++){
+				double complex u = x[i + k], v = x[i + k + len / 2] * w;
+				x[i + k] = u + v;
+				x[i + k + len / 2] = u - v;
+				w *= wl;
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,277 @@
+/**
+ * @file clock_plan_gen.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief クロック計画 ソルバ・生成・検証 (PLL設定, PIO PWM周期, 真の再生周波数 -> clock_plan.h)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note PLL_SYS の設定(FBDIV, POSTDIV1/2)・PIOクロック分周・PWM周期(48k系/44.1k系)の全組み合わせから、
+ *       以下の制約を満たし、再生周波数誤差(2系列の大きい方)が最小、次にシステムクロック・VCO周波数が最小の計画を選ぶ。
+ *         PLL   : RP2040 Datasheet 2.18.2  REFDIV = 1 (基準12MHz), FBDIV 16~320, VCO 750~1600MHz,
+ *                 POSTDIV1/2 1~7 (POSTDIV2 ≦ POSTDIV1)、システムクロック SYS_MAX_HZ 以下
+ *         PWM   : PWM周期 = PWM_CYCLE_MIN(68, 4/5bit の1周期・6bit の半周期) + 延長(偶数, H/L に等分)
+ *                 延長は 2命令の遅延(各 [0~7])で表せる範囲、既定では従来の PIOプログラム(pio_pwm_4/5/6bit.pio)と
+ *                 同じ 48k系 0, 44.1k系 6 に固定する (-f で自由に探索)
+ *                 全PWM分解能(4/5/6bit)の PIOプログラムが pio_pwm_build() で生成できること
+ *         Core1 : 全変調プロファイルの見積もりサイクル数(L/R, PIO供給含む, host/cycle_model.h)が
+ *                 384/352.8kHz 1サンプル周期(= PIO分周 * PWM周期 * 8 [cycle])以下
+ *       探索結果の上位候補と選択した計画の全てを制約について再検査し、コンパイル時の clock_plan.h と比較する。
+ *       制約違反、または clock_plan.h が探索結果と異なる場合は終了コード1を返す。
+ *       usage : clock_plan_gen [-f] [-w clock_plan.h]
+ *                 -f : PWM周期の延長を自由に探索する (PIOプログラム変更の検討用)
+ *                 -w : 選択した計画で clock_plan.h を生成する
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "pdm_output.h"
+#include "pio_pwm.h"
+#include "cycle_model.h"
+
+// RP2040 PLL 制約
+#define PLL_REF_HZ			12000000u	// XOSC
+#define PLL_FBDIV_MIN		16
+#define PLL_FBDIV_MAX		320
+#define PLL_VCO_MIN_HZ		750000000u
+#define PLL_VCO_MAX_HZ		1600000000u
+#define PLL_PD_MAX			7
+#define SYS_MAX_HZ			250000000u	// システムクロック上限 (VREG 1.30V でのオーバークロック範囲)
+
+// PIO PWM 制約
+#define PWM_CYCLE_MIN		68			// 4/5bit : 1周期 (h0 + h_step * (2^bit - 1) + h0), 6bit : 半周期
+#define PWM_PAD_MAX			16			// 延長 2命令 x (1 + 遅延7)
+#define PIO_DIV_MAX			2
+#define PWM_PAD_IMPL_48		0			// 現行PIOプログラムの延長 (PIN_FS48 = 1)
+#define PWM_PAD_IMPL_44		6			// 〃 (PIN_FS48 = 0)  jmp pin 分岐後の nop [2] x 2
+
+// Core1 見積もり (profile_bench と同じ条件)
+#define BENCH_OS_INNER_N	4
+#define BENCH_BLOCK_N		8
+#define BENCH_CHUNK_N		48
+
+#define CAND_N				10			// 表示する候補数
+
+static const double pwm_rate[2] = {352800.0 * 8, 384000.0 * 8};	// PWM周期の理想周波数 [Hz] [group_48k] (4/5bit)
+
+typedef struct {
+	uint32_t	sys_hz;
+	uint32_t	vco_hz;
+	uint		fbdiv;
+	uint		pd1;
+	uint		pd2;
+	uint		pio_div;
+	uint		cycle[2];		// PWM周期 [pio clk] [group_48k]
+	double		ppm[2];			// 再生周波数誤差 [group_48k]
+} plan_t;
+
+// 全変調プロファイルの最大見積もりサイクル数 (L/R, 1サンプル当たり)
+static uint core1_cycle_max(void){
+	uint max = 0;
+	host_set_core_num(1);
+	for(uint p = 0; p < pcm2pwm_get_profile_n(); p++){
+		pcm2pwm_init(p);
+		const uint cyc = 2 * cyc_pcm2pwm_block_prof(pcm2pwm_get_profile(p), BENCH_OS_INNER_N, pcm2pwm_get_bs_n(), BENCH_BLOCK_N)
+					   + (cyc_dma_chunk() + BENCH_CHUNK_N - 1) / BENCH_CHUNK_N;
+		if (cyc > max) max = cyc;
+	}
+	pcm2pwm_init(PCM2PWM_PROFILE_DEFAULT);
+	return max;
+}
+
+static double plan_err(const plan_t* p){
+	return fmax(fabs(p->ppm[0]), fabs(p->ppm[1]));
+}
+
+// PIOプログラム生成可否 (pdm_output.c と同じ構成 : pio_pwm_param_init())
+static bool pio_program_ok(const uint cycle[2]){
+	for(uint bit = 4; bit <= 6; bit++){
+		pio_pwm_param_t param;
+		pio_pwm_param_init(&param, bit, cycle[1], cycle[0]);
+		pio_pwm_config_t cfg;
+		if (!pio_pwm_build(&cfg, &param)) return false;
+	}
+	return true;
+}
+
+// 制約検査 NG の場合は理由を表示して false
+static bool check_plan(const plan_t* p, uint core1_cyc, bool impl_only){
+	const char* ng = NULL;
+	if (p->fbdiv < PLL_FBDIV_MIN || p->fbdiv > PLL_FBDIV_MAX)						ng = "FBDIV range";
+	else if ((uint64_t)PLL_REF_HZ * p->fbdiv != p->vco_hz)							ng = "VCO != REF * FBDIV";
+	else if (p->vco_hz < PLL_VCO_MIN_HZ || p->vco_hz > PLL_VCO_MAX_HZ)				ng = "VCO range";
+	else if (p->pd1 < 1 || p->pd1 > PLL_PD_MAX || p->pd2 < 1 || p->pd2 > p->pd1)	ng = "POSTDIV range";
+	else if (p->vco_hz % (p->pd1 * p->pd2) != 0 || p->vco_hz / (p->pd1 * p->pd2) != p->sys_hz)	ng = "SYS != VCO / POSTDIV";
+	else if (p->sys_hz > SYS_MAX_HZ)												ng = "SYS > SYS_MAX_HZ";
+	else if (p->pio_div < 1 || p->pio_div > PIO_DIV_MAX)							ng = "PIO clkdiv range";
+	for(uint g = 0; g < 2 && ng == NULL; g++){
+		const uint pad = p->cycle[g] - PWM_CYCLE_MIN;
+		const double fs = (double)p->sys_hz / p->pio_div / p->cycle[g] / 8;
+		if (p->cycle[g] < PWM_CYCLE_MIN || pad > PWM_PAD_MAX || (pad & 1))			ng = "PWM cycle / pad";
+		else if (impl_only && pad != (g ? PWM_PAD_IMPL_48 : PWM_PAD_IMPL_44))		ng = "pad != PIO program";
+		else if (p->pio_div * p->cycle[g] * 8 < core1_cyc)							ng = "Core1 budget";
+		else if (fabs((fs * 8 / pwm_rate[g] - 1.0) * 1e6 - p->ppm[g]) > 1e-6)		ng = "true fs / ppm";
+	}
+	if (ng == NULL && !pio_program_ok(p->cycle))									ng = "PIO program build";
+	if (ng != NULL) printf("  NG : %.4fMHz VCO %u/%u/%u div %u cycle %u/%u : %s\n", p->sys_hz / 1e6,
+		p->fbdiv, p->pd1, p->pd2, p->pio_div, p->cycle[1], p->cycle[0], ng);
+	return ng == NULL;
+}
+
+// 候補の評価順 : 誤差(0.1ppm単位) -> システムクロック -> VCO
+static int plan_cmp(const void* a, const void* b){
+	const plan_t* pa = a;
+	const plan_t* pb = b;
+	const long ea = lround(plan_err(pa) * 10), eb = lround(plan_err(pb) * 10);
+	if (ea != eb) return (ea < eb) ? -1 : 1;
+	if (pa->sys_hz != pb->sys_hz) return (pa->sys_hz < pb->sys_hz) ? -1 : 1;
+	if (pa->vco_hz != pb->vco_hz) return (pa->vco_hz < pb->vco_hz) ? -1 : 1;
+	return 0;
+}
+
+// 探索 戻り値 : 候補数 (plans は評価順)
+static uint solve(plan_t* plans, uint max, uint core1_cyc, bool impl_only){
+	uint n = 0;
+	for(uint fbdiv = PLL_FBDIV_MIN; fbdiv <= PLL_FBDIV_MAX; fbdiv++){
+		const uint32_t vco = PLL_REF_HZ * fbdiv;
+		if (vco < PLL_VCO_MIN_HZ || vco > PLL_VCO_MAX_HZ) continue;
+		for(uint pd1 = 1; pd1 <= PLL_PD_MAX; pd1++){
+			for(uint pd2 = 1; pd2 <= pd1; pd2++){
+				if (vco % (pd1 * pd2) != 0) continue;
+				const uint32_t sys = vco / (pd1 * pd2);
+				if (sys > SYS_MAX_HZ) continue;
+				for(uint div = 1; div <= PIO_DIV_MAX; div++){
+					plan_t p = {sys, vco, fbdiv, pd1, pd2, div, {0, 0}, {0, 0}};
+					bool ok = true;
+					for(uint g = 0; g < 2 && ok; g++){
+						// 理想周期に最も近い偶数延長 (impl_only : 現行PIOプログラムの延長)
+						const double ideal = (double)sys / div / pwm_rate[g];
+						int pad = impl_only ? (g ? PWM_PAD_IMPL_48 : PWM_PAD_IMPL_44) : 2 * (int)lround((ideal - PWM_CYCLE_MIN) / 2);
+						if (pad < 0 || pad > PWM_PAD_MAX) { ok = false; break; }
+						p.cycle[g] = PWM_CYCLE_MIN + pad;
+						p.ppm[g] = ((double)sys / div / p.cycle[g] / pwm_rate[g] - 1.0) * 1e6;
+						if (div * p.cycle[g] * 8 < core1_cyc) ok = false;
+					}
+					if (ok && n < max && pio_program_ok(p.cycle)) plans[n++] = p;
+				}
+			}
+		}
+	}
+	qsort(plans, n, sizeof(plan_t), plan_cmp);
+	return n;
+}
+
+static void print_plan(const plan_t* p, uint core1_cyc){
+	printf("  %9.4f %8.1f %5u %3u %3u %3u | %5u %5u | %+9.1f %+9.1f | %7.2f\n",
+		p->sys_hz / 1e6, p->vco_hz / 1e6, p->fbdiv, p->pd1, p->pd2, p->pio_div, p->cycle[1], p->cycle[0],
+		p->ppm[1], p->ppm[0], 100.0 * core1_cyc / (p->pio_div * p->cycle[1] * 8));
+}
+
+static bool write_header(const char* path, const plan_t* p, uint core1_cyc, bool impl_only){
+	FILE* fp = fopen(path, "w");
+	if (fp == NULL) return false;
+	fprintf(fp, "/**\n");
+	fprintf(fp, " * @file clock_plan.h\n");
+	fprintf(fp, " * @author geachlab, Yasushi MARUISHI\n");
+	fprintf(fp, " * @brief クロック計画 システムクロック(PLL)・PIO PWM周期・真の再生周波数\n");
+	fprintf(fp, " * @version 0.01\n");
+	fprintf(fp, " * @date 2026-10-17\n");
+	fprintf(fp, " * @note host/clock_plan_gen%s -w で生成する。直接編集しないこと。\n", impl_only ? "" : " -f");
+	fprintf(fp, " *       PWM周期は PWM_CYCLE_MIN(%u) + 延長 [pio clk] (4/5bit : 1周期, 6bit : 半周期)\n", PWM_CYCLE_MIN);
+	fprintf(fp, " *       Core1 見積もり最大 %u cycle/sample (384kHz 周期 %u cycle の %.1f%%)\n",
+		core1_cyc, p->pio_div * p->cycle[1] * 8, 100.0 * core1_cyc / (p->pio_div * p->cycle[1] * 8));
+	fprintf(fp, " *\n");
+	fprintf(fp, " *         fs        true fs [Hz]      error\n");
+	static const uint fs_list[] = {384000, 352800, 192000, 176400, 96000, 88200, 48000, 44100};
+	for(uint i = 0; i < sizeof(fs_list) / sizeof(fs_list[0]); i++){
+		const uint g = get_group_48k(fs_list[i]);
+		const uint div = (g ? 384000 : 352800) * 8 / fs_list[i];
+		const double fs = (double)p->sys_hz / (double)(p->pio_div * p->cycle[g]) / div;
+		fprintf(fp, " *       %6u  %16.3f  %+7.1fppm\n", fs_list[i], fs, p->ppm[g]);
+	}
+	fprintf(fp, " */\n");
+	fprintf(fp, "#ifndef _CLOCK_PLAN_H_\n#define _CLOCK_PLAN_H_\n\n");
+	fprintf(fp, "// システムクロック PLL_SYS = 12MHz * FBDIV / (POSTDIV1 * POSTDIV2)  (REFDIV = 1)\n");
+	fprintf(fp, "#define CLK_SYS                    ((uint32_t)%u)\n", p->sys_hz);
+	fprintf(fp, "#define CLOCK_PLAN_VCO_HZ          %uu\n", p->vco_hz);
+	fprintf(fp, "#define CLOCK_PLAN_FBDIV           %u\n", p->fbdiv);
+	fprintf(fp, "#define CLOCK_PLAN_POSTDIV1        %u\n", p->pd1);
+	fprintf(fp, "#define CLOCK_PLAN_POSTDIV2        %u\n\n", p->pd2);
+	fprintf(fp, "// PIO PWM  (6bit は PWM周期 x2, pacemaker は PIO分周 x2)\n");
+	fprintf(fp, "#define CLOCK_PLAN_PIO_DIV         %u       // PIOクロック分周 (整数)\n", p->pio_div);
+	fprintf(fp, "#define CLOCK_PLAN_PWM_CYCLE_48    %u      // PWM周期 [pio clk] 48k系   (PIN_FS48 = 1)\n", p->cycle[1]);
+	fprintf(fp, "#define CLOCK_PLAN_PWM_CYCLE_44    %u      // PWM周期 [pio clk] 44.1k系 (PIN_FS48 = 0)\n", p->cycle[0]);
+	fprintf(fp, "#define CLOCK_PLAN_PWM_PAD_48      %u       // PWM_CYCLE_MIN からの延長 [pio clk]\n", p->cycle[1] - PWM_CYCLE_MIN);
+	fprintf(fp, "#define CLOCK_PLAN_PWM_PAD_44      %u\n\n", p->cycle[0] - PWM_CYCLE_MIN);
+	fprintf(fp, "// 真の再生周波数 [Hz]  div : 1サンプル当たりの PWM周期数 (4/5bit換算 384k : 8, 192k : 16, 96k : 32, 48k : 64)\n");
+	fprintf(fp, "#define CLOCK_PLAN_TRUE_FS_48(div) (CLK_SYS / (double)(CLOCK_PLAN_PIO_DIV * CLOCK_PLAN_PWM_CYCLE_48) / (div))\n");
+	fprintf(fp, "#define CLOCK_PLAN_TRUE_FS_44(div) (CLK_SYS / (double)(CLOCK_PLAN_PIO_DIV * CLOCK_PLAN_PWM_CYCLE_44) / (div))\n\n");
+	fprintf(fp, "#endif\n");
+	fclose(fp);
+	return true;
+}
+
+int main(int argc, char* argv[]){
+	bool impl_only = true;
+	const char* out = NULL;
+	for(int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "-f") == 0) impl_only = false;
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) out = argv[++i];
+		else {
+			fprintf(stderr, "usage : clock_plan_gen [-f] [-w clock_plan.h]\n");
+			return 1;
+		}
+	}
+	bool fail = false;
+
+	const uint core1_cyc = core1_cycle_max();
+	const uint max = (PLL_FBDIV_MAX + 1) * PLL_PD_MAX * PLL_PD_MAX * PIO_DIV_MAX;
+	plan_t* plans = malloc(sizeof(plan_t) * max);
+	const uint n = solve(plans, max, core1_cyc, impl_only);
+
+	printf("pico_1bit_dac_v2 clock_plan_gen : %s, SYS <= %.1fMHz, Core1 max %u cycle/sample, %u candidates\n\n",
+		impl_only ? "PIO program pads (48k 0, 44.1k 6)" : "free pads", SYS_MAX_HZ / 1e6, core1_cyc, n);
+	printf("  %9s %8s %5s %3s %3s %3s | %5s %5s | %9s %9s | %7s\n",
+		"SYS[MHz]", "VCO", "FBDIV", "PD1", "PD2", "DIV", "cy48", "cy44", "48k[ppm]", "44k[ppm]", "Core1[%]");
+	for(uint i = 0; i < n && i < CAND_N; i++){
+		print_plan(&plans[i], core1_cyc);
+		if (!check_plan(&plans[i], core1_cyc, impl_only)) fail = true;
+	}
+	if (n == 0) {
+		printf("  no plan\n\nNG\n");
+		free(plans);
+		return 1;
+	}
+	const plan_t* best = &plans[0];
+
+	// コンパイル時の clock_plan.h との比較
+	const plan_t cur = {
+		CLK_SYS, CLOCK_PLAN_VCO_HZ, CLOCK_PLAN_FBDIV, CLOCK_PLAN_POSTDIV1, CLOCK_PLAN_POSTDIV2, CLOCK_PLAN_PIO_DIV,
+		{CLOCK_PLAN_PWM_CYCLE_44, CLOCK_PLAN_PWM_CYCLE_48},
+		{(CLOCK_PLAN_TRUE_FS_44(8) * 8 / pwm_rate[0] - 1.0) * 1e6, (CLOCK_PLAN_TRUE_FS_48(8) * 8 / pwm_rate[1] - 1.0) * 1e6}
+	};
+	printf("\n  clock_plan.h :\n");
+	print_plan(&cur, core1_cyc);
+	if (!check_plan(&cur, core1_cyc, true)) fail = true;
+	const bool same = (cur.sys_hz == best->sys_hz) && (cur.vco_hz == best->vco_hz) && (cur.pd1 == best->pd1) && (cur.pd2 == best->pd2)
+				   && (cur.pio_div == best->pio_div) && (cur.cycle[0] == best->cycle[0]) && (cur.cycle[1] == best->cycle[1]);
+	if (impl_only && !same) {
+		printf("  clock_plan.h differs from the solved plan (clock_plan_gen -w clock_plan.h で更新)\n");
+		fail = true;
+	}
+
+	if (out != NULL) {
+		if (!write_header(out, best, core1_cyc, impl_only)) {
+			fprintf(stderr, "cannot write : %s\n", out);
+			fail = true;
+		} else {
+			printf("\n  written : %s\n", out);
+		}
+	}
+	free(plans);
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
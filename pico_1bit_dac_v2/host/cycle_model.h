@@ -0,0 +1,301 @@
+/**
+ * @file cycle_model.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Cortex-M0+ (RP2040) 処理サイクル見積もりモデル
+ * @version 0.01
+ * @date 2026-10-17
+ * @note ホストでの実測時間(ns)はPCの性能に依存するため、実機の処理余裕は
+ *       各処理ループの命令構成から求めたサイクル数で見積もる。
+ *       前提 : コード・データともSRAM配置(PICO_COPY_TO_RAM=1)、バス競合なし
+ *       命令サイクル数は ARM Cortex-M0+ TRM、RP2040 Datasheet 2.3.1 (SIO 1cycle アクセス) による。
+ */
+#ifndef _CYCLE_MODEL_H_
+#define _CYCLE_MODEL_H_
+
+#include "pico.h"
+#include "bsp.h"
+#include "dsp.h"
+#include "pdm_output.h"
+
+#define CYC_LDR		2	// ldr (SRAM)
+#define CYC_STR		2	// str (SRAM)
+#define CYC_ALU		1	// add/sub/shift/and/mov
+#define CYC_MUL		1	// muls (RP2040は1cycle乗算器)
+#define CYC_SIO		1	// SIO(interp) レジスタ ldr/str
+#define CYC_BRANCH	2	// 分岐成立
+#define CYC_LOOP	(CYC_ALU + CYC_ALU + CYC_BRANCH)	// ループカウンタ更新・比較・分岐
+#define CYC_LMUL	16	// 64bit乗算 (__aeabi_lmul 呼び出し)
+#define CYC_APB		3	// PIO等 APB/AHBペリフェラル ldr/str
+
+// volume() : 1サンプル(L/R)当たり
+static inline uint cyc_volume(void){
+	return 2 * (CYC_LDR + CYC_MUL + CYC_ALU + CYC_STR) + CYC_LOOP;
+}
+
+// オーバーサンプラ初段の入力読込み時の音量処理 (hbf1_x2_oversampler_vol() 等) : 1サンプル(L/R)当たりの増分
+// 乗数・シフトはブロック毎にレジスタへ読み込むため、サンプル毎は乗算・シフトのみ
+static inline uint cyc_volume_fused(void){
+	return 2 * (CYC_MUL + CYC_ALU);
+}
+
+// hbfN_x2_oversampler() : 1入力サンプル(L/R)当たり
+// n_mac32 : 32bit積和(対称タップ対)数, n_mac64 : 64bit積和(対称タップ対)数
+// sw_clamp : ソフトウェアclamp (Core1版 hbfN_x2_oversampler_core1())
+static inline uint cyc_hbf_x2_clamp(uint n_mac32, uint n_mac64, bool sw_clamp){
+	const uint mac32 = 2 * CYC_LDR + CYC_ALU + CYC_MUL + CYC_ALU;				// z[a]+z[b], k*, acc+=
+	const uint mac64 = 2 * CYC_LDR + 2 * CYC_ALU + CYC_LMUL + 2 * CYC_ALU;		// z[a]+z[b], 符号拡張, k*, adds/adcs
+	const uint io    = CYC_LDR + 2 * CYC_STR + CYC_LDR + 2 * CYC_STR;			// 入力, 遅延2箇所書込み, 中央値読出し・出力, 補間値出力
+	const uint clamp = (sw_clamp ? 2 * (CYC_LDR + CYC_ALU + CYC_ALU) : 2 * CYC_SIO)	// interp1 clamp / 定数読出し・比較・分岐(不成立) x2
+					 + ((n_mac64 != 0) ? 3 * CYC_ALU : CYC_ALU);					// 係数ビット長シフト
+	const uint ptr   = 4 * CYC_ALU;												// p_o, t 更新
+	return 2 * (n_mac32 * mac32 + n_mac64 * mac64 + ((n_mac64 != 0) ? CYC_ALU : 0) + io + clamp + ptr)
+		+ 3 * CYC_ALU + CYC_LOOP;	// タップ位置巡回, ループ
+}
+
+static inline uint cyc_hbf_x2(uint n_mac32, uint n_mac64){
+	return cyc_hbf_x2_clamp(n_mac32, n_mac64, false);
+}
+
+// hbfN_x2_oversampler() : 1入力サンプル(L/R)当たり (stage : 0~2 = hbf1~3)
+// 積和構成(32bit/64bit タップ対数)は dsp.c のヘッドルーム解析結果を用いる
+static inline uint cyc_hbf_stage(uint stage){
+	uint mac32_n, mac64_n;
+	hbf_get_mac_n(stage, &mac32_n, &mac64_n);
+	return cyc_hbf_x2(mac32_n, mac64_n);
+}
+
+// hbfN_x2_oversampler_core1() : 1入力サンプル(L/R)当たり (Core1 後段分担用)
+static inline uint cyc_hbf_stage_core1(uint stage){
+	uint mac32_n, mac64_n;
+	hbf_get_mac_n(stage, &mac32_n, &mac64_n);
+	return cyc_hbf_x2_clamp(mac32_n, mac64_n, true);
+}
+
+// hbf_oversampler() : 1入力サンプル(L/R)当たり (hbf(first+1) から n_stage 段連結, first は hbf_get_first_stage())
+static inline uint cyc_hbf_cascade(uint first, uint n_stage){
+	uint cyc = 0;
+	for(uint n = 0; n < n_stage; n++) cyc += cyc_hbf_stage(first + n) << n;
+	return cyc;
+}
+
+// hbf_stream_oversampler() : 1入力サンプル(L/R)当たり (hbf(first+1) から n_stage 段、HBF_STREAM_CHUNK_N サンプル毎)
+// 段毎版との差はチャンク毎の各段関数呼出し(bl, push/pop, 引数設定, 関数表読出し)とチャンクループ
+static inline uint cyc_hbf_stream(uint first, uint n_stage){
+	const uint call = CYC_BRANCH + 1 + 6 + 8 + 4 * CYC_ALU + CYC_LDR;	// blx, push {r4-r7,lr}, pop {r4-r7,pc}, 引数設定, 関数表
+	return cyc_hbf_cascade(first, n_stage) + (n_stage * call + 6 * CYC_ALU + CYC_LOOP + HBF_STREAM_CHUNK_N - 1) / HBF_STREAM_CHUNK_N;
+}
+
+// 入力fs の hbf_oversampler() (Core0 全段, HBF_STREAM = 1) : 1入力サンプル(L/R)当たり
+static inline uint cyc_hbf_fs(uint fs){
+	const uint n = hbf_get_stage_n(fs);
+	const uint first = hbf_get_first_stage(fs);
+	return (n >= 2) ? cyc_hbf_stream(first, n) : cyc_hbf_cascade(first, n);
+}
+
+// iirN_x2_oversampler() : 1入力サンプル(L/R)当たり (a_n : 全域通過段数)
+// 全域通過段は差分を上位/下位に分割して積和する(pfir と同じ)。係数は定数(リテラルプール)
+static inline uint cyc_iir_x2(uint a_n){
+	const uint ap    = 2 * CYC_LDR + CYC_ALU + 2 * CYC_ALU + CYC_LDR		// x[n-1], y[n-1] 読出し, 差分, 上位/下位分割, 係数
+					 + 2 * CYC_MUL + 6 * CYC_ALU + CYC_ALU + 2 * CYC_STR;	// 上位/下位積, 合成, + x[n-1], x[n-1], y[n-1] 更新
+	const uint io    = CYC_LDR + CYC_ALU + 2 * (2 * CYC_SIO + CYC_STR);		// 入力・A0/A1 へ複製, clamp・出力 x2
+	return 2 * (a_n * ap + io) + 2 * CYC_ALU + CYC_LOOP;					// p_o 更新, ループ
+}
+
+// iirN_x2_oversampler() : 1入力サンプル(L/R)当たり (stage : 0~2 = iir1~3)
+static inline uint cyc_iir_stage(uint stage){
+	return cyc_iir_x2(iir_get_a_n(stage));
+}
+
+// 入力fs の hbf_oversampler() 低遅延フィルタ (os_filter_set(OS_FILTER_LOW_DELAY), Core0 全段・段毎) : 1入力サンプル(L/R)当たり
+static inline uint cyc_iir_fs(uint fs){
+	const uint n = hbf_get_stage_n(fs);
+	const uint first = hbf_get_first_stage(fs);
+	uint cyc = 0;
+	for(uint i = 0; i < n; i++) cyc += cyc_iir_stage(first + i) << i;
+	return cyc;
+}
+
+// pfir_oversampler() : 1入力サンプル(L/R)当たり
+// l : 補間比, tap_n : 全位相の有効タップ数合計(1ch)
+static inline uint cyc_pfir(uint l, uint tap_n){
+	const uint mac   = 3 * CYC_LDR + 2 * CYC_MUL + 2 * CYC_ALU + CYC_LOOP;	// k, xh, xl 読出し, 上位/下位積和
+	const uint io    = CYC_LDR + 2 * CYC_ALU + 4 * CYC_STR;					// 入力, 上位/下位分割, 遅延データ2重書込み
+	const uint phase = 3 * CYC_LDR + 3 * CYC_ALU							// 位相毎の係数・遅延データ位置
+					 + 6 * CYC_ALU + 2 * CYC_SIO + CYC_STR + CYC_LOOP;		// 上位/下位合成, clamp, 出力
+	return 2 * (io + tap_n * mac + l * phase) + 3 * CYC_ALU + CYC_LOOP;
+}
+
+// asrc_linear() : 1出力サンプル(L/R)当たり
+static inline uint cyc_asrc_linear(void){
+	return 4 * CYC_ALU							// 入力位置算出
+		+ 3 * CYC_ALU + CYC_SIO					// α算出・設定
+		+ 2 * (2 * CYC_LDR + 2 * CYC_SIO + CYC_SIO + CYC_STR)	// b0,b1 読出し・設定, blend結果出力
+		+ CYC_ALU + CYC_ALU						// len_o, asrc_pos 更新
+		+ CYC_LOOP;
+}
+
+// asrc_cubic()/asrc_sinc() 積和部 : 1出力サンプル(L/R)当たり (tap_n : タップ数)
+// 係数はL/R共通、入力データは上位/下位に分割して積和する
+static inline uint cyc_asrc_mac(uint tap_n){
+	const uint mac   = 2 * CYC_LDR + 3 * CYC_ALU + 2 * CYC_MUL + 2 * CYC_ALU;	// w, x 読出し, 上位/下位分割, 積和
+	const uint round = 6 * CYC_ALU + 2 * CYC_SIO + CYC_STR;					// 上位/下位合成, clamp, 出力
+	return 2 * (tap_n * mac + round);
+}
+
+// asrc_cubic() : 1出力サンプル(L/R)当たり
+static inline uint cyc_asrc_cubic(void){
+	return 4 * CYC_ALU							// 入力位置算出
+		+ 36 * CYC_ALU + 6 * CYC_MUL + 4 * CYC_STR + CYC_BRANCH	// 係数多項式評価 (μ, μ(μ-1), (μ+1)(μ-2), w[0~3]), DCゲイン補正
+		+ cyc_asrc_mac(4)
+		+ CYC_ALU + CYC_ALU						// len_o, asrc_pos 更新
+		+ CYC_LOOP;
+}
+
+// asrc_sinc() : 1出力サンプル(L/R)当たり (tap_n : タップ数)
+static inline uint cyc_asrc_sinc(uint tap_n){
+	return 4 * CYC_ALU							// 入力位置算出
+		+ 6 * CYC_ALU							// 位相・位相間補間値算出
+		+ tap_n * (2 * CYC_LDR + 3 * CYC_ALU + CYC_MUL + CYC_STR + CYC_LOOP)	// 隣接位相間の係数補間
+		+ cyc_asrc_mac(tap_n)
+		+ CYC_ALU + CYC_ALU						// len_o, asrc_pos 更新
+		+ CYC_LOOP;
+}
+
+// asrc() : 1出力サンプル(L/R)当たり (dsp.c の ASRC_TYPE で選択されたカーネル)
+static inline uint cyc_asrc(void){
+	uint type, tap_n;
+	asrc_get_kernel(&type, &tap_n);
+	switch(type){
+		case 2:  return cyc_asrc_sinc(tap_n);
+		case 1:  return cyc_asrc_cubic();
+		default: return cyc_asrc_linear();
+	}
+}
+
+// dop_detect() : 1入力フレーム(L/R)当たり
+static inline uint cyc_dop_detect(void){
+	return 2 * CYC_LDR + 4 * CYC_ALU		// L/R 読出し, マーカー抽出
+		+ 3 * (CYC_ALU + CYC_ALU)			// L/R一致, 0x05/0xFA, 交互 (比較・分岐不成立)
+		+ 2 * CYC_ALU						// マーカー保持, フレーム数更新
+		+ CYC_LOOP;
+}
+
+// dop_decimator() : 1入力フレーム(L/R)当たり
+// byte_n : FIR長[byte], out_per_in : 入力1フレーム当たりの出力数 (DSD64 : 2, DSD128 : 1)
+// 表引きは対称タップ対毎 (w[j], w[K-1-j] 読出し, ビット反転表, 表2回) 、内側ループは展開済み
+static inline uint cyc_dop_decimator(uint byte_n, uint out_per_in){
+	const uint pair = 3 * CYC_LDR + 4 * CYC_ALU + 2 * CYC_LDR + 2 * CYC_ALU;	// バイト・反転バイト読出し, 表アドレス算出, 表引き, 加算
+	const uint out  = (byte_n / 2) * pair + CYC_ALU + 2 * CYC_SIO + CYC_STR;		// 窓位置, clamp, 出力
+	const uint push = 2 * (CYC_ALU + 2 * CYC_STR) + 2 * CYC_ALU + CYC_BRANCH;	// L/R バイト抽出・2重書込み, 位置更新・巡回
+	return 2 * CYC_LDR + 2 * push + out_per_in * 2 * out + 2 * CYC_ALU + CYC_LOOP;
+}
+
+// ΔΣ積分器 ds[n] += -qt + ds[n-1] の1回分 (ds_order 段)
+// 積分器は下位レジスタ(r0~r7)から割り付け、不足分は上位レジスタ(r8~r12, mov往復)、さらに不足分はスタックに置く
+#define CYC_DS_LOREG_N	4	// 積分器に割り付け可能な下位レジスタ数 (qt, SIOベース, pwm_mask, 作業用を除く)
+#define CYC_DS_HIREG_N	4	// 積分器に割り付け可能な上位レジスタ数
+static inline uint cyc_ds_chain(uint ds_order){
+	uint cyc = 0;
+	for(uint n = 0; n < ds_order; n++){
+		if      (n < CYC_DS_LOREG_N)					cyc += 2 * CYC_ALU;
+		else if (n < CYC_DS_LOREG_N + CYC_DS_HIREG_N)	cyc += 2 * CYC_ALU + 2 * CYC_ALU;
+		else											cyc += CYC_LDR + 2 * CYC_ALU + CYC_STR;
+	}
+	return cyc;
+}
+
+// pcm2pwm 内側ループ(interp 1回分) 量子化値取得(pop/peek), オーバーサンプラ(pop), 積分器, 量子化器・ビットストリーマへ設定
+static inline uint cyc_pcm2pwm_inner(uint ds_order){
+	return 2 * CYC_SIO + CYC_SIO + cyc_ds_chain(ds_order) + CYC_ALU + CYC_SIO + CYC_LOOP;
+}
+
+// 旧 pcm2pwm() サンプル単位版 : 1入力サンプル(1ch)当たり
+// ds_order : ΔΣ次数, inner_n/outer_n : 内側(interp)/外側(出力ワード)ループ回数
+// サンプル毎に ch->ds[] の復帰・退避と interp0/interp1 の再設定を行う
+static inline uint cyc_pcm2pwm(uint ds_order, uint inner_n, uint outer_n){
+	const uint pre   = 2 * CYC_LDR + 3 * CYC_ALU + 2 * CYC_SIO + CYC_STR	// 直線補間初期値・傾き設定, d1保存
+					 + CYC_LDR + CYC_SIO									// ds[0] -> base[1]
+					 + ds_order * CYC_LDR;									// ds[1~] 復帰
+	const uint outer = CYC_SIO + CYC_ALU + CYC_STR + CYC_LOOP;				// bs[j] 出力
+	const uint post  = CYC_SIO + CYC_STR + ds_order * CYC_STR;				// ds[0~] 退避
+	return pre + outer_n * (inner_n * cyc_pcm2pwm_inner(ds_order) + outer) + post;
+}
+
+// pcm2pwm_block() ブロック単位版 : 1入力サンプル(1ch)当たり
+// block_n : ブロック長(PCM2PWM_BLOCK_N)、ch状態の復帰・退避と interp 設定はブロック毎に1回
+static inline uint cyc_pcm2pwm_block(uint ds_order, uint inner_n, uint outer_n, uint block_n){
+	const uint pre   = CYC_LDR + 3 * CYC_ALU + CYC_SIO + CYC_ALU;			// 入力, 傾き算出・設定, d1更新
+	const uint outer = CYC_SIO + CYC_ALU + CYC_STR + CYC_LOOP;				// bs[j] 出力
+	const uint post  = 2 * CYC_ALU + CYC_LOOP;								// p_i/p_bs 更新, サンプルループ
+	const uint block = (ds_order + 1) * (CYC_LDR + CYC_STR)					// ch->ds[] 復帰・退避
+					 + 2 * CYC_LDR + 2 * CYC_STR + 2 * CYC_SIO + CYC_ALU		// d1 復帰・退避, accum[0]/base[1] 設定
+					 + 2 * CYC_SIO											// アイドルトーン拡散 開始値
+					 + 6 * CYC_LDR + 6 * CYC_STR;							// 関数呼出し(レジスタ退避・復帰)
+	return pre + outer_n * (inner_n * cyc_pcm2pwm_inner(ds_order) + outer) + post + (block + block_n - 1) / block_n;	// ブロック分は切り上げ
+}
+
+// CRFB 係数演算 (v >> shift) * mul 1回分 (積分器への加減算を除く)
+// 係数1 : 0, シフトのみ・2のべき乗 : シフト1回, 2項の和(3, 5 等) : シフト・加算, その他 : 定数設定・乗算
+static inline uint cyc_ds_coef(ds_coef_t k){
+	const uint m = (k.mul < 0) ? (uint)-k.mul : (uint)k.mul;
+	uint cyc = (k.shift != 0) ? CYC_ALU : 0;
+	if      (m <= 1)					cyc += 0;
+	else if ((m & (m - 1)) == 0)		cyc += (k.shift != 0) ? 0 : CYC_ALU;	// シフト量をまとめる
+	else if (__builtin_popcount(m) == 2)	cyc += 2 * CYC_ALU + CYC_ALU;			// 作業レジスタへの mov, シフト・加算
+	else								cyc += CYC_ALU + CYC_MUL;
+	return cyc;
+}
+
+// CRFB 積分器 ds[n] += c[n] * ds[n-1] - (qt >> qt_shift[n]) - g[n] * ds[n+1] の1回分
+// 加減算2回は CoI と同じ (cyc_ds_chain)、係数演算・量子化値シフト・共振器の減算を加える
+static inline uint cyc_ds_crfb_chain(const ds_crfb_t* k){
+	uint cyc = cyc_ds_chain(k->order);
+	for(uint n = 1; n <= k->order; n++){
+		if (n >= 2) cyc += cyc_ds_coef(k->c[n]);
+		if (k->qt_shift[n] != 0) cyc += CYC_ALU;
+		if ((n < k->order) && (k->g[n].mul != 0)) cyc += cyc_ds_coef(k->g[n]) + CYC_ALU;
+	}
+	return cyc;
+}
+
+// pcm2pwm_block() プロファイル別 : 1入力サンプル(1ch)当たり
+// DS_TYPE_CRFB は積分器を cyc_ds_crfb_chain() に置き換え、出力ワード毎の OB変換(eor)、
+// 入力サンプル毎の過負荷判定(加算・比較・分岐不成立)を加える
+static inline uint cyc_pcm2pwm_block_prof(const pcm2pwm_profile_t* prof, uint inner_n, uint outer_n, uint block_n){
+	const uint cyc = cyc_pcm2pwm_block(prof->ds_order, inner_n, outer_n, block_n);
+	const ds_crfb_t* k = (prof->ds_type == DS_TYPE_CRFB) ? pcm2pwm_get_crfb(prof->pwm_bit, prof->ds_order) : NULL;
+	if (k == NULL) return cyc;
+	return cyc + outer_n * inner_n * (cyc_ds_crfb_chain(k) - cyc_ds_chain(prof->ds_order))
+			   + outer_n * CYC_ALU + 3 * CYC_ALU;
+}
+
+// pio0_sm01_put_blocking() : 1ワード(L/R)当たり (FIFO待ちを除く)
+static inline uint cyc_pio_put(void){
+	return CYC_APB + 2 * CYC_ALU + CYC_BRANCH + 2 * CYC_LDR + 2 * CYC_APB + CYC_LOOP;
+}
+
+// pdm_dma_feed() : 1面(PDM_DMA_CHUNK_N サンプル)当たりの面切替処理 (転送完了待ち・PWM変換を除く)
+// 完了確認(L/R), 連結解除・設定(L/R 各 al1_ctrl 読出し・書込み), 転送元・転送数設定(L/R), 起動判定, カーネル呼出し
+static inline uint cyc_dma_chunk(void){
+	const uint busy  = CYC_APB + CYC_ALU + CYC_BRANCH;						// dma_channel_is_busy()
+	const uint chain = CYC_LDR + CYC_APB + 2 * CYC_ALU + CYC_APB;			// al1_ctrl 読出し・CHAIN_TO 差替え・書込み
+	const uint setup = 2 * (CYC_LDR + CYC_APB);								// read_addr, trans_count
+	return 2 * busy + 2 * 2 * chain + 2 * setup + 3 * busy + CYC_APB + CYC_ALU
+		 + 6 * CYC_LDR + 6 * CYC_STR + CYC_LOOP;
+}
+
+// SRAMバンク競合 (1次近似)
+// 命令はSRAM(ストライプ領域)から実行し、16bit命令2個を1回の32bitフェッチで読む(分岐後のフェッチを含め 0.4回/cycle とする)
+// あるマスタの1アクセスは、同一サイクルに同じバンクへ他マスタのアクセスがある確率 rate_other で競合し、
+// 調停(ラウンドロビン)で半数が1サイクル待つとする。ストライプ領域のアクセスは4バンクに均等に分散する
+#define CYC_FETCH_RATE	0.4
+static inline double cyc_sram_stall(double n_access, double rate_other){
+	return n_access * rate_other * 0.5;
+}
+
+// 1サンプル周期当たりの使用可能サイクル数
+static inline double cyc_budget(double fs){
+	return (double)CLK_SYS / fs;
+}
+
+#endif
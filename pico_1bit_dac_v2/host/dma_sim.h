@@ -0,0 +1,132 @@
+/**
+ * @file dma_sim.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief RP2040 DMA チャネルレジスタモデル (PIO供給ピンポンバッファ, pdm_dma_feed() の手順)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note pdm_output.c (PDM_FEED_DMA = 1) の DMAチャネル 4本(pdm_dma_ch[面][ch])とピンポンバッファ pdm_dma_bs[面][ch] を
+ *       レジスタ単位で模擬し、pdm_dma_feed() と同じ手順で操作する。RP2040 Datasheet 2.5 による。モデル化の範囲 :
+ *         READ_ADDR   : 転送毎に +1ワード。CHAIN_TO による起動では再設定されない
+ *         TRANS_COUNT : 読出しは転送中の残数 (未起動・完了後は 0)。書込み値(CHx_DBG_TCR)は起動時に残数へ再設定される
+ *         CHAIN_TO    : 転送完了時に連結先を起動する (自チャネル = 連結なし)
+ *       転送のペーシング(DREQ)・1クロック当たりの転送数は呼出し側(host/pio_sink.h, host/pio_feed_model.c)が決める。
+ *       バッファはファームウェアと同じく [面][ch] の順に連続配置し、手順4で設定した範囲外の読出し(garbage)を数える。
+ *       L/R の FIFO は同一周期で消費されるため、L/R チャネルの完了・連結起動は呼出し側で揃う。
+ */
+#ifndef _DMA_SIM_H_
+#define _DMA_SIM_H_
+
+#include <string.h>
+#include "pico.h"
+#include "bsp.h"
+
+#define DMA_SIM_WORD_N		512		// 面1ch当たりのワード数 (PDM_DMA_WORD_N 相当, 面サイズ 192サンプル x 2ワードまで)
+#define DMA_SIM_CH_N		(2 * N_CH)
+
+// DMAチャネル (チャネル番号 = 面 x N_CH + ch)
+typedef struct {
+	uint		read_addr;		// READ_ADDR [mem のワード位置]
+	uint		trans_count;	// TRANS_COUNT 読出し値 (残数)
+	uint		tcr;			// TRANS_COUNT 書込み値 (CHx_DBG_TCR)
+	uint		chain_to;		// CHAIN_TO
+	bool		busy;
+	uint		valid_lo, valid_hi;	// 手順4で設定した転送範囲 [mem のワード位置]
+} dma_sim_ch_t;
+
+typedef struct {
+	dma_sim_ch_t	ch[DMA_SIM_CH_N];
+	uint32_t		mem[2][N_CH][DMA_SIM_WORD_N];	// pdm_dma_bs[面][ch]
+	uint			side;							// pdm_dma_side
+	uint			garbage;						// 設定範囲外の読出しワード数
+	uint			start_n;						// Core1 による起動回数 (手順4)
+	uint			chain_n;						// 連結起動回数
+} dma_sim_t;
+
+static inline uint dma_sim_id(uint k, uint c){
+	return k * N_CH + c;
+}
+
+static inline uint dma_sim_base(uint k, uint c){
+	return dma_sim_id(k, c) * DMA_SIM_WORD_N;
+}
+
+// pdm_dma_init()
+static inline void dma_sim_init(dma_sim_t* d){
+	memset(d, 0, sizeof(*d));
+	for(uint k = 0; k < 2; k++){
+		for(uint c = 0; c < N_CH; c++){
+			dma_sim_ch_t* ch = &d->ch[dma_sim_id(k, c)];
+			ch->chain_to = dma_sim_id(k, c);	// 自チャネル = 連結なし
+			ch->read_addr = dma_sim_base(k, c);
+		}
+	}
+}
+
+static inline void dma_sim_trigger(dma_sim_t* d, uint id){
+	dma_sim_ch_t* ch = &d->ch[id];
+	ch->trans_count = ch->tcr;
+	ch->busy = (ch->trans_count != 0);
+}
+
+static inline bool dma_sim_busy(const dma_sim_t* d, uint k, uint c){
+	return d->ch[dma_sim_id(k, c)].busy;
+}
+
+// pdm_dma_busy()
+static inline bool dma_sim_side_busy(const dma_sim_t* d, uint k){
+	return dma_sim_busy(d, k, 0) || dma_sim_busy(d, k, 1);
+}
+
+// 面 k・ch c の 1ワード転送 (DREQ 成立時に呼ぶ) 完了時は CHAIN_TO の連結先を起動する
+static inline uint32_t dma_sim_transfer(dma_sim_t* d, uint k, uint c){
+	dma_sim_ch_t* ch = &d->ch[dma_sim_id(k, c)];
+	const uint a = ch->read_addr++;
+	if (a < ch->valid_lo || a >= ch->valid_hi) d->garbage++;
+	const uint32_t v = (a < DMA_SIM_CH_N * DMA_SIM_WORD_N) ? (&d->mem[0][0][0])[a] : 0;
+	if (--ch->trans_count == 0) {
+		ch->busy = false;
+		if (ch->chain_to != dma_sim_id(k, c)) {
+			dma_sim_trigger(d, ch->chain_to);
+			d->chain_n++;
+		}
+	}
+	return v;
+}
+
+// 面 k・ch c の未転送ワード数 (転送中の残数 + 連結起動待ちの面の転送数)
+static inline uint dma_sim_pending(const dma_sim_t* d, uint c){
+	uint n = 0;
+	for(uint k = 0; k < 2; k++){
+		const dma_sim_ch_t* ch = &d->ch[dma_sim_id(k, c)];
+		if (!ch->busy) continue;
+		n += ch->trans_count;
+		const dma_sim_ch_t* next = &d->ch[ch->chain_to];
+		if (ch->chain_to != dma_sim_id(k, c) && !next->busy) n += next->tcr;
+	}
+	return n;
+}
+
+// pdm_dma_feed() 手順2 (手順1 の面 k の転送完了待ち後) 面 k の連結を解除する
+static inline void dma_sim_feed_unchain(dma_sim_t* d, uint k){
+	for(uint c = 0; c < N_CH; c++) d->ch[dma_sim_id(k, c)].chain_to = dma_sim_id(k, c);
+}
+
+// pdm_dma_feed() 手順4 (手順3 で d->mem[k][ch] へ n ワード変換後) 転送元・転送数の設定、面 k^1 -> 面 k の連結、未起動時の同時起動
+static inline void dma_sim_feed_commit(dma_sim_t* d, uint k, uint n){
+	for(uint c = 0; c < N_CH; c++){
+		dma_sim_ch_t* ch = &d->ch[dma_sim_id(k, c)];
+		ch->read_addr = dma_sim_base(k, c);
+		ch->tcr = n;
+		ch->valid_lo = ch->read_addr;
+		ch->valid_hi = ch->read_addr + n;
+	}
+	for(uint c = 0; c < N_CH; c++) d->ch[dma_sim_id(k ^ 1, c)].chain_to = dma_sim_id(k, c);
+	if (!dma_sim_side_busy(d, k ^ 1) && !dma_sim_side_busy(d, k)
+		&& d->ch[dma_sim_id(k, 0)].read_addr == dma_sim_base(k, 0)) {
+		for(uint c = 0; c < N_CH; c++) dma_sim_trigger(d, dma_sim_id(k, c));
+		d->start_n++;
+	}
+	d->side = k ^ 1;
+}
+
+#endif
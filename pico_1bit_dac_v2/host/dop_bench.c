@@ -0,0 +1,389 @@
+/**
+ * @file dop_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief DoP(DSD over PCM) 入力経路の検証 マーカー判定・PCMへの復帰・DSDデシメーション品質・処理量
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 2次 1bit ΔΣ で生成した DSD64/DSD128 正弦波を DoPパケットに詰め、dop_detect() / dop_decimator() を通す。
+ *        marker   : ロック前のミュート、マーカー誤り・途切れ時のミュートと PCMへの復帰、PCM の誤検出なし、
+ *                   非対応fs (DSD64 未満)、L/R マーカー不一致
+ *        quality  : 352.8/384kHz 出力の 20Hz~20kHz SNR (DSDビット列そのものの SNR との差) と
+ *                   1kHz 付近の正弦波レベル (DSD変調度 50% = -6.02dBFS)
+ *        idle     : DSD無音パターン(0x69)の出力 (リセット直後・定常)
+ *        load     : Core0 1入力フレーム当たりの見積もりサイクル(host/cycle_model.h)・ホスト実測時間
+ *                   DoP (dop_detect + dop_decimator) と PCM経路 (hbf_oversampler, 分担なし) の比較
+ *       いずれかの判定が NG の場合は終了コード 1
+ *       usage : dop_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+#define DB_FFT_N		16384		// 出力(352.8/384kHz)の FFT点数
+#define DB_TONE_BIN		46			// 正弦波 bin (352.8kHz : 990.5Hz, 384kHz : 1078.1Hz)
+#define DB_AMP			0.5			// DSD変調度 (SACD 0dB)
+#define DB_WARMUP		256			// 評価から除く先頭出力サンプル数
+#define DB_LOBE			4			// 正弦波の窓関数主ローブ [bin]
+#define DB_BAND_LO		20.0
+#define DB_BAND_HI		20000.0
+#define DB_SNR_LOSS		0.5			// 理想(DSDビット列の帯域内)SNR からの劣化 判定値 [dB]
+#define DB_LEVEL_TOL	0.05		// 正弦波レベル許容誤差 [dB]
+#define DB_IDLE_MAX		(1 << 10)	// 無音パターン出力の許容値 (-78dBFS)
+#define DB_LOAD_PACKETS	2000
+
+static int32_t out_buf[QUEUE_WIDTH * 2];
+
+// 2次 1bit ΔΣ (CIFB) DSD生成
+typedef struct {
+	double	s1, s2;
+	double	phase, step;		// 正弦波位相 [rad]
+} dsd_mod_t;
+
+static void dsd_mod_init(dsd_mod_t* m, double f, double fs_dsd, double phase){
+	m->s1 = m->s2 = 0;
+	m->phase = phase;
+	m->step = 2.0 * M_PI * f / fs_dsd;
+}
+
+static uint dsd_mod_bit(dsd_mod_t* m){
+	const double x = DB_AMP * sin(m->phase);
+	m->phase += m->step;
+	const double y = (m->s2 >= 0) ? 1.0 : -1.0;
+	m->s1 += x - y;
+	m->s2 += m->s1 - y;
+	return y > 0;
+}
+
+// DoP 1フレーム分 (16bit, MSB が時間的に先) の DSDデータ
+static uint32_t dsd_mod_word(dsd_mod_t* m){
+	uint32_t w = 0;
+	for(uint i = 0; i < 16; i++) w = (w << 1) | dsd_mod_bit(m);
+	return w;
+}
+
+// DoPパケット生成 marker : 次フレームのマーカー選択 (0/1, 呼出し毎に継続)
+static void dop_packet(int32_t* buf, uint len, dsd_mod_t* mod, uint* marker){
+	for(uint i = 0; i < len; i++){
+		const uint32_t m = *marker ? 0xFA : 0x05;
+		*marker ^= 1;
+		for(uint c = 0; c < N_CH; c++){
+			const uint32_t v = (m << 16) | dsd_mod_word(&mod[c]);
+			buf[i * N_CH + c] = (int32_t)(v << 8) >> 8;		// 24bit 右詰め符号拡張
+		}
+	}
+}
+
+// DSD無音パターン(0x69) の DoPパケット
+static void dop_silence(int32_t* buf, uint len, uint* marker){
+	for(uint i = 0; i < len; i++){
+		const uint32_t m = *marker ? 0xFA : 0x05;
+		*marker ^= 1;
+		for(uint c = 0; c < N_CH; c++) buf[i * N_CH + c] = (int32_t)(((m << 16) | 0x6969) << 8) >> 8;
+	}
+}
+
+static uint packet_len(uint fs){
+	return fs / 1000;
+}
+
+static uint dsd_byte_n(uint fs){
+	return (get_osr(fs) >= 8) ? 12 : 6;
+}
+
+static uint out_per_in(uint fs){
+	return (get_osr(fs) >= 8) ? 1 : 2;
+}
+
+static bool test_result(const char* name, bool ok){
+	printf("  %-44s %s\n", name, ok ? "OK" : "NG");
+	return ok;
+}
+
+// パケット列のマーカー判定 expect[] と一致するか
+static bool detect_seq(uint fs, uint len, const uint* expect, uint n, dsd_mod_t* mod, uint* marker, uint error_at){
+	bool ok = true;
+	for(uint p = 0; p < n; p++){
+		int32_t* buf = get_dsp_buf_pointer(fs);
+		dop_packet(buf, len, mod, marker);
+		if (p == error_at) buf[(len / 2) * N_CH] ^= 0x010000;		// マーカー1ビット誤り
+		const uint r = dop_detect(buf, len, fs);
+		if (r != expect[p]) ok = false;
+	}
+	return ok;
+}
+
+static bool test_marker(void){
+	bool ok = true;
+	dsd_mod_t mod[N_CH];
+	uint marker = 0;
+	printf("marker\n");
+
+	// ロック前のミュート : 8フレームのパケット 3個はミュート、4個目(32フレーム)でロック
+	{
+		static const uint e[] = {DOP_MUTE, DOP_MUTE, DOP_MUTE, DOP_DSD, DOP_DSD};
+		dop_detect_reset();
+		dsd_mod_init(&mod[0], 1000, 2822400, 0);
+		dsd_mod_init(&mod[1], 1000, 2822400, 1);
+		ok &= test_result("lock after 32 frames (8 frames/packet)", detect_seq(176400, 8, e, 5, mod, &marker, UINT32_MAX));
+	}
+	// マーカー誤り : そのパケットはミュート、次の正しいパケットで再ロック (1msパケット >= 32フレーム)
+	{
+		static const uint e[] = {DOP_DSD, DOP_DSD, DOP_MUTE, DOP_DSD, DOP_DSD};
+		dop_detect_reset();
+		ok &= test_result("marker error : mute, relock", detect_seq(176400, 176, e, 5, mod, &marker, 2));
+	}
+	// マーカー交互の乱れ (同一マーカー連続) : ミュート
+	{
+		dop_detect_reset();
+		int32_t* buf = get_dsp_buf_pointer(352800);
+		dop_packet(buf, 352, mod, &marker);
+		bool r = (dop_detect(buf, 352, 352800) == DOP_DSD);
+		marker ^= 1;
+		dop_packet(buf, 352, mod, &marker);
+		r &= (dop_detect(buf, 352, 352800) == DOP_MUTE);
+		ok &= test_result("marker sequence break across packets : mute", r);
+	}
+	// マーカー途切れ (DoP -> PCM) : 最初のパケットはミュート、以降 PCM
+	{
+		dop_detect_reset();
+		int32_t* buf = get_dsp_buf_pointer(176400);
+		dop_packet(buf, 176, mod, &marker);
+		bool r = (dop_detect(buf, 176, 176400) == DOP_DSD);
+		for(uint p = 0; p < 4; p++){
+			for(uint i = 0; i < 176; i++){
+				const int32_t s = (int32_t)lround(sin(2.0 * M_PI * 1000 * (p * 176 + i) / 176400) * (1 << 22));
+				buf[i * N_CH] = buf[i * N_CH + 1] = s;
+			}
+			r &= (dop_detect(buf, 176, 176400) == ((p == 0) ? DOP_MUTE : DOP_PCM));
+		}
+		ok &= test_result("DoP -> PCM : mute 1 packet, then PCM", r);
+	}
+	// PCM の誤検出なし : 各レベルの正弦波・無音・0x05xxxx 付近の定数
+	{
+		bool r = true;
+		static const double level[] = {1.0, 0.5, 0.031, 1e-3, 0.0};
+		for(uint l = 0; l < sizeof(level) / sizeof(level[0]); l++){
+			dop_detect_reset();
+			int32_t* buf = get_dsp_buf_pointer(192000);
+			for(uint p = 0; p < 200; p++){
+				for(uint i = 0; i < 192; i++){
+					const int32_t s = (int32_t)lround(sin(2.0 * M_PI * 997 * (p * 192 + i) / 192000) * level[l] * ((1 << 23) - 1));
+					buf[i * N_CH] = s;
+					buf[i * N_CH + 1] = -s;
+				}
+				r &= (dop_detect(buf, 192, 192000) == DOP_PCM);
+			}
+		}
+		dop_detect_reset();
+		int32_t* buf = get_dsp_buf_pointer(192000);
+		for(uint i = 0; i < 192 * N_CH; i++) buf[i] = 0x050000 + (int32_t)i;
+		for(uint p = 0; p < 8; p++) r &= (dop_detect(buf, 192, 192000) == DOP_PCM);
+		ok &= test_result("PCM never detected as DoP", r);
+	}
+	// 非対応fs : DoP形式でも PCM
+	{
+		static const uint fs_list[] = {44100, 48000, 88200, 96000};
+		bool r = true;
+		for(uint f = 0; f < sizeof(fs_list) / sizeof(fs_list[0]); f++){
+			dop_detect_reset();
+			int32_t* buf = get_dsp_buf_pointer(fs_list[f]);
+			for(uint p = 0; p < 4; p++){
+				dop_packet(buf, packet_len(fs_list[f]), mod, &marker);
+				r &= (dop_detect(buf, packet_len(fs_list[f]), fs_list[f]) == DOP_PCM);
+			}
+		}
+		ok &= test_result("44.1k-96k DoP-formatted data stays PCM", r);
+	}
+	// L/R マーカー不一致
+	{
+		dop_detect_reset();
+		int32_t* buf = get_dsp_buf_pointer(176400);
+		dop_packet(buf, 176, mod, &marker);
+		for(uint i = 0; i < 176; i++) buf[i * N_CH + 1] ^= 0xFF0000;		// 0x05 <-> 0xFA
+		ok &= test_result("L/R marker mismatch : PCM", dop_detect(buf, 176, 176400) == DOP_PCM);
+	}
+	dop_detect_reset();
+	return ok;
+}
+
+// Nuttall窓・FFT し、20Hz~20kHz の SNR[dB] と正弦波レベル[dB] (tone_bin) を求める
+static double band_snr(double complex* x, uint n, double fs, uint tone_bin, double* p_level){
+	// Nuttall窓 (連続1次導関数, 4項)
+	double wsum = 0;
+	for(uint i = 0; i < n; i++){
+		double t = 2.0 * M_PI * i / n;
+		double w = 0.355768 - 0.487396 * cos(t) + 0.144232 * cos(2 * t) - 0.012604 * cos(3 * t);
+		x[i] *= w;
+		wsum += w;
+	}
+	fft(x, n);
+	double sig = 0, noise = 0;
+	const double bin_hz = fs / n;
+	for(uint i = (uint)ceil(DB_BAND_LO / bin_hz); i <= (uint)(DB_BAND_HI / bin_hz); i++){
+		const double a = cabs(x[i]) * 2.0 / wsum;
+		const double p = a * a / 2.0;
+		if (i + DB_LOBE >= tone_bin && i <= tone_bin + DB_LOBE) sig += p;
+		else noise += p;
+	}
+	// 正弦波振幅 : 主ローブの電力和を等価雑音帯域幅 (Nuttall 2.02bin) で補正
+	*p_level = 10.0 * log10(sig / (0.5 * 2.0219));
+	return 10.0 * log10(sig / noise);
+}
+
+// DoP 正弦波のデコード品質 (Lch)
+// 試験用 DSD は2次ΔΣのため SNR の絶対値は DSD側で決まる。同じビット列を DSDレートのまま FFT した
+// 理想(帯域外遮断)の SNR との差を、デシメーション FIR の劣化(帯域内リップル・折り返し)として判定する
+static bool test_quality(void){
+	static const uint fs_list[] = {176400, 192000, 352800, 384000};
+	bool ok = true;
+	printf("\nquality (DSD modulator 2nd order, %.0f%% modulation, Lch)\n", DB_AMP * 100);
+	printf("  %-7s %-7s %5s %8s %10s %9s %9s %8s\n", "fs", "DSD", "taps", "fs out", "level[dB]", "SNR[dB]", "ideal", "loss");
+	for(uint f = 0; f < sizeof(fs_list) / sizeof(fs_list[0]); f++){
+		const uint fs = fs_list[f];
+		const uint fs_out = fs * out_per_in(fs);
+		const uint dec = 16 / out_per_in(fs);
+		const double fs_dsd = fs * 16.0;
+		const double tone = (double)DB_TONE_BIN * fs_out / DB_FFT_N;
+		double complex* x = malloc(sizeof(double complex) * DB_FFT_N);
+		double complex* d = malloc(sizeof(double complex) * DB_FFT_N * dec);
+		dsd_mod_t mod[N_CH];
+		dsd_mod_init(&mod[0], tone, fs_dsd, 0);
+		dsd_mod_init(&mod[1], tone, fs_dsd, M_PI);
+		uint marker = 0;
+		uint x_n = 0, d_n = 0, skip = DB_WARMUP, d_skip = DB_WARMUP * dec;
+		dsp_reset();
+		dop_detect_reset();
+		while(x_n < DB_FFT_N){
+			int32_t* buf = get_dsp_buf_pointer(fs);
+			uint len = packet_len(fs);
+			dop_packet(buf, len, mod, &marker);
+			if (dop_detect(buf, len, fs) != DOP_DSD) { ok = false; break; }
+			for(uint i = 0; i < len; i++){		// DSDビット列 (Lch, 出力と同じ区間)
+				for(uint b = 0; b < 16 && d_n < DB_FFT_N * dec; b++){
+					if (d_skip) { d_skip--; continue; }
+					d[d_n++] = ((buf[i * N_CH] >> (15 - b)) & 1) ? 1.0 : -1.0;
+				}
+			}
+			dop_decimator(&buf, &len, fs, out_buf);
+			for(uint i = 0; i < len && x_n < DB_FFT_N; i++){
+				if (skip) { skip--; continue; }
+				x[x_n++] = buf[i * N_CH] / (double)(1 << 23);
+			}
+		}
+		double level, level_ideal;
+		const double snr = band_snr(x, DB_FFT_N, fs_out, DB_TONE_BIN, &level);
+		const double snr_ideal = band_snr(d, DB_FFT_N * dec, fs_dsd, DB_TONE_BIN, &level_ideal);
+		const double level_ref = 20.0 * log10(DB_AMP);
+		const bool r = (snr_ideal - snr <= DB_SNR_LOSS) && (fabs(level - level_ref) <= DB_LEVEL_TOL);
+		printf("  %-7u DSD%-4u %5u %8u %10.3f %9.1f %9.1f %8.2f  %s\n", fs, (uint)(fs_dsd / (get_group_48k(fs) ? 48000 : 44100)),
+			dsd_byte_n(fs) * 8, fs_out, level, snr, snr_ideal, snr_ideal - snr, r ? "OK" : "NG");
+		ok &= r;
+		free(x);
+		free(d);
+	}
+	printf("  (level : 0dB = 24bit full scale, expected %.2fdB / ideal : same DSD bits, brick-wall 20kHz)\n", 20.0 * log10(DB_AMP));
+	return ok;
+}
+
+// DSD無音パターンの出力
+static bool test_idle(void){
+	static const uint fs_list[] = {176400, 352800};
+	bool ok = true;
+	printf("\nidle (0x69 pattern)\n");
+	for(uint f = 0; f < sizeof(fs_list) / sizeof(fs_list[0]); f++){
+		const uint fs = fs_list[f];
+		uint marker = 0;
+		int32_t peak = 0;
+		dsp_reset();
+		dop_detect_reset();
+		for(uint p = 0; p < 8; p++){
+			int32_t* buf = get_dsp_buf_pointer(fs);
+			uint len = packet_len(fs);
+			dop_silence(buf, len, &marker);
+			dop_detect(buf, len, fs);
+			dop_decimator(&buf, &len, fs, out_buf);
+			for(uint i = 0; i < len * N_CH; i++) if (abs(buf[i]) > peak) peak = abs(buf[i]);
+		}
+		const bool r = (peak <= DB_IDLE_MAX);
+		printf("  %-7u peak %6d (%6.1fdBFS)  %s\n", fs, peak, 20.0 * log10((peak + 0.5) / (double)(1 << 23)), r ? "OK" : "NG");
+		ok &= r;
+	}
+	return ok;
+}
+
+// PCM経路 (hbf_oversampler, 分担なし) の見積もりサイクル 1入力フレーム当たり
+static uint cyc_pcm_path(uint fs){
+	const uint n = hbf_get_stage_n(fs);
+	if (n == 0) return 2 * (CYC_LDR + CYC_STR) + CYC_LOOP;		// dsp_copy()
+	return cyc_hbf_fs(fs);
+}
+
+static double ns_per_frame(uint fs, bool dop){
+	uint marker = 0;
+	dsd_mod_t mod[N_CH];
+	dsd_mod_init(&mod[0], 1000, fs * 16.0, 0);
+	dsd_mod_init(&mod[1], 1000, fs * 16.0, 1);
+	const uint len = packet_len(fs);
+	static int32_t src[QUEUE_WIDTH];
+	dop_packet(src, len, mod, &marker);
+	dsp_reset();
+	dop_detect_reset();
+	os_split_set(fs, 0);
+	double ns = 0;
+	for(uint p = 0; p < DB_LOAD_PACKETS; p++){
+		int32_t* buf = get_dsp_buf_pointer(fs);
+		memcpy(buf, src, len * N_CH * sizeof(int32_t));
+		uint l = len;
+		const double t = now_ns();
+		if (dop) {
+			dop_detect(buf, l, fs);
+			dop_decimator(&buf, &l, fs, out_buf);
+		} else {
+			hbf_oversampler(&buf, &l, fs, out_buf);
+		}
+		ns += now_ns() - t;
+	}
+	dsp_reset();
+	return ns / ((double)DB_LOAD_PACKETS * len);
+}
+
+static bool test_load(void){
+	static const uint fs_list[] = {176400, 192000, 352800, 384000};
+	bool ok = true;
+	printf("\nload (Core0, per input frame, CLK_SYS = %.1fMHz)\n", CLK_SYS / 1e6);
+	printf("  %-7s %14s %14s %14s %14s\n", "fs", "DoP cyc/Core0", "PCM cyc/Core0", "DoP ns", "PCM ns");
+	for(uint f = 0; f < sizeof(fs_list) / sizeof(fs_list[0]); f++){
+		const uint fs = fs_list[f];
+		const uint cyc_dop = cyc_dop_detect() + cyc_dop_decimator(dsd_byte_n(fs), out_per_in(fs));
+		const uint cyc_pcm = cyc_pcm_path(fs);
+		const double load_dop = 100.0 * cyc_dop / cyc_budget(fs);
+		const double load_pcm = 100.0 * cyc_pcm / cyc_budget(fs);
+		printf("  %-7u %6u %6.1f%% %6u %6.1f%% %14.2f %14.2f\n", fs, cyc_dop, load_dop, cyc_pcm, load_pcm,
+			ns_per_frame(fs, true), ns_per_frame(fs, false));
+		ok &= (load_dop < 100.0);
+	}
+	printf("  (PCM : hbf_oversampler, no os split, no volume. DoP adds no Core1 stage)\n");
+	return ok;
+}
+
+int main(void){
+	printf("pico_1bit_dac_v2 dop_bench\n\n");
+	host_set_core_num(0);
+	dsp_init();
+	bool ok = test_marker();
+	ok &= test_quality();
+	ok &= test_idle();
+	ok &= test_load();
+	printf("\n%s\n", ok ? "OK" : "NG");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,283 @@
+/**
+ * @file ds_loop_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ΔΣループフィルタ CoI(積分器縦続) vs CRFB(係数・共振器付き) 処理サイクル・雑音・大振幅安定性の比較
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 直線補間(LI)の全プロファイルについて、384kHz PCM を pcm2pwm_frame() で直接変換し、Lch のビットストリームを
+ *       PIOプログラムのパルス幅列(デューティ -1~+1)に復号して以下を出力する。
+ *        cyc/sample : Cortex-M0+ 見積もりサイクル数 (L/R, host/cycle_model.h)  Core1[%] : 384kHz での負荷
+ *        SNR        : 996Hz -6dBFS の SNR [dB] (20Hz~20kHz, 高調波除く)
+ *        noise      : 無音時の帯域内雑音 [dBFS] (-6dBFS 正弦波の出力振幅から求めた 0dBFS 基準)
+ *        ovl 0dB    : 0dBFS 正弦波 100ms の積分器過負荷リセット回数 (CRFB のみ検出する)
+ *        max level  : 過負荷リセットが発生しない最大の正弦波レベル [dBFS] (0~+3dB, 0.5dB 毎)
+ *        recover    : +6dBFS 20ms のバースト後、-6dBFS 正弦波の出力がバーストなしの場合に一致するまでの時間 [ms]
+ *                     (8サンプル移動平均の差がデューティ 0.05 未満、100ms で一致しない場合は "-")
+ *       CRFB が同じ PWM分解能・次数の CoI より SNR・雑音で劣る場合、0dBFS 以下で過負荷となる場合、
+ *       バースト後に 1ms 以内に復帰しない場合は終了コード1を返す。
+ *       ファームウェアDSPチェーン全体での音質は quality_bench で確認する。
+ *       usage : ds_loop_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "pdm_output.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+// pdm_output.c の設定と合わせること
+#define BENCH_OS_INNER_N	4
+#define BENCH_BLOCK_N		8		// PCM2PWM_BLOCK_N
+
+#define B_FS			384000
+#define B_FRAME_N		384			// 1フレーム(1ms)のサンプル数
+#define B_FFT_IN_N		32768		// FFT長 (入力サンプル数換算) bin = 11.72Hz
+#define B_WARMUP_MS		20			// 評価前の空運転
+#define B_TONE_BIN		85			// 996.1Hz
+#define B_BAND_LO		20.0
+#define B_BAND_HI		20000.0
+#define B_LOBE			5			// 窓のメインローブ片側幅[bin]
+#define B_HARM_N		9
+
+#define B_FULL			(1 << 23)	// 0dBFS 振幅 (24bit)
+#define B_OVL_MS		100
+#define B_BURST_MS		20
+#define B_RECOVER_MS	100
+#define B_RECOVER_AVG	8			// 比較用移動平均 [sample]
+#define B_RECOVER_TOL	0.05		// 一致判定 (デューティ)
+#define B_RECOVER_LIM	1.0			// CRFB の復帰時間上限 [ms]
+
+// PIOプログラムのパルス幅 H = h0 + h_step * DATA (PWM周期 period [clk])  quality_bench.c と同じ
+typedef struct {
+	uint	period;
+	uint	h0;
+	uint	h_step;
+} pwm_shape_t;
+
+static const pwm_shape_t pwm_shape[3] = {
+	{ 68, 4, 4},	// 4bit
+	{ 68, 3, 2},	// 5bit
+	{136, 5, 2},	// 6bit
+};
+
+typedef struct {
+	uint	cyc;
+	double	snr;
+	double	noise;
+	uint	ovl_0db;
+	double	max_level;
+	double	recover_ms;		// < 0 : 復帰せず
+} result_t;
+
+static int32_t pcm_buf[B_FRAME_N * N_CH];
+static uint32_t bs_buf[B_FRAME_N * N_CH * 2];
+
+// 1フレーム変換し、Lch のデューティ列を x へ追加する (x = NULL : 変換のみ) 戻り値 : 追加したパルス数
+// level(n) : 入力サンプル n の振幅 (0dBFS = 1.0)
+static uint run_frame(const pcm2pwm_profile_t* prof, double (*level)(uint64_t), uint64_t* n, double* x, uint x_max){
+	const pwm_shape_t* shape = &pwm_shape[prof->pwm_bit - 4];
+	const uint32_t mask = (1u << prof->pwm_bit) - 1;
+	for(uint i = 0; i < B_FRAME_N; i++, (*n)++){
+		const int32_t s = (int32_t)lround(sin(2.0 * M_PI * B_TONE_BIN * (double)*n / B_FFT_IN_N) * level(*n) * B_FULL);
+		pcm_buf[i * 2 + 0] = s;
+		pcm_buf[i * 2 + 1] = -s;
+	}
+	pcm2pwm_frame(pcm_buf, B_FRAME_N, bs_buf);
+	if (x == NULL) return 0;
+	uint x_n = 0;
+	for(uint i = 0; i < B_FRAME_N * pcm2pwm_get_bs_n() && x_n < x_max; i++){		// Lch面
+		for(uint k = 0; k < 4 && x_n < x_max; k++){
+			uint d = (bs_buf[i] >> (k * prof->pwm_bit)) & mask;
+			double h = shape->h0 + (double)shape->h_step * d;
+			x[x_n++] = (2.0 * h - shape->period) / shape->period;
+		}
+	}
+	return x_n;
+}
+
+static double level_value;
+static double level_const(uint64_t n){
+	(void)n;
+	return level_value;
+}
+
+// 一定レベルの正弦波のパルス幅列の電力スペクトル(片側, 正弦波電力換算)
+static double* run_spectrum(uint profile, double level, uint* p_fft_n){
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(profile);
+	pcm2pwm_init(profile);
+	const uint fft_n = B_FFT_IN_N * pcm2pwm_get_bs_n() * 4;
+	double* d = malloc(sizeof(double) * fft_n);
+	uint64_t n = 0;
+	level_value = level;
+	for(uint f = 0; f < B_WARMUP_MS; f++) run_frame(prof, level_const, &n, NULL, 0);
+	n = 0;	// FFT区間の先頭を位相0とする (コヒーレント)
+	for(uint x_n = 0; x_n < fft_n; ) x_n += run_frame(prof, level_const, &n, &d[x_n], fft_n - x_n);
+
+	double complex* x = malloc(sizeof(double complex) * fft_n);
+	double wsum = 0;
+	for(uint i = 0; i < fft_n; i++){		// Nuttall窓
+		double t = 2.0 * M_PI * i / fft_n;
+		double w = 0.355768 - 0.487396 * cos(t) + 0.144232 * cos(2 * t) - 0.012604 * cos(3 * t);
+		x[i] = d[i] * w;
+		wsum += w;
+	}
+	fft(x, fft_n);
+	double* psd = malloc(sizeof(double) * fft_n / 2);
+	for(uint i = 0; i < fft_n / 2; i++){
+		double a = cabs(x[i]) * 2.0 / wsum;
+		psd[i] = a * a / 2.0;
+	}
+	free(x);
+	free(d);
+	*p_fft_n = fft_n;
+	return psd;
+}
+
+static bool near_bin(int i, int k){
+	return (i >= k - B_LOBE) && (i <= k + B_LOBE);
+}
+
+// SNR(-6dBFS), 無音時雑音
+static void measure_noise(uint profile, result_t* r){
+	const double bin_hz = (double)B_FS / B_FFT_IN_N;
+	const int lo = (int)ceil(B_BAND_LO / bin_hz) > B_LOBE ? (int)ceil(B_BAND_LO / bin_hz) : B_LOBE + 1;
+	const int hi = (int)floor(B_BAND_HI / bin_hz);
+	uint fft_n;
+
+	double* psd = run_spectrum(profile, 0.5, &fft_n);
+	double sig = 0, noise = 0;
+	for(int i = B_TONE_BIN - B_LOBE; i <= B_TONE_BIN + B_LOBE; i++) sig += psd[i];
+	for(int i = lo; i <= hi; i++){
+		bool harm = false;
+		for(int h = 1; h <= B_HARM_N; h++) harm = harm || near_bin(i, B_TONE_BIN * h);
+		if (!harm) noise += psd[i];
+	}
+	r->snr = 10.0 * log10(sig / noise);
+	const double fs_power = sig * 4.0;
+	free(psd);
+
+	psd = run_spectrum(profile, 0.0, &fft_n);
+	noise = 0;
+	for(int i = lo; i <= hi; i++) noise += psd[i];
+	r->noise = 10.0 * log10(noise / fs_power + 1e-30);
+	free(psd);
+}
+
+// 一定レベルの正弦波 B_OVL_MS の過負荷リセット回数
+static uint count_overload(uint profile, double level){
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(profile);
+	pcm2pwm_init(profile);
+	uint64_t n = 0;
+	level_value = level;
+	const uint ovl0 = pcm2pwm_get_overload_n();
+	for(uint f = 0; f < B_OVL_MS; f++) run_frame(prof, level_const, &n, NULL, 0);
+	return pcm2pwm_get_overload_n() - ovl0;
+}
+
+static double level_burst(uint64_t n){
+	return (n < (uint64_t)B_BURST_MS * B_FRAME_N) ? 2.0 : 0.5;
+}
+static double level_half(uint64_t n){
+	(void)n;
+	return 0.5;
+}
+
+// バースト後の復帰時間 [ms] (バースト終了から)  復帰しない場合は -1
+static double measure_recover(uint profile){
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(profile);
+	const uint pulse_n = pcm2pwm_get_bs_n() * 4;		// パルス数/サンプル (pcm2pwm_init 後)
+	const uint total = (B_BURST_MS + B_RECOVER_MS) * B_FRAME_N;
+	double* y[2];
+	for(uint k = 0; k < 2; k++){
+		pcm2pwm_init(profile);
+		const uint px = B_FRAME_N * pcm2pwm_get_bs_n() * 4;
+		double* d = malloc(sizeof(double) * px);
+		y[k] = calloc(total, sizeof(double));
+		uint64_t n = 0;
+		for(uint f = 0; f < B_BURST_MS + B_RECOVER_MS; f++){
+			run_frame(prof, k ? level_half : level_burst, &n, d, px);
+			for(uint i = 0; i < B_FRAME_N; i++){
+				double s = 0;
+				for(uint j = 0; j < pulse_n; j++) s += d[i * pulse_n + j];
+				y[k][f * B_FRAME_N + i] = s / pulse_n;
+			}
+		}
+		free(d);
+	}
+	// バースト終了後、最後に不一致となったサンプル
+	int last = -1;
+	const uint start = B_BURST_MS * B_FRAME_N;
+	for(uint i = start; i + B_RECOVER_AVG <= total; i++){
+		double a = 0;
+		for(uint j = 0; j < B_RECOVER_AVG; j++) a += y[0][i + j] - y[1][i + j];
+		if (fabs(a / B_RECOVER_AVG) >= B_RECOVER_TOL) last = (int)(i - start);
+	}
+	free(y[0]);
+	free(y[1]);
+	if (last >= (int)(total - start - B_FRAME_N)) return -1.0;	// 最後の 1ms まで不一致
+	return (double)(last + 1) * 1000.0 / B_FS;
+}
+
+int main(void){
+	bool fail = false;
+	const double budget = cyc_budget(B_FS);
+	const uint prof_n = pcm2pwm_get_profile_n();
+	result_t* res = calloc(prof_n, sizeof(result_t));
+
+	host_set_core_num(1);
+	printf("pico_1bit_dac_v2 ds_loop_bench : CLK_SYS %.1fMHz, fs = %uHz, FFT bin = %.2fHz, band %.0f~%.0fHz\n\n",
+		CLK_SYS / 1e6, B_FS, (double)B_FS / B_FFT_IN_N, B_BAND_LO, B_BAND_HI);
+	printf("  %-3s %-3s %-3s %-4s | %6s %8s | %8s %8s | %7s %9s %8s | %s\n",
+		"no", "bit", "ds", "lf", "cyc", "Core1[%]", "SNR", "noise", "ovl 0dB", "max level", "recover", "vs CoI");
+
+	for(uint p = 0; p < prof_n; p++){
+		const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(p);
+		if (prof->os_type != 1) continue;
+		result_t* r = &res[p];
+		pcm2pwm_init(p);
+		r->cyc = 2 * cyc_pcm2pwm_block_prof(prof, BENCH_OS_INNER_N, pcm2pwm_get_bs_n(), BENCH_BLOCK_N);
+		measure_noise(p, r);
+		r->ovl_0db = count_overload(p, 1.0);
+		r->max_level = -1.0;
+		for(double db = 0.0; db <= 3.0; db += 0.5){
+			if (count_overload(p, pow(10.0, db / 20.0)) != 0) break;
+			r->max_level = db;
+		}
+		r->recover_ms = measure_recover(p);
+
+		// 同じ PWM分解能・次数の CoI (LI) との比較
+		char cmp[48] = "";
+		bool ng = false;
+		if (prof->ds_type == DS_TYPE_CRFB) {
+			for(uint c = 0; c < p; c++){
+				const pcm2pwm_profile_t* q = pcm2pwm_get_profile(c);
+				if (q->os_type != 1 || q->ds_type != DS_TYPE_COI || q->pwm_bit != prof->pwm_bit || q->ds_order != prof->ds_order) continue;
+				snprintf(cmp, sizeof(cmp), "#%u SNR %+.1fdB noise %+.1fdB", c, r->snr - res[c].snr, r->noise - res[c].noise);
+				if (r->snr < res[c].snr || r->noise > res[c].noise) ng = true;
+			}
+			if (r->ovl_0db != 0 || r->recover_ms < 0.0 || r->recover_ms > B_RECOVER_LIM) ng = true;
+		}
+		if (ng) fail = true;
+
+		char rec[16];
+		if (r->recover_ms < 0.0) snprintf(rec, sizeof(rec), "-");
+		else                     snprintf(rec, sizeof(rec), "%.2f", r->recover_ms);
+		char lvl[16];
+		if (r->max_level < 0.0) snprintf(lvl, sizeof(lvl), "<0.0");
+		else                    snprintf(lvl, sizeof(lvl), "%+.1f", r->max_level);
+		printf("  %-3u %-3u %-3u %-4s | %6u %8.2f | %8.2f %8.2f | %7u %9s %8s | %s%s\n",
+			p, prof->pwm_bit, prof->ds_order, (prof->ds_type == DS_TYPE_CRFB) ? "CRFB" : "CoI",
+			r->cyc, 100.0 * r->cyc / budget, r->snr, r->noise, r->ovl_0db, lvl, rec, cmp, ng ? " NG" : "");
+	}
+	printf("\n  max level : CoI は過負荷を検出しないため常に +3.0 となる (復帰時間で安定性を確認する)\n");
+
+	free(res);
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
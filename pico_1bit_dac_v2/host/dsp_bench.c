@@ -0,0 +1,286 @@
+/**
+ * @file dsp_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief DSP/PDM処理チェーン ホストベンチマーク
+ * @version 0.01
+ * @date 2026-10-17
+ * @note dsp.c / pdm_output.c をinterpモデル(host/include/hardware/interp.h)上で実行し、
+ *       処理段毎の実測時間[ns/sample]と Cortex-M0+ 見積もりサイクル数[cycle/sample]を出力する。
+ *       入力fs 44.1k~384k の各々について main.c と同一の処理順で実行する。
+ *         Core0 : hbf_oversampler(初段で音量処理 + hbf1~3) -> asrc
+ *         Core1 : pcm2pwm(x8/x4 補間 + ΔΣ, ブロック単位) -> PIO出力(DMA)
+ *       最後に処理時間計測(prof.h)の集計を、実機の UARTコマンド t と同じ書式で出力する。
+ *       先頭 SINK_PACKET_N パケットの pcm2pwm 出力は Core1 の見積もりサイクルに従う時刻で
+ *       PIOモデル(host/pio_sink.h, pdm_dma_feed() と同じ手順の DMAチャネルモデル -> TX FIFO -> 生成PWMプログラム)に供給し、
+ *       以下を確認する。
+ *         nominal : アンダーランなし・全 code の波形一致・L/R 位相一致 (slack = Core1 が停止できる余裕)
+ *         stall   : 中間の面で slack の 90% 停止 -> アンダーランなし
+ *                   slack + SINK_STALL_US 停止 -> アンダーラン 1回 (FIFO空の中心レベル出力後に復帰し code 一致)
+ *         いずれも DMA の設定範囲外の読出し(garbage)・転送が終わらない(hang)ことがない
+ *       いずれかのコアの見積もり負荷が100%を超えた場合、または PIOモデルの確認に失敗した場合は終了コード1を返す。
+ *       usage : dsp_bench [packets]   packets : 1fsあたりの処理パケット数(1packet=1ms) default 1000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "pdm_output.h"
+#include "prof.h"
+#include "cycle_model.h"
+#include "pio_sink.h"
+#include "bench_util.h"
+
+// pdm_output.c の設定と合わせること
+#define BENCH_OS_INNER_N	4
+#define BENCH_BLOCK_N		8
+#define BENCH_CHUNK_N		48		// PDM_DMA_CHUNK_N
+
+#define BENCH_VOL_MUL		128		// volume 0dB (x128 >> 7)
+#define BENCH_VOL_SHIFT		7
+#define BENCH_ASRC_PITCH	(1u << 22)	// ASRC ピッチ 1.0
+
+#define SINK_PACKET_N		20		// PIOモデルに供給するパケット数
+#define SINK_STALL_US		20		// デッドライン超過の模擬 : slack を超えて停止する時間[us]
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+
+typedef struct {
+	const char*	name;
+	uint		rate;		// 処理段の入力レート[Hz]
+	double		ns;			// 累積処理時間[ns]
+	uint64_t	samples;	// 累積処理サンプル数(L/R=1sample)
+	uint		cyc;		// 見積もりサイクル数/sample
+} stage_t;
+
+static int32_t src_buf[QUEUE_WIDTH];
+static int32_t work_buf[2][QUEUE_WIDTH];
+static uint32_t bs_buf[QUEUE_WIDTH * 2];
+static uint32_t sink_bs[N_CH][SINK_PACKET_N * QUEUE_WIDTH];
+static pio_sink_t sink;
+static bool sink_ng;
+static uint64_t sink_slack_at;	// stall_at 番目の面の slack [pio clk]
+
+// -6dBFS 997Hz 24bit サイン波 (L/R逆相)
+static void make_source(int32_t* buf, uint len, uint fs, uint64_t* phase){
+	for(uint i = 0; i < len; i++){
+		double s = sin(2.0 * M_PI * 997.0 * (double)(*phase)++ / fs) * (double)(1 << 22);
+		*buf++ = (int32_t)s;
+		*buf++ = -(int32_t)s;
+	}
+}
+
+static void stage_add(stage_t* st, double t0, double t1, uint len){
+	st->ns += t1 - t0;
+	st->samples += len;
+}
+
+static void print_stage(const stage_t* st){
+	double load = 100.0 * st->cyc / cyc_budget(st->rate);
+	char ns[16] = "-";	// ホストで実行しない処理段(PIO出力)は見積もりのみ
+	if (st->samples) snprintf(ns, sizeof(ns), "%.2f", st->ns / st->samples);
+	printf("  %-16s %7u %10s %10u %10.1f %8.2f\n",
+		st->name, st->rate, ns, st->cyc, cyc_budget(st->rate), load);
+}
+
+static double stage_load(const stage_t* st){
+	return st->cyc * (double)st->rate / CLK_SYS;
+}
+
+// sink_bs を PDM_DMA_CHUNK_N サンプルの面毎に PIOモデルへ供給する
+// stall_at 番目の面の変換前に Core1 を stall [cycle] 停止させる
+static bool sink_run(uint pwm_bit, bool fs48, uint words, uint bs_n, uint core1_cyc, uint stall_at, uint stall){
+	if (!pio_sink_init(&sink, pwm_bit, fs48)) return false;
+	const uint chunk = BENCH_CHUNK_N * bs_n;
+	for(uint i = 0, k = 0; i < words; i += chunk, k++){
+		const uint n = (words - i < chunk) ? words - i : chunk;
+		const uint cyc = (n / bs_n) * core1_cyc + cyc_dma_chunk();
+		pio_sink_chunk(&sink, &sink_bs[0][i], &sink_bs[1][i], n, cyc, (k == stall_at) ? stall : 0);
+		if (k == stall_at) sink_slack_at = sink.slack_last;
+	}
+	pio_sink_drain(&sink, 8);
+	return true;
+}
+
+static bool sink_result(const char* name, uint underrun_expected){
+	uint match = 0, total = 0, ng = 0, other = 0, left = 0;
+	for(uint c = 0; c < N_CH; c++){
+		const pio_sink_ch_t* ch = &sink.ch[c];
+		match += ch->match_n;
+		ng += ch->ng_n;
+		other += ch->other_n;
+		left += ch->code_n;
+		total += ch->match_n + ch->ng_n + ch->code_n;
+	}
+	const bool ok = !ng && !left && !sink.lr_ng && !sink.dma.garbage && !sink.hang && sink.underrun_n == underrun_expected;
+	printf("  %-16s slack %7.2fus, wait %5.1f%%, underrun %u, center %u, codes %u/%u, NG %u, other %u, L/R NG %u, garbage %u%s : %s\n",
+		name, pio_sink_clk_us(sink.steady ? sink.slack_min : 0), 100.0 * sink.wait_clk / sink.pio.clk,
+		sink.underrun_n, sink.center_n, match, total, ng, other, sink.lr_ng, sink.dma.garbage, sink.hang ? ", DMA hang" : "", ok ? "OK" : "NG");
+	return ok;
+}
+
+// 1fs分のベンチマーク 戻り値:見積もり負荷の大きい方のコア負荷
+static double bench_fs(uint fs, uint packets){
+	const uint pcm2pwm_fs = get_group_48k(fs) ? 384000 : 352800;
+	const uint bs_n = pcm2pwm_get_bs_n();
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(PCM2PWM_PROFILE_DEFAULT);
+	uint osr_n = 0;		// hbf段数
+	for(uint r = fs; r < 352800; r <<= 1) osr_n++;
+	const uint first = hbf_get_first_stage(fs);		// hbf初段 (入力fs別プロファイル)
+
+	stage_t st_vol  = {"volume (fused)",  fs,         0, 0, cyc_volume_fused()};	// hbf_oversampler 初段に含む (ns は hbf_oversampler に計上)
+	stage_t st_hbf  = {"hbf_oversampler", fs,         0, 0, cyc_hbf_fs(fs)};	// HBF_STREAM = 1
+	stage_t st_asrc = {"asrc",            pcm2pwm_fs, 0, 0, cyc_asrc()};
+	stage_t st_pwm  = {"pcm2pwm",         pcm2pwm_fs, 0, 0, 2 * cyc_pcm2pwm_block_prof(prof, BENCH_OS_INNER_N, bs_n, BENCH_BLOCK_N)};
+	stage_t st_pio  = {"pio feed (DMA)",  pcm2pwm_fs, 0, 0, (cyc_dma_chunk() + BENCH_CHUNK_N - 1) / BENCH_CHUNK_N};
+	stage_t st_hbfn[3] = {
+		{"  hbf1_x2", 0, 0, 0, cyc_hbf_stage(0)},
+		{"  hbf2_x2", 0, 0, 0, cyc_hbf_stage(1)},
+		{"  hbf3_x2", 0, 0, 0, cyc_hbf_stage(2)},
+	};
+	for(uint n = 0; n < osr_n; n++) st_hbfn[first + n].rate = fs << n;		// 段の入力レート (初段 = fs)
+
+	uint64_t phase = 0;
+	const uint packet_len = fs / 1000;
+	uint sink_words = 0;
+
+	host_set_core_num(0);
+	dsp_reset();
+	volume_reset(BENCH_VOL_MUL, BENCH_VOL_SHIFT);
+	queue_init(QUEUE_MODE_ROBUST);
+	prof_set_fs(fs);
+	host_set_core_num(1);
+	pcm2pwm_reset();
+
+	// main.c と同一の処理順で実行 (hbf_oversampler(音量処理込み) -> asrc -> pcm2pwm)
+	for(uint p = 0; p < packets; p++){
+		host_set_core_num(0);
+		int32_t* dsp_buf = get_dsp_buf_pointer(fs);
+		uint len = packet_len;
+		make_source(dsp_buf, len, fs, &phase);
+
+		uint32_t t_enq = prof_now();
+		int32_t* q_buf = queue_acquire();
+		t_enq = prof_now() - t_enq;
+		double t1 = now_ns();
+		hbf_oversampler(&dsp_buf, &len, fs, get_dsp_buf_pointer(384000));
+		double t2 = now_ns();
+		stage_add(&st_hbf, t1, t2, packet_len);
+
+		uint len_asrc = len;
+		asrc(&dsp_buf, &len, BENCH_ASRC_PITCH, q_buf);
+		double t3 = now_ns();
+		stage_add(&st_asrc, t2, t3, len_asrc);
+		uint32_t t_pub = prof_now();
+		queue_publish(len);
+		prof_record(PROF_ENQUEUE, (t_enq + prof_now() - t_pub) & PROF_TICK_MASK);
+
+		host_set_core_num(1);
+		uint32_t q_len = 0;
+		dequeue(&dsp_buf, &q_len);
+		double t4 = now_ns();
+		PROF_BEGIN(PROF_PCM2PWM);
+		pcm2pwm_frame(dsp_buf, q_len, bs_buf);
+		PROF_END(PROF_PCM2PWM);
+		double t5 = now_ns();
+		stage_add(&st_pwm, t4, t5, len);
+
+		if (p < SINK_PACKET_N) {
+			const uint plane = q_len * bs_n;
+			memcpy(&sink_bs[0][sink_words], &bs_buf[0], plane * sizeof(uint32_t));
+			memcpy(&sink_bs[1][sink_words], &bs_buf[plane], plane * sizeof(uint32_t));
+			sink_words += plane;
+		}
+	}
+
+	// hbf 各段を個別に計測 (hbf_oversampler と同一の段構成)
+	host_set_core_num(0);
+	hbf_oversampler_reset();
+	phase = 0;
+	for(uint p = 0; p < packets; p++){
+		uint len = packet_len;
+		make_source(src_buf, len, fs, &phase);
+		int32_t* p_i = src_buf;
+		for(uint n = 0; n < osr_n; n++){
+			int32_t* p_o = work_buf[n & 1];
+			uint len_i = len;
+			double t0 = now_ns();
+			switch(first + n){
+				case 0: hbf1_x2_oversampler(p_i, p_o, &len); break;
+				case 1: hbf2_x2_oversampler(p_i, p_o, &len); break;
+				case 2: hbf3_x2_oversampler(p_i, p_o, &len); break;
+			}
+			double t1 = now_ns();
+			stage_add(&st_hbfn[first + n], t0, t1, len_i);
+			p_i = p_o;
+		}
+	}
+
+	double load0 = stage_load(&st_vol) + stage_load(&st_hbf) + stage_load(&st_asrc);
+	double load1 = stage_load(&st_pwm) + stage_load(&st_pio);
+
+	printf("fs = %uHz (%u packets x %u samples)\n", fs, packets, packet_len);
+	printf("  %-16s %7s %10s %10s %10s %8s\n", "stage", "rate", "ns/sample", "cyc/sample", "budget", "load[%]");
+	print_stage(&st_vol);
+	print_stage(&st_hbf);
+	for(uint n = 0; n < osr_n; n++) print_stage(&st_hbfn[first + n]);
+	print_stage(&st_asrc);
+	printf("  %-16s %62.2f\n", "Core0 total", 100.0 * load0);
+	print_stage(&st_pwm);
+	print_stage(&st_pio);
+	printf("  %-16s %62.2f\n", "Core1 total", 100.0 * load1);
+
+	// PIOモデル : 通常 -> 中間の面で slack の 90% 停止 -> slack + SINK_STALL_US 停止
+	const bool fs48 = get_group_48k(fs);
+	const uint stall_at = sink_words / (BENCH_CHUNK_N * bs_n) / 2;
+	if (stall_at < 2) {		// 定常状態(2面転送待ち)に達しない
+		printf("  %-16s skipped (packets < %u)\n\n", "pio sink", SINK_PACKET_N);
+		return (load0 > load1) ? load0 : load1;
+	}
+	bool ok = sink_run(prof->pwm_bit, fs48, sink_words, bs_n, st_pwm.cyc, stall_at, 0);
+	ok = ok && sink_result("pio sink", 0);
+	const uint64_t slack_min = sink.slack_min;
+	const uint64_t slack_at = sink_slack_at;
+	ok = ok && sink_run(prof->pwm_bit, fs48, sink_words, bs_n, st_pwm.cyc, stall_at, (uint)(slack_min * CLOCK_PLAN_PIO_DIV * 9 / 10));
+	ok = ok && sink_result("  stall 90%", 0);
+	// 面の変換中の OSR 残り(最大 1ワード)を含めて確実に超過させる
+	const uint64_t over = slack_at + 4 * sink.cycle;
+	ok = ok && sink_run(prof->pwm_bit, fs48, sink_words, bs_n, st_pwm.cyc, stall_at, (uint)(over * CLOCK_PLAN_PIO_DIV + (uint64_t)SINK_STALL_US * CLK_SYS / 1000000));
+	ok = ok && sink_result("  stall +20us", 1);
+	if (!ok) sink_ng = true;
+	printf("\n");
+
+	return (load0 > load1) ? load0 : load1;
+}
+
+int main(int argc, char* argv[]){
+	uint packets = (argc > 1) ? (uint)atoi(argv[1]) : 1000;
+
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(PCM2PWM_PROFILE_DEFAULT);
+	printf("pico_1bit_dac_v2 dsp_bench : CLK_SYS = %.1fMHz, PWM_BIT = %d, DS_ORDER = %d\n\n",
+		CLK_SYS / 1e6, prof->pwm_bit, prof->ds_order);
+
+	host_set_core_num(0);
+	dsp_init();
+	prof_init_core();
+	host_set_core_num(1);
+	pcm2pwm_init(PCM2PWM_PROFILE_DEFAULT);
+	prof_init_core();
+
+	double load_max = 0;
+	for(uint i = 0; i < sizeof(fs_list) / sizeof(fs_list[0]); i++){
+		double load = bench_fs(fs_list[i], packets);
+		if (load > load_max) load_max = load;
+	}
+
+	printf("stage timing (prof.h)\n");
+	prof_dump();
+	printf("\nmax core load (estimated) : %.2f%%\n", 100.0 * load_max);
+	if (sink_ng) printf("pio sink : NG\n");
+	return (load_max > 1.0 || sink_ng) ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file fs_profile_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 入力fs別フィルタプロファイル(HBF_FS_PROFILE) 全入力fsの Core0 処理量・周波数特性 従来(hbf1 から連結)との比較
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 入力fs毎に、従来構成(全fsで hbf1 から連結)と入力fs別プロファイル(hbf_get_first_stage() の段から連結)について
+ *       以下を出力する。
+ *        stages     : 連結する段
+ *        cyc/frame  : hbf_oversampler() 1入力フレーム(L/R)当たりの Core0 見積もりサイクル (host/cycle_model.h, HBF_STREAM = 1)
+ *        Core0[%]   : 見積もりCore0負荷 (分担なし)
+ *        ripple     : 通過域(0~20kHz)リプル[dB]
+ *        image      : 可聴帯域のイメージ(k・fs ± 20kHz, k ≧ 1)の最大レベル[dB]
+ *        flat       : DCから連続して ±FLAT_DB 以内の帯域[kHz]
+ *                     プロファイルの各段は可聴帯域(~20kHz)を対象に設計しているため、従来より狭くなる (判定しない)
+ *                     ハイレゾ入力の超音波成分(20kHz ~ fs/2)の減衰・イメージ抑圧は従来より緩い
+ *       周波数特性は インパルス応答から求める。プロファイル側は hbf_oversampler() (ファームウェアと同じ経路) で測る。
+ *       プロファイルの段構成・処理量が従来と異なる入力fs(88.2kHz以上)で、リプル・イメージが許容値を超える、
+ *       または処理量が従来以上の場合は終了コード1を返す。
+ *       usage : fs_profile_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "cycle_model.h"
+
+#define IMPULSE_LEVEL	(1 << 21)	// 周波数特性測定用インパルス振幅
+#define IMPULSE_LEN		64			// 周波数特性測定用入力サンプル数
+#define PASSBAND_EDGE	20000.0		// 通過域端[Hz]
+#define FLAT_DB			0.1			// flat 帯域の判定幅[dB]
+#define RIPPLE_MAX		0.05		// プロファイルの通過域リプル許容値[dB]
+#define IMAGE_MAX		(-60.0)		// プロファイルのイメージ許容値[dB]
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+#define FS_N	(sizeof(fs_list) / sizeof(fs_list[0]))
+
+static int32_t work_buf[2][IMPULSE_LEN * 8 * N_CH];
+static int32_t out_buf[IMPULSE_LEN * 8 * N_CH];
+
+typedef struct {
+	uint	first;		// 初段 (0~2 = hbf1~3)
+	uint	cyc;		// 見積もりサイクル/入力フレーム
+	double	ripple, image, flat;
+} prof_result_t;
+
+// 従来構成 hbf(first+1) から n_stage 段の段毎処理 (インパルス応答測定用)
+static int32_t* run_chain(int32_t* p_i, uint* p_len, uint first, uint n_stage){
+	for(uint n = 0; n < n_stage; n++){
+		int32_t* p_o = work_buf[n & 1];
+		switch(first + n){
+			case 0: hbf1_x2_oversampler(p_i, p_o, p_len); break;
+			case 1: hbf2_x2_oversampler(p_i, p_o, p_len); break;
+			case 2: hbf3_x2_oversampler(p_i, p_o, p_len); break;
+		}
+		p_i = p_o;
+	}
+	return p_i;
+}
+
+// インパルス応答 h[n] (Lch, 出力レート fs*l) の周波数特性
+static void measure_response(const int32_t* h, uint n, uint l, uint fs, prof_result_t* r){
+	const double fo = (double)fs * l;
+	double pb_max = -1e9, pb_min = 1e9, im_max = -300.0;
+	bool flat = true;
+	r->flat = 0;
+	for(double f = 0; f <= fo / 2; f += 100.0){
+		double re = 0, im = 0;
+		for(uint i = 0; i < n; i++){
+			re += h[i * N_CH] * cos(2.0 * M_PI * f * i / fo);
+			im -= h[i * N_CH] * sin(2.0 * M_PI * f * i / fo);
+		}
+		const double db = 20.0 * log10(sqrt(re * re + im * im) / ((double)IMPULSE_LEVEL * l) + 1e-12);
+		if (flat && fabs(db) <= FLAT_DB) r->flat = f;
+		else flat = false;
+		const double k = floor(f / fs + 0.5);			// 最寄りの fs の倍数
+		if (f <= PASSBAND_EDGE) {
+			if (db > pb_max) pb_max = db;
+			if (db < pb_min) pb_min = db;
+		} else if (k >= 1 && fabs(f - k * fs) <= PASSBAND_EDGE) {
+			if (db > im_max) im_max = db;
+		}
+	}
+	r->ripple = pb_max - pb_min;
+	r->image = im_max;
+}
+
+// 従来構成 : hbf1 から n 段
+static void bench_legacy(uint fs, prof_result_t* r){
+	const uint n = hbf_get_stage_n(fs);
+	r->first = 0;
+	r->cyc = (n >= 2) ? cyc_hbf_stream(0, n) : cyc_hbf_cascade(0, n);
+	static int32_t src[IMPULSE_LEN * N_CH];
+	memset(src, 0, sizeof(src));
+	src[0] = IMPULSE_LEVEL;
+	uint len = IMPULSE_LEN;
+	hbf_oversampler_reset();
+	const int32_t* h = (n == 0) ? src : run_chain(src, &len, 0, n);
+	measure_response(h, len, 1 << n, fs, r);
+}
+
+// 入力fs別プロファイル : hbf_oversampler() (分担なし)
+static void bench_profile(uint fs, prof_result_t* r){
+	const uint n = hbf_get_stage_n(fs);
+	r->first = hbf_get_first_stage(fs);
+	r->cyc = cyc_hbf_fs(fs);
+	dsp_reset();
+	os_split_set(fs, 0);
+	int32_t* buf = get_dsp_buf_pointer(fs);
+	memset(buf, 0, sizeof(int32_t) * IMPULSE_LEN * N_CH);
+	buf[0] = IMPULSE_LEVEL;
+	uint len = IMPULSE_LEN;
+	hbf_oversampler(&buf, &len, fs, out_buf);
+	measure_response(buf, len, 1 << n, fs, r);
+}
+
+static void stage_name(char* s, uint first, uint n){
+	s[0] = '\0';
+	if (n == 0) strcpy(s, "-");
+	for(uint i = 0; i < n; i++) sprintf(s + strlen(s), "%shbf%u", i ? "-" : "", first + i + 1);
+}
+
+int main(void){
+	bool fail = false;
+	host_set_core_num(0);
+	dsp_init();
+
+	printf("pico_1bit_dac_v2 fs_profile_bench : CLK_SYS %.1fMHz, HBF_STREAM = 1, no os split\n", CLK_SYS / 1e6);
+	printf("  legacy : hbf1 first for all fs, profile : hbf_get_first_stage()\n\n");
+	printf("  %-7s %-8s %-16s %9s %8s %10s %9s %9s\n",
+		"fs", "", "stages", "cyc/frame", "Core0[%]", "ripple[dB]", "image[dB]", "flat[kHz]");
+	for(uint f = 0; f < FS_N; f++){
+		const uint fs = fs_list[f];
+		const uint n = hbf_get_stage_n(fs);
+		prof_result_t r[2];
+		char fs_str[16];
+		sprintf(fs_str, "%u", fs);
+		bench_legacy(fs, &r[0]);
+		bench_profile(fs, &r[1]);
+		for(uint p = 0; p < 2; p++){
+			char st[32];
+			stage_name(st, r[p].first, n);
+			printf("  %-7s %-8s %-16s %9u %8.2f %10.4f %9.1f %9.1f\n", p ? "" : fs_str, p ? "profile" : "legacy", st,
+				r[p].cyc, 100.0 * r[p].cyc / cyc_budget(fs), r[p].ripple, r[p].image, r[p].flat / 1000);
+		}
+		if (r[1].first != r[0].first && n > 0) {
+			const bool ok = (r[1].ripple <= RIPPLE_MAX) && (r[1].image <= IMAGE_MAX) && (r[1].cyc < r[0].cyc);
+			printf("  %-7s %-8s cyc %+.1f%%  %s\n", "", "", 100.0 * ((double)r[1].cyc / r[0].cyc - 1.0), ok ? "OK" : "NG");
+			if (!ok) fail = true;
+		} else {
+			printf("  %-7s %-8s (same stages)\n", "", "");
+		}
+	}
+	printf("\n  ripple : 0~%.0fkHz, image : k*fs +-%.0fkHz (k >= 1), flat : |H| within +-%.1fdB from DC\n",
+		PASSBAND_EDGE / 1000, PASSBAND_EDGE / 1000, FLAT_DB);
+	printf("  limits (profile, 88.2kHz and above) : ripple <= %.2fdB, image <= %.0fdB, cyc < legacy\n", RIPPLE_MAX, IMAGE_MAX);
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,447 @@
+/**
+ * @file hbf_design.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ハーフバンド係数設計 段毎の仕様(通過域端・阻止域減衰量)を満たすタップ数・最小係数ビット長 -> hbf_coef.h
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 連結ハーフバンド(hbf1~3)の各段について、段の入力fs(44.1k系、遷移帯域が最も狭い条件)・通過域端 fp・
+ *       阻止域減衰量 att を仕様とし、以下の順に探索する。
+ *         最短タップ数 4m0-1           : DCゲイン1(係数和 = 2^bit)の拘束付きミニマックス(Remez交換法)で、
+ *                                         量子化前の減衰量が仕様を満たす最小の m0
+ *         係数ビット長 bit (m0~m0+3)   : 丸め値の ±1LSB 近傍の全探索と、係数和を保つ ±1LSB 移動で阻止域最大値を下げ、
+ *                                         仕様を満たす最小の bit
+ *         選択                          : Core0 見積もりサイクルが最小のもの。M0+ は 64bit積和が高価なため、
+ *                                         最短タップでも係数ビット長が長いと遅くなる場合がある
+ *       ハーフバンドは A(f) + A(fs_out/2 - f) = 1 のため、阻止域 [fs_in - fp, fs_in] の減衰量 att は
+ *       通過域 [0, fp] のリップル 20log10(1 + 10^(-att/20)) を兼ねる。
+ *       段毎に タップ数・係数ビット長・1出力サンプル当たりの積和数・32bit/64bit 積和構成(dsp.c のヘッドルーム解析と同じ規則)・
+ *       Core0 見積もりサイクル(host/cycle_model.h)・実現した減衰量を出力し、コンパイル時の hbf_coef.h と比較する。
+ *       仕様を満たせない段がある、または hbf_coef.h が設計結果と異なる場合は終了コード1を返す。
+ *       usage : hbf_design [-s stage:fp_khz:att_db]... [-w hbf_coef.h]
+ *                 -s : 段(1~3)の仕様を変更する (検討用)
+ *                 -w : 設計結果で hbf_coef.h を生成する
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "dsp.h"
+#include "hbf_coef.h"
+#include "cycle_model.h"
+
+#define HD_M_MAX		16			// 探索する最大係数数 (片側, タップ数 63)
+#define HD_BIT_MAX		16			// 探索する最大係数ビット長
+#define HD_GRID_N		2048		// 阻止域の評価点数
+#define HD_REMEZ_ITER	64
+#define HD_REFINE_ITER	256			// ±1LSB 移動の最大反復数
+#define HD_EXH_M		8			// 量子化時に ±1LSB 近傍を全探索する係数数 (外側から)
+#define HD_FP_VAR_N		8			// 量子化前の設計の遮断域端のずらし数 (fp x (1 - 0.02v))
+#define HD_M_SPAN		4			// 最短タップ数から比較するタップ数の数
+
+// 段毎の仕様
+typedef struct {
+	uint	fs_in;		// 段の入力fs [Hz] (44.1k系)
+	double	fp;			// 通過域端 [Hz]
+	double	att;		// 阻止域減衰量 [dB]
+	int32_t	in_max;		// 入力データ絶対値の最大値 (dsp.c hbf_spec[] と同じ, 積和構成の算出用)
+} hd_spec_t;
+
+// 既定の仕様 : hbf1 は 44.1kHz入力の遷移帯域が狭く(20k -> 24.1kHz)、現実的なタップ数で 20kHz まで
+// 平坦にできないため、通過域端を 15kHz とする (従来係数 31tap/12bit の実力 77.2dB@15kHz 相当)
+// hbf2/hbf3 は 20kHz まで。阻止域の像は 68kHz/156kHz 以上となり、後段(Core1 x8 補間)でさらに減衰する
+// hbf2/hbf3 は 88.2/96kHz, 176.4/192kHz 入力時の初段を兼ねる (dsp.c HBF_FS_PROFILE) ため、段の入力fsを仕様とする
+static hd_spec_t spec[HBF_STAGE_N] = {
+	{ 44100, 15000, 75.0, (1 << 23)},
+	{ 88200, 20000, 65.0, (1 << 23) + (1 << 22)},
+	{176400, 20000, 60.0, (1 << 23) + (1 << 22)},
+};
+
+// 設計結果 k[] は dsp.c と同じ並び (外側から, 最内側が最大)
+typedef struct {
+	uint	m;					// 係数数 (片側) タップ数 = 4m - 1
+	uint	bit;				// 係数ビット長 (係数和 = 2^bit)
+	int32_t	k[HD_M_MAX];
+	double	att;				// 量子化後の阻止域減衰量 [dB]
+	double	att_cont;			// 量子化前
+	bool	ok;
+} hd_result_t;
+
+static double grid_w[HD_GRID_N];				// 阻止域の評価点 [rad] (出力fs 基準)
+static double grid_c[HD_GRID_N][HD_M_MAX];		// 2cos((2i+1)ω)
+
+static void grid_init(double fp, uint fs_in){
+	const double ws = M_PI * (1.0 - fp / fs_in);
+	for(uint g = 0; g < HD_GRID_N; g++){
+		grid_w[g] = ws + (M_PI - ws) * g / (HD_GRID_N - 1);
+		for(uint i = 0; i < HD_M_MAX; i++) grid_c[g][i] = 2.0 * cos((2 * i + 1) * grid_w[g]);
+	}
+}
+
+// 誤差 e(ω) = 2A(ω) = 1 + Σ a[i] * 2cos((2i+1)ω)  a[i] : 中心からの距離 2i+1 のタップ (内側から)
+static double stop_err(const double* a, uint m, uint g){
+	double e = 1.0;
+	for(uint i = 0; i < m; i++) e += a[i] * grid_c[g][i];
+	return e;
+}
+
+// 阻止域最大値 max|2A(ω)|
+static double stop_max(const double* a, uint m){
+	double e_max = 0;
+	for(uint g = 0; g < HD_GRID_N; g++){
+		const double e = fabs(stop_err(a, m, g));
+		if (e > e_max) e_max = e;
+	}
+	return e_max;
+}
+
+static double att_db(double e_max){
+	return -20.0 * log10(e_max / 2.0 + 1e-300);
+}
+
+// 連立1次方程式 (部分ピボット選択ガウス消去) a[n][n+1]
+static bool solve(double a[HD_M_MAX + 1][HD_M_MAX + 2], uint n, double* x){
+	for(uint i = 0; i < n; i++){
+		uint p = i;
+		for(uint j = i + 1; j < n; j++) if (fabs(a[j][i]) > fabs(a[p][i])) p = j;
+		if (fabs(a[p][i]) < 1e-300) return false;
+		for(uint k = 0; k <= n; k++){ double t = a[i][k]; a[i][k] = a[p][k]; a[p][k] = t; }
+		for(uint j = i + 1; j < n; j++){
+			const double r = a[j][i] / a[i][i];
+			for(uint k = i; k <= n; k++) a[j][k] -= r * a[i][k];
+		}
+	}
+	for(int i = (int)n - 1; i >= 0; i--){
+		double s = a[i][n];
+		for(uint k = i + 1; k < n; k++) s -= a[i][k] * x[k];
+		x[i] = s / a[i][i];
+	}
+	return true;
+}
+
+// DCゲイン拘束付きミニマックス設計 (Remez交換法, 評価点は grid_init() の阻止域)
+// a0 = 1/2 - Σa[i≧1] を代入し、誤差 e(ω) = 1 + cosω + Σ a[i] * 2(cos((2i+1)ω) - cosω) の阻止域最大値を最小化する
+// ω = π では常に e = 0 のため、交番点は [ωs, π) から選ぶ
+static void remez(uint m, double* a){
+	const uint n = m - 1;				// 未知係数数
+	for(uint i = 0; i < m; i++) a[i] = 0;
+	a[0] = 0.5;
+	if (n == 0) return;
+	const uint g_n = HD_GRID_N - 1;		// ω = π を除く
+	uint ref[HD_M_MAX + 1];
+	for(uint j = 0; j <= n; j++) ref[j] = (uint)((double)j * (g_n - 1) / n * 0.95);
+	for(uint it = 0; it < HD_REMEZ_ITER; it++){
+		double mat[HD_M_MAX + 1][HD_M_MAX + 2];
+		double x[HD_M_MAX + 1];
+		for(uint j = 0; j <= n; j++){
+			const uint g = ref[j];
+			for(uint i = 1; i <= n; i++) mat[j][i - 1] = grid_c[g][i] - grid_c[g][0];
+			mat[j][n] = (j & 1) ? 1.0 : -1.0;			// - (-1)^j E
+			mat[j][n + 1] = -(1.0 + grid_c[g][0] / 2);
+		}
+		if (!solve(mat, n + 1, x)) break;
+		double sum = 0;
+		for(uint i = 1; i <= n; i++){ a[i] = x[i - 1]; sum += a[i]; }
+		a[0] = 0.5 - sum;
+		const double e_ref = fabs(x[n]);
+
+		// 誤差の符号区間毎の極値 (交番列)
+		static uint ext[HD_GRID_N];
+		static double ext_e[HD_GRID_N];
+		uint ext_n = 0;
+		for(uint g = 0; g < g_n; g++){
+			const double e = stop_err(a, m, g);
+			if (ext_n && ((e >= 0) == (ext_e[ext_n - 1] >= 0))) {
+				if (fabs(e) > fabs(ext_e[ext_n - 1])) { ext[ext_n - 1] = g; ext_e[ext_n - 1] = e; }
+			} else {
+				ext[ext_n] = g;
+				ext_e[ext_n++] = e;
+			}
+		}
+		if (ext_n < n + 1) break;
+		uint lo = 0, hi = ext_n;			// 交番点が多い場合は両端の小さい方から除く
+		while(hi - lo > n + 1){
+			if (fabs(ext_e[lo]) < fabs(ext_e[hi - 1])) lo++;
+			else hi--;
+		}
+		double e_max = 0;
+		for(uint j = 0; j <= n; j++){
+			ref[j] = ext[lo + j];
+			if (fabs(ext_e[lo + j]) > e_max) e_max = fabs(ext_e[lo + j]);
+		}
+		if (e_max - e_ref <= e_max * 1e-9) break;
+	}
+}
+
+// 係数 q (内側から) の阻止域誤差 e[] と最大値 (bound 以上になった時点で打ち切る)
+static double quant_err(const int32_t* q, uint m, uint bit, double* e, double bound){
+	const double lsb = 1.0 / (1 << bit);
+	double e_max = 0;
+	for(uint g = 0; g < HD_GRID_N && e_max < bound; g++){
+		double v = 1.0;
+		for(uint i = 0; i < m; i++) v += q[i] * lsb * grid_c[g][i];
+		if (e != NULL) e[g] = v;
+		if (fabs(v) > e_max) e_max = fabs(v);
+	}
+	return e_max;
+}
+
+// 係数の量子化 a : 連続係数 (内側から), q : 量子化係数 (内側から) 戻り値は阻止域最大値
+// 丸め値の ±1LSB 近傍を全探索(外側 HD_EXH_M 個まで, 最内側は係数和 = 2^(bit-1) で決まる)した後、
+// 係数和を保つ2係数の ±1LSB 移動で阻止域最大値を下げる
+static double quantize(const double* a, uint m, uint bit, int32_t* q){
+	const double lsb = 1.0 / (1 << bit);
+	int32_t r[HD_M_MAX];
+	for(uint i = 1; i < m; i++) r[i] = (int32_t)lround(a[i] * (1 << bit));
+	const uint exh_n = (m - 1 < HD_EXH_M) ? m - 1 : HD_EXH_M;		// 全探索する係数数 (外側から)
+	uint comb_n = 1;
+	for(uint i = 0; i < exh_n; i++) comb_n *= 3;
+	double best = 1e9;
+	for(uint c = 0; c < comb_n; c++){
+		int32_t t[HD_M_MAX];
+		int32_t sum = 0;
+		uint cc = c;
+		for(uint i = m - 1; i >= 1; i--){
+			t[i] = r[i];
+			if (i + exh_n >= m) { t[i] += (int32_t)(cc % 3) - 1; cc /= 3; }
+			sum += t[i];
+		}
+		t[0] = (1 << (bit - 1)) - sum;
+		const double e_max = quant_err(t, m, bit, NULL, best);
+		if (e_max < best) { best = e_max; memcpy(q, t, sizeof(int32_t) * m); }
+	}
+	static double e[HD_GRID_N];
+	double e_max = quant_err(q, m, bit, e, 1e9);
+	for(uint it = 0; it < HD_REFINE_ITER; it++){
+		uint bi = 0, bj = 0;
+		int bd = 0;
+		double b = e_max;
+		for(uint i = 0; i < m; i++){
+			for(uint j = i + 1; j < m; j++){
+				for(int d = -1; d <= 1; d += 2){
+					double mx = 0;
+					for(uint g = 0; g < HD_GRID_N && mx < b; g++){
+						const double v = fabs(e[g] + d * lsb * (grid_c[g][i] - grid_c[g][j]));
+						if (v > mx) mx = v;
+					}
+					if (mx < b) { b = mx; bi = i; bj = j; bd = d; }
+				}
+			}
+		}
+		if (bd == 0) break;
+		q[bi] += bd;
+		q[bj] -= bd;
+		for(uint g = 0; g < HD_GRID_N; g++) e[g] += bd * lsb * (grid_c[g][bi] - grid_c[g][bj]);
+		e_max = b;
+	}
+	return e_max;
+}
+
+// 32bitで積和可能な先頭タップ対数 (dsp.c hbf_mac32_n() と同じ規則) k[] : 外側から
+static uint mac32_n(const int32_t* k, uint m, int32_t in_max){
+	int64_t acc_max = 0;
+	uint n = 0;
+	for(uint i = 0; i < m; i++){
+		acc_max += (int64_t)abs(k[i]) * 2 * in_max;
+		if (acc_max <= INT32_MAX) n = i + 1;
+	}
+	return n;
+}
+
+static uint result_cyc(const hd_result_t* r, const hd_spec_t* s){
+	const uint n32 = mac32_n(r->k, r->m, s->in_max);
+	return cyc_hbf_x2(n32, r->m - n32);
+}
+
+// タップ数 m の最小係数ビット長
+// 連続係数は遮断域端を仕様の fp から HD_FP_VAR_N 通りずらした設計を初期値とし、量子化後に最も減衰量の大きいものを採る
+static bool design_m(const hd_spec_t* s, uint m, hd_result_t* r){
+	double a[HD_FP_VAR_N][HD_M_MAX];
+	double att_cont = -1e9;
+	for(uint v = 0; v < HD_FP_VAR_N; v++){
+		grid_init(s->fp * (1.0 - 0.02 * v), s->fs_in);
+		remez(m, a[v]);
+	}
+	grid_init(s->fp, s->fs_in);
+	for(uint v = 0; v < HD_FP_VAR_N; v++){
+		const double att = att_db(stop_max(a[v], m));
+		if (att > att_cont) att_cont = att;
+	}
+	if (att_cont < s->att) return false;
+	for(uint bit = 1; bit <= HD_BIT_MAX; bit++){
+		if ((1 << (bit - 1)) < (int32_t)m) continue;		// 係数和に対してビット長が短すぎる
+		double e_best = 1e9;
+		int32_t q_best[HD_M_MAX];
+		for(uint v = 0; v < HD_FP_VAR_N; v++){
+			int32_t q[HD_M_MAX];
+			const double e = quantize(a[v], m, bit, q);
+			if (e < e_best) { e_best = e; memcpy(q_best, q, sizeof(q)); }
+		}
+		if (att_db(e_best) >= s->att) {
+			r->m = m;
+			r->bit = bit;
+			for(uint i = 0; i < m; i++) r->k[i] = q_best[m - 1 - i];
+			r->att = att_db(e_best);
+			r->att_cont = att_cont;
+			r->ok = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+// 最短タップ数 m0 から m0 + HD_M_SPAN - 1 までの各タップ数の最小係数ビット長を候補 cand[] とし、
+// Core0 見積もりサイクルが最小のもの(同サイクルはタップ数の少ない方)を選ぶ
+// M0+ は 32bitを超える積和(64bit積和)が高価なため、最短タップでも係数ビット長が長いと遅くなる場合がある
+static uint design(const hd_spec_t* s, hd_result_t* r, hd_result_t* cand){
+	uint n = 0, m0 = 0;
+	memset(r, 0, sizeof(*r));
+	for(uint m = 1; m <= HD_M_MAX && (m0 == 0 || m < m0 + HD_M_SPAN); m++){
+		hd_result_t c;
+		memset(&c, 0, sizeof(c));
+		c.m = m;
+		if (!design_m(s, m, &c)) {
+			if (m0) cand[n++] = c;
+			continue;
+		}
+		if (m0 == 0) m0 = m;
+		cand[n++] = c;
+		if (!r->ok || result_cyc(&c, s) < result_cyc(r, s)) *r = c;
+	}
+	return n;
+}
+
+// 係数表 k[] (外側から) の阻止域減衰量
+static double table_att(const hd_spec_t* s, const int32_t* k, uint m, uint bit){
+	double c[HD_M_MAX];
+	grid_init(s->fp, s->fs_in);
+	for(uint i = 0; i < m; i++) c[i] = (double)k[m - 1 - i] / (1 << bit);
+	return att_db(stop_max(c, m));
+}
+
+static void print_row(const char* label, const hd_spec_t* s, const int32_t* k, uint m, uint bit, double att){
+	const uint n32 = mac32_n(k, m, s->in_max);
+	printf("  %-8s %5u %5u %8.1f %9.1f %7.1f %4u/%-4u %9u %9.5f  {", label, 4 * m - 1, bit, m / 2.0, (double)m,
+		att, n32, m - n32, cyc_hbf_x2(n32, m - n32), 20.0 * log10(1.0 + pow(10.0, -att / 20.0)));
+	for(uint i = 0; i < m; i++) printf("%s%+d", i ? ", " : "", k[i]);
+	printf("}\n");
+}
+
+static bool write_header(const char* path, const hd_result_t* r){
+	FILE* fp = fopen(path, "w");
+	if (fp == NULL) return false;
+	fprintf(fp, "/**\n");
+	fprintf(fp, " * @file hbf_coef.h\n");
+	fprintf(fp, " * @author geachlab, Yasushi MARUISHI\n");
+	fprintf(fp, " * @brief 連結ハーフバンド hbf1~3 の係数表 (dsp.c)\n");
+	fprintf(fp, " * @version 0.01\n");
+	fprintf(fp, " * @date 2026-10-17\n");
+	fprintf(fp, " * @note host/hbf_design -w で生成する。直接編集しないこと。\n");
+	fprintf(fp, " *       段毎の仕様(入力fs・通過域端・阻止域減衰量)を満たすタップ数・係数ビット長のうち Core0 見積もりサイクル最小\n");
+	fprintf(fp, " *       hbf2/hbf3 は 88.2/96kHz, 176.4/192kHz 入力時の初段を兼ねる (dsp.c HBF_FS_PROFILE)\n");
+	fprintf(fp, " *\n");
+	fprintf(fp, " *       stage  fs in   pass[kHz]  spec[dB]  taps  bit  att[dB]  MAC/out\n");
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		fprintf(fp, " *       hbf%u  %6u  %9.1f  %8.1f  %4u  %3u  %7.1f  %7.1f\n", s + 1, spec[s].fs_in, spec[s].fp / 1000,
+			spec[s].att, 4 * r[s].m - 1, r[s].bit, r[s].att, r[s].m / 2.0);
+	}
+	fprintf(fp, " */\n");
+	fprintf(fp, "#ifndef _HBF_COEF_H_\n#define _HBF_COEF_H_\n\n");
+	fprintf(fp, "// HBFn_TAP_N : 元のタップ数, HBFn_K_BIT_W : 係数ビット長 (係数和 = 2^bit)\n");
+	fprintf(fp, "// HBFn_K     : 補間用フィルタ(φ1)の係数 偶数番はゼロのため省略、左右対称のため後半省略 (外側から)\n");
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		fprintf(fp, "\n// hbf%u : 入力 %.1fkHz, 通過域 %.1fkHz, 阻止域 %.1fdB 以上 (実現 %.1fdB)\n", s + 1,
+			spec[s].fs_in / 1000.0, spec[s].fp / 1000, spec[s].att, r[s].att);
+		fprintf(fp, "#define HBF%u_TAP_N\t\t%u\n", s + 1, 4 * r[s].m - 1);
+		fprintf(fp, "#define HBF%u_K_BIT_W\t%u\n", s + 1, r[s].bit);
+		fprintf(fp, "#define HBF%u_K\t\t\t{", s + 1);
+		for(uint i = 0; i < r[s].m; i++) fprintf(fp, "%s%+d", i ? ", " : "", r[s].k[i]);
+		fprintf(fp, "}\n");
+	}
+	fprintf(fp, "\n#endif\n");
+	fclose(fp);
+	return true;
+}
+
+int main(int argc, char* argv[]){
+	const char* out = NULL;
+	bool spec_changed = false;
+	for(int i = 1; i < argc; i++){
+		uint st;
+		double fp, att;
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			out = argv[++i];
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc && sscanf(argv[++i], "%u:%lf:%lf", &st, &fp, &att) == 3
+			&& st >= 1 && st <= HBF_STAGE_N && fp > 0 && fp * 1000 < spec[st - 1].fs_in / 2.0 && att > 0) {
+			spec[st - 1].fp = fp * 1000;
+			spec[st - 1].att = att;
+			spec_changed = true;
+		} else {
+			fprintf(stderr, "usage : hbf_design [-s stage:fp_khz:att_db]... [-w hbf_coef.h]\n");
+			return 1;
+		}
+	}
+	bool fail = false;
+
+	// コンパイル時の係数表
+	static const int32_t cur_k1[] = HBF1_K, cur_k2[] = HBF2_K, cur_k3[] = HBF3_K;
+	static const int32_t* const cur_k[HBF_STAGE_N] = {cur_k1, cur_k2, cur_k3};
+	static const uint cur_tap[HBF_STAGE_N] = {HBF1_TAP_N, HBF2_TAP_N, HBF3_TAP_N};
+	static const uint cur_bit[HBF_STAGE_N] = {HBF1_K_BIT_W, HBF2_K_BIT_W, HBF3_K_BIT_W};
+
+	printf("pico_1bit_dac_v2 hbf_design : equiripple half-band (DC gain 1), min coefficient bits per taps -> min Core0 cycles\n\n");
+	printf("  %-8s %5s %5s %8s %9s %7s %9s %9s %9s  %s\n",
+		"", "taps", "bit", "MAC/out", "MAC/in ch", "att", "mac32/64", "cyc/frame", "ripple", "k[] (outer -> inner)");
+	hd_result_t res[HBF_STAGE_N];
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		const hd_spec_t* sp = &spec[s];
+		printf(" hbf%u : in %.1fkHz, pass %.1fkHz, stop >= %.1fkHz, att >= %.1fdB\n", s + 1,
+			sp->fs_in / 1000.0, sp->fp / 1000, (sp->fs_in - sp->fp) / 1000, sp->att);
+		hd_result_t cand[HD_M_SPAN];
+		const uint cand_n = design(sp, &res[s], cand);
+		if (!res[s].ok) {
+			printf("  no design within %u taps / %u bit\n", 4 * HD_M_MAX - 1, HD_BIT_MAX);
+			fail = true;
+		}
+		for(uint c = 0; c < cand_n; c++){
+			if (!cand[c].ok) {
+				printf("  %-8s %5u  no coefficient bits <= %u\n", "cand", 4 * cand[c].m - 1, HD_BIT_MAX);
+				continue;
+			}
+			const bool sel = res[s].ok && cand[c].m == res[s].m;
+			print_row(sel ? "design" : "cand", sp, cand[c].k, cand[c].m, cand[c].bit, cand[c].att);
+			printf("  %-8s %5s %5s %8s %9s %7.1f  (before quantization)\n", "", "", "", "", "", cand[c].att_cont);
+		}
+		const uint cur_m = (cur_tap[s] + 1) / 4;
+		const double cur_att = table_att(sp, cur_k[s], cur_m, cur_bit[s]);
+		print_row("header", sp, cur_k[s], cur_m, cur_bit[s], cur_att);
+		if (cur_att < sp->att) {
+			printf("  hbf_coef.h does not meet the spec\n");
+			fail = true;
+		}
+		if (res[s].ok && !spec_changed
+			&& (res[s].m != cur_m || res[s].bit != cur_bit[s] || memcmp(res[s].k, cur_k[s], sizeof(int32_t) * cur_m) != 0)) {
+			printf("  hbf_coef.h differs from the design (hbf_design -w hbf_coef.h で更新)\n");
+			fail = true;
+		}
+		printf("\n");
+	}
+	printf("  MAC/out : multiplies per output sample (1ch), cyc/frame : Core0 per input frame (L/R, host/cycle_model.h)\n");
+	printf("  ripple  : passband ripple [dB] = 20log10(1 + 10^(-att/20))\n");
+
+	if (out != NULL) {
+		bool all_ok = true;
+		for(uint s = 0; s < HBF_STAGE_N; s++) all_ok &= res[s].ok;
+		if (!all_ok || !write_header(out, res)) {
+			fprintf(stderr, "cannot write : %s\n", out);
+			fail = true;
+		} else {
+			printf("\n  written : %s\n", out);
+		}
+	}
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,392 @@
+/**
+ * @file hbf_exact_check.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 係数表版 hbf1~3 (hbf_x2_run()) と 従来の手書き展開版 hbf1~3 のビット一致確認
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 従来の手書き展開版 hbf1~3_x2_oversampler() (タップ対の展開・32bit/64bit の乗換え位置・右シフト・clamp) を
+ *       参照カーネルとしてそのまま持ち、dsp.c の係数表版と出力をワード単位で比較する。
+ *       係数・係数ビット長は hbf_coef.h (host/hbf_design の生成値) を参照カーネルにも使う。
+ *       タップ数が手書き展開版と異なる場合はコンパイルエラーとする。
+ *        段毎   : hbfN_x2_oversampler() (Core0, interp1 clamp), hbfN_x2_oversampler_vol() (音量 1倍),
+ *                 hbfN_x2_oversampler_core1() (Core1, ソフトウェアclamp) を 1~BLOCK_MAX サンプルの乱数長で連続処理
+ *        連結   : 全入力fsで hbf_oversampler() (直線位相, 分担なし) と 参照カーネルの連結 (初段 hbf_get_first_stage()) を
+ *                 1~(fs/1000 + 1) サンプルの乱数長パケットで連続処理
+ *       入力信号 (L/R は別系列) :
+ *        random     : 段の入力範囲の一様乱数
+ *        fullscale  : 段の入力範囲の最大値/最小値 (符号は乱数)
+ *        worst      : 係数の符号に合わせた最大値/最小値の周期列 (アキュムレータ最大, Rch は符号反転)
+ *       入力範囲は hbf1 および連結入力が 24bit PCM、hbf2/hbf3 が clamp() 出力範囲 (dsp.c の CLAMP_MIN ~ CLAMP_MAX)。
+ *       1ワードでも一致しない場合は終了コード1を返す。分担(os_split)の一致は host/os_split_bench で確認する。
+ *       usage : hbf_exact_check [samples]   default 20000 (段毎・信号毎の入力サンプル数)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "hbf_coef.h"
+
+#if (HBF1_TAP_N != 31) || (HBF2_TAP_N != 15) || (HBF3_TAP_N != 11)
+#error "hbf_coef.h のタップ数が手書き展開版と異なる (参照カーネルの展開を合わせること)"
+#endif
+
+// dsp.c の設定と合わせること
+#define CLAMP_MAX ((+1 << 23) + (+1 << 22) - 1)
+#define CLAMP_MIN ((-1 << 23) + (-1 << 22) )
+
+#define BLOCK_MAX		64			// 段毎確認の 1回の入力サンプル数の最大値
+#define PACKETS			300			// 連結確認の入力fs・信号毎のパケット数
+
+enum { SIG_RANDOM, SIG_FULLSCALE, SIG_WORST, SIG_N };
+static const char* const sig_name[SIG_N] = {"random", "fullscale", "worst"};
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+#define FS_N	(sizeof(fs_list) / sizeof(fs_list[0]))
+
+static inline int32_t ref_clamp(int32_t x){
+	return (x > CLAMP_MAX) ? CLAMP_MAX : (x < CLAMP_MIN) ? CLAMP_MIN : x;
+}
+
+//////////////////////////////////////////////////////////////////////////////// 従来の手書き展開版 (参照カーネル)
+
+#define REF_HBF3_ITAP_N	((HBF3_TAP_N + 1) / 2)	// 補間用フィルタ(φ1)のタップ数
+static void ref_hbf3_x2_oversampler(
+	int32_t *p_i,		// 24bit input data pointer  : L1,R1,L2,R2,L3,R3,,Ln,Rn (n=*p_len)
+	int32_t *p_o,		// 24bit output data pointer : L1,R1,L2,R2,L3,R3,,Lm,Rm (m=*p_len *2)
+	uint *p_len			// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+){
+	const uint k_bit_w = HBF3_K_BIT_W;					// 固定係数ビット長定義
+	const int32_t k[REF_HBF3_ITAP_N / 2] = HBF3_K;		// 固定係数定義 偶数番はゼロのため省略、左右対称のため後半省略
+	static uint t = 0;									// 遅延タップ位置宣言 連続利用のためstaticとする
+	static int32_t z[REF_HBF3_ITAP_N * 4];				// 遅延データ列宣言 連続利用のためstaticとする
+	uint len = *p_len;									// ローカル変数に処置ループ長を取得
+
+	if (len == 0) {										// 遅延データ列とタップ位置をリセット
+		t = 0;
+		for(uint c = 0; c < REF_HBF3_ITAP_N * 4; c++) z[c] = 0;
+	} else {											// オーバーサンプル処理
+		while(len--){
+			////////////////////////////////////////////// Ch0 Oversampler
+			int32_t d = *p_i++;							// 入力データ取得
+			z[t                   ] = d;				// 第1遅延データ更新
+			z[t + REF_HBF3_ITAP_N ] = d;				// 第2遅延データ更新
+			*p_o = z[t + REF_HBF3_ITAP_N / 2];			// 中央遅延データを実データとして出力
+			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
+
+			// 補間データ演算
+			d  = k[ 0] * (int32_t)(d        +z[t + 5]);	// d  = k0*(tap0 + tap10)
+			d += k[ 1] * (int32_t)(z[t + 1] +z[t + 4]);	// d += k1*(tap2 + tap8)
+			d += k[ 2] * (int32_t)(z[t + 2] +z[t + 3]);	// d += k1*(tap4 + tap6)
+														// 演算結果は32bit幅に収まるため64bit演算に移行する必要なし
+			d = ref_clamp(d >> k_bit_w);				// 演算結果を係数ビット長で右シフトし指定値でクランプし補間データ完成
+			*p_o--	= d;								// 補間データを出力、出力ポインタをCh1実データ位置へ移動
+			t += 2 * REF_HBF3_ITAP_N;					// タップ位置をCh1部に移動
+
+			////////////////////////////////////////////// Ch1 Oversampler
+			d = *p_i++;									// 入力データ取得
+			z[t                   ] = d;				// 第1遅延データ更新
+			z[t + REF_HBF3_ITAP_N ] = d;				// 第2遅延データ更新
+			*p_o = z[t + REF_HBF3_ITAP_N / 2];			// 中央遅延データを実データとして出力
+			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
+
+			// 補間データ演算
+			d  = k[ 0] * (int32_t)(d        +z[t + 5]);	// d  = k0*(tap0 + tap10)
+			d += k[ 1] * (int32_t)(z[t + 1] +z[t + 4]);	// d += k1*(tap2 + tap8)
+			d += k[ 2] * (int32_t)(z[t + 2] +z[t + 3]);	// d += k1*(tap4 + tap6)
+														// 演算結果は32bit幅に収まるため64bit演算に移行する必要なし
+			d = ref_clamp(d >> k_bit_w);				// 演算結果を係数ビット長で右シフトし指定値でクランプし補間データ完成
+			*p_o++	= d;								// 補間データを出力、出力ポインタをCh0実データ位置へ移動
+			t -= 2 * REF_HBF3_ITAP_N;					// タップ位置をCh0部に移動
+
+			if (t == 0)	t = REF_HBF3_ITAP_N - 1;		// タップが先頭に戻ったら最終タップに戻す
+			else		t--;							// 1タップずらす
+		}
+	}
+	*p_len *= 2;										// オーバーサンプリングで倍増したデータ数に更新
+}
+
+#define REF_HBF2_ITAP_N	((HBF2_TAP_N + 1) / 2)	// 補間用フィルタ(φ1)のタップ数
+static void ref_hbf2_x2_oversampler(
+	int32_t *p_i,		// 24bit input data pointer  : L1,R1,L2,R2,L3,R3,,Ln,Rn (n=*p_len)
+	int32_t *p_o,		// 24bit output data pointer : L1,R1,L2,R2,L3,R3,,Lm,Rm (m=*p_len *2)
+	uint *p_len			// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+){
+	const uint k_bit_w = HBF2_K_BIT_W;					// 固定係数ビット長定義
+	const int32_t k[REF_HBF2_ITAP_N / 2] = HBF2_K;		// 固定係数定義 偶数番は0,後半は左右対称のため省略
+	static uint t = 0;									// 遅延タップ位置宣言 連続利用のためstaticとする
+	static int32_t z[REF_HBF2_ITAP_N * 4];				// 遅延データ列宣言 連続利用のためstaticとする
+	uint len = *p_len;									// ローカル変数に処置ループ長を取得
+
+	if (len == 0) {										// 遅延データ列とタップ位置をリセット
+		t = 0;
+		for(uint c = 0; c < REF_HBF2_ITAP_N * 4; c++) z[c] = 0;
+	} else {											// オーバーサンプル処理
+		while(len--){
+			////////////////////////////////////////////// Ch0 Oversampler
+			int32_t d = *p_i++;							// 入力データ取得
+			z[t                  ] = d;					// 第1遅延データ更新
+			z[t + REF_HBF2_ITAP_N] = d;					// 第2遅延データ更新
+			*p_o = z[t + REF_HBF2_ITAP_N / 2];			// 中央遅延データを実データとして出力
+			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
+
+			// 補間データ演算
+			d  = k[ 0] *          (d        +z[t + 7]);	// k0 * (tap0 + tap14)
+			d += k[ 1] *          (z[t + 1] +z[t + 6]);	// k2 * (tap2 + tap12)
+			int64_t x  = (int64_t)d;					// 以降演算結果が32bit幅を超えるため64bitに乗り換え
+			x += k[ 2] * (int64_t)(z[t + 2] +z[t + 5]);	// k4 * (tap4 + tap10)
+			x += k[ 3] * (int64_t)(z[t + 3] +z[t + 4]);	// k6 * (tap6 + tap8)
+			d = ref_clamp(x >> k_bit_w);				// 64bit長演算結果を係数ビット長で右シフトし32bit幅に戻した後、指定値でクランプし補間データ完成
+			*p_o--	= d;								// 補間データを出力、出力ポインタをCh1実データ位置へ移動
+			t += 2 * REF_HBF2_ITAP_N;					// タップ位置をCh1部に移動
+
+			////////////////////////////////////////////// Ch1 Oversampler
+			d = *p_i++;									// 入力データ取得
+			z[t                  ] = d;					// 第1遅延データ更新
+			z[t + REF_HBF2_ITAP_N] = d;					// 第2遅延データ更新
+			*p_o = z[t + REF_HBF2_ITAP_N / 2];			// 中央遅延データを実データとして出力
+			p_o	+= 2;									// 出力ポインタを補間データ位置へ移動
+
+			// 補間データ演算
+			d  = k[ 0] *          (d        +z[t + 7]);	// k0 * (tap0 + tap14)
+			d += k[ 1] *          (z[t + 1] +z[t + 6]);	// k2 * (tap2 + tap12)
+			x  = (int64_t)d;							// 以降演算結果が32bit幅を超えるため64bitに乗り換え
+			x += k[ 2] * (int64_t)(z[t + 2] +z[t + 5]);	// k4 * (tap4 + tap10)
+			x += k[ 3] * (int64_t)(z[t + 3] +z[t + 4]);	// k6 * (tap6 + tap8)
+			d = ref_clamp(x >> k_bit_w);				// 64bit長演算結果を係数ビット長で右シフトし32bit幅に戻した後、指定値でクランプし補間データ完成
+			*p_o++	= d;								// 補間データを出力、出力ポインタをCh0実データ位置へ移動
+			t -= 2 * REF_HBF2_ITAP_N;					// タップ位置をCh0部に移動
+
+			if (t == 0)	t = REF_HBF2_ITAP_N - 1;		// タップが先頭に戻ったら最終タップに戻す
+			else		t--;							// 1タップずらす
+		}
+	}
+	*p_len *= 2;										// データ長がオーバーサンプリングで倍増するため更新
+}
+
+#define REF_HBF1_ITAP_N	((HBF1_TAP_N + 1) / 2)
+static void ref_hbf1_x2_oversampler(
+	int32_t *p_i,		// 24bit input data pointer  : L1,R1,L2,R2,L3,R3,,Ln,Rn (n=*p_len)
+	int32_t *p_o,		// 24bit output data pointer : L1,R1,L2,R2,L3,R3,,Lm,Rm (m=*p_len *2)
+	uint *p_len			// *p_len > 0 : num. of sample, *p_len = 0 : Reset Oversampler
+){
+	const uint k_bit_w = HBF1_K_BIT_W;
+	const int32_t k[REF_HBF1_ITAP_N /2] = HBF1_K;
+	static uint t = 0;
+	static int32_t z[REF_HBF1_ITAP_N * 4];
+	uint len = *p_len;
+	if (len == 0) {
+		// Clear Delayed Data
+		t = 0;
+		for(uint c=0; c < REF_HBF1_ITAP_N*4; c++) z[c] = 0;
+	} else {
+		while(len--){
+			// Ch0 Oversampler
+			int32_t d = *p_i++;
+			z[t                  ] = d;
+			z[t + REF_HBF1_ITAP_N] = d;
+			*p_o = z[t + REF_HBF1_ITAP_N / 2];
+			p_o	+= 2;
+
+			d  = k[ 0] * (int32_t)(d        +z[t +15]);
+			d += k[ 1] * (int32_t)(z[t + 1] +z[t +14]);
+			d += k[ 2] * (int32_t)(z[t + 2] +z[t +13]);
+			d += k[ 3] * (int32_t)(z[t + 3] +z[t +12]);
+			int64_t x  = (int64_t)d;
+			x += k[ 4] * (int64_t)(z[t + 4] +z[t +11]);
+			x += k[ 5] * (int64_t)(z[t + 5] +z[t +10]);
+			x += k[ 6] * (int64_t)(z[t + 6] +z[t + 9]);
+			x += k[ 7] * (int64_t)(z[t + 7] +z[t + 8]);
+			*p_o--	= ref_clamp(x >> k_bit_w);
+			t += 2 * REF_HBF1_ITAP_N;
+
+			// Ch1 Oversampler
+			d = *p_i++;
+			z[t                  ] = d;
+			z[t + REF_HBF1_ITAP_N] = d;
+			*p_o = z[t + REF_HBF1_ITAP_N / 2];
+			p_o	+= 2;
+
+			d  = k[ 0] * (int32_t)(d        +z[t +15]);
+			d += k[ 1] * (int32_t)(z[t + 1] +z[t +14]);
+			d += k[ 2] * (int32_t)(z[t + 2] +z[t +13]);
+			d += k[ 3] * (int32_t)(z[t + 3] +z[t +12]);
+			x  = (int64_t)d;
+			x += k[ 4] * (int64_t)(z[t + 4] +z[t +11]);
+			x += k[ 5] * (int64_t)(z[t + 5] +z[t +10]);
+			x += k[ 6] * (int64_t)(z[t + 6] +z[t + 9]);
+			x += k[ 7] * (int64_t)(z[t + 7] +z[t + 8]);
+			*p_o++	= ref_clamp(x >> k_bit_w);
+			t -= 2 * REF_HBF1_ITAP_N;
+
+			if (t == 0)	t = REF_HBF1_ITAP_N - 1;
+			else		t--;
+		}
+	}
+	*p_len *= 2;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*hbf_func_t)(int32_t *p_i, int32_t *p_o, uint *p_len);
+static const hbf_func_t ref_hbf[HBF_STAGE_N] = {ref_hbf1_x2_oversampler, ref_hbf2_x2_oversampler, ref_hbf3_x2_oversampler};
+
+// 係数表版 [段][0:Core0 1:Core0 音量処理統合版 2:Core1]
+#define VAR_N	3
+static const char* const var_name[VAR_N] = {"core0", "vol", "core1"};
+static const hbf_func_t dut_hbf[HBF_STAGE_N][VAR_N] = {
+	{hbf1_x2_oversampler, hbf1_x2_oversampler_vol, hbf1_x2_oversampler_core1},
+	{hbf2_x2_oversampler, hbf2_x2_oversampler_vol, hbf2_x2_oversampler_core1},
+	{hbf3_x2_oversampler, hbf3_x2_oversampler_vol, hbf3_x2_oversampler_core1},
+};
+static const int32_t* const stage_k[HBF_STAGE_N] = {(const int32_t[])HBF1_K, (const int32_t[])HBF2_K, (const int32_t[])HBF3_K};
+static const uint stage_itap_n[HBF_STAGE_N] = {REF_HBF1_ITAP_N, REF_HBF2_ITAP_N, REF_HBF3_ITAP_N};
+
+static int32_t in_buf[QUEUE_SLOT_WIDTH];
+static int32_t ref_buf[2][QUEUE_SLOT_WIDTH];
+static int32_t dut_buf[QUEUE_SLOT_WIDTH];
+
+// 入力信号の生成 (L/R 各 len サンプル) *p_n : 先頭からのサンプル位置
+//  stage : 係数の符号(worst)に使う段, lo/hi : 入力範囲
+static void make_input(int32_t* buf, uint len, uint sig, uint stage, int32_t lo, int32_t hi, uint* p_n){
+	const uint n = stage_itap_n[stage];
+	for(uint i = 0; i < len; i++){
+		for(uint c = 0; c < N_CH; c++){
+			int32_t d;
+			if (sig == SIG_RANDOM) {
+				d = lo + (int32_t)(((uint64_t)rand() * RAND_MAX + rand()) % ((uint64_t)hi - lo + 1));
+			} else if (sig == SIG_FULLSCALE) {
+				d = (rand() & 1) ? hi : lo;
+			} else {
+				const uint j = *p_n % n;
+				const bool pos = (stage_k[stage][(j < n - 1 - j) ? j : n - 1 - j] > 0) ^ (c == 1);
+				d = pos ? hi : lo;
+			}
+			buf[i * N_CH + c] = d;
+		}
+		(*p_n)++;
+	}
+}
+
+// 出力の比較 戻り値 : 不一致ワード数 (最初の不一致位置を *p_first へ)
+static uint compare(const int32_t* ref, const int32_t* dut, uint words, uint offset, uint mismatch, uint* p_first){
+	uint n = 0;
+	for(uint i = 0; i < words; i++){
+		if (ref[i] != dut[i]) {
+			if (mismatch + n == 0) *p_first = offset + i;
+			n++;
+		}
+	}
+	return n;
+}
+
+static void print_result(uint words, uint mismatch, uint first){
+	printf("%9u words  mismatch %6u", words, mismatch);
+	if (mismatch) printf(" (first word %u)", first);
+	printf("  %s\n", mismatch ? "NG" : "OK");
+}
+
+// 段毎 : 参照カーネルと係数表版 (var) を同じ入力で連続処理
+static uint check_stage(uint stage, uint var, uint sig, uint samples){
+	const int32_t lo = (stage == 0) ? -(1 << 23) : CLAMP_MIN;
+	const int32_t hi = (stage == 0) ? (1 << 23) - 1 : CLAMP_MAX;
+	uint zero = 0, pos = 0, words = 0, mismatch = 0, first = 0;
+	srand(stage * 16 + sig + 1);
+	host_set_core_num((var == 2) ? 1 : 0);
+	ref_hbf[stage](in_buf, ref_buf[0], &zero);
+	zero = 0;
+	dut_hbf[stage][var](in_buf, dut_buf, &zero);
+	for(uint s = 0; s < samples; ){
+		uint len = 1 + rand() % BLOCK_MAX;
+		if (len > samples - s) len = samples - s;
+		make_input(in_buf, len, sig, stage, lo, hi, &pos);
+		uint len_r = len, len_d = len;
+		ref_hbf[stage](in_buf, ref_buf[0], &len_r);
+		dut_hbf[stage][var](in_buf, dut_buf, &len_d);
+		if (len_r != len_d) mismatch++;
+		mismatch += compare(ref_buf[0], dut_buf, len_r * N_CH, words, mismatch, &first);
+		words += len_r * N_CH;
+		s += len;
+	}
+	host_set_core_num(0);
+	printf("  hbf%u  %-6s %-9s ", stage + 1, var_name[var], sig_name[sig]);
+	print_result(words, mismatch, first);
+	return mismatch;
+}
+
+// 連結 : hbf_oversampler() (直線位相, 分担なし) と 参照カーネルの連結 (初段 hbf_get_first_stage())
+static uint check_chain(uint fs, uint sig){
+	const uint n = hbf_get_stage_n(fs);
+	const uint first = hbf_get_first_stage(fs);
+	uint pos = 0, words = 0, mismatch = 0, first_word = 0;
+	srand(fs + sig);
+	host_set_core_num(0);
+	os_filter_set(OS_FILTER_LINEAR);
+	dsp_reset();
+	os_split_set(fs, 0);
+	for(uint i = 0; i < HBF_STAGE_N; i++){
+		uint zero = 0;
+		ref_hbf[i](in_buf, ref_buf[0], &zero);
+	}
+	for(uint p = 0; p < PACKETS; p++){
+		const uint len = 1 + rand() % (fs / 1000 + 1);
+		make_input(in_buf, len, sig, (n > 0) ? first : 0, -(1 << 23), (1 << 23) - 1, &pos);
+
+		// 参照 : 段毎に ref_buf[0], [1] を交互に使う
+		const int32_t* ref = in_buf;
+		uint len_r = len;
+		for(uint i = 0; i < n; i++){
+			ref_hbf[first + i]((int32_t*)ref, ref_buf[i & 1], &len_r);
+			ref = ref_buf[i & 1];
+		}
+
+		int32_t* buf = get_dsp_buf_pointer(fs);
+		memcpy(buf, in_buf, sizeof(int32_t) * len * N_CH);
+		uint len_d = len;
+		hbf_oversampler(&buf, &len_d, fs, dut_buf);
+		if (len_r != len_d) mismatch++;
+		mismatch += compare(ref, buf, len_r * N_CH, words, mismatch, &first_word);
+		words += len_r * N_CH;
+	}
+	printf("  %-7u %-9s stages %u", fs, sig_name[sig], n);
+	if (n > 0) printf(" (hbf%u~3) ", first + 1);
+	else       printf("          ");
+	print_result(words, mismatch, first_word);
+	return mismatch;
+}
+
+int main(int argc, char* argv[]){
+	const uint samples = (argc > 1) ? (uint)atoi(argv[1]) : 20000;
+	uint mismatch = 0;
+	host_set_core_num(0);
+	dsp_init();
+	volume_reset(1, 0);
+
+	printf("pico_1bit_dac_v2 hbf_exact_check : table-driven hbf1~3 (dsp.c) vs hand-unrolled kernels, coefficients hbf_coef.h\n");
+	printf("  hbf1 %u-bit {", HBF1_K_BIT_W);
+	for(uint i = 0; i < REF_HBF1_ITAP_N / 2; i++) printf("%s%+d", i ? ", " : "", stage_k[0][i]);
+	printf("}, hbf2 %u-bit {", HBF2_K_BIT_W);
+	for(uint i = 0; i < REF_HBF2_ITAP_N / 2; i++) printf("%s%+d", i ? ", " : "", stage_k[1][i]);
+	printf("}, hbf3 %u-bit {", HBF3_K_BIT_W);
+	for(uint i = 0; i < REF_HBF3_ITAP_N / 2; i++) printf("%s%+d", i ? ", " : "", stage_k[2][i]);
+	printf("}\n\n");
+
+	printf("  stage kernels (%u samples, block 1~%u)\n", samples, BLOCK_MAX);
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		for(uint v = 0; v < VAR_N; v++){
+			for(uint g = 0; g < SIG_N; g++) mismatch += check_stage(s, v, g, samples);
+		}
+	}
+
+	printf("\n  hbf_oversampler() chain (linear, no os split, %u packets of 1~fs/1000+1 samples)\n", PACKETS);
+	for(uint f = 0; f < FS_N; f++){
+		for(uint g = 0; g < SIG_N; g++) mismatch += check_chain(fs_list[f], g);
+	}
+
+	printf("\n%s\n", mismatch ? "NG (mismatch)" : "OK");
+	return mismatch ? 1 : 0;
+}
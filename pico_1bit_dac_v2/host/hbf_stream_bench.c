@@ -0,0 +1,167 @@
+/**
+ * @file hbf_stream_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 連結ハーフバンド 段毎版 vs 縦型ストリーミング版 (hbf_stream_oversampler) 処理量・中間データ量・ビット一致確認
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 連結2段以上となる入力fs・Core0 分担段数毎に以下を出力する。
+ *        cyc/frame  : Cortex-M0+ 見積もりサイクル数 1入力フレーム(L/R)当たり (host/cycle_model.h)
+ *        Core0[%]   : 見積もりCore0負荷
+ *        ns/frame   : ホスト実測処理時間
+ *        inter[B]   : 中間fsデータの使用領域 段毎版は1パケット(1ms)分の dsp_buf 中間fs領域、ストリーミング版は段毎の小バッファ
+ *                     (hbf_stream_s1, s2 : HBF_STREAM_CHUNK_N サンプル分)
+ *       ビット一致確認 : 各条件で ストリーミング版の出力が段毎版(初段 -> .. -> hbf3, 初段は hbf_get_first_stage())と一致すること (音量処理なし/あり)
+ *       ビット一致しない場合は終了コード1を返す。
+ *       実機では UARTコマンド(t) の "hbf strm" 段 (HBF_STREAM = 0 で "hbf1~3" 段) で処理時間を確認する。
+ *       usage : hbf_stream_bench [packets]   default 1000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+#define BENCH_VOL_MUL		100		// 音量処理ありの確認用 (x100 >> 7)
+#define BENCH_VOL_SHIFT		7
+#define BENCH_PACKETS		100		// ビット一致確認のパケット数
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000};
+#define FS_N	(sizeof(fs_list) / sizeof(fs_list[0]))
+
+static int32_t src_buf[QUEUE_WIDTH];
+static int32_t work_buf[2][QUEUE_WIDTH];
+static int32_t ref_out[QUEUE_WIDTH];
+static int32_t str_out[QUEUE_WIDTH];
+static int32_t ref_all[BENCH_PACKETS * QUEUE_WIDTH];
+static int32_t str_all[BENCH_PACKETS * QUEUE_WIDTH];
+
+static void make_source(int32_t* buf, uint len, uint fs, uint64_t* phase){
+	for(uint i = 0; i < len; i++){
+		// -1dBFS 997Hz + 雑音 (clamp 動作を含める)
+		double s = sin(2.0 * M_PI * 997.0 * (double)(*phase)++ / fs) * (1 << 23) * 0.89 + (rand() % 65536 - 32768);
+		*buf++ = (int32_t)s;
+		*buf++ = (rand() % (1 << 24)) - (1 << 23);
+	}
+}
+
+// 段毎版 hbf(first+1) から n 段 中間段は work_buf、最終段は p_o
+static void run_stage(int32_t* p_i, int32_t* p_o, uint* p_len, uint first, uint n, bool use_vol){
+	for(uint i = 0; i < n; i++){
+		int32_t* p = (i == n - 1) ? p_o : work_buf[i & 1];
+		const bool vol = use_vol && (i == 0);
+		switch(first + i){
+			case 0:
+				if (vol) hbf1_x2_oversampler_vol(p_i, p, p_len);
+				else     hbf1_x2_oversampler(p_i, p, p_len);
+				break;
+			case 1:
+				if (vol) hbf2_x2_oversampler_vol(p_i, p, p_len);
+				else     hbf2_x2_oversampler(p_i, p, p_len);
+				break;
+			default:
+				if (vol) hbf3_x2_oversampler_vol(p_i, p, p_len);
+				else     hbf3_x2_oversampler(p_i, p, p_len);
+				break;
+		}
+		p_i = p;
+	}
+}
+
+// BENCH_PACKETS パケットを 段毎版(stream = false) / ストリーミング版(stream = true) で処理し out へ格納する
+// use_vol : 初段で音量処理 戻り値 : 出力サンプル数
+static uint run_packets(uint fs, uint first, uint n, bool use_vol, bool stream, int32_t* out){
+	uint64_t phase = 0;
+	uint n_out = 0;
+	srand(1);
+	hbf_oversampler_reset();
+	volume_reset(use_vol ? BENCH_VOL_MUL : 1, use_vol ? BENCH_VOL_SHIFT : 0);
+	for(uint p = 0; p < BENCH_PACKETS; p++){
+		uint len = fs / 1000 + (p % 3 == 0);
+		make_source(src_buf, len, fs, &phase);
+		if (stream) hbf_stream_oversampler(src_buf, &out[n_out * N_CH], &len, first, n, use_vol);
+		else        run_stage(src_buf, &out[n_out * N_CH], &len, first, n, use_vol);
+		n_out += len;
+	}
+	volume_reset(1, 0);
+	return n_out;
+}
+
+int main(int argc, char* argv[]){
+	uint packets = (argc > 1) ? (uint)atoi(argv[1]) : 1000;
+	if (packets == 0) packets = 1;
+	bool fail = false;
+
+	host_set_core_num(0);
+	dsp_init();
+
+	printf("pico_1bit_dac_v2 hbf_stream_bench : CLK_SYS %.1fMHz, %u packets\n\n", CLK_SYS / 1e6, packets);
+	printf("  %-7s %-6s | %-28s | %-28s | %-17s | %s\n", "", "",
+		"cyc/frame (Core0[%])", "ns/frame (host)", "inter[B]", "bit-exact");
+	printf("  %-7s %-6s | %13s %14s | %13s %14s | %8s %8s | %s\n", "fs", "stages",
+		"stage", "stream", "stage", "stream", "stage", "stream", "vol off/on");
+
+	for(uint f = 0; f < FS_N; f++){
+		const uint fs = fs_list[f];
+		const uint n_all = hbf_get_stage_n(fs);
+		const uint first = hbf_get_first_stage(fs);
+		for(uint n = n_all; n >= 2; n--){
+			const uint pkt_n = fs / 1000 + 1;
+
+			// 見積もり
+			const uint cyc_stage = cyc_hbf_cascade(first, n);
+			const uint cyc_stream = cyc_hbf_stream(first, n);
+
+			// 中間fsデータ量 (1パケット) : 初段 ~ n-1段目の出力
+			uint inter = 0;
+			for(uint i = 1; i < n; i++) inter += (pkt_n << i) * N_CH * sizeof(int32_t);
+			uint inter_stream = 0;
+			for(uint i = 1; i < n; i++) inter_stream += (HBF_STREAM_CHUNK_N << i) * N_CH * sizeof(int32_t);
+
+			// ビット一致 (音量処理なし/あり)
+			bool ok[2];
+			for(uint v = 0; v < 2; v++){
+				const uint ref_n = run_packets(fs, first, n, v, false, ref_all);
+				const uint str_n = run_packets(fs, first, n, v, true, str_all);
+				ok[v] = (ref_n == str_n) && (memcmp(ref_all, str_all, sizeof(int32_t) * ref_n * N_CH) == 0);
+				if (!ok[v]) fail = true;
+			}
+
+			// ホスト実測
+			double ns_stage = 0.0, ns_stream = 0.0;
+			uint64_t phase = 0;
+			make_source(src_buf, pkt_n, fs, &phase);
+			hbf_oversampler_reset();
+			for(uint p = 0; p < packets; p++){
+				uint len = pkt_n;
+				double t0 = now_ns();
+				run_stage(src_buf, ref_out, &len, first, n, false);
+				double t1 = now_ns();
+				len = pkt_n;
+				hbf_stream_oversampler(src_buf, str_out, &len, first, n, false);
+				double t2 = now_ns();
+				ns_stage += t1 - t0;
+				ns_stream += t2 - t1;
+			}
+			ns_stage /= (double)packets * pkt_n;
+			ns_stream /= (double)packets * pkt_n;
+			hbf_oversampler_reset();
+
+			printf("  %-7u %-6u | %6u (%5.1f) %6u (%5.1f) | %13.2f %14.2f | %8u %8u | %s/%s\n",
+				fs, n,
+				cyc_stage, 100.0 * cyc_stage * (double)fs / CLK_SYS,
+				cyc_stream, 100.0 * cyc_stream * (double)fs / CLK_SYS,
+				ns_stage, ns_stream, inter, inter_stream,
+				ok[0] ? "OK" : "NG", ok[1] ? "OK" : "NG");
+		}
+	}
+
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
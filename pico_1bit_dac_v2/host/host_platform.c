@@ -0,0 +1,18 @@
+/**
+ * @file host_platform.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ホストビルド用 RP2040 ハードウェアモデルの実体
+ * @version 0.01
+ * @date 2026-10-17
+ * @note interp0/interp1 (コア毎) と仮想コア番号
+ */
+
+#include "pico.h"
+#include "hardware/interp.h"
+
+_Thread_local uint host_core_num = 0;
+
+interp_hw_t host_interp_hw[2][2] = {
+	{ { .num = 0 }, { .num = 1 } },		// Core0 interp0, interp1
+	{ { .num = 0 }, { .num = 1 } },		// Core1 interp0, interp1
+};
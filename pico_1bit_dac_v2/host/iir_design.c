@@ -0,0 +1,330 @@
+/**
+ * @file iir_design.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 低遅延オーバーサンプラ iir1~3 係数設計 ポリフェーズ全域通過型ハーフバンドIIR(楕円特性) -> iir_coef.h
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 連結ハーフバンド hbf1~3 (host/hbf_design) と同じ段毎の仕様(入力fs・通過域端 fp・阻止域減衰量 att)を満たす
+ *       最小の全域通過段数 n (フィルタ次数 2n+1) を求める。
+ *         H(z) = (A0(z^2) + z^-1 A1(z^2)) / 2,  Ap(z) = Π (a + z^-1) / (1 + a z^-1)
+ *         係数 a[0..n-1] は楕円特性ハーフバンドの閉形式 (遷移帯域 fp ~ fs_in - fp, Valenzuela-Constantinides) で求め、
+ *         偶数番を A0 (偶数番出力)、奇数番を A1 (奇数番出力) に割り当てる。
+ *       係数は IIR_A_BIT で量子化し、量子化後の周波数特性で仕様を判定する。
+ *       全域通過段は dsp.c で差分 x - y[n-1] を上位/下位に分割して32bit積和する(pfir と同じ)ため、
+ *       各段の入力・出力の L1ノルムから差分の最大値を求め、32bit に収まること(ヘッドルーム)を確認する。
+ *       段毎に 係数数・阻止域減衰量・通過域リプル・DC/通過域端の群遅延・Core0 見積もりサイクル(host/cycle_model.h)を
+ *       同じ段の hbf と並べて出力し、コンパイル時の iir_coef.h と比較する。
+ *       仕様・ヘッドルームを満たせない段がある、または iir_coef.h が設計結果と異なる場合は終了コード1を返す。
+ *       usage : iir_design [-w iir_coef.h]
+ *                 -w : 設計結果で iir_coef.h を生成する
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "dsp.h"
+#include "hbf_coef.h"
+#include "iir_coef.h"
+#include "cycle_model.h"
+
+#define ID_A_MAX		8			// 探索する最大全域通過段数 (次数 17)
+#define ID_A_BIT		16			// 係数ビット長 (dsp.c PFIR_COEF_BIT と同じ)
+#define ID_DATA_SPLIT	12			// 差分の分割ビット位置 (dsp.c PFIR_DATA_SPLIT と同じ)
+#define ID_GRID_N		2048		// 通過域・阻止域の評価点数
+#define ID_L1_LEN		4096		// L1ノルム算出用インパルス応答長 [入力サンプル]
+
+// 段毎の仕様 (host/hbf_design と同じ)
+typedef struct {
+	uint	fs_in;		// 段の入力fs [Hz] (44.1k系)
+	double	fp;			// 通過域端 [Hz]
+	double	att;		// 阻止域減衰量 [dB]
+	int32_t	in_max;		// 入力データ絶対値の最大値 (dsp.c hbf_spec[] と同じ, ヘッドルーム算出用)
+} id_spec_t;
+
+static const id_spec_t spec[HBF_STAGE_N] = {
+	{ 44100, 15000, 75.0, (1 << 23)},
+	{ 88200, 20000, 65.0, (1 << 23) + (1 << 22)},
+	{176400, 20000, 60.0, (1 << 23) + (1 << 22)},
+};
+
+typedef struct {
+	uint	n;					// 全域通過段数
+	int32_t	a[ID_A_MAX];		// 量子化係数 (a * 2^ID_A_BIT)
+	double	att;				// 量子化後の阻止域減衰量 [dB]
+	double	att_cont;			// 量子化前
+	double	ripple;				// 通過域リプル [dB]
+	double	gd_dc, gd_fp;		// 群遅延 [出力サンプル] DC, 通過域端
+	double	d_max;				// 全域通過段の差分 x - y[n-1] の最大値
+	bool	ok;
+} id_result_t;
+
+// 楕円特性ハーフバンドの全域通過係数 (閉形式) tbw : 遷移帯域幅 / 出力fs, a[n]
+static void design_cont(uint n, double tbw, double* a){
+	double k = tan((1.0 - 2.0 * tbw) * M_PI / 4);
+	k *= k;
+	const double kk = pow(1.0 - k * k, 0.25);
+	const double e = 0.5 * (1.0 - kk) / (1.0 + kk);
+	const double e4 = e * e * e * e;
+	const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));	// ノーム
+	const uint order = 2 * n + 1;
+	for(uint i = 0; i < n; i++){
+		const uint c = i + 1;
+		double num = 0, den = 0.5;
+		double s = 1.0;
+		for(uint j = 0; j < 32; j++, s = -s) num += s * pow(q, j * (j + 1)) * sin((2 * j + 1) * c * M_PI / order);
+		s = -1.0;
+		for(uint j = 1; j < 32; j++, s = -s) den += s * pow(q, j * j) * cos(2 * j * c * M_PI / order);
+		const double w = num * pow(q, 0.25) / den;
+		const double w2 = w * w;
+		const double x = sqrt((1.0 - w2 * k) * (1.0 - w2 / k)) / (1.0 + w2);
+		a[i] = (1.0 - x) / (1.0 + x);
+	}
+}
+
+// H(e^jω) ω : 出力fs 基準 [rad]
+static void response(const double* a, uint n, double w, double* re, double* im){
+	double r0 = 1.0, i0 = 0.0, r1 = 1.0, i1 = 0.0;
+	const double c = cos(2 * w), s = -sin(2 * w);		// z^-1 (入力レート)
+	for(uint i = 0; i < n; i++){
+		// (a + z^-1) / (1 + a z^-1)
+		const double nr = a[i] + c, ni = s;
+		const double dr = 1.0 + a[i] * c, di = a[i] * s;
+		const double d2 = dr * dr + di * di;
+		const double hr = (nr * dr + ni * di) / d2, hi = (ni * dr - nr * di) / d2;
+		double* pr = (i & 1) ? &r1 : &r0;
+		double* pi = (i & 1) ? &i1 : &i0;
+		const double tr = *pr * hr - *pi * hi;
+		*pi = *pr * hi + *pi * hr;
+		*pr = tr;
+	}
+	const double zc = cos(w), zs = -sin(w);				// z^-1 A1
+	*re = 0.5 * (r0 + r1 * zc - i1 * zs);
+	*im = 0.5 * (i0 + r1 * zs + i1 * zc);
+}
+
+static double mag(const double* a, uint n, double w){
+	double re, im;
+	response(a, n, w, &re, &im);
+	return sqrt(re * re + im * im);
+}
+
+// 阻止域 [fs_in - fp, fs_in] の減衰量 [dB]
+static double stop_att(const id_spec_t* s, const double* a, uint n){
+	const double ws = M_PI * (1.0 - s->fp / s->fs_in);
+	double m_max = 0;
+	for(uint g = 0; g < ID_GRID_N; g++){
+		const double m = mag(a, n, ws + (M_PI - ws) * g / (ID_GRID_N - 1));
+		if (m > m_max) m_max = m;
+	}
+	return -20.0 * log10(m_max + 1e-300);
+}
+
+// 通過域 [0, fp] のリプル [dB]
+static double pass_ripple(const id_spec_t* s, const double* a, uint n){
+	const double wp = M_PI * s->fp / s->fs_in;
+	double db_max = -1e9, db_min = 1e9;
+	for(uint g = 0; g < ID_GRID_N; g++){
+		const double db = 20.0 * log10(mag(a, n, wp * g / (ID_GRID_N - 1)));
+		if (db > db_max) db_max = db;
+		if (db < db_min) db_min = db;
+	}
+	return db_max - db_min;
+}
+
+// 群遅延 [出力サンプル]
+// DC : τ0 + τ1 + 1/2 (τp : Ap の DC群遅延 [入力サンプル] = Σ (1 - a) / (1 + a))、ω > 0 : 位相の数値微分
+static double group_delay(const double* a, uint n, double w){
+	if (w == 0) {
+		double t = 0.5;
+		for(uint i = 0; i < n; i++) t += (1.0 - a[i]) / (1.0 + a[i]);
+		return t;
+	}
+	const double dw = 1e-5;
+	double r0, i0, r1, i1;
+	response(a, n, w - dw, &r0, &i0);
+	response(a, n, w + dw, &r1, &i1);
+	return -atan2(r0 * i1 - i0 * r1, r0 * r1 + i0 * i1) / (2 * dw);
+}
+
+// 全域通過段の差分 x - y[n-1] の最大値 : 段入力・段出力の L1ノルム和 x 入力最大値
+static double diff_max(const double* a, uint n, int32_t in_max){
+	static double x[ID_L1_LEN], y[ID_L1_LEN];
+	double d_max = 0;
+	for(uint p = 0; p < 2; p++){
+		for(uint t = 0; t < ID_L1_LEN; t++) x[t] = (t == 0) ? 1.0 : 0.0;
+		double l1_in = 1.0;
+		for(uint i = p; i < n; i += 2){
+			double l1_out = 0;
+			for(uint t = 0; t < ID_L1_LEN; t++){
+				y[t] = a[i] * (x[t] - (t ? y[t - 1] : 0)) + (t ? x[t - 1] : 0);
+				l1_out += fabs(y[t]);
+			}
+			if ((l1_in + l1_out) * in_max > d_max) d_max = (l1_in + l1_out) * in_max;
+			memcpy(x, y, sizeof(x));
+			l1_in = l1_out;
+		}
+	}
+	return d_max;
+}
+
+static void quant_to_double(const int32_t* q, uint n, double* a){
+	for(uint i = 0; i < n; i++) a[i] = (double)q[i] / (1 << ID_A_BIT);
+}
+
+// 量子化係数 q の評価
+static void evaluate(const id_spec_t* s, const int32_t* q, uint n, id_result_t* r){
+	double a[ID_A_MAX];
+	quant_to_double(q, n, a);
+	r->n = n;
+	memcpy(r->a, q, sizeof(int32_t) * n);
+	r->att = stop_att(s, a, n);
+	r->ripple = pass_ripple(s, a, n);
+	r->gd_dc = group_delay(a, n, 0);
+	r->gd_fp = group_delay(a, n, M_PI * s->fp / s->fs_in);
+	r->d_max = diff_max(a, n, s->in_max);
+}
+
+// 差分の上限 : 上位(差分 >> ID_DATA_SPLIT) x 係数 が 2^31 未満
+static bool headroom_ok(double d_max){
+	return d_max < (double)(1u << (31 - ID_A_BIT + ID_DATA_SPLIT));
+}
+
+// 仕様を満たす最小段数
+static void design(const id_spec_t* s, id_result_t* r){
+	memset(r, 0, sizeof(*r));
+	const double tbw = 0.5 - s->fp / s->fs_in;
+	for(uint n = 1; n <= ID_A_MAX; n++){
+		double a[ID_A_MAX];
+		int32_t q[ID_A_MAX];
+		design_cont(n, tbw, a);
+		for(uint i = 0; i < n; i++) q[i] = (int32_t)lround(a[i] * (1 << ID_A_BIT));
+		evaluate(s, q, n, r);
+		r->att_cont = stop_att(s, a, n);
+		if (r->att >= s->att) {
+			r->ok = headroom_ok(r->d_max);
+			return;
+		}
+	}
+	r->n = 0;
+}
+
+static void print_row(const char* label, const id_spec_t* s, const id_result_t* r){
+	printf("  %-8s %5u %5u %7.1f %11.2e %8.2f %8.2f %9u %8.1f  {", label, r->n, 2 * r->n + 1, r->att, r->ripple,
+		r->gd_dc / (2.0 * s->fs_in) * 1e6, r->gd_fp / (2.0 * s->fs_in) * 1e6, cyc_iir_x2(r->n), log2(r->d_max));
+	for(uint i = 0; i < r->n; i++) printf("%s%d", i ? ", " : "", r->a[i]);
+	printf("}\n");
+}
+
+static bool write_header(const char* path, const id_result_t* r){
+	FILE* fp = fopen(path, "w");
+	if (fp == NULL) return false;
+	fprintf(fp, "/**\n");
+	fprintf(fp, " * @file iir_coef.h\n");
+	fprintf(fp, " * @author geachlab, Yasushi MARUISHI\n");
+	fprintf(fp, " * @brief 低遅延オーバーサンプラ iir1~3 (ポリフェーズ全域通過型ハーフバンドIIR) の係数表 (dsp.c)\n");
+	fprintf(fp, " * @version 0.01\n");
+	fprintf(fp, " * @date 2026-10-17\n");
+	fprintf(fp, " * @note host/iir_design -w で生成する。直接編集しないこと。\n");
+	fprintf(fp, " *       hbf1~3 と同じ段毎の仕様(入力fs・通過域端・阻止域減衰量)を満たす最小の全域通過段数 (楕円特性, 次数 2n+1)\n");
+	fprintf(fp, " *       群遅延は DC の値 (通過域端では増加する)\n");
+	fprintf(fp, " *\n");
+	fprintf(fp, " *       stage  fs in   pass[kHz]  spec[dB]  coef  order  att[dB]  delay[us]\n");
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		fprintf(fp, " *       iir%u   %6u  %9.1f  %8.1f  %4u  %5u  %7.1f  %9.2f\n", s + 1, spec[s].fs_in, spec[s].fp / 1000,
+			spec[s].att, r[s].n, 2 * r[s].n + 1, r[s].att, r[s].gd_dc / (2.0 * spec[s].fs_in) * 1e6);
+	}
+	fprintf(fp, " */\n");
+	fprintf(fp, "#ifndef _IIR_COEF_H_\n#define _IIR_COEF_H_\n\n");
+	fprintf(fp, "#define IIR_A_BIT\t\t%u\t\t// 係数ビット長 (係数 = a * 2^IIR_A_BIT)\n\n", ID_A_BIT);
+	fprintf(fp, "// IIRn_A_N : 全域通過段数, IIRn_A : 全域通過係数 偶数番は A0 (偶数番出力)、奇数番は A1 (奇数番出力)\n");
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		fprintf(fp, "\n// iir%u : 入力 %.1fkHz, 通過域 %.1fkHz, 阻止域 %.1fdB 以上 (実現 %.1fdB)\n", s + 1,
+			spec[s].fs_in / 1000.0, spec[s].fp / 1000, spec[s].att, r[s].att);
+		fprintf(fp, "#define IIR%u_A_N\t\t%u\n", s + 1, r[s].n);
+		fprintf(fp, "#define IIR%u_A\t\t\t{", s + 1);
+		for(uint i = 0; i < r[s].n; i++) fprintf(fp, "%s%d", i ? ", " : "", r[s].a[i]);
+		fprintf(fp, "}\n");
+	}
+	fprintf(fp, "\n#endif\n");
+	fclose(fp);
+	return true;
+}
+
+int main(int argc, char* argv[]){
+	const char* out = NULL;
+	for(int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			out = argv[++i];
+		} else {
+			fprintf(stderr, "usage : iir_design [-w iir_coef.h]\n");
+			return 1;
+		}
+	}
+	bool fail = false;
+
+	// コンパイル時の係数表
+	static const int32_t cur_a1[] = IIR1_A, cur_a2[] = IIR2_A, cur_a3[] = IIR3_A;
+	static const int32_t* const cur_a[HBF_STAGE_N] = {cur_a1, cur_a2, cur_a3};
+	static const uint cur_n[HBF_STAGE_N] = {IIR1_A_N, IIR2_A_N, IIR3_A_N};
+	static const uint hbf_tap[HBF_STAGE_N] = {HBF1_TAP_N, HBF2_TAP_N, HBF3_TAP_N};
+
+	printf("pico_1bit_dac_v2 iir_design : polyphase allpass half-band IIR (elliptic), min allpass sections, %u bit coefficients\n\n", ID_A_BIT);
+	printf("  %-8s %5s %5s %7s %11s %8s %8s %9s %8s  %s\n",
+		"", "coef", "order", "att", "ripple[dB]", "gd DC", "gd fp", "cyc/frame", "d[bit]", "a[] x 2^16 (even : A0, odd : A1)");
+	id_result_t res[HBF_STAGE_N];
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		const id_spec_t* sp = &spec[s];
+		printf(" iir%u : in %.1fkHz, pass %.1fkHz, stop >= %.1fkHz, att >= %.1fdB\n", s + 1,
+			sp->fs_in / 1000.0, sp->fp / 1000, (sp->fs_in - sp->fp) / 1000, sp->att);
+		design(sp, &res[s]);
+		if (res[s].n == 0) {
+			printf("  no design within %u allpass sections\n", ID_A_MAX);
+			fail = true;
+		} else {
+			print_row("design", sp, &res[s]);
+			printf("  %-8s %5s %5s %7.1f  (before quantization)\n", "", "", "", res[s].att_cont);
+			if (!res[s].ok) {
+				printf("  allpass difference exceeds 32bit split MAC range (2^%d)\n", 31 - ID_A_BIT + ID_DATA_SPLIT);
+				fail = true;
+			}
+		}
+		id_result_t cur;
+		evaluate(sp, cur_a[s], cur_n[s], &cur);
+		print_row("header", sp, &cur);
+		if (cur.att < sp->att || !headroom_ok(cur.d_max)) {
+			printf("  iir_coef.h does not meet the spec\n");
+			fail = true;
+		}
+		if (res[s].n != 0 && (res[s].n != cur.n || memcmp(res[s].a, cur.a, sizeof(int32_t) * cur.n) != 0)) {
+			printf("  iir_coef.h differs from the design (iir_design -w iir_coef.h で更新)\n");
+			fail = true;
+		}
+		// 同じ段の hbf (直線位相, 群遅延 = (タップ数 + 1) / 2 出力サンプル)
+		printf("  %-8s %5s %5u %7s %11s %8.2f %8.2f %9u\n", "hbf", "-", hbf_tap[s], "", "",
+			(hbf_tap[s] + 1) / 2 / (2.0 * sp->fs_in) * 1e6, (hbf_tap[s] + 1) / 2 / (2.0 * sp->fs_in) * 1e6, cyc_hbf_stage(s));
+		printf("\n");
+	}
+	printf("  gd DC / gd fp : group delay [us] at DC / passband edge, cyc/frame : Core0 per input frame (L/R, host/cycle_model.h)\n");
+	printf("  d[bit] : max |x - y[n-1]| of allpass sections (log2), limit 2^%d (split MAC)\n", 31 - ID_A_BIT + ID_DATA_SPLIT);
+	if (IIR_A_BIT != ID_A_BIT) {
+		printf("  iir_coef.h IIR_A_BIT (%d) differs from %d\n", IIR_A_BIT, ID_A_BIT);
+		fail = true;
+	}
+
+	if (out != NULL) {
+		bool all_ok = true;
+		for(uint s = 0; s < HBF_STAGE_N; s++) all_ok &= res[s].ok;
+		if (!all_ok || !write_header(out, res)) {
+			fprintf(stderr, "cannot write : %s\n", out);
+			fail = true;
+		} else {
+			printf("\n  written : %s\n", out);
+		}
+	}
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+/**
+ * @file interp.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ホストビルド用 RP2040 Interpolator(interp0/interp1) ソフトウェアモデル
+ * @version 0.01
+ * @date 2026-10-17
+ * @note pico-sdk hardware/interp.h と同名のAPIを提供し、dsp.c/pdm_output.c を無改造でホスト実行する。
+ *       モデル化している機能 (RP2040 Datasheet 2.3.1.6 準拠)
+ *        ・shift / mask / signed (符号拡張)
+ *        ・cross_input / cross_result
+ *        ・add_raw (LANE結果のみshift/maskを迂回、FULL結果には影響しない)
+ *        ・force_bits
+ *        ・blend  (interp0 lane0設定, LANE1結果 = BASE0 + α(BASE1-BASE0), α:8bit)
+ *        ・clamp  (interp1 lane0設定, LANE0結果 = BASE0 ≦ x ≦ BASE1)
+ *       レジスタ読出しによる副作用(pop)があるため、結果の取得は必ず
+ *       interp_peek_lane_result() / interp_pop_lane_result() / interp_peek_full_result() /
+ *       interp_pop_full_result() を用いること。accum[]/base[] の直接書込みはそのまま利用できる。
+ *       interp0/interp1 はコア毎に独立したインスタンスを持つ (get_core_num()で選択)。
+ */
+#ifndef _HOST_HARDWARE_INTERP_H_
+#define _HOST_HARDWARE_INTERP_H_
+
+#include "pico.h"
+
+// CTRL_LANEx ビット配置 (SIO_INTERPx_CTRL_LANEx と同一)
+#define INTERP_CTRL_SHIFT_LSB		0
+#define INTERP_CTRL_SHIFT_BITS		(0x1fu <<  0)
+#define INTERP_CTRL_MASK_LSB_LSB	5
+#define INTERP_CTRL_MASK_LSB_BITS	(0x1fu <<  5)
+#define INTERP_CTRL_MASK_MSB_LSB	10
+#define INTERP_CTRL_MASK_MSB_BITS	(0x1fu << 10)
+#define INTERP_CTRL_SIGNED_BITS		(1u << 15)
+#define INTERP_CTRL_CROSS_INPUT_BITS	(1u << 16)
+#define INTERP_CTRL_CROSS_RESULT_BITS	(1u << 17)
+#define INTERP_CTRL_ADD_RAW_BITS	(1u << 18)
+#define INTERP_CTRL_FORCE_MSB_LSB	19
+#define INTERP_CTRL_FORCE_MSB_BITS	(3u << 19)
+#define INTERP_CTRL_BLEND_BITS		(1u << 21)	// interp0 lane0のみ有効
+#define INTERP_CTRL_CLAMP_BITS		(1u << 22)	// interp1 lane0のみ有効
+
+typedef struct {
+	uint32_t accum[2];
+	uint32_t base[3];
+	uint32_t ctrl[2];
+	uint num;			// 0:interp0, 1:interp1
+} interp_hw_t;
+
+typedef struct {
+	uint32_t ctrl;
+} interp_config;
+
+// [コア番号][interp番号]
+extern interp_hw_t host_interp_hw[2][2];
+
+#define interp0 (&host_interp_hw[get_core_num()][0])
+#define interp1 (&host_interp_hw[get_core_num()][1])
+
+static inline uint interp_index(interp_hw_t *interp){
+	return interp->num;
+}
+
+//////////////////////////////////////////////////// config設定 (pico-sdk互換)
+static inline interp_config interp_default_config(void){
+	interp_config c = {0};
+	c.ctrl = (31u << INTERP_CTRL_MASK_MSB_LSB);	// mask 0~31
+	return c;
+}
+
+static inline void interp_config_set_shift(interp_config *c, uint shift){
+	c->ctrl = (c->ctrl & ~INTERP_CTRL_SHIFT_BITS) | ((shift << INTERP_CTRL_SHIFT_LSB) & INTERP_CTRL_SHIFT_BITS);
+}
+
+static inline void interp_config_set_mask(interp_config *c, uint mask_lsb, uint mask_msb){
+	c->ctrl = (c->ctrl & ~(INTERP_CTRL_MASK_LSB_BITS | INTERP_CTRL_MASK_MSB_BITS))
+			| ((mask_lsb << INTERP_CTRL_MASK_LSB_LSB) & INTERP_CTRL_MASK_LSB_BITS)
+			| ((mask_msb << INTERP_CTRL_MASK_MSB_LSB) & INTERP_CTRL_MASK_MSB_BITS);
+}
+
+static inline void interp_config_set_ctrl_flag(interp_config *c, uint32_t bits, bool value){
+	c->ctrl = value ? (c->ctrl | bits) : (c->ctrl & ~bits);
+}
+
+static inline void interp_config_set_cross_input(interp_config *c, bool cross_input){
+	interp_config_set_ctrl_flag(c, INTERP_CTRL_CROSS_INPUT_BITS, cross_input);
+}
+
+static inline void interp_config_set_cross_result(interp_config *c, bool cross_result){
+	interp_config_set_ctrl_flag(c, INTERP_CTRL_CROSS_RESULT_BITS, cross_result);
+}
+
+static inline void interp_config_set_signed(interp_config *c, bool _signed){
+	interp_config_set_ctrl_flag(c, INTERP_CTRL_SIGNED_BITS, _signed);
+}
+
+static inline void interp_config_set_add_raw(interp_config *c, bool add_raw){
+	interp_config_set_ctrl_flag(c, INTERP_CTRL_ADD_RAW_BITS, add_raw);
+}
+
+static inline void interp_config_set_blend(interp_config *c, bool blend){
+	interp_config_set_ctrl_flag(c, INTERP_CTRL_BLEND_BITS, blend);
+}
+
+static inline void interp_config_set_clamp(interp_config *c, bool clamp){
+	interp_config_set_ctrl_flag(c, INTERP_CTRL_CLAMP_BITS, clamp);
+}
+
+static inline void interp_config_set_force_bits(interp_config *c, uint bits){
+	c->ctrl = (c->ctrl & ~INTERP_CTRL_FORCE_MSB_BITS) | ((bits << INTERP_CTRL_FORCE_MSB_LSB) & INTERP_CTRL_FORCE_MSB_BITS);
+}
+
+static inline void interp_set_config(interp_hw_t *interp, uint lane, interp_config *config){
+	uint32_t ctrl = config->ctrl;
+	// blendはinterp0 lane0, clampはinterp1 lane0 のみ実装されている
+	if ((lane != 0) || (interp->num != 0)) ctrl &= ~INTERP_CTRL_BLEND_BITS;
+	if ((lane != 0) || (interp->num != 1)) ctrl &= ~INTERP_CTRL_CLAMP_BITS;
+	interp->ctrl[lane] = ctrl;
+}
+
+//////////////////////////////////////////////////// レジスタアクセス (pico-sdk互換)
+static inline void interp_set_base(interp_hw_t *interp, uint lane, uint32_t val){
+	interp->base[lane] = val;
+}
+
+static inline uint32_t interp_get_base(interp_hw_t *interp, uint lane){
+	return interp->base[lane];
+}
+
+static inline void interp_set_accumulator(interp_hw_t *interp, uint lane, uint32_t val){
+	interp->accum[lane] = val;
+}
+
+static inline uint32_t interp_get_accumulator(interp_hw_t *interp, uint lane){
+	return interp->accum[lane];
+}
+
+//////////////////////////////////////////////////// 演算モデル
+// lane の shift - mask - sign-extend 処理
+static inline uint32_t interp_emu_shift_mask(uint32_t ctrl, uint32_t input){
+	uint shift = (ctrl & INTERP_CTRL_SHIFT_BITS) >> INTERP_CTRL_SHIFT_LSB;
+	uint lsb   = (ctrl & INTERP_CTRL_MASK_LSB_BITS) >> INTERP_CTRL_MASK_LSB_LSB;
+	uint msb   = (ctrl & INTERP_CTRL_MASK_MSB_BITS) >> INTERP_CTRL_MASK_MSB_LSB;
+	uint32_t upper = (msb == 31) ? 0xffffffffu : ((1u << (msb + 1)) - 1);
+	uint32_t mask  = upper & ~((1u << lsb) - 1);
+	uint32_t x = (input >> shift) & mask;
+	if ((ctrl & INTERP_CTRL_SIGNED_BITS) && (x & (1u << msb))) x |= ~upper;
+	return x;
+}
+
+// LANE0, LANE1, FULL の3結果を同時に算出
+static inline void interp_emu_eval(const interp_hw_t *interp, uint32_t result[3]){
+	uint32_t ctrl0 = interp->ctrl[0];
+	uint32_t ctrl1 = interp->ctrl[1];
+	uint32_t in0 = (ctrl0 & INTERP_CTRL_CROSS_INPUT_BITS) ? interp->accum[1] : interp->accum[0];
+	uint32_t in1 = (ctrl1 & INTERP_CTRL_CROSS_INPUT_BITS) ? interp->accum[0] : interp->accum[1];
+	uint32_t sm0 = interp_emu_shift_mask(ctrl0, in0);
+	uint32_t sm1 = interp_emu_shift_mask(ctrl1, in1);
+	uint32_t v0  = (ctrl0 & INTERP_CTRL_ADD_RAW_BITS) ? in0 : sm0;
+	uint32_t v1  = (ctrl1 & INTERP_CTRL_ADD_RAW_BITS) ? in1 : sm1;
+
+	if (ctrl0 & INTERP_CTRL_BLEND_BITS) {
+		// blendモード α = LANE1 shift/mask値の下位8bit、符号の扱いはLANE1のsigned設定に従う
+		uint32_t alpha = sm1 & 0xff;
+		int64_t b0, b1;
+		if (ctrl1 & INTERP_CTRL_SIGNED_BITS) {
+			b0 = (int32_t)interp->base[0];
+			b1 = (int32_t)interp->base[1];
+		} else {
+			b0 = interp->base[0];
+			b1 = interp->base[1];
+		}
+		result[0] = v0;
+		result[1] = (uint32_t)(b0 + (((b1 - b0) * (int64_t)alpha) >> 8));
+		result[2] = interp->base[2] + sm0;
+	} else if (ctrl0 & INTERP_CTRL_CLAMP_BITS) {
+		// clampモード BASE0~BASE1の範囲に制限
+		if (ctrl0 & INTERP_CTRL_SIGNED_BITS) {
+			int32_t x = (int32_t)sm0;
+			if (x < (int32_t)interp->base[0]) x = (int32_t)interp->base[0];
+			if (x > (int32_t)interp->base[1]) x = (int32_t)interp->base[1];
+			result[0] = (uint32_t)x;
+		} else {
+			uint32_t x = sm0;
+			if (x < interp->base[0]) x = interp->base[0];
+			if (x > interp->base[1]) x = interp->base[1];
+			result[0] = x;
+		}
+		result[1] = interp->base[1] + v1;
+		result[2] = interp->base[2] + sm0 + sm1;
+	} else {
+		result[0] = interp->base[0] + v0;
+		result[1] = interp->base[1] + v1;
+		result[2] = interp->base[2] + sm0 + sm1;
+	}
+	result[0] |= ((ctrl0 & INTERP_CTRL_FORCE_MSB_BITS) >> INTERP_CTRL_FORCE_MSB_LSB) << 28;
+	result[1] |= ((ctrl1 & INTERP_CTRL_FORCE_MSB_BITS) >> INTERP_CTRL_FORCE_MSB_LSB) << 28;
+}
+
+// pop時の結果書き戻し (cross_result対応)
+static inline void interp_emu_writeback(interp_hw_t *interp, const uint32_t result[3]){
+	interp->accum[0] = (interp->ctrl[0] & INTERP_CTRL_CROSS_RESULT_BITS) ? result[1] : result[0];
+	interp->accum[1] = (interp->ctrl[1] & INTERP_CTRL_CROSS_RESULT_BITS) ? result[0] : result[1];
+}
+
+//////////////////////////////////////////////////// 結果取得 (pico-sdk互換)
+static inline uint32_t interp_peek_lane_result(interp_hw_t *interp, uint lane){
+	uint32_t r[3];
+	interp_emu_eval(interp, r);
+	return r[lane];
+}
+
+static inline uint32_t interp_pop_lane_result(interp_hw_t *interp, uint lane){
+	uint32_t r[3];
+	interp_emu_eval(interp, r);
+	interp_emu_writeback(interp, r);
+	return r[lane];
+}
+
+static inline uint32_t interp_peek_full_result(interp_hw_t *interp){
+	return interp_peek_lane_result(interp, 2);
+}
+
+static inline uint32_t interp_pop_full_result(interp_hw_t *interp){
+	return interp_pop_lane_result(interp, 2);
+}
+
+#endif
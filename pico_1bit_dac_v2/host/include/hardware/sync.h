@@ -0,0 +1,16 @@
+/**
+ * @file sync.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ホストビルド用 hardware/sync.h 代替ヘッダ
+ * @version 0.01
+ * @date 2026-10-17
+ * @note メモリバリアのみ。__dmb() はコンパイラ・CPU双方の並べ替えを禁止するフェンスとする。
+ */
+#ifndef _HOST_HARDWARE_SYNC_H_
+#define _HOST_HARDWARE_SYNC_H_
+
+static inline void __dmb(void){
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif
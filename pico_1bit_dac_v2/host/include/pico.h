@@ -0,0 +1,41 @@
+/**
+ * @file pico.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ホストビルド用 pico-sdk 代替ヘッダ (基本型・プラットフォーム定義)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note dsp.c/pdm_output.c をPC上でビルドするための最小限の定義のみを持つ。
+ *       pico-sdk の host プラットフォームに倣い PICO_ON_DEVICE=0, PICO_NO_HARDWARE=1 とする。
+ */
+#ifndef _HOST_PICO_H_
+#define _HOST_PICO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PICO_ON_DEVICE		0
+#define PICO_NO_HARDWARE	1
+
+typedef unsigned int uint;
+
+#define __not_in_flash_func(func_name)	func_name
+#define __time_critical_func(func_name)	func_name
+#define __scratch_x(group)
+#define __scratch_y(group)
+
+// コア番号 ホストではスレッド毎に仮想コア番号(0/1)を持つ
+// Core0/Core1処理を同一スレッドで交互に実行する場合は host_set_core_num() で切り替える
+extern _Thread_local uint host_core_num;
+
+static inline uint get_core_num(void){
+	return host_core_num;
+}
+
+static inline void host_set_core_num(uint core){
+	host_core_num = core & 1;
+}
+
+static inline void tight_loop_contents(void){}
+
+#endif
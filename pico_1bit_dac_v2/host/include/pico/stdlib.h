@@ -0,0 +1,18 @@
+/**
+ * @file stdlib.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief ホストビルド用 pico/stdlib.h 代替ヘッダ
+ * @version 0.01
+ * @date 2026-10-17
+ * @note GPIOアクセスは処理なしとする (DEBUG_PIN等の計測用ピン操作を無効化)
+ */
+#ifndef _HOST_PICO_STDLIB_H_
+#define _HOST_PICO_STDLIB_H_
+
+#include "pico.h"
+
+static inline void gpio_put(uint gpio, bool value){ (void)gpio; (void)value; }
+static inline void gpio_set_mask(uint32_t mask){ (void)mask; }
+static inline void gpio_clr_mask(uint32_t mask){ (void)mask; }
+
+#endif
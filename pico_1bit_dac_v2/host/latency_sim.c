@@ -0,0 +1,241 @@
+/**
+ * @file latency_sim.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief キュー動作モード(ロバスト / 低遅延)毎の 入力->ビットストリーム遅延・アンダーラン率シミュレーション
+ * @version 0.01
+ * @date 2026-10-17
+ * @note main.c の受信ループ(サブフレーム分割 -> asrc -> キュー公開)と pdm_output() の再生ループ(ミュート判定 -> 取出し
+ *       -> PDM_FEED_N 毎の変換)を時刻順のイベントとして模擬し、simple_queue.c / asrc_servo.c / asrc() をそのまま動作させる。
+ *         Core0 : パケット到着からサブフレーム毎に処理し、処理時間は host/cycle_model.h の hbf/asrc サイクル数とする
+ *         Core1 : DAC実再生レート(CLK_SYS/68/8)でキューを消費する。取り出したサンプルは DMA 1面分(PDM_DMA_CHUNK_N)後に出力される
+ *       遅延 : ソースでのサンプル取込み時刻から PWM出力開始時刻まで (パケット化 1ms を含み、補間フィルタの群遅延は含まない。群遅延は os_get_group_delay_us()、host/low_delay_bench を参照)
+ *       シナリオ
+ *         i2s        : I2S 48kHz(+100ppm) ASRCサーボ、到着ジッタ ±50us
+ *         i2s jitter : 同 到着ジッタ ±200us
+ *         usb        : USB 48kHz (Feedbackによりレート一致、47/48サンプル/パケット)、到着ジッタ ±100us
+ *         usb burst  : 同 997パケット毎に1パケットが 1.5ms 遅れて到着(ホストのスケジューリング遅れ)
+ *        lat mean/min/max [ms] : 遅延 (再生開始 SIM_SKIP_S 秒後から集計)
+ *        urun/min : 再生開始後のアンダーラン(ミュート)回数 [/分]
+ *        drop     : キュー満杯で破棄したサブフレーム数
+ *       いずれかのモード・シナリオで drop があるか、ジッタ(バーストなし)のシナリオでアンダーランがある場合は終了コード1を返す。
+ *       usage : latency_sim [seconds]   default 60
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "asrc_servo.h"
+#include "dsp.h"
+#include "cycle_model.h"
+
+#define SIM_OVERLAP		64			// 入力バッファ手前の作業領域 [word] (ASRC_OVERLAP 以上)
+#define SIM_OSR			8
+#define SIM_FEED_N		48			// PDM_FEED_N = PDM_DMA_CHUNK_N
+#define SIM_MUTE_N		24			// pdm_output() 無音バッファ長
+#define SIM_FF_PACKETS	1000		// 周波数計測周期[パケット]
+#define SIM_SKIP_S		5.0			// 集計から除く再生開始後の時間[s] (サーボ収束)
+#define SIM_CYC_SLOT	200			// サブフレーム毎の固定処理 (acquire/publish, 呼出し) [cycle]
+
+typedef struct {
+	const char*	name;
+	bool		asrc;		// I2S(ASRCサーボ) / USB
+	double		ppm;		// ソース偏差 [ppm] (I2S)
+	double		jitter_us;	// パケット到着ジッタ ±[us]
+	uint		burst_n;	// 遅延パケット周期 [パケット] (0 : なし)
+	double		burst_us;	// 遅延量 [us]
+} scenario_t;
+
+static const scenario_t scenario_list[] = {
+	{"i2s",        true,  100,  50,   0,    0},
+	{"i2s jitter", true,  100, 200,   0,    0},
+	{"usb",        false,   0, 100,   0,    0},
+	{"usb burst",  false,   0, 100, 997, 1500},
+};
+
+typedef struct {
+	double	lat_sum, lat_min, lat_max;
+	uint	lat_n;
+	uint	underrun;
+	uint	drop;
+} sim_result_t;
+
+// スロット毎の取込み時刻タグ (スロット先頭に書き込む : 先頭サンプルの取込み時刻, 1出力サンプル当たりの時間)
+typedef struct {
+	double	t_cap;
+	double	dt;
+} slot_tag_t;
+
+// Core1 モデル
+typedef struct {
+	double		t;			// 次イベント時刻
+	uint		pend;		// 変換中のサンプル数 (t で完了通知)
+	bool		mute;
+	bool		started;
+	double		t_start;	// 再生開始時刻
+	int32_t*	buf;
+	uint32_t	len;
+	uint32_t	pos;
+	slot_tag_t	tag;
+	uint		underrun;
+} core1_t;
+
+static int32_t in_top[SIM_OVERLAP + QUEUE_WIDTH];
+static int32_t* const in_buf = &in_top[SIM_OVERLAP];
+
+static double fs_dac;		// DAC実再生レート (384kHz段)
+
+static uint32_t sim_us(double t){
+	return (uint32_t)(uint64_t)(t * 1e6);
+}
+
+static double urand(void){
+	return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+// Core1 1イベント : 変換完了通知 -> ミュート判定・取出し -> 次の変換開始 (遅延を集計)
+static void core1_step(core1_t* c, sim_result_t* r){
+	if (c->pend) {
+		queue_consume(c->pend, sim_us(c->t));
+		c->pend = 0;
+	}
+	if (c->pos >= c->len) {
+		uint32_t queue_length = get_queue_length();
+		if ((queue_length == 0) && !c->mute) {
+			c->mute = true;
+			queue_reset();
+			if (c->started) c->underrun++;
+		} else if (queue_length >= queue_get_mode()->play_thr) {
+			if (!c->started) c->t_start = c->t;
+			c->mute = false;
+			c->started = true;
+		}
+		if (c->mute) {
+			c->t += SIM_MUTE_N / fs_dac;
+			return;
+		}
+		dequeue(&c->buf, &c->len);
+		memcpy(&c->tag, c->buf, sizeof(slot_tag_t));
+		c->pos = 0;
+	}
+	uint n = (c->len - c->pos < SIM_FEED_N) ? c->len - c->pos : SIM_FEED_N;
+	if (c->t - c->t_start >= SIM_SKIP_S) {
+		// 出力開始 = 変換開始 + DMA 1面分
+		double lat = c->t + SIM_FEED_N / fs_dac - (c->tag.t_cap + c->pos * c->tag.dt);
+		r->lat_sum += lat;
+		r->lat_n++;
+		if (lat < r->lat_min) r->lat_min = lat;
+		if (lat > r->lat_max) r->lat_max = lat;
+	}
+	c->pos += n;
+	c->pend = n;
+	c->t += n / fs_dac;
+}
+
+static sim_result_t sim_run(uint mode, const scenario_t* sc, double seconds){
+	const uint packets = (uint)(seconds * 1000);
+	const double fs_src = sc->asrc ? 48000.0 * (1.0 + sc->ppm * 1e-6) : fs_dac / SIM_OSR;
+	const uint frame_n = 48 * SIM_OSR;
+	const uint32_t pitch_nominal = (uint32_t)lround(48000.0 * SIM_OSR / fs_dac * (1 << ASRC_SERVO_FRAC_BIT));
+	const uint cyc_in = cyc_hbf_cascade(0, 3);
+	const uint cyc_out = sc->asrc ? cyc_asrc() : 0;
+	sim_result_t r = {.lat_min = 1e30};
+
+	srand(1);
+	queue_init(mode);
+	const queue_mode_t* qm = queue_get_mode();
+	asrc_reset();
+	asrc_servo_reset(pitch_nominal, qm->fill_target * frame_n / qm->frame_div, frame_n);
+	core1_t c1 = {.mute = true};
+
+	double t_packet = 0;		// パケット完成時刻 (ジッタなし)
+	double t_core0 = 0;			// Core0 処理完了時刻
+	double t_meas = 0;
+	double usb_acc = 0;
+	for(uint p = 0; p < packets; p++){
+		// パケット長 : I2S 48サンプル固定、USB はDAC実再生レートに一致するよう 47/48
+		uint packet_len = 48;
+		if (!sc->asrc) {
+			usb_acc += fs_src / 1000;
+			packet_len = (uint)usb_acc;
+			usb_acc -= packet_len;
+		}
+		t_packet += sc->asrc ? packet_len / fs_src : 1e-3;
+		double t = t_packet + sc->jitter_us * 1e-6 * urand();
+		if (sc->burst_n && (p % sc->burst_n == sc->burst_n - 1)) t += sc->burst_us * 1e-6;
+		if (t < t_core0) t = t_core0;
+		while (c1.t <= t) core1_step(&c1, &r);
+
+		// 周波数計測・サーボ (パケット毎)
+		uint32_t pitch = 1u << ASRC_SERVO_FRAC_BIT;
+		if (sc->asrc) {
+			if ((p + 1) % SIM_FF_PACKETS == 0) {
+				asrc_servo_set_ff((uint32_t)lround(SIM_FF_PACKETS * 48 / (t_packet - t_meas) * SIM_OSR / fs_dac * (1 << ASRC_SERVO_FRAC_BIT)));
+				t_meas = t_packet;
+			}
+			int32_t fill;
+			bool playing = queue_get_fill(sim_us(t), (uint32_t)fs_dac, &fill);
+			pitch = asrc_servo_update(playing, fill);
+		}
+
+		// サブフレーム毎の処理 (main.c と同じ分割)
+		for(uint j = 0, offset = 0; j < qm->frame_div; j++){
+			const uint end = packet_len * (j + 1) / qm->frame_div;
+			uint len = end - offset;
+			if (len == 0) continue;
+			const double t_cap = t_packet - (double)(packet_len - offset) / fs_src;
+			offset = end;
+			int32_t* q_buf = queue_acquire();
+			if (q_buf == NULL) {
+				r.drop++;
+				continue;
+			}
+			uint len_o = len * SIM_OSR;
+			if (sc->asrc) {
+				int32_t* buf = in_buf;
+				asrc(&buf, &len_o, pitch, q_buf);
+			}
+			t += (len * cyc_in + len_o * cyc_out + SIM_CYC_SLOT) / (double)CLK_SYS;
+			while (c1.t <= t) core1_step(&c1, &r);
+			slot_tag_t tag = {t_cap, (double)pitch / (1 << ASRC_SERVO_FRAC_BIT) / (fs_src * SIM_OSR)};
+			memcpy(q_buf, &tag, sizeof(tag));
+			queue_publish(len_o);
+		}
+		t_core0 = t;
+	}
+	r.underrun = c1.underrun;
+	return r;
+}
+
+int main(int argc, char* argv[]){
+	double seconds = (argc > 1) ? atof(argv[1]) : 60;
+	if (seconds < SIM_SKIP_S * 2) seconds = SIM_SKIP_S * 2;
+	fs_dac = CLK_SYS / 68.0 / 8;
+	bool fail = false;
+
+	host_set_core_num(0);
+	dsp_init();
+
+	printf("pico_1bit_dac_v2 latency_sim : DAC %.2fHz (384k), %.0fs/scenario, latency = capture -> PWM output (excl. filter group delay)\n\n",
+		fs_dac, seconds);
+	printf("  %-12s %-11s %4s %5s %5s %6s | %8s %8s %8s %8s %5s\n",
+		"mode", "scenario", "div", "depth", "thr", "target", "lat mean", "min", "max", "urun/min", "drop");
+	for(uint m = 0; m < QUEUE_MODE_N; m++){
+		for(uint s = 0; s < sizeof(scenario_list) / sizeof(scenario_list[0]); s++){
+			const scenario_t* sc = &scenario_list[s];
+			sim_result_t r = sim_run(m, sc, seconds);
+			const queue_mode_t* qm = queue_get_mode();
+			printf("  %-12s %-11s %4u %5u %5u %6u | %8.3f %8.3f %8.3f %8.2f %5u\n",
+				qm->name, sc->name, qm->frame_div, qm->depth, qm->play_thr, qm->fill_target,
+				r.lat_n ? 1e3 * r.lat_sum / r.lat_n : 0, r.lat_n ? 1e3 * r.lat_min : 0, r.lat_n ? 1e3 * r.lat_max : 0,
+				r.underrun * 60.0 / seconds, r.drop);
+			if (r.drop || (!sc->burst_n && r.underrun)) fail = true;
+		}
+	}
+	printf("\n%s\n", fail ? "NG (drop / underrun)" : "OK");
+	return fail ? 1 : 0;
+}
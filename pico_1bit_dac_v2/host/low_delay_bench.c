@@ -0,0 +1,176 @@
+/**
+ * @file low_delay_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 低遅延オーバーサンプリングフィルタ(iir1~3) 全入力fsの インパルス応答遅延・群遅延・Core0 処理量 直線位相(hbf1~3)との比較
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 入力fs毎に、直線位相(OS_FILTER_LINEAR)と低遅延(OS_FILTER_LOW_DELAY)について hbf_oversampler() (分担なし) へ
+ *       インパルスを入力し、352.8/384kHz 出力の応答から以下を出力する。
+ *        report     : os_get_group_delay_us() の群遅延 (ホスト側の遅延補正に使う値)
+ *        gd DC      : 応答から求めた DC の群遅延 Σn・h[n] / Σh[n] [us]
+ *        gd 20k     : 20kHz の群遅延 Re(Σn・h[n]e^-jωn / Σh[n]e^-jωn) [us] (直線位相は DC と同じ)
+ *        peak       : インパルス入力から応答の最大値までの時間 [us]
+ *        cyc/frame  : 1入力フレーム(L/R)当たりの Core0 見積もりサイクル (host/cycle_model.h)
+ *                     直線位相は cyc_hbf_fs() (HBF_STREAM = 1)、低遅延は cyc_iir_fs() (段毎)
+ *        Core0[%]   : 見積もりCore0負荷 (分担なし)
+ *        ripple     : 通過域(0~20kHz)リプル[dB]
+ *        image      : 可聴帯域のイメージ(k・fs ± 20kHz, k ≧ 1)の最大レベル[dB]
+ *       report と gd DC の差が GD_TOL を超える、低遅延の群遅延が直線位相以上、低遅延のリプル・イメージが
+ *       直線位相より悪化する(RIPPLE_TOL, IMAGE_TOL を超える)、または低遅延で Core1 分担が選ばれる場合は終了コード1を返す。
+ *       群遅延・リプル・イメージは オーバーサンプラ(入力fs -> 352.8/384kHz)のみで、ASRC・Core1 の x8 補間・キューを含まない。
+ *       usage : low_delay_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "cycle_model.h"
+
+#define IMPULSE_LEVEL	(1 << 21)	// インパルス振幅
+#define PACKET_LEN		32			// 1回の hbf_oversampler() 入力サンプル数
+#define PACKET_N		8			// 応答測定パケット数 (IIR の応答が減衰するまで)
+#define RESP_LEN		(PACKET_LEN * PACKET_N * 8)		// 応答長 (最大 x8)
+#define PASSBAND_EDGE	20000.0		// 通過域端[Hz]
+#define GD_TOL			0.05		// report と gd DC の許容差[us] (低遅延は全域通過段の丸め誤差分ずれる)
+#define RIPPLE_TOL		0.01		// 低遅延のリプル悪化の許容値[dB]
+#define IMAGE_TOL		3.0			// 低遅延のイメージ悪化の許容値[dB] (段毎の仕様は同じ、実現減衰量の差)
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+#define FS_N	(sizeof(fs_list) / sizeof(fs_list[0]))
+
+static const char* const filter_name[2] = {"linear", "lowdelay"};
+
+static int32_t out_buf[PACKET_LEN * 8 * N_CH];
+static double resp[RESP_LEN];
+
+typedef struct {
+	double	report, gd_dc, gd_20k, peak;	// [us]
+	uint	cyc;
+	uint	split;							// os_split_select() の分担段数
+	double	ripple, image;
+} ld_result_t;
+
+// h[] (出力レート fo) の周波数 f の応答 H と Σn・h[n]e^-jωn
+static void dft(const double* h, uint n, double f, double fo, double* hr, double* hi, double* nr, double* ni){
+	*hr = *hi = *nr = *ni = 0;
+	for(uint i = 0; i < n; i++){
+		const double c = cos(2.0 * M_PI * f * i / fo), s = -sin(2.0 * M_PI * f * i / fo);
+		*hr += h[i] * c;		*hi += h[i] * s;
+		*nr += i * h[i] * c;	*ni += i * h[i] * s;
+	}
+}
+
+// 周波数 f の群遅延 [出力サンプル]
+static double group_delay(const double* h, uint n, double f, double fo){
+	double hr, hi, nr, ni;
+	dft(h, n, f, fo, &hr, &hi, &nr, &ni);
+	return (nr * hr + ni * hi) / (hr * hr + hi * hi);
+}
+
+// インパルス応答 (Lch) の測定
+static void measure(uint fs, uint filter, ld_result_t* r){
+	const uint n = hbf_get_stage_n(fs);
+	const uint l = 1 << n;
+	const double fo = (double)fs * l;
+	os_filter_set(filter);
+	dsp_reset();
+
+	// 分担選択 (段毎の処理量は見積もり値, Core1 PWM変換を最小とし、直線位相では分担が選ばれる条件)
+	os_cost_t cost;
+	memset(&cost, 0, sizeof(cost));
+	for(uint s = 0; s < HBF_STAGE_N; s++){
+		cost.hbf[s][0] = cyc_hbf_stage(s);
+		cost.hbf[s][1] = cyc_hbf_stage_core1(s);
+	}
+	cost.pcm2pwm = 1;
+	r->split = os_split_select(fs, &cost);
+	os_split_set(fs, 0);
+
+	r->report = os_get_group_delay_us(fs);
+	r->cyc = (filter == OS_FILTER_LOW_DELAY) ? cyc_iir_fs(fs) : cyc_hbf_fs(fs);
+	uint len_o = 0;
+	for(uint p = 0; p < PACKET_N; p++){
+		int32_t* buf = get_dsp_buf_pointer(fs);
+		memset(buf, 0, sizeof(int32_t) * PACKET_LEN * N_CH);
+		if (p == 0) buf[0] = IMPULSE_LEVEL;
+		uint len = PACKET_LEN;
+		hbf_oversampler(&buf, &len, fs, out_buf);
+		for(uint i = 0; i < len; i++) resp[len_o + i] = (double)buf[i * N_CH] / IMPULSE_LEVEL;
+		len_o += len;
+	}
+
+	double sum = 0, nsum = 0, peak = 0;
+	uint peak_i = 0;
+	for(uint i = 0; i < len_o; i++){
+		sum += resp[i];
+		nsum += i * resp[i];
+		if (fabs(resp[i]) > peak) { peak = fabs(resp[i]); peak_i = i; }
+	}
+	r->gd_dc = nsum / sum / fo * 1e6;
+	r->gd_20k = (n == 0) ? 0 : group_delay(resp, len_o, PASSBAND_EDGE, fo) / fo * 1e6;
+	r->peak = peak_i / fo * 1e6;
+
+	// 周波数特性 (fs_profile_bench と同じ評価)
+	double pb_max = -1e9, pb_min = 1e9, im_max = -300.0;
+	for(double f = 0; f <= fo / 2; f += 100.0){
+		double hr, hi, nr, ni;
+		dft(resp, len_o, f, fo, &hr, &hi, &nr, &ni);
+		const double db = 20.0 * log10(sqrt(hr * hr + hi * hi) / l + 1e-12);
+		const double k = floor(f / fs + 0.5);
+		if (f <= PASSBAND_EDGE) {
+			if (db > pb_max) pb_max = db;
+			if (db < pb_min) pb_min = db;
+		} else if (k >= 1 && fabs(f - k * fs) <= PASSBAND_EDGE) {
+			if (db > im_max) im_max = db;
+		}
+	}
+	r->ripple = pb_max - pb_min;
+	r->image = im_max;
+}
+
+int main(void){
+	bool fail = false;
+	host_set_core_num(0);
+	dsp_init();
+
+	printf("pico_1bit_dac_v2 low_delay_bench : CLK_SYS %.1fMHz, impulse -> hbf_oversampler() -> 352.8/384kHz, no os split\n\n", CLK_SYS / 1e6);
+	printf("  %-7s %-9s %10s %9s %9s %9s %9s %8s %10s %9s %6s\n",
+		"fs", "filter", "report[us]", "gd DC", "gd 20k", "peak", "cyc/frame", "Core0[%]", "ripple[dB]", "image[dB]", "split");
+	for(uint f = 0; f < FS_N; f++){
+		const uint fs = fs_list[f];
+		const uint n = hbf_get_stage_n(fs);
+		ld_result_t r[2];
+		char fs_str[16];
+		sprintf(fs_str, "%u", fs);
+		for(uint m = 0; m < 2; m++){
+			measure(fs, m ? OS_FILTER_LOW_DELAY : OS_FILTER_LINEAR, &r[m]);
+			printf("  %-7s %-9s %10.2f %9.2f %9.2f %9.2f %9u %8.2f %10.4f %9.1f %6u\n", m ? "" : fs_str, filter_name[m],
+				r[m].report, r[m].gd_dc, r[m].gd_20k, r[m].peak, r[m].cyc, 100.0 * r[m].cyc / cyc_budget(fs),
+				r[m].ripple, (n == 0) ? 0.0 : r[m].image, r[m].split);
+		}
+		bool ok = (fabs(r[0].report - r[0].gd_dc) <= GD_TOL) && (fabs(r[1].report - r[1].gd_dc) <= GD_TOL)
+			&& (r[1].split == 0);
+		if (n > 0) {
+			ok = ok && (r[1].gd_dc < r[0].gd_dc) && (r[1].ripple <= r[0].ripple + RIPPLE_TOL) && (r[1].image <= r[0].image + IMAGE_TOL);
+			printf("  %-7s %-9s delay %+.2fus (%.0f%%), cyc %+.1f%%  %s\n", "", "", r[1].gd_dc - r[0].gd_dc,
+				100.0 * r[1].gd_dc / r[0].gd_dc, 100.0 * ((double)r[1].cyc / r[0].cyc - 1.0), ok ? "OK" : "NG");
+		} else {
+			printf("  %-7s %-9s (no stages)  %s\n", "", "", ok ? "OK" : "NG");
+		}
+		if (!ok) fail = true;
+	}
+	os_filter_set(OS_FILTER_LINEAR);
+	printf("\n  report : os_get_group_delay_us(), gd DC/20k : group delay from the impulse response, peak : impulse -> response peak\n");
+	printf("  ripple : 0~%.0fkHz, image : k*fs +-%.0fkHz (k >= 1), split : os_split_select() with Core1 headroom\n",
+		PASSBAND_EDGE / 1000, PASSBAND_EDGE / 1000);
+	printf("  limits : |report - gd DC| <= %.2fus, lowdelay gd DC < linear, ripple <= linear + %.2fdB, image <= linear + %.0fdB, split = 0\n",
+		GD_TOL, RIPPLE_TOL, IMAGE_TOL);
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
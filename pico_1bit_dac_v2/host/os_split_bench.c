@@ -0,0 +1,184 @@
+/**
+ * @file os_split_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Core0/Core1 オーバーサンプリング分担(os_split) 全入力fsのコア負荷・分担選択・ビット一致確認
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 段毎の処理サイクルを host/cycle_model.h の見積もりで os_cost_t に設定し、dsp.c の os_split_select() で分担を選ぶ。
+ *       入力fs毎・ソース(USB : volume, I2S : asrc)毎に、分担段数 split = 0~OS_SPLIT_MAX の Core0/Core1 負荷[%]を出力し、
+ *       選択した分担(*)と、固定分担(split = 0, 従来)に対する最大コア負荷を比較する。
+ *       実機は os_split_calibrate() の計測値(SysTick)と Core1 の PWM変換計測値で同じ選択を行う。
+ *       ビット一致確認 : 各fs・各分担で Core0 hbf_oversampler() -> (キューのfs) -> Core1 hbf_oversampler_core1() を
+ *       PDM_FEED_N 単位で処理した 352.8/384kHz 出力が、分担なしの出力と一致することを確認する。
+ *       fs変化確認 : 分担設定後、次のフォーマット更新前に段数の少ない fs のパケットが来た場合に、
+ *       hbf_oversampler() が段数を超えて処理せず 0段(コピー)となることを確認する。
+ *       選択した分担の最大コア負荷が100%を超える、またはビット一致しない場合は終了コード1を返す。
+ *       usage : os_split_bench [profile]   default PCM2PWM_PROFILE_DEFAULT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "pdm_output.h"
+#include "dsp.h"
+#include "cycle_model.h"
+
+// pdm_output.c の設定と合わせること
+#define BENCH_OS_INNER_N	4
+#define BENCH_BLOCK_N		8
+#define BENCH_CHUNK_N		48		// PDM_DMA_CHUNK_N = PDM_FEED_N
+
+#define BENCH_PACKETS		200		// ビット一致確認のパケット数
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+#define FS_N	(sizeof(fs_list) / sizeof(fs_list[0]))
+
+static int32_t ref_out[BENCH_PACKETS * QUEUE_WIDTH];
+static int32_t slot[QUEUE_SLOT_WIDTH];
+static int32_t os_buf[BENCH_CHUNK_N * N_CH];
+
+static double util(uint load, uint fs){
+	return 100.0 * load * (double)fs / CLK_SYS;
+}
+
+// 入力fs fs, 分担 split で BENCH_PACKETS パケットを処理し、352.8/384kHz 出力を out へ格納する 戻り値 : 出力サンプル数
+static uint run_split(uint fs, uint split, int32_t* out){
+	uint64_t phase = 0;
+	uint n_out = 0;
+	srand(1);
+	host_set_core_num(0);
+	dsp_reset();
+	const uint32_t tag = os_split_set(fs, split);
+	for(uint p = 0; p < BENCH_PACKETS; p++){
+		host_set_core_num(0);
+		int32_t* buf = get_dsp_buf_pointer(fs);
+		uint len = fs / 1000 + (p % 3 == 0);
+		for(uint i = 0; i < len; i++){
+			// -1dBFS 997Hz + 雑音 (clamp 動作を含める)
+			double s = sin(2.0 * M_PI * 997.0 * (double)phase++ / fs) * (1 << 23) * 0.89 + (rand() % 65536 - 32768);
+			buf[i * 2] = (int32_t)s;
+			buf[i * 2 + 1] = (p & 1) ? (rand() % (1 << 24)) - (1 << 23) : -(int32_t)s;
+		}
+		hbf_oversampler(&buf, &len, fs, slot);
+
+		// Core1 : PDM_FEED_N >> split サンプル毎に後段処理
+		host_set_core_num(1);
+		for(uint i = 0; i < len; ){
+			uint n = (len - i < (BENCH_CHUNK_N >> split)) ? len - i : (BENCH_CHUNK_N >> split);
+			if (split) {
+				uint n_o = n;
+				hbf_oversampler_core1(&slot[i * N_CH], os_buf, &n_o, tag);
+				memcpy(&out[n_out * N_CH], os_buf, sizeof(int32_t) * n_o * N_CH);
+				n_out += n_o;
+			} else {
+				memcpy(&out[n_out * N_CH], &slot[i * N_CH], sizeof(int32_t) * n * N_CH);
+				n_out += n;
+			}
+			i += n;
+		}
+	}
+	host_set_core_num(0);
+	os_split_set(fs, 0);
+	return n_out;
+}
+
+int main(int argc, char* argv[]){
+	uint profile = (argc > 1) ? (uint)atoi(argv[1]) : PCM2PWM_PROFILE_DEFAULT;
+	if (profile >= pcm2pwm_get_profile_n()) profile = PCM2PWM_PROFILE_DEFAULT;
+	bool fail = false;
+
+	host_set_core_num(0);
+	dsp_init();
+	queue_init(QUEUE_MODE_ROBUST);
+	host_set_core_num(1);
+	pcm2pwm_init(profile);
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(profile);
+	const uint bs_n = pcm2pwm_get_bs_n();
+
+	// 段毎の処理サイクル (見積もり)
+	os_cost_t cost;
+	for(uint i = 0; i < HBF_STAGE_N; i++){
+		cost.hbf[i][0] = cyc_hbf_stage(i);
+		cost.hbf[i][1] = cyc_hbf_stage_core1(i);
+	}
+	cost.volume = cyc_volume_fused();
+	cost.asrc = cyc_asrc();
+	cost.pcm2pwm = 2 * cyc_pcm2pwm_block_prof(prof, BENCH_OS_INNER_N, bs_n, BENCH_BLOCK_N)
+				 + (cyc_dma_chunk() + BENCH_CHUNK_N - 1) / BENCH_CHUNK_N;
+
+	printf("pico_1bit_dac_v2 os_split_bench : CLK_SYS %.1fMHz, profile %u (PWM %ubit, DS order %u, %s)\n",
+		CLK_SYS / 1e6, profile, prof->pwm_bit, prof->ds_order, prof->os_type ? "LI" : "SH");
+	printf("cost [cycle/sample] : hbf1 %u/%u, hbf2 %u/%u, hbf3 %u/%u (Core0/Core1), volume %u, asrc %u, pcm2pwm %u\n\n",
+		cost.hbf[0][0], cost.hbf[0][1], cost.hbf[1][0], cost.hbf[1][1], cost.hbf[2][0], cost.hbf[2][1],
+		cost.volume, cost.asrc, cost.pcm2pwm);
+
+	printf("  %-7s %-4s |", "fs", "src");
+	for(uint s = 0; s <= OS_SPLIT_MAX; s++) printf("  split%u C0/C1 [%%] ", s);
+	printf("| %5s %9s %9s\n", "split", "fixed[%]", "worst[%]");
+	for(uint f = 0; f < FS_N; f++){
+		const uint fs = fs_list[f];
+		const uint n = hbf_get_stage_n(fs);
+		for(uint src = 0; src < 2; src++){
+			os_cost_t c = cost;
+			if (src == 0) c.asrc = 0;		// USB : volume
+			else          c.volume = 0;		// I2S : asrc
+			const uint sel = os_split_select(fs, &c);
+			double worst[OS_SPLIT_MAX + 1] = {0};
+			printf("  %-7u %-4s |", fs, src ? "i2s" : "usb");
+			for(uint s = 0; s <= OS_SPLIT_MAX; s++){
+				if (s > n) {
+					printf("  %17s ", "-");
+					continue;
+				}
+				uint load0, load1;
+				os_split_load(fs, s, &c, &load0, &load1);
+				const double u0 = util(load0, fs), u1 = util(load1, fs);
+				worst[s] = (u0 > u1) ? u0 : u1;
+				printf(" %c%7.1f /%7.1f ", (s == sel) ? '*' : ' ', u0, u1);
+			}
+			printf("| %5u %9.1f %9.1f\n", sel, worst[0], worst[sel]);
+			if (worst[sel] > 100.0) fail = true;
+		}
+	}
+
+	// ビット一致確認
+	printf("\nbit-exact (Core0 -> queue -> Core1 tail vs no split)\n");
+	static int32_t out[BENCH_PACKETS * QUEUE_WIDTH];
+	for(uint f = 0; f < FS_N; f++){
+		const uint fs = fs_list[f];
+		const uint n = hbf_get_stage_n(fs);
+		const uint ref_n = run_split(fs, 0, ref_out);
+		printf("  %-7u", fs);
+		for(uint s = 1; (s <= OS_SPLIT_MAX) && (s <= n); s++){
+			const uint out_n = run_split(fs, s, out);
+			const bool ok = (out_n == ref_n) && (memcmp(out, ref_out, sizeof(int32_t) * ref_n * N_CH) == 0);
+			printf("  split%u %s", s, ok ? "OK" : "NG");
+			if (!ok) fail = true;
+		}
+		printf("\n");
+	}
+
+	// fs変化確認 : 48kHz で分担 OS_SPLIT_MAX を設定したまま 384kHz (0段) のパケットを処理
+	printf("\nfs change before format update (split %u set at 48000, packet at 384000)\n", OS_SPLIT_MAX);
+	{
+		host_set_core_num(0);
+		dsp_reset();
+		os_split_set(48000, OS_SPLIT_MAX);
+		int32_t* buf = get_dsp_buf_pointer(384000);
+		uint len = 384;
+		for(uint i = 0; i < len * N_CH; i++) buf[i] = (rand() % (1 << 24)) - (1 << 23);
+		memcpy(ref_out, buf, sizeof(int32_t) * len * N_CH);
+		hbf_oversampler(&buf, &len, 384000, slot);
+		const bool ok = (len == 384) && (memcmp(slot, ref_out, sizeof(int32_t) * len * N_CH) == 0);
+		printf("  384000  len %u, copy %s\n", len, ok ? "OK" : "NG");
+		if (!ok) fail = true;
+		os_split_set(48000, 0);
+	}
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file oversampler_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 前段オーバーサンプラ比較ベンチマーク 連結ハーフバンド(hbf1~3) vs 単段ポリフェーズFIR(pfir)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 入力fs毎に以下を出力する。
+ *        mul/frame  : 1入力フレーム(L/R)当たりの乗算回数
+ *        ns/frame   : ホスト実測処理時間
+ *        cyc/frame  : Cortex-M0+ 見積もりサイクル数 (host/cycle_model.h)
+ *        Core0[%]   : 見積もりCore0負荷
+ *        ripple     : 通過域(0~20kHz)リプル[dB]
+ *        stopband   : 阻止域(fs-20kHz ~ 出力ナイキスト)の最大レベル[dB]
+ *       最後に両方式の出力差の最大値(-6dBFSサイン入力)を出力する。
+ *       usage : oversampler_bench [packets]   default 1000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+#define IMPULSE_LEVEL	(1 << 21)	// 周波数特性測定用インパルス振幅
+#define IMPULSE_LEN		64			// 周波数特性測定用入力サンプル数
+#define PASSBAND_EDGE	20000.0		// 通過域端[Hz]
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000};
+
+static int32_t src_buf[QUEUE_WIDTH];
+static int32_t work_buf[2][QUEUE_WIDTH];
+static int32_t out_buf[2][IMPULSE_LEN * 8 * N_CH];
+
+static void make_source(int32_t* buf, uint len, uint fs, uint64_t* phase){
+	for(uint i = 0; i < len; i++){
+		double s = sin(2.0 * M_PI * 997.0 * (double)(*phase)++ / fs) * (double)(1 << 22);
+		*buf++ = (int32_t)s;
+		*buf++ = -(int32_t)s;
+	}
+}
+
+// 連結ハーフバンド hbf(first+1) から n_stage 段 (hbf_oversampler と同一構成)、出力は work_buf のいずれか
+static int32_t* run_cascade(int32_t* p_i, uint* p_len, uint first, uint n_stage){
+	for(uint n = 0; n < n_stage; n++){
+		int32_t* p_o = work_buf[n & 1];
+		switch(first + n){
+			case 0: hbf1_x2_oversampler(p_i, p_o, p_len); break;
+			case 1: hbf2_x2_oversampler(p_i, p_o, p_len); break;
+			case 2: hbf3_x2_oversampler(p_i, p_o, p_len); break;
+		}
+		p_i = p_o;
+	}
+	return p_i;
+}
+
+// インパルス応答から通過域リプルと阻止域最大レベルを求める (Lch)
+static void measure_response(const int32_t* h, uint n, uint l, uint fs, double* ripple, double* stopband){
+	const double fo = (double)fs * l;
+	double pb_max = -1e9, pb_min = 1e9, sb_max = -1e9;
+	for(double f = 0; f <= fo / 2; f += 100.0){
+		double re = 0, im = 0;
+		for(uint i = 0; i < n; i++){
+			re += h[i * N_CH] * cos(2.0 * M_PI * f * i / fo);
+			im -= h[i * N_CH] * sin(2.0 * M_PI * f * i / fo);
+		}
+		double db = 20.0 * log10(sqrt(re * re + im * im) / ((double)IMPULSE_LEVEL * l) + 1e-12);
+		if (f <= PASSBAND_EDGE) {
+			if (db > pb_max) pb_max = db;
+			if (db < pb_min) pb_min = db;
+		} else if (f >= fs - PASSBAND_EDGE) {
+			if (db > sb_max) sb_max = db;
+		}
+	}
+	*ripple = pb_max - pb_min;
+	*stopband = sb_max;
+}
+
+static void bench_fs(uint fs, uint packets){
+	uint n_stage = 0;		// hbf段数
+	for(uint r = fs; r < 352800; r <<= 1) n_stage++;
+	const uint l = 1 << n_stage;
+	const uint first = hbf_get_first_stage(fs);	// 入力fs別プロファイルの初段
+	const uint packet_len = fs / 1000;
+
+	// 乗算回数 : hbf は対称タップ対毎に1回、pfir は上位/下位で2回
+	uint mul_hbf = 0;
+	for(uint n = 0; n < n_stage; n++){
+		uint mac32_n, mac64_n;
+		hbf_get_mac_n(first + n, &mac32_n, &mac64_n);
+		mul_hbf += (mac32_n + mac64_n) << n;
+	}
+	mul_hbf *= N_CH;
+	const uint tap_pfir = pfir_get_tap_n(l);
+	const uint mul_pfir = tap_pfir * 2 * N_CH;
+	const uint cyc_hbf  = cyc_hbf_cascade(first, n_stage);
+	const uint cyc_pf   = cyc_pfir(l, tap_pfir);
+
+	// 処理時間計測
+	double ns_hbf = 0, ns_pfir = 0;
+	uint64_t phase = 0;
+	hbf_oversampler_reset();
+	for(uint p = 0; p < packets; p++){
+		uint len = packet_len;
+		make_source(src_buf, len, fs, &phase);
+		double t0 = now_ns();
+		run_cascade(src_buf, &len, first, n_stage);
+		double t1 = now_ns();
+		len = packet_len;
+		pfir_oversampler(src_buf, work_buf[1], &len, l);
+		double t2 = now_ns();
+		ns_hbf  += t1 - t0;
+		ns_pfir += t2 - t1;
+	}
+
+	// 出力差 (同一入力、リセットから開始)
+	int32_t diff_max = 0;
+	phase = 0;
+	hbf_oversampler_reset();
+	for(uint p = 0; p < 100; p++){
+		uint len = packet_len;
+		make_source(src_buf, len, fs, &phase);
+		int32_t* p_h = run_cascade(src_buf, &len, first, n_stage);
+		memcpy(out_buf[0], p_h, sizeof(int32_t) * ((len < IMPULSE_LEN * 8) ? len : IMPULSE_LEN * 8) * N_CH);
+		len = packet_len;
+		pfir_oversampler(src_buf, out_buf[1], &len, l);
+		for(uint i = 0; i < len * N_CH && i < IMPULSE_LEN * 8 * N_CH; i++){
+			int32_t d = abs(out_buf[0][i] - out_buf[1][i]);
+			if (d > diff_max) diff_max = d;
+		}
+	}
+
+	// 周波数特性 (インパルス応答)
+	double rip_hbf, sb_hbf, rip_pfir, sb_pfir;
+	uint len = IMPULSE_LEN;
+	memset(src_buf, 0, sizeof(src_buf));
+	src_buf[0] = IMPULSE_LEVEL;
+	hbf_oversampler_reset();
+	int32_t* p_h = run_cascade(src_buf, &len, first, n_stage);
+	memcpy(out_buf[0], p_h, sizeof(int32_t) * len * N_CH);
+	measure_response(out_buf[0], len, l, fs, &rip_hbf, &sb_hbf);
+	len = IMPULSE_LEN;
+	pfir_oversampler(src_buf, out_buf[1], &len, l);
+	measure_response(out_buf[1], len, l, fs, &rip_pfir, &sb_pfir);
+
+	const double frames = (double)packets * packet_len;
+	printf("fs = %uHz  x%u  (%u packets x %u samples)\n", fs, l, packets, packet_len);
+	printf("  %-8s %10s %10s %10s %9s %11s %12s\n", "type", "mul/frame", "ns/frame", "cyc/frame", "Core0[%]", "ripple[dB]", "stopband[dB]");
+	printf("  %-8s %10u %10.2f %10u %9.2f %11.4f %12.1f\n", "hbf1~3", mul_hbf, ns_hbf / frames, cyc_hbf,
+		100.0 * cyc_hbf / cyc_budget(fs), rip_hbf, sb_hbf);
+	printf("  %-8s %10u %10.2f %10u %9.2f %11.4f %12.1f\n", "pfir", mul_pfir, ns_pfir / frames, cyc_pf,
+		100.0 * cyc_pf / cyc_budget(fs), rip_pfir, sb_pfir);
+	printf("  max |hbf - pfir| = %d LSB (24bit)\n\n", diff_max);
+}
+
+int main(int argc, char* argv[]){
+	uint packets = (argc > 1) ? (uint)atoi(argv[1]) : 1000;
+
+	printf("pico_1bit_dac_v2 oversampler_bench : CLK_SYS = %.1fMHz\n\n", CLK_SYS / 1e6);
+
+	host_set_core_num(0);
+	dsp_init();
+	for(uint i = 0; i < sizeof(fs_list) / sizeof(fs_list[0]); i++){
+		bench_fs(fs_list[i], packets);
+	}
+	return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file pcm2pwm_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Core1 PWM変換(ΔΣ)処理 サンプル単位版 vs ブロック単位版 サイクル見積もり
+ * @version 0.01
+ * @date 2026-10-17
+ * @note PWM_BIT / DS_ORDER の組み合わせ毎に、fs = 384kHz 入力時の Core1 見積もり負荷を出力する。
+ *        per-sample : 旧 pcm2pwm() (サンプル毎に ch->ds[] 復帰・退避, interp再設定)
+ *        block      : pcm2pwm_block() (PCM2PWM_BLOCK_N サンプル毎)
+ *       いずれもPIO出力(pio0_sm01_put_blocking, FIFO待ちを除く)を含む L/R 2ch分。
+ *       最後に既定プロファイル(PCM2PWM_PROFILE_DEFAULT)のホスト実測時間を出力する。
+ *       usage : pcm2pwm_bench [packets]   default 1000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "pdm_output.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+// pdm_output.c の設定と合わせること
+#define BENCH_OS_INNER_N	4
+#define BENCH_BLOCK_N		8
+
+#define BENCH_FS			384000	// Core1入力fs (最悪条件)
+#define BENCH_DS_ORDER_MAX	7
+
+static int32_t src_buf[QUEUE_WIDTH];
+static uint32_t bs_buf[QUEUE_WIDTH * 2];
+
+// PWM_BIT毎の出力ワード数 4~5bit : x8 (2word/sample), 6bit : x4 (1word/sample)
+static uint bench_outer_n(uint pwm_bit){
+	return (pwm_bit == 6) ? 1 : 2;
+}
+
+int main(int argc, char* argv[]){
+	uint packets = (argc > 1) ? (uint)atoi(argv[1]) : 1000;
+	const double budget = cyc_budget(BENCH_FS);
+
+	printf("pico_1bit_dac_v2 pcm2pwm_bench : CLK_SYS = %.1fMHz, fs = %uHz, budget = %.1f cycle/sample, block = %u\n\n",
+		CLK_SYS / 1e6, BENCH_FS, budget, BENCH_BLOCK_N);
+	printf("  %-7s %-8s %-5s %12s %12s %8s %10s %10s %s\n",
+		"PWM_BIT", "DS_ORDER", "rate", "per-sample", "block", "saved", "load old", "load new", "");
+	for(uint pwm_bit = 5; pwm_bit <= 6; pwm_bit++){
+		const uint outer_n = bench_outer_n(pwm_bit);
+		const uint os = BENCH_OS_INNER_N * outer_n;
+		const uint pio = outer_n * cyc_pio_put();
+		for(uint order = 1; order <= BENCH_DS_ORDER_MAX; order++){
+			uint cyc_old = 2 * cyc_pcm2pwm(order, BENCH_OS_INNER_N, outer_n) + pio;
+			uint cyc_new = 2 * cyc_pcm2pwm_block(order, BENCH_OS_INNER_N, outer_n, BENCH_BLOCK_N) + pio;
+			double load_old = 100.0 * cyc_old / budget;
+			double load_new = 100.0 * cyc_new / budget;
+			const char* fit = (load_new > 100.0) ? "NG" : (load_old > 100.0) ? "OK (new)" : "OK";
+			printf("  %-7u %-8u x%-4u %12u %12u %7.1f%% %9.1f%% %9.1f%% %s%s\n",
+				pwm_bit, order, os, cyc_old, cyc_new, 100.0 * (cyc_old - cyc_new) / cyc_old,
+				load_old, load_new, fit, (order >= pwm_bit) ? " *PWM_BIT<=DS_ORDER" : "");
+		}
+	}
+	printf("  *PWM_BIT<=DS_ORDER : ΔΣの安定条件(PWM_BIT > DS_ORDER)を満たさない\n\n");
+
+	// ビルド時設定での実測
+	host_set_core_num(1);
+	pcm2pwm_init(PCM2PWM_PROFILE_DEFAULT);
+	const uint packet_len = BENCH_FS / 1000;
+	uint64_t phase = 0;
+	double ns = 0;
+	for(uint p = 0; p < packets; p++){
+		for(uint i = 0; i < packet_len; i++){
+			int32_t s = (int32_t)(sin(2.0 * M_PI * 997.0 * (double)phase++ / BENCH_FS) * (double)(1 << 22));
+			src_buf[i * 2 + 0] = s;
+			src_buf[i * 2 + 1] = -s;
+		}
+		double t0 = now_ns();
+		pcm2pwm_frame(src_buf, packet_len, bs_buf);
+		ns += now_ns() - t0;
+	}
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(PCM2PWM_PROFILE_DEFAULT);
+	printf("host measured (PWM_BIT = %d, DS_ORDER = %d, block) : %.2f ns/sample (L/R)\n",
+		prof->pwm_bit, prof->ds_order, ns / ((double)packets * packet_len));
+	return 0;
+}
@@ -0,0 +1,312 @@
+/**
+ * @file pio_feed_model.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Core1 -> PIO TX FIFO 供給タイミングモデル FIFO空き待ち書込み vs DMA(ピンポンバッファ)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note Core1 の処理サイクル(host/cycle_model.h)と PIO のワード消費周期から、1ch分の TX FIFO(8段, join)の
+ *       書込み・消費時刻をワード単位で求め、1フレーム(384サンプル, 1ms)当たりの Core1 の時間配分を出力する。
+ *         FIFO : pcm2pwm_block() Lchブロック変換後、Rch変換と並行して pio0_sm01_put_blocking() で書込み
+ *         DMA  : PDM_DMA_CHUNK_N サンプル毎に面へ変換し、前面の転送完了後に DMA が FIFO 空き(DREQ)毎に書込み
+ *                面の切替・起動は pdm_dma_feed() と同じ手順で DMAチャネルレジスタモデル(host/dma_sim.h)を操作し、
+ *                READ_ADDR・TRANS_COUNT・CHAIN_TO による連結起動で転送する
+ *       PIO は PWM周期毎に FIFO を確認し、1ワード(4PWM周期)を出力する。FIFO空の周期は中心レベルを出力する(アンダーラン)。
+ *       L/R の FIFO は同一周期で消費されるため 1ch分のみを模擬する。DMAのバス占有は無視する。
+ *        Core1[%]   : 処理サイクル(PWM変換・PIO書込み・面切替)の割合
+ *        wait       : FIFO空き待ち / 面の転送完了待ち [cycle/frame] (Core1 の空き時間)
+ *        waits      : 待ちの回数 [/frame]
+ *        max window : 1回の待ちの最大長 [cycle] (他処理・スリープに使用できる連続時間の目安)
+ *        slack[us]  : Core1 が割込み等で停止してもアンダーランしない時間の最小値
+ *        underrun   : アンダーラン回数 (起動直後を除く)
+ *       DMA で出力の欠落(lost)・面の設定範囲外の読出し(garbage)・転送完了待ちが終わらない(DMA hang)場合は表示する。
+ *       既定プロファイルの DMA では、面の変換前に Core1 を停止させ、slack の 90% ではアンダーランなし、
+ *       slack + STALL_OVER_US ではアンダーラン 1回の後に欠落・範囲外読出しなく復帰することを確認する。
+ *       いずれかのプロファイル・方式でアンダーラン・欠落・範囲外読出し・DMA hang が発生した場合、
+ *       または Core1 停止の結果が上記と異なる場合は終了コード1を返す。
+ *       usage : pio_feed_model [frames]   default 50
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "pdm_output.h"
+#include "cycle_model.h"
+#include "dma_sim.h"
+
+// pdm_output.c の設定と合わせること
+#define MODEL_OS_INNER_N	4
+#define MODEL_BLOCK_N		8		// PCM2PWM_BLOCK_N
+#define MODEL_CHUNK_N		48		// PDM_DMA_CHUNK_N
+#define MODEL_FIFO_N		8		// PIO TX FIFO 段数 (join)
+
+#define MODEL_FRAME_N		384		// 1フレームのサンプル数 (384kHz, 1ms)
+#define MODEL_SKIP			2		// 集計から除く先頭フレーム数
+#define STALL_OVER_US		20.0	// Core1 停止試験 : 余裕を超える停止時間[us]
+
+typedef struct {
+	double	busy;		// 処理サイクル
+	double	wait;		// 待ちサイクル
+	uint	waits;		// 待ち回数
+	double	max_window;	// 最大待ち
+	double	slack;		// 最小余裕 [cycle]
+	uint	underrun;	// アンダーラン回数
+	uint	lost;		// 出力されなかったワード数
+	uint	garbage;	// DMA : 面の設定範囲外の読出しワード数
+	bool	hang;		// DMA : 転送完了待ちが終わらない (連結ループ)
+} feed_result_t;
+
+typedef struct {
+	uint	pwm_cycle;	// PWM周期 [cycle]
+	uint	bs_n;		// 1サンプル1ch当たりのワード数
+	double	cyc_ch;		// 1サンプル1ch当たりのPWM変換サイクル
+	uint	frames;
+	uint	chunk_n;
+	double	stall;		// Core1 停止 [cycle] (フレーム stall_frame の中央の面の手順1 の後)
+	uint	stall_frame;
+	// 状態
+	double	tc;			// Core1 時刻
+	double* push;		// ワード書込み時刻
+	double* pull;		// ワード消費(OSR取込み)時刻
+	uint	word_n;
+	uint	word_cap;
+	dma_sim_t	dma;
+	double	dma_t;		// DMA 最終書込み時刻
+	uint	side_first[2];	// 面の先頭ワード
+	double	side_tc[2];		// 面の起動設定(手順4)時刻
+	bool	side_count[2];
+	bool	hang;
+	feed_result_t r;
+} feed_model_t;
+
+static void model_wait(feed_model_t* m, double until, bool count){
+	if (until <= m->tc) return;
+	if (count) {
+		double w = until - m->tc;
+		m->r.wait += w;
+		m->r.waits++;
+		if (w > m->r.max_window) m->r.max_window = w;
+	}
+	m->tc = until;
+}
+
+static void model_busy(feed_model_t* m, double cyc, bool count){
+	m->tc += cyc;
+	if (count) m->r.busy += cyc;
+}
+
+// ワード i を時刻 t に FIFO へ書き込む。消費時刻を PWM周期単位で求め、アンダーランを判定する
+static void model_push(feed_model_t* m, double t, bool count){
+	const uint i = m->word_n++;
+	const double word = (double)m->pwm_cycle * MODEL_OS_INNER_N;
+	m->push[i] = t;
+	if (i == 0) {
+		m->pull[i] = t;
+		return;
+	}
+	const double due = m->pull[i - 1] + word;				// 連続出力時の消費時刻
+	double pull = due;
+	if (t > due) {											// FIFO空 : 次の PWM周期の FIFO確認で取り込む
+		pull = due + (double)m->pwm_cycle * (uint)((t - due + m->pwm_cycle - 1) / m->pwm_cycle);
+		if (count) m->r.underrun++;
+	}
+	m->pull[i] = pull;
+	if (count && (pull - t < m->r.slack)) m->r.slack = pull - t;
+}
+
+// FIFO 空き時刻 (ワード i を書き込める時刻)
+static double model_fifo_free(const feed_model_t* m, uint i){
+	return (i < MODEL_FIFO_N) ? 0 : m->pull[i - MODEL_FIFO_N];
+}
+
+// FIFO空き待ち書込み (PDM_FEED_DMA = 0)
+static void model_run_fifo(feed_model_t* m){
+	const double put = cyc_pio_put();
+	for(uint f = 0; f < m->frames; f++){
+		const bool count = (f >= MODEL_SKIP);
+		for(uint s = 0; s < MODEL_FRAME_N; s += MODEL_BLOCK_N){
+			model_busy(m, MODEL_BLOCK_N * m->cyc_ch, count);						// Lch ブロック
+			for(uint j = 0; j < MODEL_BLOCK_N; j++){
+				model_busy(m, m->cyc_ch, count);									// Rch 1サンプル
+				for(uint w = 0; w < m->bs_n; w++){
+					model_wait(m, model_fifo_free(m, m->word_n), count);
+					model_push(m, m->tc, count);
+					model_busy(m, put, count);
+				}
+			}
+		}
+	}
+}
+
+// DMA : 転送中の面 (転送中の面がなければ -1)
+static int model_dma_side(const feed_model_t* m){
+	for(uint k = 0; k < 2; k++){
+		if (dma_sim_side_busy(&m->dma, k)) return (int)k;
+	}
+	return -1;
+}
+
+// DMA : 転送を進める。転送中のチャネルが FIFO 空き(DREQ)毎に 1ワードずつ書き込む (L/R は同一周期のため 1ch分を記録)
+//  wait < 0 : 時刻 until までの転送, wait = 0/1 : 面 wait の転送完了まで, wait = 2 : 全転送完了まで
+//  連結ループで待ちが 2面分を超えても終わらない場合は hang とする
+static void model_dma_run(feed_model_t* m, double until, int wait, bool count){
+	const double word = (double)m->pwm_cycle * MODEL_OS_INNER_N;
+	const uint limit = m->word_n + 2 * DMA_SIM_WORD_N;
+	while (!m->hang) {
+		const int k = model_dma_side(m);
+		if (k < 0) break;
+		if ((wait == 0 || wait == 1) && !dma_sim_side_busy(&m->dma, (uint)wait)) break;
+		double t = model_fifo_free(m, m->word_n);
+		if (t < m->dma_t) t = m->dma_t;
+		if (wait < 0 && t > until) break;
+		if ((wait >= 0 && m->word_n >= limit) || m->word_n >= m->word_cap) {
+			m->hang = true;
+			break;
+		}
+		for(uint c = 0; c < N_CH; c++){
+			if (dma_sim_busy(&m->dma, k, c)) dma_sim_transfer(&m->dma, k, c);
+		}
+		const uint i = m->word_n;
+		model_push(m, t, false);
+		if (count && i > 0 && m->pull[i] > m->pull[i - 1] + word) m->r.underrun++;
+		m->dma_t = t;
+	}
+}
+
+// DMA : 面 k の先頭ワードの消費時刻までに Core1 が起動すればよい (面の転送完了後に評価)
+static void model_dma_slack(feed_model_t* m, uint k){
+	if (!m->side_count[k] || m->side_first[k] >= m->word_n) return;
+	const double slack = m->pull[m->side_first[k]] - m->side_tc[k];
+	if (slack < m->r.slack) m->r.slack = slack;
+	m->side_count[k] = false;
+}
+
+// DMA ピンポンバッファ (PDM_FEED_DMA = 1) pdm_dma_feed() の手順を host/dma_sim.h のチャネルレジスタモデルで実行する
+static void model_run_dma(feed_model_t* m){
+	dma_sim_init(&m->dma);
+	for(uint f = 0; f < m->frames; f++){
+		const bool count = (f >= MODEL_SKIP);
+		for(uint s = 0; s < MODEL_FRAME_N; s += m->chunk_n){
+			const uint n = (MODEL_FRAME_N - s < m->chunk_n) ? MODEL_FRAME_N - s : m->chunk_n;
+			const uint k = m->dma.side;
+			// 1. 面 k の転送完了待ち
+			model_dma_run(m, m->tc, -1, count);
+			model_dma_run(m, 0, (int)k, count);
+			model_wait(m, m->dma_t, count);
+			model_dma_slack(m, k);
+			if (m->stall > 0 && f == m->stall_frame && s == MODEL_FRAME_N / 2) m->tc += m->stall;	// Core1 停止 (割込み等)
+			// 2. 面 k の連結解除
+			dma_sim_feed_unchain(&m->dma, k);
+			// 3. 面 k へ変換
+			model_busy(m, cyc_dma_chunk() + 2 * n * m->cyc_ch, count);
+			// 4. 転送元・転送数の設定、面 k^1 -> 面 k の連結、未起動時の起動
+			model_dma_run(m, m->tc, -1, count);
+			m->side_first[k] = m->word_n + dma_sim_pending(&m->dma, 0);
+			m->side_tc[k] = m->tc;
+			m->side_count[k] = count;
+			const uint start_n = m->dma.start_n;
+			dma_sim_feed_commit(&m->dma, k, n * m->bs_n);
+			if (m->dma.start_n != start_n && m->dma_t < m->tc) m->dma_t = m->tc;
+		}
+	}
+	model_dma_run(m, 0, 2, true);
+	for(uint k = 0; k < 2; k++) model_dma_slack(m, k);
+	m->r.garbage = m->dma.garbage;
+	m->r.hang = m->hang;
+}
+
+static feed_result_t model_run(const pcm2pwm_profile_t* prof, bool dma, uint chunk_n, uint frames, double stall){
+	feed_model_t* m = calloc(1, sizeof(feed_model_t));
+	m->pwm_cycle = CLOCK_PLAN_PIO_DIV * CLOCK_PLAN_PWM_CYCLE_48 * ((prof->pwm_bit == 6) ? 2 : 1);	// PIN_FS48 = 1 (48k系)
+	m->bs_n = (prof->pwm_bit == 6) ? 1 : 2;
+	m->cyc_ch = cyc_pcm2pwm_block_prof(prof, MODEL_OS_INNER_N, m->bs_n, MODEL_BLOCK_N);
+	m->frames = frames;
+	m->chunk_n = chunk_n;
+	m->stall = stall;
+	m->stall_frame = MODEL_SKIP;
+	m->word_cap = frames * MODEL_FRAME_N * m->bs_n + 2 * DMA_SIM_WORD_N;
+	m->push = malloc(sizeof(double) * m->word_cap);
+	m->pull = malloc(sizeof(double) * m->word_cap);
+	m->r.slack = 1e30;
+	if (dma) model_run_dma(m);
+	else     model_run_fifo(m);
+	const uint word_n = frames * MODEL_FRAME_N * m->bs_n;
+	m->r.lost = (m->word_n < word_n) ? word_n - m->word_n : 0;
+	feed_result_t r = m->r;
+	free(m->push);
+	free(m->pull);
+	free(m);
+	return r;
+}
+
+// 出力の欠落・面の範囲外読出し・転送完了待ちが終わらない
+static bool feed_broken(const feed_result_t* r){
+	return r->lost || r->garbage || r->hang;
+}
+
+static void print_result(const feed_result_t* r, uint frames){
+	const double n = frames - MODEL_SKIP;
+	const double frame_cyc = (double)CLK_SYS / 1000;
+	printf(" %8.2f %8.0f %6.1f %8.0f %8.2f %5u",
+		100.0 * r->busy / n / frame_cyc, r->wait / n, r->waits / n, r->max_window,
+		(r->slack < 1e29) ? r->slack * 1e6 / CLK_SYS : 0, r->underrun);
+	if (feed_broken(r)) printf(" (lost %u, garbage %u%s)", r->lost, r->garbage, r->hang ? ", DMA hang" : "");
+}
+
+int main(int argc, char* argv[]){
+	uint frames = (argc > 1) ? (uint)atoi(argv[1]) : 50;
+	if (frames <= MODEL_SKIP + 1) frames = MODEL_SKIP + 2;
+	bool fail = false;
+
+	printf("pico_1bit_dac_v2 pio_feed_model : CLK_SYS = %.1fMHz, frame = %u samples, FIFO = %u words, DMA chunk = %u samples\n\n",
+		CLK_SYS / 1e6, MODEL_FRAME_N, MODEL_FIFO_N, MODEL_CHUNK_N);
+	printf("  %-3s %-3s %-3s | %-46s | %-46s\n", "", "", "", "FIFO (pio0_sm01_put_blocking)", "DMA (ping-pong)");
+	printf("  %-3s %-3s %-3s |", "no", "bit", "ds");
+	for(uint k = 0; k < 2; k++){
+		printf(" %8s %8s %6s %8s %8s %5s |", "Core1[%]", "wait", "waits", "max win", "slack", "urun");
+	}
+	printf("\n");
+
+	for(uint p = 0; p < pcm2pwm_get_profile_n(); p++){
+		const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(p);
+		feed_result_t r_fifo = model_run(prof, false, MODEL_CHUNK_N, frames, 0);
+		feed_result_t r_dma  = model_run(prof, true,  MODEL_CHUNK_N, frames, 0);
+		printf("  %-3u %-3u %-3u |", p, prof->pwm_bit, prof->ds_order);
+		print_result(&r_fifo, frames);
+		printf(" |");
+		print_result(&r_dma, frames);
+		printf(" |\n");
+		if (r_fifo.underrun || r_dma.underrun || feed_broken(&r_fifo) || feed_broken(&r_dma)) fail = true;
+	}
+
+	// 面サイズ毎 (既定プロファイル)
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(PCM2PWM_PROFILE_DEFAULT);
+	printf("\n  DMA chunk size (profile %u) |\n  %-5s |", PCM2PWM_PROFILE_DEFAULT, "chunk");
+	printf(" %8s %8s %6s %8s %8s %5s\n", "Core1[%]", "wait", "waits", "max win", "slack", "urun");
+	static const uint chunk_list[] = {8, 16, 24, 48, 96, 192};
+	for(uint c = 0; c < sizeof(chunk_list) / sizeof(chunk_list[0]); c++){
+		feed_result_t r = model_run(prof, true, chunk_list[c], frames, 0);
+		printf("  %-5u |", chunk_list[c]);
+		print_result(&r, frames);
+		printf("\n");
+		if (feed_broken(&r)) fail = true;
+	}
+
+	// Core1 停止 (既定プロファイル, DMA) : 余裕以内ならアンダーランなし、余裕を超えるとアンダーラン 1回の後に欠落・範囲外読出しなく復帰すること
+	const feed_result_t r_ref = model_run(prof, true, MODEL_CHUNK_N, frames, 0);
+	printf("\n  DMA Core1 stall (profile %u, chunk %u) |\n  %-10s |", PCM2PWM_PROFILE_DEFAULT, MODEL_CHUNK_N, "stall[us]");
+	printf(" %8s %8s %6s %8s %8s %5s\n", "Core1[%]", "wait", "waits", "max win", "slack", "urun");
+	static const double stall_rate[] = {0.9, 1.0};
+	for(uint i = 0; i < 2; i++){
+		const double stall = r_ref.slack * stall_rate[i] + ((i == 1) ? STALL_OVER_US * 1e-6 * CLK_SYS : 0);
+		const feed_result_t r = model_run(prof, true, MODEL_CHUNK_N, frames, stall);
+		const bool ok = (r.underrun == i) && !feed_broken(&r);
+		printf("  %-10.2f |", stall * 1e6 / CLK_SYS);
+		print_result(&r, frames);
+		printf("  %s\n", ok ? "OK" : "NG");
+		if (!ok) fail = true;
+	}
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
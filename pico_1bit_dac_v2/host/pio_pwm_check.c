@@ -0,0 +1,351 @@
+/**
+ * @file pio_pwm_check.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief PIO PWMプログラム生成(pio_pwm.c)の検証 参照設計 pio_pwm_4bit/5bit/6bit.pio との波形一致・H:L・中心レベル
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 参照設計(.pio, host/pio_sim.h でアセンブル)と生成プログラムを PIOモデル(host/pio_sim.h)で同条件で動かし、
+ *       sm0(LP/LN), sm1(RP/RN) のピン波形をクロック単位で比較する。いずれも entry から起動し(pio_pwm_program_init()と同じ)、
+ *       LP の最初の立下りで位置を合わせて比較する。
+ *         ramp   : code 0 ~ 2^bit-1 を 24PWM周期ずつ出力 -> FIFO空 (中心レベル)
+ *         random : 乱数 code、途中で FIFO供給を止めてアンダーラン -> 再開
+ *         fs     : 乱数 code を出力中に PIN_FS48 を切り替える
+ *       各シナリオ・PIN_FS48 = 1/0 で以下を確認する。
+ *         ref    : 参照設計とのピン波形一致 (4/5/6bit のみ)
+ *         H:L    : データ区間の各 L パルス幅が 周期 - pio_pwm_high_clk(code)、FIFO空区間が 周期 - pio_pwm_center_clk()
+ *         center : L パルス中心の間隔が PWM周期に一致 (起動直後を除く)。データ <-> FIFO空 の切替時のみ
+ *                  参照設計と同じく 2clk 以内の位相ずれ(step)を許容する (切替回数以下)
+ *         diff   : P/N が相補 (pin_n = true のみ)
+ *       clock_plan.h の PWM周期に加え、4bit 220.8MHz案・非対称延長・pacemaker同期・7/8bit も生成・確認する。
+ *       いずれかで不一致があれば終了コード1を返す。
+ *       usage : pio_pwm_check [-v] [-w prefix]
+ *         -v        : 生成した命令列を表示
+ *         -w prefix : clock_plan.h の各設計の生成プログラムのピン波形を prefix_<bit>bit_<scenario>_fs<0|1>.vcd に出力
+ *                     (LP/LN/RP/RN/FS48, irq0~7, sm0/sm1 TX FIFO段数。ロジアナ波形との比較用)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "clock_plan.h"
+#include "pio_pwm.h"
+#include "pio_sim.h"
+
+#ifndef PIO_SRC_DIR
+#define PIO_SRC_DIR	".."
+#endif
+
+#define CODE_PERIOD_N	24			// ramp : 1code 当たりの PWM周期数
+#define RAND_CODE_N		1024		// random / fs : 乱数 code 数
+#define HOLD_AT			96			// random : FIFO供給を止めるワード位置
+#define HOLD_PERIOD_N	40			// random : 供給停止期間 [PWM周期]
+#define TAIL_PERIOD_N	24			// 全データ出力後の FIFO空区間 [PWM周期]
+#define SKIP_PULSE_N	2			// 起動直後の除外パルス数
+
+// PIOプログラム一式 (pm.len = 0 : pacemaker なし)
+typedef struct {
+	pio_sim_prog_t	pwm, pm;
+	uint			out_thr;
+} impl_t;
+
+// シナリオ
+typedef struct {
+	const char*	name;
+	uint16_t*	code;
+	uint		code_n;
+	uint		hold_at;		// FIFO供給を止めるワード位置 (0 : なし)
+	uint		hold_clk;
+	uint		fs_toggle_clk;	// 最初の立下りからの PIN_FS48 切替時刻 (0 : なし)
+} scenario_t;
+
+// 1クロック分のピン : bit0 LP, bit1 LN, bit2 RP, bit3 RN
+typedef struct {
+	uint8_t*	pin;
+	uint		n;
+	uint		t0;				// LP の最初の立下り
+	uint		end_clk;		// 最終ワードの FIFO投入時刻
+	uint		fs_clk;			// PIN_FS48 切替時刻
+} trace_t;
+
+typedef struct {
+	uint	fall, rise;
+} pulse_t;
+
+static void impl_from_cfg(impl_t* im, const pio_pwm_config_t* cfg){
+	im->pwm = cfg->pwm;
+	im->pm = cfg->pacemaker;
+	im->out_thr = cfg->out_thr;
+}
+
+static bool impl_from_file(impl_t* im, uint bit){
+	char path[256], name[64];
+	memset(im, 0, sizeof(*im));
+	snprintf(path, sizeof(path), "%s/pio_pwm_%ubit.pio", PIO_SRC_DIR, bit);
+	snprintf(name, sizeof(name), "pio_pwm_%ubit", bit);
+	if (!pio_asm_file(path, name, &im->pwm)) return false;
+	if (bit == 6) {
+		snprintf(name, sizeof(name), "pio_pwm_%ubit_pacemaker", bit);
+		if (!pio_asm_file(path, name, &im->pm)) return false;
+		im->pm.clkdiv = 2;		// pio_pwm_6bit_program_init() と同じ
+	}
+	im->out_thr = 4 * bit;
+	return true;
+}
+
+static uint32_t pack_word(const uint16_t* code, uint n, uint bit){
+	uint32_t w = 0;
+	for(uint i = 0; i < n; i++) w |= (uint32_t)code[i] << (bit * i);
+	return w;
+}
+
+// PIOモデル実行 sm0/sm1 に同じデータを FIFO満杯を保って供給する
+// vcd : NULL 以外ならピン波形を出力
+static void sim_run(const impl_t* im, const scenario_t* sc, uint bit, bool fs48, trace_t* tr, uint clk_n, pio_sim_vcd_t* vcd){
+	static pio_sim_t pio;
+	pio_sim_init(&pio);
+	pio.pins_in = (uint32_t)fs48 << PIN_FS48;
+	const int off = pio_sim_add_program(&pio, &im->pwm);
+	for(uint sm = 0; sm < 2; sm++){
+		pio_sim_sm_init(&pio, sm, &im->pwm, off, im->pwm.clkdiv, sm ? PIN_OUTPUT_RP : PIN_OUTPUT_LP, PIN_FS48, im->out_thr, true);
+	}
+	uint mask = 3;
+	if (im->pm.len) {
+		const int off_pm = pio_sim_add_program(&pio, &im->pm);
+		pio_sim_sm_init(&pio, 2, &im->pm, off_pm, im->pm.clkdiv, 0, PIN_FS48, 32, false);
+		mask = 7;
+	}
+
+	const uint word_n = sc->code_n / 4;
+	uint word_i = 0, hold_end = 0;
+	bool hold_done = false;
+	tr->n = clk_n;
+	tr->t0 = 0;
+	tr->end_clk = 0;
+	tr->fs_clk = 0;
+	for(uint clk = 0; clk < clk_n; clk++){
+		// 供給
+		if (sc->hold_at && word_i == sc->hold_at && !hold_done) {
+			if (hold_end == 0) hold_end = clk + sc->hold_clk;
+			if (clk >= hold_end) hold_done = true;
+		}
+		const bool hold = sc->hold_at && word_i == sc->hold_at && !hold_done;
+		while(!hold && word_i < word_n && !pio_sim_tx_full(&pio, 0)){
+			const uint32_t w = pack_word(&sc->code[word_i * 4], 4, bit);
+			pio_sim_put(&pio, 0, w);
+			pio_sim_put(&pio, 1, w);
+			if (++word_i == word_n) tr->end_clk = clk;
+		}
+		if (clk == 0) pio_sim_enable(&pio, mask);
+		if (sc->fs_toggle_clk && tr->t0 && clk == tr->t0 + sc->fs_toggle_clk) {
+			pio.pins_in ^= 1u << PIN_FS48;
+			tr->fs_clk = clk;
+		}
+		pio_sim_clock(&pio);
+		if (vcd) pio_sim_vcd_sample(vcd, &pio);
+		const uint8_t p = (uint8_t)(((pio.pins_out >> PIN_OUTPUT_LP) & 3) | (((pio.pins_out >> PIN_OUTPUT_RP) & 3) << 2));
+		tr->pin[clk] = p;
+		if (!tr->t0 && clk && (tr->pin[clk - 1] & 1) && !(p & 1)) tr->t0 = clk;
+	}
+}
+
+// LP の L パルス抽出 (立下りから立上りまで)
+static uint get_pulses(const trace_t* tr, pulse_t* pl, uint max){
+	uint k = 0;
+	bool low = false;
+	for(uint i = 1; i < tr->n && k < max; i++){
+		const uint prev = tr->pin[i - 1] & 1, cur = tr->pin[i] & 1;
+		if (prev && !cur) {
+			pl[k].fall = i;
+			low = true;
+		} else if (!prev && cur && low) {
+			pl[k++].rise = i;
+			low = false;
+		}
+	}
+	return k;
+}
+
+typedef struct {
+	uint	ref_ng, hl_ng, center_ng, diff_ng, lr_ng;
+	uint	pulse_n, step_n;
+} result_t;
+
+// 波形確認 (参照設計との比較は呼出し側)
+static void check_trace(const trace_t* tr, const pio_pwm_config_t* cfg, const scenario_t* sc, bool fs48, result_t* res){
+	static pulse_t pl[200000];
+	const uint n = get_pulses(tr, pl, sizeof(pl) / sizeof(pl[0]));
+	res->pulse_n += n;
+	const uint c48 = pio_pwm_cycle_clk(cfg, true), c44 = pio_pwm_cycle_clk(cfg, false);
+	for(uint i = 0; i < n; i++){
+		// PIN_FS48 切替の前後は H:L・間隔を確認しない
+		const bool after_fs = sc->fs_toggle_clk && tr->fs_clk && pl[i].fall >= tr->fs_clk;
+		const bool fs = after_fs ? !fs48 : fs48;
+		if (sc->fs_toggle_clk && tr->fs_clk && pl[i].fall + 2 * c44 >= tr->fs_clk && pl[i].fall <= tr->fs_clk + 2 * c44) continue;
+		const uint c = fs ? c48 : c44;
+		const uint lo = pl[i].rise - pl[i].fall;
+		// データ区間は i 番目のパルスが code[i]、最終ワード投入から FIFO 8段 + 1ワード後は FIFO空区間
+		const bool data = !sc->hold_at && i < sc->code_n;
+		const bool tail = tr->end_clk && pl[i].fall > tr->end_clk + (PIO_SIM_FIFO_N + 2) * 4 * c;
+		if (data && i >= 1) {
+			if (lo != c - pio_pwm_high_clk(cfg, sc->code[i], fs)) res->hl_ng++;
+		} else if (tail) {
+			if (lo != c - pio_pwm_center_clk(cfg, fs)) res->hl_ng++;
+		}
+		if (i >= SKIP_PULSE_N) {
+			const uint sp = (pl[i].fall + pl[i].rise) - (pl[i - 1].fall + pl[i - 1].rise);
+			if (sp != 2 * c) {
+				res->step_n++;
+				if (sp + 4 < 2 * c || sp > 2 * c + 4) res->center_ng++;
+			}
+		}
+	}
+	// データ <-> FIFO空 切替 : 供給停止の前後 + 全データ出力後
+	if (res->step_n > (sc->hold_at ? 3u : 1u)) res->center_ng++;
+	for(uint i = tr->t0; i < tr->n; i++){
+		const uint8_t p = tr->pin[i];
+		if (((p >> 2) & 3) != (p & 3)) res->lr_ng++;
+		if (cfg->param.pin_n && (((p ^ (p >> 1)) & 1) == 0)) res->diff_ng++;
+	}
+}
+
+static uint compare_trace(const trace_t* a, const trace_t* b){
+	uint ng = 0;
+	if (!a->t0 || !b->t0) return 1;
+	const uint n = (a->n - a->t0 < b->n - b->t0) ? a->n - a->t0 : b->n - b->t0;
+	for(uint i = 0; i < n; i++) if (a->pin[a->t0 + i] != b->pin[b->t0 + i]) ng++;
+	return ng;
+}
+
+static void print_prog(const char* name, const pio_sim_prog_t* p){
+	printf("  %s : %u insn, wrap %u..%u, entry %u, clkdiv %u\n   ", name, p->len, p->wrap_target, p->wrap, p->entry, p->clkdiv);
+	for(uint i = 0; i < p->len; i++) printf(" %04x", p->insn[i]);
+	printf("\n");
+}
+
+// 1設計の確認 ref : 参照設計 (NULL : なし)
+static const char* vcd_prefix;		// NULL : VCD出力なし
+
+static bool check_design(const char* note, const pio_pwm_param_t* param, const impl_t* ref, bool verbose){
+	static pio_pwm_config_t cfg;
+	static uint16_t code[(1u << PIO_PWM_BIT_MAX) * CODE_PERIOD_N + RAND_CODE_N];
+	static uint8_t pin_gen[4000000], pin_ref[4000000];
+	const uint bit = param->pwm_bit, m = 1u << bit;
+
+	printf("%-34s %ubit %3u/%3u pad_lo %2u : ", note, bit, param->cycle_48, param->cycle_44, param->pad_lo);
+	if (!pio_pwm_build(&cfg, param)) {
+		printf("build NG\n");
+		return false;
+	}
+	printf("%s, insn %2u+%2u, H = %u + %u * code, center %u\n", (cfg.param.sync == PIO_PWM_SYNC_SELF) ? "self     " : "pacemaker",
+		cfg.pwm.len, cfg.pacemaker.len, cfg.h0, cfg.step, cfg.h_center);
+	if (verbose) {
+		print_prog("pwm", &cfg.pwm);
+		if (cfg.pacemaker.len) print_prog("pacemaker", &cfg.pacemaker);
+	}
+	impl_t gen;
+	impl_from_cfg(&gen, &cfg);
+
+	// H:L 表 (.pio ヘッダの表と同形式)
+	const uint tbl[] = {0, 1, 2, m / 2 - 1, m / 2, m - 2, m - 1};
+	printf("  code ");
+	for(uint i = 0; i < sizeof(tbl) / sizeof(tbl[0]); i++) printf("%9u      ", tbl[i]);
+	printf("   center\n  H:L  ");
+	for(uint i = 0; i < sizeof(tbl) / sizeof(tbl[0]); i++){
+		const uint h48 = pio_pwm_high_clk(&cfg, tbl[i], true), h44 = pio_pwm_high_clk(&cfg, tbl[i], false);
+		printf(" %02u:%02u(%02u:%02u)", h48, param->cycle_48 - h48, h44, param->cycle_44 - h44);
+	}
+	printf(" %02u:%02u(%02u:%02u)\n", pio_pwm_center_clk(&cfg, true), param->cycle_48 - pio_pwm_center_clk(&cfg, true),
+		pio_pwm_center_clk(&cfg, false), param->cycle_44 - pio_pwm_center_clk(&cfg, false));
+
+	// シナリオ
+	scenario_t sc[3];
+	uint n = 0;
+	for(uint c = 0; c < m; c++) for(uint i = 0; i < CODE_PERIOD_N; i++) code[n++] = (uint16_t)c;
+	sc[0] = (scenario_t){"ramp", code, n, 0, 0, 0};
+	uint16_t* rnd = &code[n];
+	srand(bit * 1000 + param->cycle_48);
+	for(uint i = 0; i < RAND_CODE_N; i++) rnd[i] = (uint16_t)(rand() % m);
+	sc[1] = (scenario_t){"random", rnd, RAND_CODE_N, HOLD_AT, HOLD_PERIOD_N * param->cycle_44, 0};
+	sc[2] = (scenario_t){"fs", rnd, RAND_CODE_N, 0, 0, RAND_CODE_N / 2 * param->cycle_48};
+
+	bool ok = true;
+	for(uint s = 0; s < 3; s++){
+		for(int fs = 1; fs >= 0; fs--){
+			const uint clk_n = (sc[s].code_n + TAIL_PERIOD_N + PIO_SIM_FIFO_N * 4 + 8) * param->cycle_44 + sc[s].hold_clk;
+			if (clk_n > sizeof(pin_gen)) {
+				printf("  trace buffer short\n");
+				return false;
+			}
+			trace_t tg = {.pin = pin_gen}, tref = {.pin = pin_ref};
+			result_t res = {0};
+			static pio_sim_vcd_t vcd;
+			if (vcd_prefix && ref) {
+				static const uint8_t pin[] = {PIN_OUTPUT_LP, PIN_OUTPUT_LN, PIN_OUTPUT_RP, PIN_OUTPUT_RN, PIN_FS48};
+				static const char* const name[] = {"LP", "LN", "RP", "RN", "FS48"};
+				char path[256];
+				snprintf(path, sizeof(path), "%s_%ubit_%s_fs%d.vcd", vcd_prefix, bit, sc[s].name, fs);
+				if (!pio_sim_vcd_open(&vcd, path, pin, name, sizeof(pin), (double)CLK_SYS / CLOCK_PLAN_PIO_DIV)) printf("  %s : open NG\n", path);
+			}
+			sim_run(&gen, &sc[s], bit, fs, &tg, clk_n, vcd.fp ? &vcd : NULL);
+			pio_sim_vcd_close(&vcd);
+			check_trace(&tg, &cfg, &sc[s], fs, &res);
+			if (ref) {
+				sim_run(ref, &sc[s], bit, fs, &tref, clk_n, NULL);
+				res.ref_ng = compare_trace(&tg, &tref);
+			}
+			const bool r = !res.ref_ng && !res.hl_ng && !res.center_ng && !res.diff_ng && !res.lr_ng && res.pulse_n > sc[s].code_n;
+			printf("  %-6s fs48=%d : pulse %5u, ref %s, H:L NG %u, center NG %u (step %u), diff NG %u, L/R NG %u  %s\n",
+				sc[s].name, fs, res.pulse_n, ref ? (res.ref_ng ? "NG" : "OK") : "--",
+				res.hl_ng, res.center_ng, res.step_n, res.diff_ng, res.lr_ng, r ? "OK" : "NG");
+			ok &= r;
+		}
+	}
+	return ok;
+}
+
+int main(int argc, char* argv[]){
+	bool verbose = false;
+	for(int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "-v") == 0) verbose = true;
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) vcd_prefix = argv[++i];
+	}
+	bool ok = true;
+
+	// clock_plan.h の PWM周期 (6bit は x2) + 参照設計
+	for(uint bit = 4; bit <= 6; bit++){
+		pio_pwm_param_t param;
+		pio_pwm_param_init(&param, bit, CLOCK_PLAN_PWM_CYCLE_48, CLOCK_PLAN_PWM_CYCLE_44);
+		static impl_t ref;
+		char note[64];
+		snprintf(note, sizeof(note), "clock_plan vs pio_pwm_%ubit.pio", bit);
+		if (!impl_from_file(&ref, bit)) {
+			printf("%s : assemble NG\n", note);
+			ok = false;
+			continue;
+		}
+		ok &= check_design(note, &param, &ref, verbose);
+	}
+
+	// 参照設計なし
+	static const struct {
+		const char*		note;
+		pio_pwm_param_t	param;
+	} extra[] = {
+		{"4bit 220.8MHz (72/78)",        {4,  72,  78,  3, PIO_PWM_SYNC_AUTO,      true }},
+		{"5bit 220.8MHz (72/78)",        {5,  72,  78,  3, PIO_PWM_SYNC_AUTO,      true }},
+		{"5bit asymmetric pad (L1:H5)",  {5,  68,  74,  1, PIO_PWM_SYNC_AUTO,      true }},
+		{"4bit pacemaker",               {4,  68,  74,  3, PIO_PWM_SYNC_PACEMAKER, true }},
+		{"6bit 220.8MHz (144/156)",      {6, 144, 156,  6, PIO_PWM_SYNC_AUTO,      false}},
+		{"7bit (2 PWM cycle/sample)",    {7, 272, 296, 12, PIO_PWM_SYNC_AUTO,      false}},
+		{"8bit (1 PWM cycle/sample)",    {8, 544, 592, 24, PIO_PWM_SYNC_AUTO,      false}},
+	};
+	for(uint i = 0; i < sizeof(extra) / sizeof(extra[0]); i++){
+		ok &= check_design(extra[i].note, &extra[i].param, NULL, verbose);
+	}
+
+	printf("%s\n", ok ? "OK" : "NG");
+	return ok ? 0 : 1;
+}
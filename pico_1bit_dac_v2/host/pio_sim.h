@@ -0,0 +1,536 @@
+/**
+ * @file pio_sim.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief RP2040 PIO 命令モデル (.pio アセンブラ, 1PIOブロック sm0~sm3 のクロック単位実行, VCD波形出力)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note pio_pwm_Nbit.pio (参照設計) と pio_pwm.c の生成プログラムを同じ条件で動かし、ピン波形を比較するためのもの。
+ *       RP2040 Datasheet 3.4/3.5 による。モデル化の範囲 :
+ *         全命令 (jmp/wait/in/out/push/pull/mov/irq/set)、side-set(opt なし)、遅延、wrap、整数クロック分周、
+ *         TX FIFO(8段, join) と autopull (OSR空かつFIFOにデータがあれば命令実行前に補充)、
+ *         irq フラグ(他smへの反映は次クロック)、jmp pin / wait gpio の入力ピン。
+ *       モデル化しないもの : RX FIFO/autopush, side-set pindirs, mov status, exec, irq rel, 分周の小数部。
+ *       統計 : ストール [pio clk]、アンダーラン(最初のデータ投入後に autopull の OSR・TX FIFO とも空になった回数)。
+ *       pio_sim_vcd_xxx() でピン・irq フラグ・TX FIFO 段数をクロック単位の VCD (GTKWave 等で表示) に出力する。
+ */
+#ifndef _PIO_SIM_H_
+#define _PIO_SIM_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "pico.h"
+#include "pio_pwm.h"
+
+#define PIO_SIM_SM_N		4
+#define PIO_SIM_FIFO_N		8		// TX FIFO (PIO_FIFO_JOIN_TX)
+#define PIO_SIM_LABEL_N		32
+
+// アセンブル結果 (pio_pwm_prog_t と同形式)
+typedef pio_pwm_prog_t pio_sim_prog_t;
+
+// ステートマシン
+typedef struct {
+	bool		en;
+	uint8_t		pc;
+	uint8_t		wrap_target;	// 絶対アドレス
+	uint8_t		wrap;
+	uint8_t		sideset_n;
+	uint8_t		sideset_base;
+	uint8_t		jmp_pin;
+	uint16_t	clkdiv;
+	uint16_t	div_cnt;
+	uint8_t		delay;			// 残り遅延 [sm clk]
+	bool		stall;
+	uint32_t	x, y, isr, osr;
+	uint8_t		isr_cnt, osr_cnt;
+	uint8_t		out_thr;
+	bool		autopull;
+	uint32_t	fifo[PIO_SIM_FIFO_N];
+	uint8_t		fifo_rd, fifo_n;
+	bool		fed, starved;
+	uint64_t	stall_clk;		// 統計 : ストール [pio clk]
+	uint32_t	underrun_n;		// 統計 : アンダーラン回数
+} pio_sim_sm_t;
+
+// PIOブロック
+typedef struct {
+	uint16_t		mem[32];
+	uint8_t			mem_used;
+	uint8_t			irq;			// irq フラグ 0~7
+	uint8_t			irq_set, irq_clr;	// 次クロックで反映
+	uint32_t		pins_in;		// 入力ピン (jmp pin / wait gpio)
+	uint32_t		pins_out;		// 出力ピン (side-set / set pins / out pins)
+	pio_sim_sm_t	sm[PIO_SIM_SM_N];
+	uint64_t		clk;
+} pio_sim_t;
+
+static inline void pio_sim_init(pio_sim_t* pio){
+	memset(pio, 0, sizeof(*pio));
+}
+
+// プログラム登録 戻り値 : オフセット (空きなし -1)
+static inline int pio_sim_add_program(pio_sim_t* pio, const pio_sim_prog_t* prog){
+	if (pio->mem_used + prog->len > 32) return -1;
+	const uint off = pio->mem_used;
+	for(uint i = 0; i < prog->len; i++){
+		uint16_t insn = prog->insn[i];
+		if ((insn & PIO_OP_MASK) == PIO_OP_JMP) insn = (insn & ~0x1fu) | ((insn + off) & 0x1f);	// 絶対アドレスへ
+		pio->mem[off + i] = insn;
+	}
+	pio->mem_used += prog->len;
+	return (int)off;
+}
+
+// sm 設定 (out : shift right, in : shift left 固定)
+static inline void pio_sim_sm_init(pio_sim_t* pio, uint sm, const pio_sim_prog_t* prog, uint offset,
+		uint clkdiv, uint sideset_base, uint jmp_pin, uint out_thr, bool autopull){
+	pio_sim_sm_t* s = &pio->sm[sm];
+	memset(s, 0, sizeof(*s));
+	s->pc = offset + prog->entry;
+	s->wrap_target = offset + prog->wrap_target;
+	s->wrap = offset + prog->wrap;
+	s->sideset_n = prog->sideset_n;
+	s->sideset_base = sideset_base;
+	s->jmp_pin = jmp_pin;
+	s->clkdiv = clkdiv ? clkdiv : 1;
+	s->out_thr = out_thr ? out_thr : 32;
+	s->osr_cnt = 32;		// OSR空 (pio_sm_init 直後)
+	s->autopull = autopull;
+}
+
+// sm0~3 を同期スタート (pio_enable_sm_mask_in_sync : クロック分周も同時に再スタート)
+static inline void pio_sim_enable(pio_sim_t* pio, uint mask){
+	for(uint i = 0; i < PIO_SIM_SM_N; i++){
+		pio->sm[i].en = (mask >> i) & 1;
+		pio->sm[i].div_cnt = 0;
+	}
+}
+
+static inline bool pio_sim_tx_full(const pio_sim_t* pio, uint sm){
+	return pio->sm[sm].fifo_n >= PIO_SIM_FIFO_N;
+}
+
+static inline bool pio_sim_tx_empty(const pio_sim_t* pio, uint sm){
+	return pio->sm[sm].fifo_n == 0;
+}
+
+static inline bool pio_sim_put(pio_sim_t* pio, uint sm, uint32_t data){
+	pio_sim_sm_t* s = &pio->sm[sm];
+	if (s->fifo_n >= PIO_SIM_FIFO_N) return false;
+	s->fifo[(s->fifo_rd + s->fifo_n++) % PIO_SIM_FIFO_N] = data;
+	s->fed = true;
+	return true;
+}
+
+static inline bool pio_sim_pop(pio_sim_sm_t* s, uint32_t* data){
+	if (s->fifo_n == 0) return false;
+	*data = s->fifo[s->fifo_rd];
+	s->fifo_rd = (s->fifo_rd + 1) % PIO_SIM_FIFO_N;
+	s->fifo_n--;
+	return true;
+}
+
+static inline uint32_t pio_sim_src(pio_sim_t* pio, pio_sim_sm_t* s, uint src){
+	switch(src){
+	case PIO_SRC_DST_PINS:	return pio->pins_in;
+	case PIO_SRC_DST_X:		return s->x;
+	case PIO_SRC_DST_Y:		return s->y;
+	case PIO_SRC_DST_ISR:	return s->isr;
+	case PIO_SRC_DST_OSR:	return s->osr;
+	default:				return 0;		// null, status(未モデル)
+	}
+}
+
+static inline uint32_t pio_sim_rev(uint32_t v){
+	uint32_t r = 0;
+	for(uint i = 0; i < 32; i++) r |= ((v >> i) & 1) << (31 - i);
+	return r;
+}
+
+// 1命令実行 (遅延・ストール処理済みの状態で呼ぶ)
+static inline void pio_sim_exec(pio_sim_t* pio, pio_sim_sm_t* s){
+	const uint16_t insn = pio->mem[s->pc];
+	const uint ss = s->sideset_n;
+	const uint side = ss ? (insn >> (13 - ss)) & ((1u << ss) - 1) : 0;
+	const uint delay = (insn >> 8) & ((1u << (5 - ss)) - 1);
+	const uint arg1 = (insn >> 5) & 7, arg2 = insn & 0x1f;
+	bool jump = false, stall = false;
+
+	// side-set はストール中も命令発行時に反映する
+	if (ss) pio->pins_out = (pio->pins_out & ~(((1u << ss) - 1) << s->sideset_base)) | (side << s->sideset_base);
+	// autopull : OSR空ならFIFOから補充 (FIFO空なら out はストール)
+	if (s->autopull && s->osr_cnt >= s->out_thr && s->fifo_n) {
+		pio_sim_pop(s, &s->osr);
+		s->osr_cnt = 0;
+	}
+
+	switch(insn & PIO_OP_MASK){
+	case PIO_OP_JMP: {
+		bool cond = true;
+		switch(arg1 << 5){
+		case PIO_JMP_NOT_X:		cond = (s->x == 0); break;
+		case PIO_JMP_X_DEC:		cond = (s->x != 0); s->x--; break;
+		case PIO_JMP_NOT_Y:		cond = (s->y == 0); break;
+		case PIO_JMP_Y_DEC:		cond = (s->y != 0); s->y--; break;
+		case PIO_JMP_X_NE_Y:	cond = (s->x != s->y); break;
+		case PIO_JMP_PIN:		cond = (pio->pins_in >> s->jmp_pin) & 1; break;
+		case PIO_JMP_NOT_OSRE:	cond = (s->osr_cnt < s->out_thr); break;
+		}
+		if (cond) { s->pc = arg2; jump = true; }
+		break;
+	}
+	case PIO_OP_WAIT: {
+		const uint pol = (insn >> 7) & 1, src = (insn >> 5) & 3;
+		bool v = false;
+		if (src == 0) v = (pio->pins_in >> arg2) & 1;
+		else if (src == 1) v = (pio->pins_in >> arg2) & 1;
+		else if (src == 2) v = (pio->irq >> (arg2 & 7)) & 1;
+		if (v != pol) stall = true;
+		else if (src == 2 && pol) pio->irq_clr |= 1u << (arg2 & 7);
+		break;
+	}
+	case PIO_OP_IN: {
+		const uint n = arg2 ? arg2 : 32;
+		const uint32_t v = pio_sim_src(pio, s, arg1) & ((n == 32) ? 0xffffffffu : ((1u << n) - 1));
+		s->isr = (n == 32) ? v : ((s->isr << n) | v);
+		s->isr_cnt = (s->isr_cnt + n > 32) ? 32 : s->isr_cnt + n;
+		break;
+	}
+	case PIO_OP_OUT: {
+		const uint n = arg2 ? arg2 : 32;
+		if (s->osr_cnt >= s->out_thr && s->autopull) { stall = true; break; }	// FIFO空
+		const uint32_t v = s->osr & ((n == 32) ? 0xffffffffu : ((1u << n) - 1));
+		s->osr = (n == 32) ? 0 : (s->osr >> n);
+		s->osr_cnt = (s->osr_cnt + n > 32) ? 32 : s->osr_cnt + n;
+		switch(arg1){
+		case PIO_SRC_DST_PINS:	pio->pins_out = v; break;
+		case PIO_SRC_DST_X:		s->x = v; break;
+		case PIO_SRC_DST_Y:		s->y = v; break;
+		case PIO_SRC_DST_PC:	s->pc = v & 0x1f; jump = true; break;
+		case PIO_SRC_DST_ISR:	s->isr = v; s->isr_cnt = n; break;
+		default: break;
+		}
+		break;
+	}
+	case PIO_OP_PUSH_PULL:
+		if (insn & PIO_PULL) {
+			if ((insn & PIO_IF_FULL_EMPTY) && s->osr_cnt < s->out_thr) break;
+			if (!pio_sim_pop(s, &s->osr)) {
+				if (insn & PIO_BLOCK) { stall = true; break; }
+				s->osr = s->x;
+			}
+			s->osr_cnt = 0;
+		}
+		break;
+	case PIO_OP_MOV: {
+		uint32_t v = pio_sim_src(pio, s, insn & 7);
+		const uint op = insn & (3 << 3);
+		if (op == PIO_MOV_INVERT) v = ~v;
+		else if (op == PIO_MOV_REVERSE) v = pio_sim_rev(v);
+		switch(arg1){
+		case PIO_SRC_DST_PINS:	pio->pins_out = v; break;
+		case PIO_SRC_DST_X:		s->x = v; break;
+		case PIO_SRC_DST_Y:		s->y = v; break;
+		case PIO_SRC_DST_PC:	s->pc = v & 0x1f; jump = true; break;
+		case PIO_SRC_DST_ISR:	s->isr = v; s->isr_cnt = 0; break;
+		case PIO_SRC_DST_OSR:	s->osr = v; s->osr_cnt = 0; break;
+		default: break;
+		}
+		break;
+	}
+	case PIO_OP_IRQ: {
+		const uint n = arg2 & 7;
+		if (insn & PIO_IRQ_CLEAR) {
+			pio->irq_clr |= 1u << n;
+		} else if ((insn & PIO_IRQ_WAIT) && s->stall) {
+			if ((pio->irq >> n) & 1) stall = true;		// 設定済みフラグのクリア待ち
+		} else {
+			pio->irq_set |= 1u << n;
+			if (insn & PIO_IRQ_WAIT) stall = true;
+		}
+		break;
+	}
+	case PIO_OP_SET:
+		switch(arg1){
+		case PIO_SRC_DST_X:	s->x = arg2; break;
+		case PIO_SRC_DST_Y:	s->y = arg2; break;
+		default: break;
+		}
+		break;
+	}
+
+	s->stall = stall;
+	if (stall) return;
+	s->delay = delay;
+	if (!jump) s->pc = (s->pc == s->wrap) ? s->wrap_target : (s->pc + 1) & 0x1f;
+}
+
+// 1 PIOクロック進める
+static inline void pio_sim_clock(pio_sim_t* pio){
+	for(uint i = 0; i < PIO_SIM_SM_N; i++){
+		pio_sim_sm_t* s = &pio->sm[i];
+		if (!s->en) continue;
+		if (++s->div_cnt < s->clkdiv) continue;
+		s->div_cnt = 0;
+		if (s->delay) {
+			s->delay--;
+			continue;
+		}
+		pio_sim_exec(pio, s);
+		if (s->stall) s->stall_clk += s->clkdiv;
+		const bool starved = s->fed && s->autopull && s->osr_cnt >= s->out_thr && s->fifo_n == 0;
+		if (starved && !s->starved) s->underrun_n++;
+		s->starved = starved;
+	}
+	pio->irq = (pio->irq | pio->irq_set) & ~pio->irq_clr;
+	pio->irq_set = pio->irq_clr = 0;
+	pio->clk++;
+}
+
+// ---- VCD出力 ----
+
+#define PIO_SIM_VCD_PIN_N	8
+
+typedef struct {
+	FILE*		fp;
+	uint		pin_n;
+	uint8_t		pin[PIO_SIM_VCD_PIN_N];
+	uint32_t	ps;				// 1 pio clk [ps]
+	uint32_t	pins;			// 前回値
+	uint8_t		irq, fifo[2];
+	bool		first;
+} pio_sim_vcd_t;
+
+// pin/name : 出力するピン番号・信号名、clk_hz : PIOクロック周波数
+static inline bool pio_sim_vcd_open(pio_sim_vcd_t* v, const char* path, const uint8_t* pin, const char* const* name, uint pin_n, double clk_hz){
+	memset(v, 0, sizeof(*v));
+	v->fp = fopen(path, "w");
+	if (v->fp == NULL) return false;
+	v->pin_n = (pin_n > PIO_SIM_VCD_PIN_N) ? PIO_SIM_VCD_PIN_N : pin_n;
+	memcpy(v->pin, pin, v->pin_n);
+	v->ps = (uint32_t)(1e12 / clk_hz + 0.5);
+	v->first = true;
+	fprintf(v->fp, "$timescale 1ps $end\n$scope module pio0 $end\n");
+	for(uint i = 0; i < v->pin_n; i++) fprintf(v->fp, "$var wire 1 %c %s $end\n", 'a' + i, name[i]);
+	for(uint i = 0; i < 8; i++) fprintf(v->fp, "$var wire 1 %c irq%u $end\n", 'A' + i, i);
+	for(uint i = 0; i < 2; i++) fprintf(v->fp, "$var wire 4 %c sm%u_tx_fifo $end\n", '0' + i, i);
+	fprintf(v->fp, "$upscope $end\n$enddefinitions $end\n");
+	return true;
+}
+
+static inline void pio_sim_vcd_bits(FILE* fp, uint v, char id){
+	fputc('b', fp);
+	for(int i = 3; i >= 0; i--) fputc('0' + ((v >> i) & 1), fp);
+	fprintf(fp, " %c\n", id);
+}
+
+// pio_sim_clock() 毎に呼ぶ (変化した信号のみ出力)
+static inline void pio_sim_vcd_sample(pio_sim_vcd_t* v, const pio_sim_t* pio){
+	if (v->fp == NULL) return;
+	const uint32_t pins = pio->pins_out | pio->pins_in;
+	const uint8_t fifo[2] = {pio->sm[0].fifo_n, pio->sm[1].fifo_n};
+	const unsigned long long t = (unsigned long long)(pio->clk ? pio->clk - 1 : 0) * v->ps;	// 直前の pio_sim_clock() の時刻
+	bool ts = false;
+	for(uint i = 0; i < v->pin_n; i++){
+		const uint b = (pins >> v->pin[i]) & 1;
+		if (!v->first && b == ((v->pins >> v->pin[i]) & 1)) continue;
+		if (!ts) { fprintf(v->fp, "#%llu\n", t); ts = true; }
+		fprintf(v->fp, "%u%c\n", b, 'a' + i);
+	}
+	for(uint i = 0; i < 8; i++){
+		const uint b = (pio->irq >> i) & 1;
+		if (!v->first && b == ((v->irq >> i) & 1u)) continue;
+		if (!ts) { fprintf(v->fp, "#%llu\n", t); ts = true; }
+		fprintf(v->fp, "%u%c\n", b, 'A' + i);
+	}
+	for(uint i = 0; i < 2; i++){
+		if (!v->first && fifo[i] == v->fifo[i]) continue;
+		if (!ts) { fprintf(v->fp, "#%llu\n", t); ts = true; }
+		pio_sim_vcd_bits(v->fp, fifo[i], '0' + i);
+	}
+	v->pins = pins;
+	v->irq = pio->irq;
+	v->fifo[0] = fifo[0];
+	v->fifo[1] = fifo[1];
+	v->first = false;
+}
+
+static inline void pio_sim_vcd_close(pio_sim_vcd_t* v){
+	if (v->fp) fclose(v->fp);
+	v->fp = NULL;
+}
+
+// ---- .pio アセンブラ (pioasm の本リポジトリで使う範囲) ----
+
+static inline char* pio_asm_trim(char* s){
+	while(isspace((unsigned char)*s)) s++;
+	char* e = s + strlen(s);
+	while(e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+	return s;
+}
+
+static inline int pio_asm_src_dst(const char* t){
+	static const char* const name[] = {"pins", "x", "y", "null", "pindirs", "pc", "isr", "osr"};
+	for(uint i = 0; i < 8; i++) if (strcmp(t, name[i]) == 0) return (int)i;
+	if (strcmp(t, "status") == 0) return PIO_SRC_DST_STATUS;
+	if (strcmp(t, "exec") == 0) return PIO_SRC_DST_EXEC;
+	return -1;
+}
+
+static inline int pio_asm_label_find(char label[][PIO_SIM_LABEL_N], const uint8_t* addr, uint n, const char* name){
+	for(uint i = 0; i < n; i++) if (strcmp(label[i], name) == 0) return addr[i];
+	return -1;
+}
+
+// path の .program name をアセンブルする 失敗時は理由を表示して false
+static inline bool pio_asm_file(const char* path, const char* name, pio_sim_prog_t* prog){
+	FILE* fp = fopen(path, "r");
+	if (fp == NULL) {
+		printf("  cannot open : %s\n", path);
+		return false;
+	}
+	char label[PIO_PWM_INSN_MAX][PIO_SIM_LABEL_N];
+	uint8_t label_addr[PIO_PWM_INSN_MAX];
+	uint label_n = 0;
+	char src[PIO_PWM_INSN_MAX][128];
+	bool ok = true;
+	memset(prog, 0, sizeof(*prog));
+	prog->clkdiv = 1;
+	bool wrap_set = false;
+
+	// 1パス目 : 対象プログラムの命令行・ラベル・ディレクティブ
+	char line[256];
+	bool in_prog = false, in_block = false;
+	while(fgets(line, sizeof(line), fp) != NULL){
+		char* c = strchr(line, ';');
+		if (c) *c = '\0';
+		c = strstr(line, "//");
+		if (c) *c = '\0';
+		char* t = pio_asm_trim(line);
+		if (t[0] == '%') { in_block = (strstr(t, "{") != NULL); continue; }
+		if (in_block || t[0] == '\0') continue;
+		if (strncmp(t, ".program", 8) == 0) {
+			in_prog = (strcmp(pio_asm_trim(t + 8), name) == 0);
+			continue;
+		}
+		if (!in_prog) continue;
+		if (strncmp(t, ".side_set", 9) == 0) { prog->sideset_n = (uint8_t)atoi(t + 9); continue; }
+		if (strcmp(t, ".wrap_target") == 0) { prog->wrap_target = prog->len; continue; }
+		if (strcmp(t, ".wrap") == 0) { prog->wrap = prog->len - 1; wrap_set = true; continue; }
+		if (t[0] == '.') continue;
+		char* colon = strchr(t, ':');
+		if (colon) {
+			*colon = '\0';
+			char* l = pio_asm_trim(t);
+			bool pub = (strncmp(l, "public", 6) == 0);
+			if (pub) l = pio_asm_trim(l + 6);
+			if (label_n < PIO_PWM_INSN_MAX) {
+				snprintf(label[label_n], PIO_SIM_LABEL_N, "%s", l);
+				label_addr[label_n++] = prog->len;
+			}
+			if (pub && strcmp(l, "entry_point") == 0) prog->entry = prog->len;
+			t = pio_asm_trim(colon + 1);
+			if (t[0] == '\0') continue;
+		}
+		if (prog->len >= PIO_PWM_INSN_MAX) { ok = false; break; }
+		snprintf(src[prog->len++], sizeof(src[0]), "%s", t);
+	}
+	fclose(fp);
+	if (!wrap_set && prog->len) prog->wrap = prog->len - 1;
+
+	// 2パス目 : 命令エンコード
+	for(uint i = 0; i < prog->len && ok; i++){
+		char buf[128];
+		snprintf(buf, sizeof(buf), "%s", src[i]);
+		// ',' は区切り、'[ 2]' の括弧内の空白は詰める
+		bool in_delay = false;
+		char* w = buf;
+		for(char* p = buf; *p; p++){
+			if (*p == '[') in_delay = true;
+			else if (*p == ']') in_delay = false;
+			if (in_delay && isspace((unsigned char)*p)) continue;
+			*w++ = (*p == ',') ? ' ' : *p;
+		}
+		*w = '\0';
+		char* tok[12] = {NULL};
+		uint n = 0;
+		for(char* p = strtok(buf, " \t"); p && n < 12; p = strtok(NULL, " \t")) tok[n++] = p;
+		uint side = 0, delay = 0;
+		uint m = n;
+		for(uint k = 0; k < n; k++){
+			if (strcmp(tok[k], "side") == 0 && k + 1 < n) { side = (uint)atoi(tok[k + 1]); if (k < m) m = k; }
+			else if (tok[k][0] == '[') { delay = (uint)atoi(tok[k] + 1); if (k < m) m = k; }
+		}
+		n = m;
+		uint16_t insn = 0;
+		int v;
+		const char* op = tok[0];
+		if (strcmp(op, "nop") == 0) {
+			insn = PIO_I_NOP;
+		} else if (strcmp(op, "jmp") == 0) {
+			static const char* const cond[] = {"", "!x", "x--", "!y", "y--", "x!=y", "pin", "!osre"};
+			uint cd = 0;
+			const char* target = tok[n - 1];
+			if (n == 3) {
+				for(cd = 1; cd < 8 && strcmp(tok[1], cond[cd]) != 0; cd++);
+				if (cd == 8) ok = false;
+			}
+			v = pio_asm_label_find(label, label_addr, label_n, target);
+			if (v < 0) v = isdigit((unsigned char)target[0]) ? atoi(target) : -1;
+			if (v < 0) ok = false;
+			insn = PIO_OP_JMP | (cd << 5) | (v & 0x1f);
+		} else if (strcmp(op, "wait") == 0 && n >= 4) {
+			const uint pol = (uint)atoi(tok[1]);
+			const uint srcsel = (strcmp(tok[2], "gpio") == 0) ? 0 : (strcmp(tok[2], "pin") == 0) ? 1 : 2;
+			insn = PIO_OP_WAIT | (pol << 7) | (srcsel << 5) | ((uint)atoi(tok[3]) & 0x1f);
+		} else if ((strcmp(op, "in") == 0 || strcmp(op, "out") == 0) && n == 3) {
+			v = pio_asm_src_dst(tok[1]);
+			if (v < 0) ok = false;
+			insn = ((op[0] == 'i') ? PIO_OP_IN : PIO_OP_OUT) | ((v & 7) << 5) | ((uint)atoi(tok[2]) & 0x1f);
+		} else if (strcmp(op, "pull") == 0 || strcmp(op, "push") == 0) {
+			insn = PIO_OP_PUSH_PULL | ((op[1] == 'u' && op[2] == 'l') ? PIO_PULL : 0) | PIO_BLOCK;
+			for(uint k = 1; k < n; k++){
+				if (strcmp(tok[k], "noblock") == 0) insn &= ~PIO_BLOCK;
+				if (strcmp(tok[k], "ifempty") == 0 || strcmp(tok[k], "iffull") == 0) insn |= PIO_IF_FULL_EMPTY;
+			}
+		} else if (strcmp(op, "mov") == 0 && n == 3) {
+			const char* s = tok[2];
+			uint mop = PIO_MOV_NONE;
+			if (s[0] == '!' || s[0] == '~') { mop = PIO_MOV_INVERT; s++; }
+			else if (s[0] == ':' && s[1] == ':') { mop = PIO_MOV_REVERSE; s += 2; }
+			int d = pio_asm_src_dst(tok[1]);
+			if (strcmp(tok[1], "exec") == 0) d = 4;
+			v = pio_asm_src_dst(s);
+			if (d < 0 || v < 0) ok = false;
+			insn = PIO_OP_MOV | ((d & 7) << 5) | mop | (v & 7);
+		} else if (strcmp(op, "irq") == 0 && n >= 2) {
+			insn = PIO_OP_IRQ;
+			for(uint k = 1; k < n - 1; k++){
+				if (strcmp(tok[k], "clear") == 0) insn |= PIO_IRQ_CLEAR;
+				if (strcmp(tok[k], "wait") == 0) insn |= PIO_IRQ_WAIT;
+			}
+			insn |= (uint)atoi(tok[n - 1]) & 7;
+		} else if (strcmp(op, "set") == 0 && n == 3) {
+			v = pio_asm_src_dst(tok[1]);
+			if (v < 0) ok = false;
+			insn = PIO_OP_SET | ((v & 7) << 5) | ((uint)atoi(tok[2]) & 0x1f);
+		} else {
+			ok = false;
+		}
+		const uint ss = prog->sideset_n;
+		if (delay >= (1u << (5 - ss)) || (ss ? side >= (1u << ss) : side != 0)) ok = false;
+		insn |= (uint16_t)(delay << 8);
+		if (ss) insn |= (uint16_t)(side << (13 - ss));
+		prog->insn[i] = insn;
+		if (!ok) printf("  %s : %s : cannot assemble \"%s\"\n", path, name, src[i]);
+	}
+	if (prog->len == 0) {
+		printf("  %s : program %s not found\n", path, name);
+		ok = false;
+	}
+	return ok;
+}
+
+#endif
@@ -0,0 +1,216 @@
+/**
+ * @file pio_sink.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Core1 出力先の PIOモデル (DMAピンポン供給 -> TX FIFO -> 生成PWMプログラム -> ピン, 実時間余裕・波形照合)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note pcm2pwm_frame() のビットストリームを、Core1 の見積もりサイクル(host/cycle_model.h)に従う時刻で
+ *       PIOモデル(host/pio_sim.h)に供給する。PIOプログラムは pdm_output.c と同じ構成で pio_pwm_build() により生成する。
+ *         Core1 : pdm_dma_feed() と同じ手順で PDM_DMA_CHUNK_N サンプル毎に面へ変換し、DMAチャネルを設定・連結・起動する
+ *                 (面の転送完了待ち -> 連結解除 -> 変換 -> 転送元・転送数設定・連結 -> 未起動なら同時起動)
+ *         DMA   : host/dma_sim.h のチャネルレジスタモデル (READ_ADDR・TRANS_COUNT再設定・CHAIN_TO)。
+ *                 転送中のチャネルが TX FIFO の空き毎に sm0/sm1 へ書込む (転送遅延・バス占有は無視)
+ *       LP/RP の L パルス幅から code を復元し、供給したビットストリームと照合する。
+ *       FIFO空時の中心レベルは code 間の H となるため code と区別できる。
+ *        slack    : Core1 の変換中に FIFO・DMA に残るデータの出力時間の最小値 [pio clk]
+ *                   (定常状態 = 最初の面転送完了待ち以降)。Core1 がこれ以上停止するとアンダーランする
+ *        underrun : データ出力開始後、供給終了までに OSR・TX FIFO とも空になった回数 (sm0)
+ *        garbage  : DMA が Core1 の設定範囲外(面のバッファ終端以降など)を読み出したワード数 (L/R)
+ *        hang     : 面の転送完了待ち・供給終了待ちが 2面 + FIFO の出力時間を超えた (連結の循環などで DMA が止まらない)
+ *                   以降の面は供給しない
+ *        center   : データ出力開始後、供給終了までの中心レベル周期数 (LCh)
+ *        L/R      : L/R の L パルス中心の不一致数
+ */
+#ifndef _PIO_SINK_H_
+#define _PIO_SINK_H_
+
+#include "pico.h"
+#include "bsp.h"
+#include "pio_pwm.h"
+#include "pio_sim.h"
+#include "dma_sim.h"
+
+#define PIO_SINK_CODE_N		8192	// 照合待ち code 数 (ch毎)
+#define PIO_SINK_LR_N		16		// L/R 位相比較用 パルス中心履歴
+
+typedef struct {
+	uint8_t		code[PIO_SINK_CODE_N];		// 照合待ち code
+	uint		code_rd, code_n;
+	uint64_t	fall;						// 立下り時刻 [pio clk]
+	bool		lo, fall_valid;
+	bool		data;						// データ出力開始済み
+	uint32_t	center2[PIO_SINK_LR_N];		// L パルス中心 x2
+	uint		pulse_n;
+	uint		match_n, ng_n, center_n, other_n;
+} pio_sink_ch_t;
+
+typedef struct {
+	pio_sim_t			pio;
+	pio_pwm_config_t	cfg;
+	bool				fs48;
+	uint				cycle;							// PWM周期 [pio clk]
+	uint64_t			t_core1;						// Core1 時刻 [pio clk]
+	dma_sim_t			dma;							// DMAチャネル・ピンポンバッファ
+	bool				steady;							// 面転送完了待ちが発生済み
+	pio_sink_ch_t		ch[2];
+	pio_sim_vcd_t*		vcd;							// NULL : 波形出力なし
+	uint64_t			slack_min;						// [pio clk]
+	uint64_t			slack_last;						// 直前の面の変換完了時点の slack [pio clk]
+	uint64_t			wait_clk;						// Core1 の面転送完了待ち [pio clk]
+	uint				lr_ng;
+	uint				underrun_n, center_n;			// 供給終了(drain)までの sm0 アンダーラン回数・LCh 中心レベル周期数
+	bool				hang;							// DMA転送が終わらない
+} pio_sink_t;
+
+static inline bool pio_sink_init(pio_sink_t* k, uint pwm_bit, bool fs48){
+	memset(k, 0, sizeof(*k));
+	pio_pwm_param_t param;
+	pio_pwm_param_init(&param, pwm_bit, CLOCK_PLAN_PWM_CYCLE_48, CLOCK_PLAN_PWM_CYCLE_44);
+	if (!pio_pwm_build(&k->cfg, &param)) return false;
+	k->fs48 = fs48;
+	k->cycle = pio_pwm_cycle_clk(&k->cfg, fs48);
+
+	pio_sim_init(&k->pio);
+	k->pio.pins_in = (uint32_t)fs48 << PIN_FS48;
+	const int off = pio_sim_add_program(&k->pio, &k->cfg.pwm);
+	for(uint sm = 0; sm < 2; sm++){
+		pio_sim_sm_init(&k->pio, sm, &k->cfg.pwm, off, k->cfg.pwm.clkdiv, sm ? PIN_OUTPUT_RP : PIN_OUTPUT_LP, PIN_FS48, k->cfg.out_thr, true);
+	}
+	uint mask = 3;
+	if (k->cfg.pacemaker.len) {
+		const int off_pm = pio_sim_add_program(&k->pio, &k->cfg.pacemaker);
+		pio_sim_sm_init(&k->pio, 2, &k->cfg.pacemaker, off_pm, k->cfg.pacemaker.clkdiv, 0, PIN_FS48, 32, false);
+		mask = 7;
+	}
+	pio_sim_enable(&k->pio, mask);
+	dma_sim_init(&k->dma);
+	for(uint c = 0; c < 2; c++) k->ch[c].lo = true;		// 起動時は P = L (立下り待ち)
+	k->slack_min = UINT64_MAX;
+	return true;
+}
+
+// L パルス 1個の判定 (code 照合・中心レベル・L/R位相)
+static inline void pio_sink_pulse(pio_sink_t* k, uint c, uint64_t rise){
+	pio_sink_ch_t* ch = &k->ch[c];
+	const uint lo = (uint)(rise - ch->fall);
+	const uint h = (lo < k->cycle) ? k->cycle - lo : 0;
+	const uint h0 = pio_pwm_high_clk(&k->cfg, 0, k->fs48);
+	const uint code = (h >= h0) ? (h - h0) / k->cfg.step : 0;
+	if (h == pio_pwm_center_clk(&k->cfg, k->fs48)) {
+		if (ch->data) ch->center_n++;
+	} else if (h >= h0 && (h - h0) % k->cfg.step == 0 && code < (1u << k->cfg.param.pwm_bit)) {
+		if (ch->code_n && ch->code[ch->code_rd] == code) ch->match_n++;
+		else ch->ng_n++;
+		if (ch->code_n) {
+			ch->code_rd = (ch->code_rd + 1) % PIO_SINK_CODE_N;
+			ch->code_n--;
+		}
+		ch->data = true;
+	} else {
+		ch->other_n++;
+	}
+
+	const uint n = ch->pulse_n++;
+	ch->center2[n % PIO_SINK_LR_N] = (uint32_t)(ch->fall + rise);
+	const pio_sink_ch_t* o = &k->ch[c ^ 1];
+	if (o->pulse_n > n && o->pulse_n - n <= PIO_SINK_LR_N && o->center2[n % PIO_SINK_LR_N] != ch->center2[n % PIO_SINK_LR_N]) k->lr_ng++;
+}
+
+// 1 PIOクロック (DMA転送 -> PIO -> ピン判定)
+// 転送中のチャネルは TX FIFO の空き(DREQ)毎に転送する。完了したチャネルの連結先は同じクロックで転送を始める
+static inline void pio_sink_clock(pio_sink_t* k){
+	for(uint c = 0; c < N_CH; c++){
+		for(uint s = 0; s < 2; s++){
+			while(dma_sim_busy(&k->dma, s, c) && !pio_sim_tx_full(&k->pio, c)){
+				pio_sim_put(&k->pio, c, dma_sim_transfer(&k->dma, s, c));
+			}
+		}
+	}
+	pio_sim_clock(&k->pio);
+	if (k->vcd) pio_sim_vcd_sample(k->vcd, &k->pio);
+	const uint64_t clk = k->pio.clk - 1;
+	for(uint c = 0; c < 2; c++){
+		pio_sink_ch_t* ch = &k->ch[c];
+		const bool lo = !((k->pio.pins_out >> (c ? PIN_OUTPUT_RP : PIN_OUTPUT_LP)) & 1);
+		if (lo && !ch->lo) {
+			ch->fall = clk;
+			ch->fall_valid = true;
+		} else if (!lo && ch->lo && ch->fall_valid) {
+			pio_sink_pulse(k, c, clk);
+		}
+		ch->lo = lo;
+	}
+}
+
+static inline void pio_sink_run_to(pio_sink_t* k, uint64_t t){
+	while(k->pio.clk < t) pio_sink_clock(k);
+}
+
+// DMA の転送完了待ち (side : 面, 2 : 全面と TX FIFO) 正常なら 2面 + FIFO の出力時間内に終わる
+static inline void pio_sink_wait_dma(pio_sink_t* k, uint side){
+	const uint64_t limit = k->pio.clk + (uint64_t)(2 * DMA_SIM_WORD_N + PIO_SIM_FIFO_N + 1) * 4 * k->cycle;
+	while((side < 2) ? dma_sim_side_busy(&k->dma, side)
+		: (dma_sim_side_busy(&k->dma, 0) || dma_sim_side_busy(&k->dma, 1) || !pio_sim_tx_empty(&k->pio, 0))){
+		if (k->pio.clk >= limit) {
+			k->hang = true;
+			return;
+		}
+		pio_sink_clock(k);
+	}
+}
+
+// Core1 : L/R 各 n ワードの面を cyc [cycle] で変換して DMA に渡す (pdm_dma_feed() の 1面分)
+// stall : 変換前の Core1 停止 [cycle] (割込み・処理遅延によるデッドライン超過の模擬)
+static inline void pio_sink_chunk(pio_sink_t* k, const uint32_t* bs_l, const uint32_t* bs_r, uint n, uint cyc, uint stall){
+	dma_sim_t* d = &k->dma;
+	const uint s = d->side;
+	if (n > DMA_SIM_WORD_N || k->hang) return;
+	// 1. 面 s の転送完了待ち
+	pio_sink_run_to(k, k->t_core1);
+	if (dma_sim_side_busy(d, s)) k->steady = true;
+	pio_sink_wait_dma(k, s);
+	if (k->hang) return;
+	if (k->pio.clk > k->t_core1) {
+		k->wait_clk += k->pio.clk - k->t_core1;
+		k->t_core1 = k->pio.clk;
+	}
+	// 2. 面 s の連結解除
+	dma_sim_feed_unchain(d, s);
+	// 3. 変換 (この間も DMA は転送を続ける)
+	k->t_core1 += (stall + cyc + CLOCK_PLAN_PIO_DIV - 1) / CLOCK_PLAN_PIO_DIV;
+	pio_sink_run_to(k, k->t_core1);
+	if (k->steady) {
+		const uint64_t slack = (uint64_t)(dma_sim_pending(d, 0) + k->pio.sm[0].fifo_n) * 4 * k->cycle;
+		if (slack < k->slack_min) k->slack_min = slack;
+		k->slack_last = slack;
+	}
+	for(uint i = 0; i < n; i++){
+		d->mem[s][0][i] = bs_l[i];
+		d->mem[s][1][i] = bs_r[i];
+		for(uint c = 0; c < 2; c++){
+			pio_sink_ch_t* ch = &k->ch[c];
+			const uint32_t v = c ? bs_r[i] : bs_l[i];
+			const uint bit = k->cfg.param.pwm_bit;
+			for(uint j = 0; j < 4 && ch->code_n < PIO_SINK_CODE_N; j++){
+				ch->code[(ch->code_rd + ch->code_n++) % PIO_SINK_CODE_N] = (v >> (bit * j)) & ((1u << bit) - 1);
+			}
+		}
+	}
+	// 4. 転送元・転送数設定、面 s^1 -> 面 s の連結、未起動なら同時起動
+	dma_sim_feed_commit(d, s, n);
+}
+
+// 全データを出力し、FIFO空の中心レベルを period_n 周期出力するまで進める
+static inline void pio_sink_drain(pio_sink_t* k, uint period_n){
+	pio_sink_run_to(k, k->t_core1);
+	k->underrun_n = k->pio.sm[0].underrun_n;
+	k->center_n = k->ch[0].center_n;
+	pio_sink_wait_dma(k, 2);
+	pio_sink_run_to(k, k->pio.clk + (uint64_t)(4 + period_n) * k->cycle);
+}
+
+static inline double pio_sink_clk_us(uint64_t clk){
+	return (double)clk * CLOCK_PLAN_PIO_DIV * 1e6 / CLK_SYS;
+}
+
+#endif
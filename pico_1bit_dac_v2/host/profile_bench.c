@@ -0,0 +1,121 @@
+/**
+ * @file profile_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 変調プロファイル全数ベンチマーク
+ * @version 0.01
+ * @date 2026-10-17
+ * @note pdm_output.c の全変調プロファイル(pcm2pwm_profile[])に同一入力(-6dBFS 997Hz, fs = 384kHz)を与え、
+ *       プロファイル毎に以下を出力する。
+ *        ns/sample  : ホスト実測処理時間 (L/R)
+ *        cyc/sample : Cortex-M0+ 見積もりサイクル数 (PWM変換 + DMA面切替, L/R)
+ *        Core1[%]   : 見積もりCore1負荷
+ *        err[dB]    : ビットストリームを復号・平均化した波形と入力の誤差 (変換結果の簡易確認)
+ *       いずれかのプロファイルが見積もり負荷100%を超える、または誤差が ERR_LIMIT_DB を超えた場合は終了コード1を返す。
+ *       usage : profile_bench [packets]   default 100
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "pdm_output.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+// pdm_output.c の設定と合わせること
+#define BENCH_OS_INNER_N	4
+#define BENCH_BLOCK_N		8
+#define BENCH_CHUNK_N		48		// PDM_DMA_CHUNK_N
+
+#define BENCH_FS			384000	// Core1入力fs (最悪条件)
+#define AVG_N				16		// 復号時の平均化サンプル数 (384k/16 = 24kHz 帯域相当)
+#define ERR_LIMIT_DB		(-10.0)	// 誤差判定値 (変換破綻の検出用。DS_ORDER = 0 は単純再量子化のため 4bit で約 -16dB)
+
+static int32_t src_buf[QUEUE_WIDTH];
+static uint32_t bs_buf[QUEUE_WIDTH * 2];
+
+// Lch ビットストリーム1サンプル分(bs_n ワード)の PWM値平均 (中心 = 0)
+static double decode_sample(const uint32_t* bs, uint bs_n, uint pwm_bit){
+	const uint32_t mask = (1u << pwm_bit) - 1;
+	const double center = (double)(1u << (pwm_bit - 1));
+	double sum = 0;
+	for(uint j = 0; j < bs_n; j++){
+		uint32_t w = bs[j];
+		for(uint k = 0; k < BENCH_OS_INNER_N; k++){
+			sum += (double)((w >> (k * pwm_bit)) & mask) - center;
+		}
+	}
+	return sum / (bs_n * BENCH_OS_INNER_N);
+}
+
+int main(int argc, char* argv[]){
+	uint packets = (argc > 1) ? (uint)atoi(argv[1]) : 100;
+	const uint packet_len = BENCH_FS / 1000;
+	const double budget = cyc_budget(BENCH_FS);
+	bool fail = false;
+
+	printf("pico_1bit_dac_v2 profile_bench : CLK_SYS = %.1fMHz, fs = %uHz, budget = %.1f cycle/sample\n\n",
+		CLK_SYS / 1e6, BENCH_FS, budget);
+	printf("  %-3s %-7s %-8s %-4s %10s %10s %9s %8s\n",
+		"no", "PWM_BIT", "DS_ORDER", "OS", "ns/sample", "cyc/sample", "Core1[%]", "err[dB]");
+
+	host_set_core_num(1);
+	for(uint n = 0; n < pcm2pwm_get_profile_n(); n++){
+		const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(n);
+		pcm2pwm_init(n);
+		const uint bs_n = pcm2pwm_get_bs_n();
+		const uint cyc = 2 * cyc_pcm2pwm_block_prof(prof, BENCH_OS_INNER_N, bs_n, BENCH_BLOCK_N)
+					   + (cyc_dma_chunk() + BENCH_CHUNK_N - 1) / BENCH_CHUNK_N;
+
+		uint64_t phase = 0;
+		double ns = 0;
+		double sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0, sn = 0;
+		double ax = 0, ay = 0;
+		uint avg = 0;
+		for(uint p = 0; p < packets; p++){
+			for(uint i = 0; i < packet_len; i++){
+				int32_t s = (int32_t)(sin(2.0 * M_PI * 997.0 * (double)phase++ / BENCH_FS) * (double)(1 << 22));
+				src_buf[i * 2 + 0] = s;
+				src_buf[i * 2 + 1] = -s;
+			}
+			double t0 = now_ns();
+			pcm2pwm_frame(src_buf, packet_len, bs_buf);
+			ns += now_ns() - t0;
+
+			// 起動直後(先頭10packet)を除き、AVG_N サンプル平均で入力と比較
+			// ΔΣ・直線補間の遅延(1サンプル)を補正する
+			for(uint i = 1; (p >= 10) && (i < packet_len); i++){
+				ax += src_buf[(i - 1) * 2];
+				ay += decode_sample(&bs_buf[i * bs_n], bs_n, prof->pwm_bit);	// Lch面
+				if (++avg == AVG_N) {
+					sx  += ax;
+					sy  += ay;
+					sn  += 1;
+					sxx += ax * ax;
+					sxy += ax * ay;
+					syy += ay * ay;
+					ax = ay = 0;
+					avg = 0;
+				}
+			}
+		}
+		// 最小二乗でゲイン・オフセット(量子化器の1/2LSBオフセット)を合わせた残差
+		double vxx = sxx - sx * sx / sn;
+		double vxy = sxy - sx * sy / sn;
+		double vyy = syy - sy * sy / sn;
+		double err = 10.0 * log10((vyy - vxy * vxy / vxx) / (vxy * vxy / vxx) + 1e-20);
+		double load = 100.0 * cyc / budget;
+		bool ng = (load > 100.0) || (err > ERR_LIMIT_DB);
+		if (ng) fail = true;
+
+		printf("  %-3u %-7u %-8u %-4s %10.2f %10u %9.2f %8.1f%s%s%s\n",
+			n, prof->pwm_bit, prof->ds_order, prof->os_type ? "LI" : "SH",
+			ns / ((double)packets * packet_len), cyc, load, err,
+			(prof->ds_type == DS_TYPE_CRFB) ? " (CRFB)" : "", (n == PCM2PWM_PROFILE_DEFAULT) ? " (default)" : "", ng ? " NG" : "");
+	}
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,326 @@
+/**
+ * @file quality_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 音質回帰チェック ファームウェアDSPチェーンのビットストリームを復号・FFTし、基準値(golden)と比較する
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 入力 fs = 48kHz の試験信号を main.c(I2S) と同じ処理順 volume -> hbf_oversampler -> asrc(ピッチ1.0) -> pcm2pwm で
+ *       処理し、Lch のビットストリームを PIOプログラムが出力するパルス幅列(PWM周期毎のデューティ -1~+1)に復号して評価する。
+ *         sine   : 996Hz -6dBFS          SNR[dB] (20Hz~20kHz, 高調波除く), THD+N[dB]
+ *         twin   : 19.0k + 20.0kHz 各-12dBFS  IMD+N[dB] (20Hz~20kHz, 2波以外の全成分)
+ *         silence: 無音                  idle[dBFS] 帯域内最大スプリアス, noise[dBFS] 帯域内雑音,
+ *                                        slope[dB/oct] 10k~80kHz オクターブ帯域雑音の傾き(ノイズシェーピング特性)
+ *       試験信号はFFT長(入力4096サンプル)に整数周期で収まる周波数とし(コヒーレント)、
+ *       帯域外の大きな量子化雑音の漏れ込みを避けるため Nuttall窓(サイドローブ -93dB, -18dB/oct)を用いる。
+ *       dBFS はプロファイル毎に sine の出力振幅から求めた 0dBFS 正弦波を基準とする。
+ *       帯域の下限は 20Hz と DC近傍(窓のメインローブ, PWM中心値の1/2LSBオフセット)を除いた bin のうち高い方とする。
+ *       基準値ファイル(既定 host/quality_golden.txt)と比較し、いずれかの指標が許容値を超えて悪化した場合は終了コード1を返す。
+ *       usage : quality_bench [-u] [golden file]
+ *                 -u : 現在の結果で基準値ファイルを更新する
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "pdm_output.h"
+#include "bench_util.h"
+
+#ifndef QUALITY_GOLDEN_FILE
+#define QUALITY_GOLDEN_FILE	"quality_golden.txt"
+#endif
+
+#define Q_FS			48000		// 入力fs
+#define Q_PACKET_N		48			// 1パケット(1ms)のサンプル数
+#define Q_FFT_IN_N		4096		// FFT長 (入力サンプル数換算) bin = 11.72Hz
+#define Q_WARMUP_MS		100			// 評価前の空運転
+#define Q_BAND_LO		20.0
+#define Q_BAND_HI		20000.0
+#define Q_TONE_BIN		85			// 996.1Hz
+#define Q_TWIN1_BIN		1621		// 18996.1Hz
+#define Q_TWIN2_BIN		1706		// 19992.2Hz
+#define Q_LOBE			5			// 窓のメインローブ片側幅[bin] (Nuttall : 4)
+#define Q_HARM_N		9			// THD 評価高調波 2~9次
+
+#define Q_TOL_DB		0.5			// 許容悪化量 [dB]
+#define Q_TOL_SLOPE		1.0			// 許容変化量 [dB/oct]
+
+#define Q_VOL_MUL		128			// volume 0dB (x128 >> 7)
+#define Q_VOL_SHIFT		7
+
+enum { SIG_SINE, SIG_TWIN, SIG_SILENCE };
+
+typedef struct {
+	double	snr;		// sine  SNR [dB]
+	double	thdn;		// sine  THD+N [dB]
+	double	imdn;		// twin  IMD+N [dB]
+	double	idle;		// silence 最大スプリアス [dBFS]
+	double	noise;		// silence 帯域内雑音 [dBFS]
+	double	slope;		// silence ノイズシェーピング傾き [dB/oct]
+} quality_t;
+
+#define Q_METRIC_N	6
+static const char* const metric_name[Q_METRIC_N] = {"snr", "thdn", "imdn", "idle", "noise", "slope"};
+static const bool metric_higher_better[Q_METRIC_N] = {true, false, false, false, false, true};
+
+static inline double* metric_ptr(quality_t* q, uint m){
+	return &((double*)q)[m];
+}
+
+// PIOプログラムのパルス幅 H = h0 + h_step * DATA (PWM周期 period [clk])  pio_pwm_4/5/6bit.pio
+typedef struct {
+	uint	period;
+	uint	h0;
+	uint	h_step;
+} pwm_shape_t;
+
+static const pwm_shape_t pwm_shape[3] = {
+	{ 68, 4, 4},	// 4bit
+	{ 68, 3, 2},	// 5bit
+	{136, 5, 2},	// 6bit
+};
+
+static int32_t q_slot[QUEUE_SLOT_WIDTH];
+static uint32_t bs_buf[QUEUE_WIDTH * 2];
+
+// 試験信号 1サンプル
+static int32_t signal_sample(uint sig, uint64_t n){
+	const double w = 2.0 * M_PI / Q_FFT_IN_N;
+	switch(sig){
+		case SIG_SINE: return (int32_t)lround(sin(w * Q_TONE_BIN * n) * (1 << 22));
+		case SIG_TWIN: return (int32_t)lround((sin(w * Q_TWIN1_BIN * n) + sin(w * Q_TWIN2_BIN * n)) * (1 << 21));
+		default:       return 0;
+	}
+}
+
+// 1プロファイル・1信号 ファームウェアDSPチェーンを実行し、パルス幅列の電力スペクトル(片側, n/2 bin)を返す
+static double* run_chain(uint profile, uint sig, uint* p_fft_n, double* p_bin_hz){
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(profile);
+	const pwm_shape_t* shape = &pwm_shape[prof->pwm_bit - 4];
+	const uint32_t mask = (1u << prof->pwm_bit) - 1;
+
+	host_set_core_num(0);
+	dsp_reset();
+	host_set_core_num(1);
+	pcm2pwm_init(profile);
+	const uint bs_n = pcm2pwm_get_bs_n();
+	const uint os = bs_n * 4;								// パルス数/384kHzサンプル
+	const uint fft_n = Q_FFT_IN_N * 8 * os;					// 48k -> 384k (x8) -> PWM周期
+	double complex* x = malloc(sizeof(double complex) * fft_n);
+	uint x_n = 0;
+	uint64_t n = 0;
+
+	for(uint p = 0; x_n < fft_n; p++){
+		host_set_core_num(0);
+		int32_t* buf = get_dsp_buf_pointer(Q_FS);
+		uint len = Q_PACKET_N;
+		for(uint i = 0; i < len; i++, n++){
+			int32_t s = signal_sample(sig, n);
+			buf[i * 2 + 0] = s;
+			buf[i * 2 + 1] = -s;
+		}
+		volume(buf, len, Q_VOL_MUL, Q_VOL_SHIFT);
+		hbf_oversampler(&buf, &len, Q_FS, get_dsp_buf_pointer(384000));
+		asrc(&buf, &len, 1u << 22, q_slot);
+
+		host_set_core_num(1);
+		pcm2pwm_frame(buf, len, bs_buf);
+		if (p < Q_WARMUP_MS) continue;
+		for(uint i = 0; i < len * bs_n && x_n < fft_n; i++){		// Lch面
+			for(uint k = 0; k < 4 && x_n < fft_n; k++){
+				uint d = (bs_buf[i] >> (k * prof->pwm_bit)) & mask;
+				double h = shape->h0 + (double)shape->h_step * d;
+				x[x_n++] = (2.0 * h - shape->period) / shape->period;	// デューティ -1~+1
+			}
+		}
+	}
+
+	// Nuttall窓 (連続1次導関数, 4項)
+	double wsum = 0;
+	for(uint i = 0; i < fft_n; i++){
+		double t = 2.0 * M_PI * i / fft_n;
+		double w = 0.355768 - 0.487396 * cos(t) + 0.144232 * cos(2 * t) - 0.012604 * cos(3 * t);
+		x[i] *= w;
+		wsum += w;
+	}
+	fft(x, fft_n);
+	double* psd = malloc(sizeof(double) * fft_n / 2);
+	for(uint i = 0; i < fft_n / 2; i++){
+		double a = cabs(x[i]) * 2.0 / wsum;			// 正弦波振幅換算
+		psd[i] = a * a / 2.0;							// 正弦波電力換算
+	}
+	free(x);
+	*p_fft_n = fft_n;
+	*p_bin_hz = (double)Q_FS / Q_FFT_IN_N;
+	return psd;
+}
+
+// bin k ±Q_LOBE の電力和
+static double lobe_power(const double* psd, int k){
+	double s = 0;
+	for(int i = k - Q_LOBE; i <= k + Q_LOBE; i++) if (i >= 0) s += psd[i];
+	return s;
+}
+
+static bool near_bin(int i, int k){
+	return (i >= k - Q_LOBE) && (i <= k + Q_LOBE);
+}
+
+static quality_t measure(uint profile){
+	quality_t q;
+	uint fft_n;
+	double bin_hz;
+	const int lo = (int)ceil(Q_BAND_LO / ((double)Q_FS / Q_FFT_IN_N));
+	const int hi = (int)floor(Q_BAND_HI / ((double)Q_FS / Q_FFT_IN_N));
+
+	// sine : SNR, THD+N, 0dBFS 基準
+	double* psd = run_chain(profile, SIG_SINE, &fft_n, &bin_hz);
+	double sig = lobe_power(psd, Q_TONE_BIN);
+	double noise = 0, noise_harm = 0;
+	for(int i = (lo > Q_LOBE) ? lo : Q_LOBE + 1; i <= hi; i++){
+		if (near_bin(i, Q_TONE_BIN)) continue;
+		bool harm = false;
+		for(int h = 2; h <= Q_HARM_N; h++) harm = harm || near_bin(i, Q_TONE_BIN * h);
+		if (harm) noise_harm += psd[i];
+		else      noise += psd[i];
+	}
+	q.snr  = 10.0 * log10(sig / noise);
+	q.thdn = 10.0 * log10((noise + noise_harm) / sig);
+	const double fs_power = sig * 4.0;				// -6dBFS -> 0dBFS
+	free(psd);
+
+	// twin : IMD+N
+	psd = run_chain(profile, SIG_TWIN, &fft_n, &bin_hz);
+	double sig2 = lobe_power(psd, Q_TWIN1_BIN) + lobe_power(psd, Q_TWIN2_BIN);
+	double imd = 0;
+	for(int i = (lo > Q_LOBE) ? lo : Q_LOBE + 1; i <= hi; i++){
+		if (near_bin(i, Q_TWIN1_BIN) || near_bin(i, Q_TWIN2_BIN)) continue;
+		imd += psd[i];
+	}
+	q.imdn = 10.0 * log10(imd / sig2);
+	free(psd);
+
+	// silence : 最大スプリアス, 帯域内雑音, 10k~80kHz オクターブ帯域の傾き
+	psd = run_chain(profile, SIG_SILENCE, &fft_n, &bin_hz);
+	double peak = 0, idle = 0;
+	for(int i = (lo > Q_LOBE) ? lo : Q_LOBE + 1; i <= hi; i++){
+		if (psd[i] > peak) peak = psd[i];
+		idle += psd[i];
+	}
+	q.idle  = 10.0 * log10(peak / fs_power + 1e-30);
+	q.noise = 10.0 * log10(idle / fs_power + 1e-30);
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	for(uint o = 0; o < 3; o++){
+		const int b0 = (int)(10000.0 * (1 << o) / bin_hz), b1 = (int)(20000.0 * (1 << o) / bin_hz);
+		double s = 0;
+		for(int i = b0; i < b1; i++) s += psd[i];
+		double y = 10.0 * log10(s / (b1 - b0) + 1e-30);
+		sx += o; sy += y; sxx += o * o; sxy += o * y;
+	}
+	q.slope = (3 * sxy - sx * sy) / (3 * sxx - sx * sx);
+	free(psd);
+	return q;
+}
+
+// 基準値ファイル 1行 : profile snr thdn imdn idle noise slope
+static uint load_golden(const char* path, quality_t* golden, bool* valid, uint n){
+	FILE* fp = fopen(path, "r");
+	if (fp == NULL) return 0;
+	char line[256];
+	uint count = 0;
+	while(fgets(line, sizeof(line), fp)){
+		if (line[0] == '#') continue;
+		uint p;
+		quality_t q;
+		if (sscanf(line, "%u %lf %lf %lf %lf %lf %lf", &p, &q.snr, &q.thdn, &q.imdn, &q.idle, &q.noise, &q.slope) == 7 && p < n) {
+			golden[p] = q;
+			valid[p] = true;
+			count++;
+		}
+	}
+	fclose(fp);
+	return count;
+}
+
+static bool save_golden(const char* path, const quality_t* result, uint n){
+	FILE* fp = fopen(path, "w");
+	if (fp == NULL) return false;
+	fprintf(fp, "# pico_1bit_dac_v2 quality_bench golden metrics (quality_bench -u で更新)\n");
+	fprintf(fp, "# profile snr[dB] thdn[dB] imdn[dB] idle[dBFS] noise[dBFS] slope[dB/oct]\n");
+	for(uint p = 0; p < n; p++){
+		const quality_t* q = &result[p];
+		fprintf(fp, "%u %.2f %.2f %.2f %.2f %.2f %.2f\n", p, q->snr, q->thdn, q->imdn, q->idle, q->noise, q->slope);
+	}
+	fclose(fp);
+	return true;
+}
+
+int main(int argc, char* argv[]){
+	bool update = false;
+	const char* path = QUALITY_GOLDEN_FILE;
+	for(int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "-u") == 0) update = true;
+		else path = argv[i];
+	}
+	const uint prof_n = pcm2pwm_get_profile_n();
+	quality_t* result = calloc(prof_n, sizeof(quality_t));
+	quality_t* golden = calloc(prof_n, sizeof(quality_t));
+	bool* valid = calloc(prof_n, sizeof(bool));
+	uint golden_n = update ? 0 : load_golden(path, golden, valid, prof_n);
+	if (!update && golden_n == 0) {
+		fprintf(stderr, "golden file not found : %s (quality_bench -u で作成)\n", path);
+		return 1;
+	}
+
+	printf("pico_1bit_dac_v2 quality_bench : fs = %uHz, FFT bin = %.2fHz, band %.0f~%.0fHz, golden = %s (%u)\n\n",
+		Q_FS, (double)Q_FS / Q_FFT_IN_N, Q_BAND_LO, Q_BAND_HI, path, golden_n);
+	printf("  %-3s %-3s %-3s %-3s %-4s %8s %8s %8s %8s %8s %8s  %s\n",
+		"no", "bit", "ds", "os", "lf", "SNR", "THD+N", "IMD+N", "idle", "noise", "slope", "golden");
+
+	host_set_core_num(0);
+	dsp_init();
+	uint fail_n = 0;
+	for(uint p = 0; p < prof_n; p++){
+		const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(p);
+		quality_t q = measure(p);
+		result[p] = q;
+		printf("  %-3u %-3u %-3u %-3s %-4s", p, prof->pwm_bit, prof->ds_order, prof->os_type ? "LI" : "SH",
+			(prof->ds_type == DS_TYPE_CRFB) ? "CRFB" : "CoI");
+		for(uint m = 0; m < Q_METRIC_N; m++) printf(" %8.2f", *metric_ptr(&q, m));
+		if (!valid[p]) {
+			printf("  -\n");
+			continue;
+		}
+		// 悪化方向のみ判定 (slope は変化量)
+		bool ok = true;
+		printf(" ");
+		for(uint m = 0; m < Q_METRIC_N; m++){
+			double d = *metric_ptr(&q, m) - *metric_ptr(&golden[p], m);
+			double tol = (m == 5) ? Q_TOL_SLOPE : Q_TOL_DB;
+			bool worse = (m == 5) ? (fabs(d) > tol) : (metric_higher_better[m] ? (d < -tol) : (d > tol));
+			if (worse) {
+				printf(" %s%+.2f", metric_name[m], d);
+				ok = false;
+			}
+		}
+		printf(" %s\n", ok ? "OK" : "NG");
+		if (!ok) fail_n++;
+	}
+
+	if (update) {
+		if (!save_golden(path, result, prof_n)) {
+			fprintf(stderr, "cannot write %s\n", path);
+			return 1;
+		}
+		printf("\ngolden updated : %s\n", path);
+		return 0;
+	}
+	printf("\n%s (%u/%u profiles degraded)\n", fail_n ? "NG" : "OK", fail_n, prof_n);
+	return fail_n ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file queue_stress.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Core0->Core1 キュー (simple_queue.c) 2スレッド負荷試験
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 生産者スレッド(Core0相当)と消費者スレッド(Core1相当)で simple_queue.c を同時に実行し、
+ *       スロット取得・公開・取出し・解放のプロトコルを検証する。
+ *         生産者 : queue_acquire() -> スロット全体に通番とサンプル長から決まるパターンを書込み -> queue_publish()
+ *         消費者 : dequeue() -> パターン照合(読出し中の上書き検出のため時間をおいて2回照合)
+ *                  一定間隔で queue_reset() (ミュート遷移相当) を行う
+ *       検出項目 : データ破損、通番の逆行・重複、キュー長の範囲外
+ *       キュー動作モード(ロバスト / 低遅延)毎に実行する。
+ *       異常を検出した場合は終了コード1を返す。
+ *       usage : queue_stress [packets]   default 200000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "pico/stdlib.h"
+
+#include "simple_queue.h"
+
+#define RESET_INTERVAL	9973	// 消費者の queue_reset() 間隔 [dequeue回数]
+
+static uint32_t packet_n;
+static volatile bool producer_done = false;
+
+static uint32_t acquire_fail = 0;	// 生産者 空きスロット無し回数
+static uint32_t consumed = 0;		// 消費者 取出し数
+static uint32_t resets = 0;			// 消費者 queue_reset() 回数
+static uint32_t errors = 0;			// 消費者 異常検出数
+
+// 通番 seq のスロット内容 先頭2ワードに通番・サンプル長、以降はパターン
+static uint32_t packet_len(uint32_t seq){
+	return (get_queue_slot_width() / 2 - 1) - (seq % 9);
+}
+
+static int32_t pattern(uint32_t seq, uint32_t i){
+	return (int32_t)(seq * 2654435761u + i * 40503u);
+}
+
+static bool verify(const int32_t* buf, uint32_t len){
+	uint32_t seq = (uint32_t)buf[0];
+	if (len != packet_len(seq) || (uint32_t)buf[1] != len) return false;
+	for(uint32_t i = 2; i < len * 2; i++){
+		if (buf[i] != pattern(seq, i)) return false;
+	}
+	return true;
+}
+
+static void* producer(void* arg){
+	(void)arg;
+	host_set_core_num(0);
+	for(uint32_t seq = 0; seq < packet_n; ){
+		int32_t* buf = queue_acquire();
+		if (buf == NULL) {
+			acquire_fail++;
+			sched_yield();
+			continue;
+		}
+		uint32_t len = packet_len(seq);
+		buf[0] = (int32_t)seq;
+		buf[1] = (int32_t)len;
+		for(uint32_t i = 2; i < len * 2; i++) buf[i] = pattern(seq, i);
+		queue_publish(len);
+		seq++;
+	}
+	producer_done = true;
+	return NULL;
+}
+
+static void* consumer(void* arg){
+	(void)arg;
+	host_set_core_num(1);
+	int64_t last_seq = -1;
+	uint32_t calls = 0;
+	while(!producer_done || get_queue_length() != 0){
+		uint32_t length = get_queue_length();
+		if (length > queue_get_mode()->depth) {
+			fprintf(stderr, "queue length out of range : %u\n", length);
+			errors++;
+		}
+		if (++calls % RESET_INTERVAL == 0) {
+			queue_reset();
+			resets++;
+		}
+		int32_t* buf = NULL;
+		uint32_t len = 0;
+		dequeue(&buf, &len);
+		if (buf == NULL) {
+			sched_yield();
+			continue;
+		}
+
+		// 1回目照合 -> 処理時間相当の待ち -> 2回目照合 (解放前の上書き検出)
+		// 待ちの間は生産者に実行を譲る (1CPUのホストでも参照中スロットへの書込みを発生させるため)
+		bool ok = verify(buf, len);
+		for(volatile uint32_t w = 0; w < (calls & 0xff); w++);
+		sched_yield();
+		ok = ok && verify(buf, len);
+		int64_t seq = (uint32_t)buf[0];
+		if (!ok) {
+			fprintf(stderr, "corrupted slot : seq %lld\n", (long long)seq);
+			errors++;
+		} else if (seq <= last_seq) {
+			fprintf(stderr, "sequence error : %lld after %lld\n", (long long)seq, (long long)last_seq);
+			errors++;
+		}
+		last_seq = seq;
+		consumed++;
+	}
+	return NULL;
+}
+
+int main(int argc, char* argv[]){
+	packet_n = (argc > 1) ? (uint32_t)atoi(argv[1]) : 200000;
+	uint32_t errors_total = 0;
+
+	for(uint mode = 0; mode < QUEUE_MODE_N; mode++){
+		producer_done = false;
+		acquire_fail = consumed = resets = errors = 0;
+		queue_init(mode);
+		pthread_t th_p, th_c;
+		pthread_create(&th_c, NULL, consumer, NULL);
+		pthread_create(&th_p, NULL, producer, NULL);
+		pthread_join(th_p, NULL);
+		pthread_join(th_c, NULL);
+
+		printf("pico_1bit_dac_v2 queue_stress : mode = %s, depth = %u, width = %u word\n",
+			queue_get_mode()->name, queue_get_mode()->depth, get_queue_slot_width());
+		printf("  produced %u, consumed %u, dropped by reset %u, resets %u, acquire full %u\n",
+			packet_n, consumed, packet_n - consumed, resets, acquire_fail);
+		printf("  errors %u\n\n", errors);
+		errors_total += errors;
+	}
+	printf("%s\n", errors_total ? "NG" : "OK");
+	return errors_total ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file sram_bank_model.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief SRAMバンク配置 既定配置(全てストライプ領域) vs バンク配置(bsp.h CORE0_HOT/CORE1_HOT) の Core1 処理サイクル比較
+ * @version 0.01
+ * @date 2026-10-17
+ * @note Core1 の PWM変換(+後段オーバーサンプリング)1サンプル(L/R, 352.8/384kHz)当たりの SRAMアクセスを
+ *       命令フェッチ・キュー読出し・DMAバッファ書込み・状態(ch[], 遅延データ列, pdm_os_buf)・スタックに分類し、
+ *       Core0(入力fsの連結ハーフバンド・ASRC)・DMA(PIO供給)とのバンク競合による待ちサイクルを見積もる。
+ *         既定配置   : 状態・Core0 遅延データ列ともストライプ領域 (Core1 スタックのみ scratch_x)
+ *         バンク配置 : Core1 状態は scratch_x、Core0 遅延データ列は scratch_y (Core1 と競合しない)
+ *       Core0 は入力 48kHz I2S (hbf1~3 + ASRC) の負荷で動作し続けるとし、分担 split = 0/1 毎に出力する。
+ *       見積もり(host/cycle_model.h cyc_sram_stall())のため、実機では UARTコマンド(t) の pcm2pwm / os core1 段で確認する。
+ *       バンク配置の待ちサイクルが既定配置より大きい場合は終了コード1を返す。
+ *       usage : sram_bank_model
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "pdm_output.h"
+#include "dsp.h"
+#include "cycle_model.h"
+
+// pdm_output.c の設定と合わせること
+#define BENCH_OS_INNER_N	4
+#define BENCH_BLOCK_N		8
+#define BENCH_CHUNK_N		48		// PDM_DMA_CHUNK_N
+
+#define MODEL_FS			48000	// Core0 入力fs
+
+// 1サンプル当たりの SRAMアクセス数 (領域別)
+typedef struct {
+	double striped;		// ストライプ領域 (他マスタと競合)
+	double scratch;		// コア専用バンク (競合なし)
+} access_t;
+
+// hbfN 1入力サンプル(L/R)当たりの遅延データ列アクセス (対称タップ対の読出し, 2重化書込み, 中央値読出し)
+static double hbf_z_access(uint stage){
+	uint mac32_n, mac64_n;
+	hbf_get_mac_n(stage, &mac32_n, &mac64_n);
+	return 2.0 * (2 * (mac32_n + mac64_n) * 2 + 2 + 1);
+}
+
+int main(void){
+	bool fail = false;
+
+	host_set_core_num(0);
+	dsp_init();
+
+	os_cost_t cost;
+	for(uint i = 0; i < HBF_STAGE_N; i++){
+		cost.hbf[i][0] = cyc_hbf_stage(i);
+		cost.hbf[i][1] = cyc_hbf_stage_core1(i);
+	}
+	cost.volume = 0;
+	cost.asrc = cyc_asrc();
+
+	printf("pico_1bit_dac_v2 sram_bank_model : CLK_SYS %.1fMHz, Core0 %ukHz I2S (hbf + asrc)\n\n", CLK_SYS / 1e6, MODEL_FS / 1000);
+	printf("  %-7s %-5s | %8s | %8s %8s | %8s %8s | %9s %9s\n", "profile", "split",
+		"cyc", "stall", "stall", "Core1[%]", "Core1[%]", "C0 rate", "C0 rate");
+	printf("  %-7s %-5s | %8s | %8s %8s | %8s %8s | %9s %9s\n", "", "",
+		"(base)", "default", "placed", "default", "placed", "default", "placed");
+
+	const uint fs_o = MODEL_FS * 8;
+	const double budget = cyc_budget(fs_o);
+	for(uint p = 0; p < pcm2pwm_get_profile_n(); p++){
+		host_set_core_num(1);
+		pcm2pwm_init(p);
+		const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(p);
+		const uint bs_n = pcm2pwm_get_bs_n();
+		host_set_core_num(0);
+
+		for(uint split = 0; split <= 1; split++){
+			// Core0 負荷とSRAMアクセス率 (1cycle当たり、hbf1 の構成で代表する)
+			uint load0, load1;
+			cost.pcm2pwm = 0;
+			os_split_load(MODEL_FS, split, &cost, &load0, &load1);
+			const double u0 = (double)load0 * MODEL_FS / CLK_SYS;
+			const double c0 = cyc_hbf_stage(0);
+			const double z0 = hbf_z_access(0) / c0;						// 遅延データ列
+			const double io0 = 6.0 / c0;								// 入力読出し, 出力書込み
+			const double rate0_default = u0 * (CYC_FETCH_RATE + z0 + io0);
+			const double rate0_placed  = u0 * (CYC_FETCH_RATE + io0);
+
+			// DMA : PIO供給 (ストライプ領域の DMAバッファ読出し)
+			const double rate_dma = 2.0 * bs_n / budget;
+
+			// Core1 1サンプル(L/R)当たりのサイクル・アクセス
+			double c1 = 2 * cyc_pcm2pwm_block_prof(prof, BENCH_OS_INNER_N, bs_n, BENCH_BLOCK_N)
+					  + (double)cyc_dma_chunk() / BENCH_CHUNK_N;
+			const double state = 2.0 * ((prof->ds_order + 1) * 2 + 4) / BENCH_BLOCK_N;	// ch[] 復帰・退避
+			const double stack = 2.0 * 12 / BENCH_BLOCK_N;								// 関数呼出し
+			const double q_rd = split ? 1.0 : 2.0;										// キュー読出し (分担時はキューのfs = 1/2)
+			access_t a_def = {.striped = q_rd + 2.0 * bs_n, .scratch = stack};			// キュー読出し, DMAバッファ書込み
+			access_t a_plc = a_def;
+			a_def.striped += state;
+			a_plc.scratch += state;
+			if (split) {
+				// 後段 hbf3 (Core1版) : 192kHz 1サンプル -> 384kHz 2サンプル, pdm_os_buf 書込み・読出し
+				c1 += cyc_hbf_stage_core1(2) / 2.0;
+				const double z1 = hbf_z_access(2) / 2.0;
+				const double os_buf = 2.0 + 2.0;
+				a_def.striped += z1 + os_buf;
+				a_plc.scratch += z1 + os_buf;
+			}
+			a_def.striped += CYC_FETCH_RATE * c1;
+			a_plc.striped += CYC_FETCH_RATE * c1;
+
+			// 他マスタのストライプ1バンク当たりのアクセス率
+			const double stall_def = cyc_sram_stall(a_def.striped, (rate0_default + rate_dma) / 4);
+			const double stall_plc = cyc_sram_stall(a_plc.striped, (rate0_placed  + rate_dma) / 4);
+
+			printf("  %-7u %-5u | %8.1f | %8.2f %8.2f | %8.2f %8.2f | %9.3f %9.3f\n", p, split, c1,
+				stall_def, stall_plc, 100.0 * (c1 + stall_def) / budget, 100.0 * (c1 + stall_plc) / budget,
+				rate0_default, rate0_placed);
+			if (stall_plc > stall_def) fail = true;
+		}
+	}
+	printf("\n  stall   : バンク競合による Core1 待ちサイクル/sample (見積もり)\n");
+	printf("  C0 rate : Core0 のストライプ領域アクセス率 [access/cycle]\n");
+
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file volume_ramp_bench.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 初段統合音量処理(ランプ付き) 処理量・ビット一致・ランプの滑らかさ確認
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 以下を出力する。
+ *        処理量     : volume() + hbf1_x2_oversampler() (別パス) と hbf1_x2_oversampler_vol() (初段統合) の
+ *                     Cortex-M0+ 見積もりサイクル(host/cycle_model.h)・48kHz入力時のCore0負荷・ホスト実測時間
+ *        ビット一致 : 定常状態(ランプなし)で 全入力fsの hbf_oversampler() 出力が volume() + hbf_oversampler() と一致すること
+ *        ランプ     : 48kHz -6dBFS 1kHz cos波を 0dB -> -20dB に切替えた際の 即時 / 直線 / 指数ランプの比較
+ *                       click    : 切替区間の出力2階差分の最大値 (切替前の定常値比[dB])
+ *                       step     : ブロック(8サンプル)毎のゲイン変化の最大値[dB] (DC入力・0段経路で計測)
+ *                       settle   : ランプ終了後のゲインが目標の mul/shift と一致すること
+ *       統合版が別パス版より重い、定常状態でビット一致しない、ランプの click が即時切替より RAMP_MARGIN_DB 以上
+ *       小さくない、または目標ゲインに収束しない場合は終了コード1を返す。
+ *       usage : volume_ramp_bench [repeat]   default 2000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "cycle_model.h"
+#include "bench_util.h"
+
+#define BENCH_VOL_MUL		100		// ビット一致確認・処理量測定の音量 (x100 >> 7)
+#define BENCH_VOL_SHIFT		7
+#define BENCH_PACKETS		100		// ビット一致確認のパケット数
+
+#define RAMP_FS				48000
+#define RAMP_PKT_N			48		// 1パケットのサンプル数 (1ms)
+#define RAMP_SWITCH_PKT		20		// 音量切替パケット (切替前は定常値測定)
+#define RAMP_TOTAL_PKT		40
+#define RAMP_MUL0			128		// 切替前 0dB (x128 >> 7)
+#define RAMP_MUL1			13		// 切替後 -19.9dB (x13 >> 7)
+#define RAMP_SHIFT			7
+#define RAMP_MARGIN_DB		20.0	// ランプの click が即時切替より小さくあるべき量[dB]
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+#define FS_N	(sizeof(fs_list) / sizeof(fs_list[0]))
+
+static int32_t src_buf[RAMP_PKT_N * N_CH];
+static int32_t work_buf[RAMP_PKT_N * N_CH];
+static int32_t out_buf[RAMP_PKT_N * 2 * N_CH];
+static int32_t ref_out[BENCH_PACKETS * QUEUE_WIDTH];
+static int32_t vol_out[BENCH_PACKETS * QUEUE_WIDTH];
+static int32_t ramp_out[RAMP_TOTAL_PKT * QUEUE_WIDTH];
+
+// 入力fs fs で BENCH_PACKETS パケットを処理し 352.8/384kHz 出力を out へ格納する
+// fused : 0 = volume() 別パス, 1 = 初段統合 戻り値 : 出力サンプル数
+static uint run_steady(uint fs, bool fused, int32_t* out){
+	uint64_t phase = 0;
+	uint n_out = 0;
+	srand(1);
+	dsp_reset();
+	volume_reset(fused ? BENCH_VOL_MUL : 1, fused ? BENCH_VOL_SHIFT : 0);
+	for(uint p = 0; p < BENCH_PACKETS; p++){
+		int32_t* buf = get_dsp_buf_pointer(fs);
+		uint len = fs / 1000 + (p % 3 == 0);
+		for(uint i = 0; i < len; i++){
+			// -1dBFS 997Hz + 雑音, 負値の丸め・クリップ付近を含める
+			double s = sin(2.0 * M_PI * 997.0 * (double)phase++ / fs) * (1 << 23) * 0.89 + (rand() % 65536 - 32768);
+			buf[i * 2] = (int32_t)s;
+			buf[i * 2 + 1] = (rand() % (1 << 24)) - (1 << 23);
+		}
+		if (!fused) volume(buf, len, BENCH_VOL_MUL, BENCH_VOL_SHIFT);
+		hbf_oversampler(&buf, &len, fs, &out[n_out * N_CH]);
+		n_out += len;
+	}
+	volume_reset(1, 0);
+	return n_out;
+}
+
+// 48kHz cos波を RAMP_SWITCH_PKT パケット目で音量切替し 384kHz 出力(L)を ramp_out へ格納する
+// type : 0 = 直線ランプ, 1 = 指数ランプ, 2 = 即時切替 戻り値 : 出力サンプル数
+static uint run_ramp(uint type){
+	uint64_t phase = 0;
+	uint n_out = 0;
+	dsp_reset();
+	volume_set_ramp_type(type & 1);
+	volume_reset(RAMP_MUL0, RAMP_SHIFT);
+	for(uint p = 0; p < RAMP_TOTAL_PKT; p++){
+		if (p == RAMP_SWITCH_PKT) {
+			// 切替はcos波の正のピークで行う (即時切替のクリックが最大となる位相)
+			if (type == 2) volume_reset(RAMP_MUL1, RAMP_SHIFT);
+			else           volume_set(RAMP_MUL1, RAMP_SHIFT, RAMP_FS * VOLUME_RAMP_MS / 1000);
+		}
+		int32_t* buf = get_dsp_buf_pointer(RAMP_FS);
+		uint len = RAMP_PKT_N;
+		for(uint i = 0; i < len; i++){
+			int32_t s = (int32_t)(cos(2.0 * M_PI * 1000.0 * (double)phase++ / RAMP_FS) * (1 << 22));	// -6dBFS
+			buf[i * 2] = s;
+			buf[i * 2 + 1] = s;
+		}
+		hbf_oversampler(&buf, &len, RAMP_FS, &ramp_out[n_out * N_CH]);
+		n_out += len;
+	}
+	volume_set_ramp_type(0);
+	volume_reset(1, 0);
+	return n_out;
+}
+
+// ramp_out[from, to) の2階差分の最大値
+static double max_d2(uint from, uint to){
+	double m = 0.0;
+	for(uint i = from + 2; i < to; i++){
+		double d2 = fabs((double)ramp_out[i * N_CH] - 2.0 * ramp_out[(i - 1) * N_CH] + ramp_out[(i - 2) * N_CH]);
+		if (d2 > m) m = d2;
+	}
+	return m;
+}
+
+// DC入力・0段経路(384kHz)でゲイン推移を計測 ランプ長はブロック数を48kHz時と揃える
+// 戻り値 : ブロック毎のゲイン変化の最大値[dB]  *p_settle : ランプ終了後のゲインが目標と一致
+static double gain_trace(uint type, bool* p_settle){
+	const int32_t dc = 1 << 22;
+	const uint fs = 384000;
+	const uint ramp_n = RAMP_FS * VOLUME_RAMP_MS / 1000;
+	double g_prev = 0.0, step_max = 0.0;
+	dsp_reset();
+	volume_set_ramp_type(type);
+	volume_reset(RAMP_MUL0, RAMP_SHIFT);
+	volume_set(RAMP_MUL1, RAMP_SHIFT, ramp_n);
+	*p_settle = true;
+	for(uint p = 0; p < 2 * ramp_n / RAMP_PKT_N + 1; p++){
+		int32_t* buf = get_dsp_buf_pointer(fs);
+		uint len = RAMP_PKT_N;
+		for(uint i = 0; i < len * N_CH; i++) buf[i] = dc;
+		hbf_oversampler(&buf, &len, fs, out_buf);
+		for(uint i = 0; i < len; i++){
+			const uint n = p * RAMP_PKT_N + i;
+			const double g = (double)out_buf[i * N_CH] / dc;
+			if ((n > 0) && (g > 0.0) && (g_prev > 0.0)) {
+				const double step = fabs(20.0 * log10(g / g_prev));
+				if (step > step_max) step_max = step;
+			}
+			g_prev = g;
+			if ((n >= ramp_n) && (out_buf[i * N_CH] != ((dc * RAMP_MUL1) >> RAMP_SHIFT))) *p_settle = false;
+		}
+	}
+	volume_set_ramp_type(0);
+	volume_reset(1, 0);
+	return step_max;
+}
+
+int main(int argc, char* argv[]){
+	uint repeat = (argc > 1) ? (uint)atoi(argv[1]) : 2000;
+	if (repeat == 0) repeat = 1;
+	bool fail = false;
+
+	host_set_core_num(0);
+	dsp_init();
+	queue_init(QUEUE_MODE_ROBUST);
+
+	// 処理量 (1入力サンプル(L/R)当たり)
+	const uint cyc_sep = cyc_volume() + cyc_hbf_stage(0);
+	const uint cyc_fus = cyc_hbf_stage(0) + cyc_volume_fused();
+	const double util_sep = 100.0 * cyc_sep * (double)RAMP_FS / CLK_SYS;
+	const double util_fus = 100.0 * cyc_fus * (double)RAMP_FS / CLK_SYS;
+
+	for(uint i = 0; i < RAMP_PKT_N * N_CH; i++) src_buf[i] = (int32_t)((rand() % (1 << 24)) - (1 << 23));
+	double ns_sep = 0.0, ns_fus = 0.0;
+	for(uint r = 0; r < repeat; r++){
+		uint len = RAMP_PKT_N;
+		memcpy(work_buf, src_buf, sizeof(work_buf));
+		double t0 = now_ns();
+		volume(work_buf, len, BENCH_VOL_MUL, BENCH_VOL_SHIFT);
+		hbf1_x2_oversampler(work_buf, out_buf, &len);
+		double t1 = now_ns();
+		ns_sep += t1 - t0;
+
+		len = RAMP_PKT_N;
+		volume_reset(BENCH_VOL_MUL, BENCH_VOL_SHIFT);
+		memcpy(work_buf, src_buf, sizeof(work_buf));
+		t0 = now_ns();
+		hbf1_x2_oversampler_vol(work_buf, out_buf, &len);
+		t1 = now_ns();
+		ns_fus += t1 - t0;
+	}
+	volume_reset(1, 0);
+	ns_sep /= (double)repeat * RAMP_PKT_N;
+	ns_fus /= (double)repeat * RAMP_PKT_N;
+
+	printf("pico_1bit_dac_v2 volume_ramp_bench : CLK_SYS %.1fMHz, ramp %ums (%u samples @ %ukHz, %u blocks)\n\n",
+		CLK_SYS / 1e6, VOLUME_RAMP_MS, RAMP_FS * VOLUME_RAMP_MS / 1000, RAMP_FS / 1000, RAMP_FS * VOLUME_RAMP_MS / 1000 / 8);
+	printf("cost per input sample (L/R)    %8s %10s %10s\n", "cyc", "Core0[%]", "ns(host)");
+	printf("  volume() + hbf1 (separate)   %8u %10.2f %10.2f\n", cyc_sep, util_sep, ns_sep);
+	printf("  hbf1_vol (fused)             %8u %10.2f %10.2f\n", cyc_fus, util_fus, ns_fus);
+	printf("  saving                       %8d %10.2f\n", (int)cyc_sep - (int)cyc_fus, util_sep - util_fus);
+	if (cyc_fus >= cyc_sep) fail = true;
+
+	// 定常状態のビット一致
+	printf("\nbit-exact (fused vs volume() + hbf_oversampler, steady state)\n ");
+	for(uint f = 0; f < FS_N; f++){
+		const uint fs = fs_list[f];
+		const uint ref_n = run_steady(fs, false, ref_out);
+		const uint out_n = run_steady(fs, true, vol_out);
+		const bool ok = (out_n == ref_n) && (memcmp(ref_out, vol_out, sizeof(int32_t) * ref_n * N_CH) == 0);
+		printf(" %u %s", fs, ok ? "OK" : "NG");
+		if (!ok) fail = true;
+	}
+	printf("\n");
+
+	// ランプの滑らかさ
+	static const char* const type_name[] = {"linear", "exp", "instant"};
+	double click[3];
+	printf("\nramp 0dB -> %.1fdB (48kHz -6dBFS 1kHz)\n", 20.0 * log10((double)RAMP_MUL1 / RAMP_MUL0));
+	printf("  %-8s %10s %10s %7s\n", "type", "click[dB]", "step[dB]", "settle");
+	for(uint type = 0; type < 3; type++){
+		const uint n = run_ramp(type);
+		const uint sw = n * RAMP_SWITCH_PKT / RAMP_TOTAL_PKT;
+		const double d2_ref = max_d2(n / 4, sw);
+		click[type] = 20.0 * log10(max_d2(sw, n) / d2_ref);
+		bool settle = true;
+		const double step = (type < 2) ? gain_trace(type, &settle) : 20.0 * log10((double)RAMP_MUL0 / RAMP_MUL1);
+		printf("  %-8s %10.1f %10.3f %7s\n", type_name[type], click[type], step, settle ? "OK" : "NG");
+		if (!settle) fail = true;
+	}
+	for(uint type = 0; type < 2; type++){
+		if (click[type] > click[2] - RAMP_MARGIN_DB) fail = true;
+	}
+
+	printf("\n%s\n", fail ? "NG" : "OK");
+	return fail ? 1 : 0;
+}
@@ -0,0 +1,454 @@
+/**
+ * @file wav_render.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief WAVファイル -> PWM code列 / 1bitストリーム(DSF) オフライン変換 (ファームウェアDSP処理チェーンをそのまま実行)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 実機で再生音に問題があった音源を、実機と同一の処理でホスト上に再現するためのツール。
+ *       dsp.c / pdm_output.c をinterpモデル上で main.c / pdm_output() と同じ順序で実行するため、出力は実機とビット一致する。
+ *         Core0 スレッド : 1ms パケット毎に volume(hbf_oversampler 初段) -> hbf_oversampler -> (asrc) -> queue_publish
+ *         Core1 スレッド : dequeue -> pcm2pwm_frame (PDM_DMA_CHUNK_N 毎) -> ファイル出力
+ *       Core0/Core1 はキュー(simple_queue.c)で連結した2スレッドで並列に実行する。キュー満杯時は破棄せず空きを待つ。
+ *       pcm2pwm のカーネルは L/R を1回の呼出しで変換する(状態もカーネル内で L/R 共有の配置)ため、L/R のスレッド分割は行わない。
+ *       複数ファイル指定時は -j でファイル単位に並列実行する(ファームウェアの状態は静的変数のため、ファイル毎にプロセスを分ける)。
+ *       入力 : RIFF WAVE (PCM / WAVE_FORMAT_EXTENSIBLE), 1~2ch, 16/24/32bit, fs = 44.1k~384k (dsp.c の対応fs)
+ *              サンプルは USB受信と同じ 24bit 右詰め(16bit は <<8, 32bit は >>8)として処理する。FLAC は非対応(WAVへ変換して使用)
+ *       出力 : <name>.pwm : PWM周期毎の code (uint8, L/R交互)
+ *              <name>.dsf : -d 指定時。PIOの出力ピン(LP/RP)波形を PIOクロック単位の 1bit列とした DSF
+ *                           (pio_pwm_build() の設計 H:L、fs = CLK_SYS/CLOCK_PLAN_PIO_DIV。44.1k系/48k系とも同一クロック)
+ *       ファイル毎に 処理時間・実時間比・code列の FNV-1a ハッシュ(回帰確認用) を表示する。
+ *       ファイル指定なしの場合はベンチマークとして全fsの -6dBFS サイン波 BENCH_SEC 秒を変換し(出力なし)、実時間比を表示する。
+ *       usage : wav_render [-p profile] [-a] [-d] [-o dir] [-j jobs] [file.wav ...]
+ *         -p : 変調プロファイル (default PCM2PWM_PROFILE_DEFAULT)
+ *         -a : I2S入力の処理順 (hbf -> asrc, ピッチ 1.0)。省略時は USB入力の処理順 (hbf の出力をキューへ直接)
+ *         -d : DSF も出力
+ *         -o : 出力ディレクトリ (default 入力ファイルと同じ)
+ *         -j : 並列実行ファイル数 (default 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "clock_plan.h"
+#include "simple_queue.h"
+#include "dsp.h"
+#include "pdm_output.h"
+#include "pio_pwm.h"
+#include "prof.h"
+#include "bench_util.h"
+
+#define RENDER_CHUNK_N		48		// PDM_DMA_CHUNK_N
+#define RENDER_BS_MAX		2		// BS_MAX (pdm_output.c)
+#define RENDER_VOL_MUL		128		// volume 0dB (x128 >> 7)
+#define RENDER_VOL_SHIFT	7
+#define RENDER_ASRC_PITCH	(1u << 22)	// ASRC ピッチ 1.0
+#define DSF_BLOCK_N			4096	// DSF ch毎ブロック長[byte]
+#define BENCH_SEC			10
+
+static const uint fs_list[] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+
+// 変換設定
+typedef struct {
+	uint		profile;
+	bool		asrc_on;
+	bool		dsf;
+	const char*	out_dir;
+} render_opt_t;
+
+// 入力 (WAVファイル or ベンチマーク用サイン波)
+typedef struct {
+	FILE*		fp;				// NULL : サイン波
+	uint		fs;
+	uint		ch_n;
+	uint		bit;			// 16/24/32
+	uint		block;			// 1サンプル(全ch)のバイト数
+	uint64_t	frame_n;		// 総サンプル数
+	uint64_t	frame_rd;
+} render_src_t;
+
+// DSF 出力
+typedef struct {
+	FILE*		fp;
+	uint8_t		blk[N_CH][DSF_BLOCK_N];
+	uint		bit_n;			// ブロック内のビット位置
+	uint64_t	sample_n;		// ch毎のビット数
+} dsf_t;
+
+// 1ファイル分の変換状態 (Core0/Core1 スレッドで共有)
+typedef struct {
+	const render_opt_t*	opt;
+	render_src_t		src;
+	FILE*				pwm_fp;		// NULL : 出力なし
+	dsf_t				dsf;
+	pio_pwm_config_t	pio_cfg;
+	uint				bs_n;
+	volatile bool		core0_done;
+	uint64_t			code_n;		// ch毎
+	uint32_t			hash;		// code列 FNV-1a
+	bool				error;
+} render_t;
+
+static bool fs_supported(uint fs){
+	for(uint i = 0; i < sizeof(fs_list) / sizeof(fs_list[0]); i++){
+		if (fs_list[i] == fs) return true;
+	}
+	return false;
+}
+
+static uint32_t rd_le(const uint8_t* p, uint n){
+	uint32_t v = 0;
+	for(uint i = 0; i < n; i++) v |= (uint32_t)p[i] << (8 * i);
+	return v;
+}
+
+static void wr_le(uint8_t* p, uint64_t v, uint n){
+	for(uint i = 0; i < n; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// RIFF WAVE ヘッダ解析 (data チャンク先頭へ位置付け)
+static bool wav_open(render_src_t* s, const char* path){
+	memset(s, 0, sizeof(*s));
+	s->fp = fopen(path, "rb");
+	if (s->fp == NULL) {
+		fprintf(stderr, "%s : open NG\n", path);
+		return false;
+	}
+	uint8_t h[12];
+	if (fread(h, 1, 12, s->fp) != 12 || memcmp(h, "RIFF", 4) || memcmp(&h[8], "WAVE", 4)) {
+		fprintf(stderr, "%s : not RIFF WAVE\n", path);
+		return false;
+	}
+	bool fmt_ok = false;
+	uint8_t ck[8];
+	while(fread(ck, 1, 8, s->fp) == 8){
+		const uint32_t size = rd_le(&ck[4], 4);
+		if (!memcmp(ck, "fmt ", 4)) {
+			uint8_t f[40] = {0};
+			const uint n = (size < sizeof(f)) ? size : sizeof(f);
+			if (size < 16 || fread(f, 1, n, s->fp) != n) break;
+			fseek(s->fp, (long)(size - n + (size & 1)), SEEK_CUR);
+			uint format = rd_le(&f[0], 2);
+			if (format == 0xfffe && size >= 40) format = rd_le(&f[24], 2);	// WAVE_FORMAT_EXTENSIBLE : SubFormat 先頭
+			s->ch_n = rd_le(&f[2], 2);
+			s->fs = rd_le(&f[4], 4);
+			s->block = rd_le(&f[12], 2);
+			s->bit = rd_le(&f[14], 2);
+			if (format != 1 || s->ch_n < 1 || s->ch_n > N_CH || (s->bit != 16 && s->bit != 24 && s->bit != 32)
+				|| s->block != s->ch_n * s->bit / 8 || !fs_supported(s->fs)) {
+				fprintf(stderr, "%s : unsupported format (format 0x%x, %uch, %ubit, %uHz)\n", path, format, s->ch_n, s->bit, s->fs);
+				return false;
+			}
+			fmt_ok = true;
+		} else if (!memcmp(ck, "data", 4)) {
+			if (!fmt_ok) break;
+			s->frame_n = size / s->block;
+			return true;
+		} else {
+			fseek(s->fp, (long)(size + (size & 1)), SEEK_CUR);
+		}
+	}
+	fprintf(stderr, "%s : fmt/data chunk not found\n", path);
+	return false;
+}
+
+// len サンプルを L,R,L,R,.. 24bit 右詰めで読込み 戻り値:読込みサンプル数
+static uint src_read(render_src_t* s, int32_t* buf, uint len){
+	if (s->frame_n - s->frame_rd < len) len = (uint)(s->frame_n - s->frame_rd);
+	if (s->fp == NULL) {
+		// -6dBFS 997Hz サイン波 (L/R逆相, dsp_bench と同じ)
+		for(uint i = 0; i < len; i++){
+			const double v = sin(2.0 * M_PI * 997.0 * (double)s->frame_rd++ / s->fs) * (double)(1 << 22);
+			*buf++ = (int32_t)v;
+			*buf++ = -(int32_t)v;
+		}
+		return len;
+	}
+	static uint8_t raw[QUEUE_PACKET_MAX * 8 * N_CH * 4];
+	len = (uint)fread(raw, s->block, len, s->fp);
+	for(uint i = 0; i < len; i++){
+		int32_t v[N_CH];
+		for(uint c = 0; c < s->ch_n; c++){
+			const uint8_t* p = &raw[i * s->block + c * s->bit / 8];
+			switch(s->bit){
+				case 16: v[c] = (int32_t)(int16_t)rd_le(p, 2) * (1 << 8); break;
+				case 24: v[c] = (int32_t)(rd_le(p, 3) << 8) >> 8; break;
+				default: v[c] = (int32_t)rd_le(p, 4) >> 8; break;
+			}
+		}
+		*buf++ = v[0];
+		*buf++ = v[s->ch_n - 1];
+	}
+	s->frame_rd += len;
+	return len;
+}
+
+// DSF ヘッダ (DSD chunk 28 + fmt chunk 52 + data chunk header 12)
+static void dsf_header(dsf_t* d, uint32_t fs){
+	uint8_t h[92] = {0};
+	const uint64_t block_n = (d->sample_n + DSF_BLOCK_N * 8 - 1) / (DSF_BLOCK_N * 8);
+	const uint64_t data_size = block_n * DSF_BLOCK_N * N_CH;
+	memcpy(&h[0], "DSD ", 4);
+	wr_le(&h[4], 28, 8);
+	wr_le(&h[12], 92 + data_size, 8);		// file size
+	memcpy(&h[28], "fmt ", 4);
+	wr_le(&h[32], 52, 8);
+	wr_le(&h[40], 1, 4);					// format version
+	wr_le(&h[44], 0, 4);					// DSD raw
+	wr_le(&h[48], 2, 4);					// channel type : stereo
+	wr_le(&h[52], N_CH, 4);
+	wr_le(&h[56], fs, 4);
+	wr_le(&h[60], 1, 4);					// bits per sample : LSB first
+	wr_le(&h[64], d->sample_n, 8);
+	wr_le(&h[72], DSF_BLOCK_N, 4);
+	memcpy(&h[80], "data", 4);
+	wr_le(&h[84], 12 + data_size, 8);
+	fseek(d->fp, 0, SEEK_SET);
+	fwrite(h, 1, sizeof(h), d->fp);
+}
+
+static void dsf_flush(dsf_t* d){
+	for(uint c = 0; c < N_CH; c++) fwrite(d->blk[c], 1, DSF_BLOCK_N, d->fp);
+	memset(d->blk, 0, sizeof(d->blk));
+	d->bit_n = 0;
+}
+
+// ブロック内のビット s ~ e-1 を 1 にする
+static void dsf_set(uint8_t* blk, uint s, uint e){
+	for(; s < e && (s & 7); s++) blk[s >> 3] |= 1u << (s & 7);
+	for(; s + 8 <= e; s += 8) blk[s >> 3] = 0xff;
+	for(; s < e; s++) blk[s >> 3] |= 1u << (s & 7);
+}
+
+// 1 PWM周期 (L パルス中心を周期境界とし、H を周期中央に置く)
+static void dsf_put(dsf_t* d, const pio_pwm_config_t* cfg, bool fs48, const uint8_t* code){
+	const uint cycle = pio_pwm_cycle_clk(cfg, fs48);
+	uint h0[N_CH], h1[N_CH];
+	for(uint c = 0; c < N_CH; c++){
+		const uint h = pio_pwm_high_clk(cfg, code[c], fs48);
+		h0[c] = (cycle - h) / 2;
+		h1[c] = h0[c] + h;
+	}
+	d->sample_n += cycle;
+	if (d->bit_n + cycle <= DSF_BLOCK_N * 8) {
+		for(uint c = 0; c < N_CH; c++) dsf_set(d->blk[c], d->bit_n + h0[c], d->bit_n + h1[c]);
+		d->bit_n += cycle;
+		if (d->bit_n == DSF_BLOCK_N * 8) dsf_flush(d);
+		return;
+	}
+	// ブロック境界を跨ぐ周期
+	for(uint t = 0; t < cycle; t++){
+		for(uint c = 0; c < N_CH; c++){
+			if (t >= h0[c] && t < h1[c]) d->blk[c][d->bit_n >> 3] |= 1u << (d->bit_n & 7);
+		}
+		if (++d->bit_n == DSF_BLOCK_N * 8) dsf_flush(d);
+	}
+}
+
+// Core0 : main.c の受信ループと同じ処理順 (ロバストモード, 1パケット = 1サブフレーム)
+static void* core0_thread(void* arg){
+	render_t* r = (render_t*)arg;
+	const uint fs = r->src.fs;
+	host_set_core_num(0);
+	dsp_reset();
+	volume_reset(RENDER_VOL_MUL, RENDER_VOL_SHIFT);
+	queue_set_tag(os_split_set(fs, 0));
+	for(uint64_t p = 0; ; p++){
+		// USB と同じく 1ms 毎のパケット長 (44.1kHz : 44 x9 + 45)
+		const uint len_p = (uint)((p + 1) * fs / 1000 - p * fs / 1000);
+		int32_t* dsp_buf = get_dsp_buf_pointer(fs);
+		uint len = src_read(&r->src, dsp_buf, len_p);
+		if (len == 0) break;
+		volume_set(RENDER_VOL_MUL, RENDER_VOL_SHIFT, fs * VOLUME_RAMP_MS / 1000);
+
+		int32_t* q_buf;
+		while((q_buf = queue_acquire()) == NULL) sched_yield();		// オフライン変換は破棄せず待つ
+		int32_t* hbf_out = r->opt->asrc_on ? get_dsp_buf_pointer(384000) : q_buf;
+		hbf_oversampler(&dsp_buf, &len, fs, hbf_out);
+		if (r->opt->asrc_on) asrc(&dsp_buf, &len, RENDER_ASRC_PITCH, q_buf);
+		queue_publish(len);
+	}
+	r->core0_done = true;
+	return NULL;
+}
+
+// Core1 : pdm_output() の再生ループと同じく PDM_DMA_CHUNK_N 毎に変換 (ミュート判定なし)
+static void* core1_thread(void* arg){
+	render_t* r = (render_t*)arg;
+	const bool fs48 = get_group_48k(r->src.fs);
+	const uint bit = pcm2pwm_get_profile(r->opt->profile)->pwm_bit;
+	const uint code_n = 4 * r->bs_n;		// 1サンプル当たりの code数 (FIFOワード = 4 code)
+	static uint32_t bs[RENDER_CHUNK_N * RENDER_BS_MAX * N_CH];
+	static uint8_t code[RENDER_CHUNK_N * RENDER_BS_MAX * 4 * N_CH];
+	host_set_core_num(1);
+	pcm2pwm_reset();
+	while(1){
+		int32_t* buf = NULL;
+		uint32_t len = 0;
+		const bool done = r->core0_done;
+		dequeue(&buf, &len);
+		if (buf == NULL) {
+			if (done) break;
+			sched_yield();
+			continue;
+		}
+		for(uint i = 0; i < len; ){
+			const uint n = (len - i < RENDER_CHUNK_N) ? len - i : RENDER_CHUNK_N;
+			const uint plane = pcm2pwm_frame(&buf[i * N_CH], n, bs) / N_CH;
+			uint k = 0;
+			for(uint w = 0; w < plane; w++){
+				for(uint j = 0; j < 4; j++){
+					for(uint c = 0; c < N_CH; c++){
+						const uint8_t v = (uint8_t)((bs[c * plane + w] >> (bit * j)) & ((1u << bit) - 1));
+						code[k++] = v;
+						r->hash = (r->hash ^ v) * 16777619u;
+					}
+					if (r->dsf.fp) dsf_put(&r->dsf, &r->pio_cfg, fs48, &code[k - N_CH]);
+				}
+			}
+			if (r->pwm_fp && fwrite(code, 1, k, r->pwm_fp) != k) r->error = true;
+			r->code_n += (uint64_t)n * code_n;
+			i += n;
+		}
+	}
+	return NULL;
+}
+
+static FILE* open_out(const char* path, const render_opt_t* opt, const char* ext, char* out, uint out_size){
+	const char* base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	const char* dot = strrchr(base, '.');
+	const int base_n = dot ? (int)(dot - base) : (int)strlen(base);
+	if (opt->out_dir) snprintf(out, out_size, "%s/%.*s%s", opt->out_dir, base_n, base, ext);
+	else              snprintf(out, out_size, "%.*s%s", (int)(base - path) + base_n, path, ext);
+	FILE* fp = fopen(out, "wb");
+	if (fp == NULL) fprintf(stderr, "%s : open NG\n", out);
+	return fp;
+}
+
+// 1ファイル(path = NULL : ベンチマーク用サイン波 fs)の変換 戻り値:成否
+static bool render(const char* path, uint fs, const render_opt_t* opt){
+	static render_t r;
+	memset(&r, 0, sizeof(r));
+	r.opt = opt;
+	r.hash = 2166136261u;
+	r.bs_n = pcm2pwm_get_bs_n();
+	char pwm_path[512] = "", dsf_path[512] = "";
+	bool ok = true;
+	if (path) {
+		ok = wav_open(&r.src, path);
+		if (ok) ok = (r.pwm_fp = open_out(path, opt, ".pwm", pwm_path, sizeof(pwm_path))) != NULL;
+		if (ok && opt->dsf) {
+			pio_pwm_param_t param;
+			pio_pwm_param_init(&param, pcm2pwm_get_profile(opt->profile)->pwm_bit, CLOCK_PLAN_PWM_CYCLE_48, CLOCK_PLAN_PWM_CYCLE_44);
+			ok = pio_pwm_build(&r.pio_cfg, &param) && (r.dsf.fp = open_out(path, opt, ".dsf", dsf_path, sizeof(dsf_path))) != NULL;
+			if (ok) dsf_header(&r.dsf, CLK_SYS / CLOCK_PLAN_PIO_DIV);
+		}
+	} else {
+		r.src.fs = fs;
+		r.src.ch_n = N_CH;
+		r.src.frame_n = (uint64_t)fs * BENCH_SEC;
+	}
+
+	double t = now_ns();
+	if (ok) {
+		queue_init(QUEUE_MODE_ROBUST);
+		pthread_t th0, th1;
+		pthread_create(&th1, NULL, core1_thread, &r);
+		pthread_create(&th0, NULL, core0_thread, &r);
+		pthread_join(th0, NULL);
+		pthread_join(th1, NULL);
+		if (r.dsf.fp) {
+			if (r.dsf.bit_n) dsf_flush(&r.dsf);
+			dsf_header(&r.dsf, CLK_SYS / CLOCK_PLAN_PIO_DIV);
+		}
+	}
+	t = (now_ns() - t) * 1e-9;
+
+	if (r.src.fp) fclose(r.src.fp);
+	if (r.pwm_fp && fclose(r.pwm_fp)) r.error = true;
+	if (r.dsf.fp && fclose(r.dsf.fp)) r.error = true;
+	if (!ok) return false;
+	if (r.error) fprintf(stderr, "%s : write NG\n", pwm_path);
+
+	const double sec = (double)r.src.frame_rd / r.src.fs;
+	printf("%-24s %6uHz %2ubit %8.2fs -> %9llu codes/ch, %7.2fs (x%6.1f), hash %08x%s%s\n",
+		path ? path : "(sine -6dBFS)", r.src.fs, path ? r.src.bit : 24, sec, (unsigned long long)r.code_n,
+		t, t > 0 ? sec / t : 0.0, r.hash, path ? "  " : "", pwm_path);
+	return !r.error;
+}
+
+// ファームウェア初期化後、files[k], files[k + step], .. を変換 (files = NULL : 全fsのベンチマーク)
+static bool render_files(char** files, uint file_n, uint k, uint step, const render_opt_t* opt){
+	host_set_core_num(0);
+	dsp_init();
+	prof_init_core();
+	host_set_core_num(1);
+	pcm2pwm_init(opt->profile);
+	prof_init_core();
+
+	bool ok = true;
+	if (files == NULL) {
+		for(uint i = 0; i < sizeof(fs_list) / sizeof(fs_list[0]); i++) ok &= render(NULL, fs_list[i], opt);
+	}
+	for(uint f = k; f < file_n; f += step) ok &= render(files[f], 0, opt);
+	fflush(stdout);
+	return ok;
+}
+
+int main(int argc, char* argv[]){
+	render_opt_t opt = {PCM2PWM_PROFILE_DEFAULT, false, false, NULL};
+	uint jobs = 1;
+	int file_i = argc;
+	for(int i = 1; i < argc; i++){
+		if      (strcmp(argv[i], "-p") == 0 && i + 1 < argc) opt.profile = (uint)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-a") == 0) opt.asrc_on = true;
+		else if (strcmp(argv[i], "-d") == 0) opt.dsf = true;
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) opt.out_dir = argv[++i];
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) jobs = (uint)atoi(argv[++i]);
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "usage : wav_render [-p profile] [-a] [-d] [-o dir] [-j jobs] [file.wav ...]\n");
+			return 1;
+		} else {
+			file_i = i;
+			break;
+		}
+	}
+	if (opt.profile >= pcm2pwm_get_profile_n()) {
+		fprintf(stderr, "profile %u : out of range (0~%u)\n", opt.profile, pcm2pwm_get_profile_n() - 1);
+		return 1;
+	}
+	if (jobs < 1) jobs = 1;
+
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(opt.profile);
+	printf("pico_1bit_dac_v2 wav_render : CLK_SYS = %.1fMHz, profile %u (PWM_BIT = %d, DS_ORDER = %d), %s input\n",
+		CLK_SYS / 1e6, opt.profile, prof->pwm_bit, prof->ds_order, opt.asrc_on ? "I2S (asrc)" : "USB");
+	fflush(stdout);
+
+	// ベンチマーク
+	const uint file_n = (uint)(argc - file_i);
+	if (file_n == 0) return render_files(NULL, 0, 0, 1, &opt) ? 0 : 1;
+
+	// ファイル毎にプロセスを分けて並列実行 (job k はファイル k, k+jobs, ..)
+	if (jobs > file_n) jobs = file_n;
+	if (jobs == 1) return render_files(&argv[file_i], file_n, 0, 1, &opt) ? 0 : 1;
+	for(uint k = 0; k < jobs; k++){
+		const pid_t pid = fork();
+		if (pid == 0) exit(render_files(&argv[file_i], file_n, k, jobs, &opt) ? 0 : 1);
+		if (pid < 0) {
+			fprintf(stderr, "fork NG\n");
+			return 1;
+		}
+	}
+	bool ok = true;
+	int status;
+	while(wait(&status) > 0) ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file iir_coef.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 低遅延オーバーサンプラ iir1~3 (ポリフェーズ全域通過型ハーフバンドIIR) の係数表 (dsp.c)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note host/iir_design -w で生成する。直接編集しないこと。
+ *       hbf1~3 と同じ段毎の仕様(入力fs・通過域端・阻止域減衰量)を満たす最小の全域通過段数 (楕円特性, 次数 2n+1)
+ *       群遅延は DC の値 (通過域端では増加する)
+ *
+ *       stage  fs in   pass[kHz]  spec[dB]  coef  order  att[dB]  delay[us]
+ *       iir1    44100       15.0      75.0     4      9     87.3      28.50
+ *       iir2    88200       20.0      65.0     2      5     66.7       8.72
+ *       iir3   176400       20.0      60.0     2      5     98.1       4.53
+ */
+#ifndef _IIR_COEF_H_
+#define _IIR_COEF_H_
+
+#define IIR_A_BIT		16		// 係数ビット長 (係数 = a * 2^IIR_A_BIT)
+
+// IIRn_A_N : 全域通過段数, IIRn_A : 全域通過係数 偶数番は A0 (偶数番出力)、奇数番は A1 (奇数番出力)
+
+// iir1 : 入力 44.1kHz, 通過域 15.0kHz, 阻止域 75.0dB 以上 (実現 87.3dB)
+#define IIR1_A_N		4
+#define IIR1_A			{3804, 14415, 30375, 51725}
+
+// iir2 : 入力 88.2kHz, 通過域 20.0kHz, 阻止域 65.0dB 以上 (実現 66.7dB)
+#define IIR2_A_N		2
+#define IIR2_A			{8600, 37587}
+
+// iir3 : 入力 176.4kHz, 通過域 20.0kHz, 阻止域 60.0dB 以上 (実現 98.1dB)
+#define IIR3_A_N		2
+#define IIR3_A			{7288, 35288}
+
+#endif
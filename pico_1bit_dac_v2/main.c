@@ -12,19 +12,14 @@
  * 新:  main.c          初期化, USB/I2S処理ブランチ, USB/I2S共通再生処理
  *      usb_audio.c/h   USB 初期化, USB 受信処理
  *      i2s.c/h         I2S 初期化, I2S 受信処理
- *      dsp.c/h         音量, 前段x1~x8オーバーサンプリング, ASRC
+ *      dsp.c/h         音量, 前段x1~x8オーバーサンプリング(直線位相/低遅延), ASRC, Core0/Core1 オーバーサンプリング分担(os_split), DoP入力
  *      bsp.c/h         ボード依存処理・GPIO定義・初期化
+ *      prof.c/h        処理段毎の処理時間計測 (UARTコマンド t で出力)
+ *      asrc_servo.c/h  ASRCピッチ制御 (キュー水位サーボ)
  * 継承:simple_queue.c/h Core0->Core1 PCMデータキュー管理
  *      pdm_output.c/h  後段x8オーバーサンプリング、ΔΣ、PWM出力
  */
 
-// デバッグ時に1とする
-#if 0
-#define DEBUG_PIN(x, y) gpio_put((x), (y))
-#else
-#define DEBUG_PIN(x, y) /*処理なし*/
-#endif
-
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,22 +33,117 @@
 #include "i2s_rx.h"
 #include "dsp.h"
 #include "simple_queue.h"
+#include "asrc_servo.h"
 #include "pdm_output.h"
+#include "prof.h"
 
 audio_state_t audio_state;
 
+// 変調プロファイル一覧表示
+static void print_profiles(void){
+	for(uint i = 0; i < pcm2pwm_get_profile_n(); i++){
+		const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(i);
+		printf("%c%2d: PWM %dbit, DS order %d, %s, %s\n", (i == pdm_output_get_profile()) ? '*' : ' ',
+			i, prof->pwm_bit, prof->ds_order, prof->os_type ? "LI" : "SH", (prof->ds_type == DS_TYPE_CRFB) ? "CRFB" : "CoI");
+	}
+	printf("DS overload reset : %u\n", pcm2pwm_get_overload_n());
+}
+
+// オーバーサンプリングフィルタと入力fsの群遅延表示 (ホスト側の遅延補正用、PCM入力時)
+static void print_os_filter(void){
+	printf("os filter %s", (os_filter_get() == OS_FILTER_LOW_DELAY) ? "low delay" : "linear");
+	if(audio_state.fs) printf(", group delay %.2fus @%dHz", os_get_group_delay_us(audio_state.fs), audio_state.fs);
+	printf("\n");
+}
+
+// UARTコマンド処理 (ノンブロッキング、1行単位)
+//  p    : 変調プロファイル一覧
+//  p<n> : 変調プロファイル n に切り替え (Core1で PIOフェードアウト~再設定~ミュート解除)
+//  f    : オーバーサンプリングフィルタと群遅延を表示
+//  f<n> : オーバーサンプリングフィルタ切替 0:直線位相 1:低遅延 (受信中はフォーマット更新と同じ手順で再設定)
+//  t    : 処理段毎の処理時間集計を出力 (prof.h)
+//  tc   : 処理時間集計をクリア
+static void uart_command(void){
+	static char cmd[8];
+	static uint cmd_len = 0;
+	int c;
+	while((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT){
+		if(c != '\r' && c != '\n'){
+			if(cmd_len < sizeof(cmd) - 1) cmd[cmd_len++] = (char)c;
+			continue;
+		}
+		cmd[cmd_len] = '\0';
+		if(cmd[0] == 'p'){
+			if(cmd[1] == '\0'){
+				print_profiles();
+			} else {
+				uint n = (uint)atoi(&cmd[1]);
+				if(n < pcm2pwm_get_profile_n()){
+					pdm_output_set_profile(n);
+					printf("profile %d\n", n);
+				} else {
+					puts("invalid profile");
+				}
+			}
+		} else if(cmd[0] == 'f'){
+			if(cmd[1] != '\0') os_filter_set((uint)atoi(&cmd[1]));
+			// 受信中はフィルタ残存データ破棄・分担の再選択を行い、フォーマット更新時に表示する
+			if(cmd[1] != '\0' && audio_state.fs) audio_state.format_updated = true;
+			else                                   print_os_filter();
+		} else if(cmd[0] == 't'){
+			if(cmd[1] == 'c'){
+				prof_reset();
+				puts("profile cleared");
+			} else {
+				prof_dump();
+			}
+		}
+		cmd_len = 0;
+	}
+}
+
+// キュースロットのタグ・水位補間レート・ASRCサーボの設定 (フォーマット更新時、DoP/PCM 切替時)
+// fs : Core0 DSP処理の入力fs (DoP は dop_decimator() の出力 352.8/384kHz), split : Core1 分担段数
+// キューのfs = 352.8/384kHz >> split (水位・ASRC出力はキューのfsで数える)
+static void queue_format_set(uint fs, uint split, uint32_t* p_fill_rate){
+	queue_set_tag(os_split_set(fs, split));
+	*p_fill_rate = (uint32_t)get_true_playback_fs(audio_state.group_48k_dac ? 384000 : 352800) >> split;
+	uint frame_len = asrc_servo_frame_len(fs) >> split;	// 1パケット当たりの ASRC 入力サンプル数
+	const queue_mode_t* qm = queue_get_mode();
+	asrc_servo_reset(audio_state.asrc_pitch ? audio_state.asrc_pitch : (1u << ASRC_SERVO_FRAC_BIT),
+		qm->fill_target * frame_len / qm->frame_div, frame_len);
+}
+
+// Core0/Core1 分担選択 pcm2pwm : Core1 の PWM変換サイクル (pdm_output_get_cycle())
+// 未計測(0)の場合は分担なし、低遅延フィルタは os_split_set() で分担なしとなる
+// 負荷に含める前処理 : USB は volume、I2S は asrc
+static uint os_split_choose(uint fs, const os_cost_t* os_cost, uint pcm2pwm){
+	os_cost_t cost = *os_cost;
+	cost.pcm2pwm = pcm2pwm;
+	if(audio_state.source == FROM_I2S_TARGET) cost.volume = 0;
+	else                                      cost.asrc   = 0;
+	return cost.pcm2pwm ? os_split_select(fs, &cost) : 0;
+}
+
 int main(void) {
 	vreg_set_voltage(VREG_VOLTAGE_1_30);	// Core電圧Up 1.1V->1.3V メリット:S/Nが約3dB改善する デメリット:消費電力増(未測定)
 	//  PDM動作に最適なCPU周波数の設定
-    set_sys_clock_khz(CLK_SYS/1000, true);    //  208M8/48k/64 = 67.968->68, 208M8/44k1/64 = 73.979->74 x1.57 Overclock
+    set_sys_clock_pll(CLOCK_PLAN_VCO_HZ, CLOCK_PLAN_POSTDIV1, CLOCK_PLAN_POSTDIV2);	// clock_plan.h  208M8/48k/64 = 67.968->68, 208M8/44k1/64 = 73.979->74 x1.57 Overclock
 
 	all_gpio_init();
     stdio_uart_init();
 //	uart_init(uart0, 1500000);	// 開発用 Baudを高速にしておき、I2S DMAの競合を回避する
 	puts("pico_1bit_dac_v2");
 
-    queue_init();
+	// キュー動作モード選択 起動時の PIN_LOW_LATENCY (GND短絡で低遅延モード)
+	queue_init(get_low_latency_strap() ? QUEUE_MODE_LOW_LATENCY : QUEUE_MODE_ROBUST);
+	printf("queue mode : %s\n", queue_get_mode()->name);
 	dsp_init();
+	prof_init_core();
+
+	// Core0/Core1 オーバーサンプリング分担用 段毎の処理サイクル計測 (Core1 の PWM変換は再生中に計測される)
+	static os_cost_t os_cost;
+	os_split_calibrate(&os_cost);
 
 	// ボードの動作モード設定
 	// VBUS給電時はUSB DAC Mode、VBUS非給電時はHAT DAC Modeとし、モードに応じた初期化を行う
@@ -74,55 +164,139 @@ int main(void) {
 		audio_state.source = FROM_I2S_TARGET;
 	}
 
+	// 変調プロファイル選択 DIP SW (全OFF = 既定プロファイル)、起動後は UARTコマンドで変更可
+	pdm_output_set_profile(pcm2pwm_profile_from_dip(get_dip()));
+	print_profiles();
+
 	// core1(x8OverSampling~ΔΣ~pdm出力)起動
 	multicore_launch_core1(pdm_output);
 
+	uint32_t fill_rate = 383824;	// キュー水位補間用 DAC再生レート[sample/s] (フォーマット更新時に設定)
+	uint os_split_pcm = 0;			// PCM入力時の Core1 分担段数 (フォーマット更新時に選択)
+	bool os_split_pending = false;	// Core1 の PWM変換サイクル未計測のまま分担を選択した (計測後に選び直す)
+	bool dop_on = false;			// DoP(DSD)入力を dop_decimator() で処理中
+
 	// usb_audio/i2s_rx 受信ループ
 	while(1){
 		// usb/i2s irq処理待ち
 		__wfi();
 
+		uart_command();
+
 		// オーディオフォーマット更新時の処理
 		if(audio_state.format_updated) {
 			dsp_reset();	// dsp処理内のフィルタ残存データ破棄
+			if(audio_state.source == FROM_USB) volume_reset(audio_state.vol_mul, audio_state.vol_shift);	// 再生開始時はランプしない
 			set_dac_fs_group_48k(audio_state.group_48k_dac);	// DAC fs変更
-			printf("Format Updated:%6dHz/%2dbit\n", audio_state.fs, audio_state.bit_depth);
+			prof_set_fs(audio_state.fs);
+			// Core0/Core1 分担選択
+			const uint pcm2pwm = pdm_output_get_cycle();
+			uint split = os_split_choose(audio_state.fs, &os_cost, pcm2pwm);
+			os_split_pcm = split;
+			os_split_pending = (pcm2pwm == 0);
+			queue_format_set(audio_state.fs, split, &fill_rate);
+			// DoP はフォーマット更新後のパケットから改めて判定する
+			dop_detect_reset();
+			dop_on = false;
+			printf("Format Updated:%6dHz/%2dbit, os split %d\n", audio_state.fs, audio_state.bit_depth, split);
+			print_os_filter();
+		}
+
+		// 分担の再選択 Core1 の PWM変換サイクルは再生(ミュート解除)後に計測されるため、
+		// 起動後最初のフォーマット更新は分担なしで開始し、計測値が得られた時点で選び直す
+		// Core0 後段の遅延データは以降使わず、Core1 はタグの変化で後段をリセットする。DoP 中は PCM 復帰時に反映する
+		const uint pcm2pwm = os_split_pending ? pdm_output_get_cycle() : 0;
+		if(pcm2pwm) {
+			os_split_pending = false;
+			const uint split = os_split_choose(audio_state.fs, &os_cost, pcm2pwm);
+			if(split != os_split_pcm) {
+				os_split_pcm = split;
+				if(!dop_on) queue_format_set(audio_state.fs, split, &fill_rate);
+				printf("os split %d\n", split);
+			}
 		}
 
 		// オーディオデータ受信時のdsp処理
 		if(audio_state.data_received) {
-			DEBUG_PIN(PIN_GP13, 1);
-
-			int32_t* dsp_buf = audio_state.dsp_buf;
-			uint len = audio_state.len; 
+			uint packet_len = audio_state.len;
 
 			// 音量処理 現状はUSBソースのみ処理
+			// 音量はオーバーサンプラ初段の入力読込み時に処理する。変更時は VOLUME_RAMP_MS でランプする
 			if(audio_state.source == FROM_USB) {
-				volume(dsp_buf, len, audio_state.vol_mul, audio_state.vol_shift);
+				volume_set(audio_state.vol_mul, audio_state.vol_shift, audio_state.fs * VOLUME_RAMP_MS / 1000);
 			}
-			DEBUG_PIN(PIN_GP13, 0);
 
-			// 連結ハーフバンドフィルタによる周波数適応オーバーサンプリング処理
-			hbf_oversampler(&dsp_buf, &len, audio_state.fs);
-			DEBUG_PIN(PIN_GP13, 1);
+			// ASRCピッチ I2S_TARGETソースのみ処理 (パケット毎に1回更新し、全サブフレームに適用する)
+			// キュー水位サーボ : LRCK計測ピッチをフィードフォワードとし、水位を目標(fill_target)に保つようピッチを補正する
+			// (USBソースは Feedback エンドポイントでホストの送出レートを制御する)
+			bool asrc_on = (audio_state.source == FROM_I2S_TARGET);
+			uint32_t pitch = 0;
+			if(asrc_on) {
+				if(asrc_pitch_update()){
+					asrc_servo_set_ff(audio_state.asrc_pitch);
+//					printf("%2d %2d %3d %9.7f %6d\n", get_queue_length(), audio_state.bit_depth, audio_state.fs/1000, (float)audio_state.asrc_pitch/(float)(1<<22), (int32_t)((int64_t)104400000*48000/audio_state.count_long));
+				}
+				int32_t fill;
+				bool playing = queue_get_fill(time_us_32(), fill_rate, &fill);
+				pitch = asrc_servo_update(playing, fill);
+			}
 
-			// キューオーバーフロー救済処置 オーバーフロー水位でデータから1サンプルを間引く
-			uint queue_length = get_queue_length();
-			if( queue_length >= QUEUE_DEPTH - 1){
-				len--;
+			// DoP判定 (176.4/192kHz : DSD64, 352.8/384kHz : DSD128)
+			// DoP は hbf_oversampler の代わりに dop_decimator で 352.8/384kHz へ変換する (音量処理なし、Core1 分担なし)
+			// ロック前・DoP途切れのパケットはミュートし PCM経路で処理する
+			// 切替時はフィルタ残存データを破棄し、キューのタグ(分担)・水位補間レートを切り替える
+			int32_t* const in_buf = get_dsp_buf_pointer(audio_state.fs);
+			const uint dop = dop_detect(in_buf, packet_len, audio_state.fs);
+			if(dop == DOP_MUTE) memset(in_buf, 0, packet_len * N_CH * sizeof(int32_t));
+			if((dop == DOP_DSD) != dop_on) {
+				dop_on = (dop == DOP_DSD);
+				dsp_reset();
+				if(dop_on) queue_format_set(audio_state.fs * (8 / get_osr(audio_state.fs)), 0, &fill_rate);
+				else       queue_format_set(audio_state.fs, os_split_pcm, &fill_rate);
+				printf("%s:%6dHz\n", dop_on ? ((get_osr(audio_state.fs) >= 8) ? "DoP DSD128" : "DoP DSD64") : "PCM", audio_state.fs);
 			}
 
-			// ASRC処理 I2S_TARGETソースのみ処理
-			if(audio_state.source == FROM_I2S_TARGET) {
-				if(asrc_pitch_update()){
-//					printf("%2d %2d %3d %9.7f %6d\n", queue_length, audio_state.bit_depth, audio_state.fs/1000, (float)audio_state.asrc_pitch/(float)(1<<22), (int32_t)((int64_t)104400000*48000/audio_state.count_long));
+			// サブフレーム毎のDSP処理・キュー公開 (ロバストモードは1パケット = 1サブフレーム)
+			// 低遅延モードはパケットを frame_div 分割し、先頭のサブフレームから順に公開して Core1 の再生開始を早める
+			const uint div = queue_get_mode()->frame_div;
+			for(uint j = 0, offset = 0; j < div; j++){
+				const uint end = packet_len * (j + 1) / div;
+				uint len = end - offset;
+				if(len == 0) continue;
+				dsp_buf_advance(audio_state.fs, offset, len);	// サブフレームを入力バッファ先頭へ
+				offset = end;
+				int32_t* dsp_buf = get_dsp_buf_pointer(audio_state.fs);
+
+				// キュー書込みスロット取得 DSP最終段(hbf/asrc)はスロットへ直接出力する
+				// 空きスロットが無い場合(Core1停止時など)はサブフレームを破棄する
+				uint32_t t_enq = prof_now();
+				int32_t* q_buf = queue_acquire();
+				t_enq = prof_now() - t_enq;
+				if(q_buf == NULL) continue;
+
+				// ASRC処理を行う場合は hbf出力を384kHzバッファに置き、asrc がスロットへ出力する
+				int32_t* hbf_out = asrc_on ? get_dsp_buf_pointer(384000) : q_buf;
+
+				// 連結ハーフバンドフィルタによる周波数適応オーバーサンプリング処理 (DoP は DSDデシメーション)
+				if(dop_on) dop_decimator(&dsp_buf, &len, audio_state.fs, hbf_out);
+				else       hbf_oversampler(&dsp_buf, &len, audio_state.fs, hbf_out);
+
+				// キューオーバーフロー救済処置 (USBソース) オーバーフロー水位でデータから1サンプルを間引く
+				// Feedback エンドポイントに従わないホストでも、満杯によるサブフレーム破棄に至る前に サブフレーム当たり1サンプル(キューのfs)ずつ緩やかに吸収する
+				if(!asrc_on && (get_queue_length() >= queue_get_mode()->depth - 1)) {
+					len--;
+				}
+
+				// ASRC処理
+				if(asrc_on) {
+					asrc(&dsp_buf, &len, pitch, q_buf);
 				}
-				asrc(&dsp_buf, &len, audio_state.asrc_pitch);
-			}
 
-			// オーバーサンプリング後のデータをキューに積む
-			enqueue(dsp_buf, len);
-			DEBUG_PIN(PIN_GP13, 0);
+				// オーバーサンプリング後のデータをキューに公開する
+				uint32_t t_pub = prof_now();
+				queue_publish(len);
+				prof_record(PROF_ENQUEUE, (t_enq + prof_now() - t_pub) & PROF_TICK_MASK);
+			}
 
 			// 受信データ処理完了
 			audio_state.data_received = false;
@@ -0,0 +1,181 @@
+# pico_1bit_dac_v2 SRAMバンク配置レポート
+# ファームウェアELFのシンボル表(nm -S)から、処理毎に参照の多い変数(ホットシンボル)の配置バンク・大きさを出力し、
+# bsp.h の配置方針(CORE0_HOT : scratch_y, CORE1_HOT : scratch_x, 大きな領域 : ストライプ)と異なる場合はエラーとする。
+# 上位 CMakeLists.txt からビルド後(POST_BUILD)に実行される。レビュー時は出力 mem_map.txt の差分で配置の変化を確認する。
+#
+# $ cmake -DNM=arm-none-eabi-nm -DELF=pico_1bit_dac_v2.elf -DOUT=mem_map.txt -P mem_map_report.cmake
+# $ cmake -DNM_FILE=nm_output.txt -P mem_map_report.cmake      (nm -S の出力を直接与える場合)
+#
+# RP2040 SRAM
+#   0x20000000 ~ 0x2003ffff : SRAM0~3 ワード単位ストライプ (アドレス bit3:2 がバンク番号)
+#   0x20040000 ~ 0x20040fff : SRAM4 scratch_x (Core1 スタック)
+#   0x20041000 ~ 0x20041fff : SRAM5 scratch_y (Core0 スタック)
+#   0x21000000 ~ 0x2103ffff : SRAM0~3 非ストライプエイリアス (64KB毎に1バンク)
+cmake_minimum_required(VERSION 3.13)
+
+# ホットシンボル  "シンボル 期待配置 用途"  期待配置 : scratch_x / scratch_y / striped  (末尾? : ビルド設定により存在しない場合あり)
+set(MEM_HOT_SYMBOLS
+	"ch                              scratch_x   Core1 ΔΣ状態・直線補間前回値"
+	"pwm_bs                          scratch_x?  Core1 ブロック変換結果 (PDM_FEED_DMA = 0)"
+	"pdm_os_buf                      scratch_x   Core1 後段オーバーサンプリング出力"
+	"hbf1_x2_oversampler_core1_z     scratch_x   Core1 後段 hbf1 遅延データ列"
+	"hbf2_x2_oversampler_core1_z     scratch_x   Core1 後段 hbf2 遅延データ列"
+	"hbf3_x2_oversampler_core1_z     scratch_x   Core1 後段 hbf3 遅延データ列"
+	"hbf1_x2_oversampler_z           scratch_y   Core0 hbf1 遅延データ列"
+	"hbf2_x2_oversampler_z           scratch_y   Core0 hbf2 遅延データ列"
+	"hbf3_x2_oversampler_z           scratch_y   Core0 hbf3 遅延データ列"
+	"hbf_stream_s1                   scratch_y   Core0 ストリーミング中間バッファ"
+	"hbf_stream_s2                   scratch_y   Core0 ストリーミング中間バッファ"
+	"asrc_hist                       scratch_y   Core0 ASRC過去データ"
+	"vol                             scratch_y   Core0 音量ランプ状態"
+	"dsd_z                           scratch_y   Core0 DoP デシメーション遅延データ列"
+	"iir1_x2_oversampler_z           scratch_y   Core0 低遅延 iir1 全域通過段の状態"
+	"iir2_x2_oversampler_z           scratch_y   Core0 低遅延 iir2 全域通過段の状態"
+	"iir3_x2_oversampler_z           scratch_y   Core0 低遅延 iir3 全域通過段の状態"
+	"queue_pool                      striped     Core0->Core1 キュースロット"
+	"dsp_buf_top                     striped     Core0 入力・オーバーサンプリング・ASRC作業領域"
+	"pdm_dma_bs                      striped?    Core1->DMA ピンポンバッファ (PDM_FEED_DMA = 1)"
+	"asrc_sinc_k                     striped     Core0 ASRC sinc係数表"
+	"dsd_lut64                       striped     Core0 DoP DSD64 バイト表"
+	"dsd_lut128                      striped     Core0 DoP DSD128 バイト表"
+)
+
+set(SCRATCH_STACK_SIZE 2048)	# scratch_x/y 各々のスタック (PICO_STACK_SIZE, PICO_CORE1_STACK_SIZE 既定値)
+set(SCRATCH_SIZE 4096)
+
+# シンボル表取得
+if(NM_FILE)
+	file(STRINGS ${NM_FILE} nm_lines)
+else()
+	if(NOT NM OR NOT ELF)
+		message(FATAL_ERROR "mem_map_report : NM, ELF (または NM_FILE) を指定してください")
+	endif()
+	execute_process(COMMAND ${NM} -S ${ELF} OUTPUT_VARIABLE nm_out RESULT_VARIABLE nm_result)
+	if(NOT nm_result EQUAL 0)
+		message(FATAL_ERROR "mem_map_report : ${NM} -S ${ELF} failed")
+	endif()
+	string(REPLACE "\n" ";" nm_lines "${nm_out}")
+endif()
+
+# アドレス -> 配置領域名・バンク
+function(mem_region addr out_region out_bank)
+	math(EXPR a "${addr}")
+	if(a GREATER_EQUAL 536870912 AND a LESS 537133056)			# 0x20000000 ~ 0x2003ffff
+		set(region "striped")
+		set(bank "SRAM0-3")
+	elseif(a GREATER_EQUAL 537133056 AND a LESS 537137152)		# 0x20040000 ~ 0x20040fff
+		set(region "scratch_x")
+		set(bank "SRAM4")
+	elseif(a GREATER_EQUAL 537137152 AND a LESS 537141248)		# 0x20041000 ~ 0x20041fff
+		set(region "scratch_y")
+		set(bank "SRAM5")
+	elseif(a GREATER_EQUAL 553648128 AND a LESS 553910272)		# 0x21000000 ~ 0x2103ffff
+		math(EXPR n "(${a} - 553648128) / 65536")
+		set(region "sram${n}")
+		set(bank "SRAM${n}")
+	elseif(a GREATER_EQUAL 268435456 AND a LESS 536870912)		# 0x10000000 ~ (XIP)
+		set(region "flash")
+		set(bank "XIP")
+	else()
+		set(region "other")
+		set(bank "-")
+	endif()
+	set(${out_region} ${region} PARENT_SCOPE)
+	set(${out_bank} ${bank} PARENT_SCOPE)
+endfunction()
+
+# シンボル名 -> アドレス・大きさ (nm -S : "addr size type name", 大きさのないシンボルは "addr type name")
+foreach(line IN LISTS nm_lines)
+	if(line MATCHES "^([0-9a-fA-F]+) ([0-9a-fA-F]+) [a-zA-Z] ([^ ]+)$")
+		set(sym_addr_${CMAKE_MATCH_3} "0x${CMAKE_MATCH_1}")
+		set(sym_size_${CMAKE_MATCH_3} "0x${CMAKE_MATCH_2}")
+	elseif(line MATCHES "^([0-9a-fA-F]+) [a-zA-Z] ([^ ]+)$")
+		set(sym_addr_${CMAKE_MATCH_2} "0x${CMAKE_MATCH_1}")
+	endif()
+endforeach()
+
+set(report "pico_1bit_dac_v2 SRAM bank placement\n\n")
+string(APPEND report "symbol                          address     size  bank     region     expected   check  usage\n")
+# 列幅
+set(w_sym 32)
+set(w_addr_s 11)
+set(w_size 6)
+set(w_bank 9)
+set(w_region 11)
+set(w_expect 11)
+set(w_check 7)
+set(ng 0)
+set(used_scratch_x 0)
+set(used_scratch_y 0)
+foreach(entry IN LISTS MEM_HOT_SYMBOLS)
+	string(REGEX MATCH "^([^ ]+) +([^ ]+) +(.*)$" m "${entry}")
+	set(sym ${CMAKE_MATCH_1})
+	set(expect ${CMAKE_MATCH_2})
+	set(usage ${CMAKE_MATCH_3})
+	set(optional 0)
+	if(expect MATCHES "\\?$")
+		set(optional 1)
+		string(REGEX REPLACE "\\?$" "" expect ${expect})
+	endif()
+	if(NOT DEFINED sym_addr_${sym})
+		if(optional)
+			set(check "-")
+		else()
+			set(check "NG")
+			set(ng 1)
+		endif()
+		set(addr_s "-")
+		set(size 0)
+		set(bank "-")
+		set(region "(none)")
+	else()
+		mem_region(${sym_addr_${sym}} region bank)
+		math(EXPR size "${sym_size_${sym}}+0")
+		math(EXPR addr_s "${sym_addr_${sym}}" OUTPUT_FORMAT HEXADECIMAL)
+		if(region STREQUAL expect)
+			set(check "OK")
+		else()
+			set(check "NG")
+			set(ng 1)
+		endif()
+		if(region STREQUAL "scratch_x")
+			math(EXPR used_scratch_x "${used_scratch_x} + ${size}")
+		elseif(region STREQUAL "scratch_y")
+			math(EXPR used_scratch_y "${used_scratch_y} + ${size}")
+		endif()
+	endif()
+	foreach(col sym addr_s size bank region expect check)
+		set(v "${${col}}")
+		string(LENGTH "${v}" len)
+		math(EXPR pad "${w_${col}} - ${len}")
+		if(pad LESS 1)
+			set(pad 1)
+		endif()
+		string(REPEAT " " ${pad} sp)
+		if(col STREQUAL "size")
+			string(APPEND report "${sp}${v}  ")
+		else()
+			string(APPEND report "${v}${sp}")
+		endif()
+	endforeach()
+	string(APPEND report "${usage}\n")
+endforeach()
+
+# scratch_x/y の使用量 (ホットシンボル分 + スタック)
+foreach(r scratch_x scratch_y)
+	math(EXPR total "${used_${r}} + ${SCRATCH_STACK_SIZE}")
+	string(APPEND report "\n${r} : hot symbols ${used_${r}} B + stack ${SCRATCH_STACK_SIZE} B = ${total} / ${SCRATCH_SIZE} B")
+	if(total GREATER SCRATCH_SIZE)
+		string(APPEND report "  NG (overflow)")
+		set(ng 1)
+	endif()
+endforeach()
+string(APPEND report "\n")
+
+if(OUT)
+	file(WRITE ${OUT} "${report}")
+endif()
+message("${report}")
+if(ng)
+	message(FATAL_ERROR "mem_map_report : placement regression (see NG above)")
+endif()
@@ -13,6 +13,11 @@
  * 　CPU処理時間に余裕ができ、4次・5次ΔΣ演算が可能となった。
  * 0.4 GPIO Drive strength 初期化ミス修正 GP14,GP16のみ設定→GP14~17を設定
  *     pdm fs設定をbsp.cに移設　
+ * Core0/Core1 分担(dsp.c os_split) : 入力fsにより連結ハーフバンドの後段を Core1 が処理する場合、
+ *     キューのデータは 352.8/384kHz >> split となり、PDM_FEED_N 毎に hbf_oversampler_core1() で 352.8/384kHz としてから変換する。
+ * ΔΣループフィルタ構成(ds_type) : 従来の積分器縦続(CoI)に加え、係数・共振器付き(CRFB)をプロファイルで選択できる。
+ *     CRFB は NTF零点を帯域内に分散して同じ次数の CoI より帯域内雑音を下げ、||h||1 を抑えて大振幅でも安定とする。
+ *     積分器過負荷時は積分器をリセットする。
  */
 
 #include <stdio.h>
@@ -21,11 +26,17 @@
 //#include "pico/stdlib.h"
 //#include "pico/platform.h"
 #include "hardware/interp.h"
+#if !PICO_NO_HARDWARE	// ホストビルド(host/)ではPIO出力部を除外し、PWM変換部のみをビルドする
 #include "hardware/pio.h"
+#include "hardware/dma.h"
 #include "hardware/clocks.h"
+#endif
 
 #include "bsp.h"
 #include "simple_queue.h"
+#include "pdm_output.h"
+#include "dsp.h"
+#include "prof.h"
 
 #if 0 /*PWM/PDM処理時間計測時に使用*/
 #define DEBUG_PIN_PUT(x, y) gpio_put((x), (y))
@@ -37,42 +48,89 @@
 #define DEBUG_PIN_CLR(pin)	/*処理なし*/
 #endif
 
-#define PWM_BIT	6	// PWM分解能(4~6) 4~5:4~5bit(cycle = 3.072M) 6:6bit(cycle = 1.536M)
-#define DS_ORDER 5	// ΔΣ次数(0~5) 設定値は PWM_BIT > DS_ORDER とすること
-#define OS_TYPE 1	// x8オーバサンプラ動作選択 0:SH(SampleHold) 1:LinerInterpolator(直線補間)
+#define DS_ORDER_MAX 7		// ΔΣ次数の上限(カーネル生成可能範囲)
+#define PCM2PWM_BLOCK_N 8	// ブロック変換のサンプル数 Lch変換中にPIO TX FIFO(8段)が空にならないこと
 
 // 定数群
 const uint	os_inner_loop_n = 4;			// Interpで処理するループ回数(bit長にかかわらず4回に固定) 
 const uint	ds_bitshift = 7;				// ΔΣ処理ビット長 ― 音源ビット長 = 31 - 24 = 7
-const uint32_t pwm_mask = ((int32_t)0x80000000) >> (PWM_BIT - 1);	// Ex. PWM_BIT = 5 ; pwm_mask = 0xf8000000
-const uint32_t pwm_bitshift = 32 - PWM_BIT * os_inner_loop_n;	// full bit - working pwm bit 
-
-#if   (PWM_BIT == 4)
-  #include "pio_pwm_4bit.pio.h"
-  const uint os_bitshift = 3;	// 2^os_bitshift = x8
-  const uint os_outer_loop_n = 8 / os_inner_loop_n;	// x8 OverSampling / 8
-#elif (PWM_BIT == 5)
-  #include "pio_pwm_5bit.pio.h"
-  const uint os_bitshift = 3;	// 2^os_bitshift = x8
-  const uint os_outer_loop_n = 8 / os_inner_loop_n;	// x8 OverSampling / 4
-#elif (PWM_BIT == 6)
-  #include "pio_pwm_6bit.pio.h"
-  const uint os_bitshift = 2;	// 2^os_bitshift = x4
-  const uint os_outer_loop_n = 4 / os_inner_loop_n;	// x4 OverSampling / 4
-#endif
 
-#define DS_MAX	(DS_ORDER + 1)	// ΔΣレジスタワークの最大数(最大のΔΣ次数)
-#define BS_MAX	2				// ビットストリームデータ最大段数
+#include "pio_pwm.h"
+
+// PWM分解能毎の定数 4~5bit : x8 (cycle = 3.072M), 6bit : x4 (cycle = 1.536M)
+static inline uint32_t pwm_get_mask(uint pwm_bit){			// Ex. pwm_bit = 5 ; pwm_mask = 0xf8000000
+	return ((int32_t)0x80000000) >> (pwm_bit - 1);
+}
+static inline uint32_t pwm_get_bitshift(uint pwm_bit){		// full bit - working pwm bit
+	return 32 - pwm_bit * os_inner_loop_n;
+}
+static inline uint pwm_get_os_bitshift(uint pwm_bit){		// 2^os_bitshift = x8/x4
+	return (pwm_bit == 6) ? 2 : 3;
+}
+static inline uint pwm_get_outer_loop_n(uint pwm_bit){		// x8/x4 OverSampling / os_inner_loop_n
+	return (1u << pwm_get_os_bitshift(pwm_bit)) / os_inner_loop_n;
+}
+static inline uint32_t pwm_get_sign_mask(uint pwm_bit){	// 出力ワード(4データ)の各PWMデータ最上位ビット Ex. pwm_bit = 5 ; 0x00084210
+	uint32_t m = 0;
+	for(uint k = 0; k < os_inner_loop_n; k++) m |= 1u << (k * pwm_bit + pwm_bit - 1);
+	return m;
+}
+
+#define DS_MAX	(DS_ORDER_MAX + 1)	// ΔΣレジスタワークの最大数(最大のΔΣ次数)
+#define BS_MAX	2				// ビットストリームデータ最大段数(1サンプル1ch当たり)
+
+/* CRFB ループフィルタ係数 [pwm_bit - 4][ds_order]
+ 積分器は全段とも量子化値を帰還し(CoI と同じ)、段間係数 c[n] と共振器係数 g[n] で NTF を与える。
+   ds[1] += x - qt - g[1] * ds[2]
+   ds[n] += c[n] * ds[n-1] - (qt >> qt_shift[n]) - g[n] * ds[n+1]     (n = 2~ds_order, ds[n+1] は前回値)
+   量子化器入力 = ds[ds_order]
+ NTF は帯域(20kHz)内に零点を最適配置し、極は最大平坦高域通過型とした(Schreier の ΔΣ設計法 synthesizeNTF 相当)。
+ 帯域外利得は NTF インパルス応答の絶対値和 ||h||1 が 1 + 2^(pwm_bit-2) 以下となる範囲で最大とし、
+ 0dBFS(量子化器範囲の1/2)入力で量子化器入力が範囲の3/4を超えないようにした。
+ 2段目の積分器は 0dBFS 入力で量子化器範囲の2~3倍に達するため、qt_shift[2] = 2 で 1/4 にスケーリングした。
+ (前後の c[n], g[n] は 4倍・1/4倍して同じ NTF とする。+2.9dBFS(量子化器範囲の0.7)入力まで全積分器が int32 に収まることを確認した)
+ 係数は2のべき乗または2項の和(シフト・加算のみ、乗算なし)に丸め、丸め後の NTF で零点・||h||1 を確認した。
+ OSR : 6bit 1.536MHz/40kHz = 38.4, 4~5bit 3.072MHz/40kHz = 76.8
+ 帯域内雑音(量子化ステップ比, 線形モデル) : 括弧内は同じ PWM分解能の CoI
+   6bit 4次 -127.0dB (4次 -112.4dB, 5次 -135.0dB)  ||h||1 14.8
+   6bit 3次 -103.5dB (3次  -89.6dB)                 ||h||1 14.8
+   5bit 4次 -144.5dB (4次 -139.6dB)                 ||h||1  7.3
+   5bit 3次 -120.6dB (3次 -110.7dB)                 ||h||1  8.7
+   4bit 3次 -112.6dB (3次 -110.7dB)                 ||h||1  4.7
+*/
+static const ds_crfb_t ds_crfb[3][DS_CRFB_ORDER_MAX + 1] = {
+	[0][3] = {3, .c = {[2] = {1, 2}, [3] = {2, 0}},                .g = {[2] = {1, 11}},                .qt_shift = {[2] = 2}},	// 4bit 3次
+	[1][3] = {3, .c = {[2] = {5, 3}, [3] = {2, 0}},                .g = {[2] = {1, 11}},                .qt_shift = {[2] = 2}},	// 5bit 3次
+	[1][4] = {4, .c = {[2] = {1, 2}, [3] = {2, 0}, [4] = {1, 0}},  .g = {[1] = {1, 10}, [3] = {1, 10}}, .qt_shift = {[2] = 2}},	// 5bit 4次
+	[2][3] = {3, .c = {[2] = {1, 0}, [3] = {2, 0}},                .g = {[2] = {1,  9}},                .qt_shift = {[2] = 2}},	// 6bit 3次
+	[2][4] = {4, .c = {[2] = {1, 0}, [3] = {1, 0}, [4] = {5, 2}},  .g = {[1] = {1, 10}, [3] = {1,  8}}, .qt_shift = {[2] = 2}},	// 6bit 4次
+};
+
+// CRFB 係数設計の取得 設計がない組み合わせは NULL
+const ds_crfb_t* pcm2pwm_get_crfb(uint pwm_bit, uint ds_order){
+	if (pwm_bit < 4 || pwm_bit > 6 || ds_order > DS_CRFB_ORDER_MAX) return NULL;
+	const ds_crfb_t* k = &ds_crfb[pwm_bit - 4][ds_order];
+	return (k->order != 0) ? k : NULL;
+}
+
+// CRFB 積分器過負荷検出 量子化器入力が量子化器範囲の DS_OVL_LIM を超えたら過負荷として積分器をリセットする
+// 0dBFS 入力時の量子化器入力は ||h||1 の条件から範囲の1/2 + 帯域外雑音のため、3/4 を超えることはない
+#define DS_OVL_LIM	0x60000000u	// 量子化器範囲(±2^31)の 3/4
+static volatile uint pcm2pwm_overload_n = 0;	// 過負荷リセット回数 (Core1 で更新)
+
+uint pcm2pwm_get_overload_n(void){
+	return pcm2pwm_overload_n;
+}
 
 // PWM変換処理構造体定義・宣言
 typedef struct {
 	uint32_t	ds[DS_MAX];		// ΔΣレジスタワーク 処理終了時に退避、処理再開時に復帰利用 OB(Offset Binary)処理に伴い int->uintに変更
-	uint32_t	bs[BS_MAX];		// ビットストリーム 時刻順：LSB First,pdm[0]->pdm[1]
 	int32_t		d1;				// 前回入力データ 線形補間用
 } pcm2pwm_arg_t;
 
-static pcm2pwm_arg_t ch[N_CH];	// L/R Channel PWM変換処理構造体
+static pcm2pwm_arg_t CORE1_HOT("pdm") ch[N_CH];	// L/R Channel PWM変換処理構造体 (Core1 専用バンク)
 static uint32_t ds_pwm_offset;	// ΔΣ/PWM OB(Offset Binary)演算用加算値
+static const pcm2pwm_profile_t* pwm_prof;	// 選択中の変調プロファイル
 
 // PWM変換初期化
 // PWM変換処理構造体のゼロクリアを行う
@@ -88,7 +146,11 @@ void pcm2pwm_reset(void){
 }
 
 // PWM変換処理初期化
-void pcm2pwm_init(uint pwm_bit){
+// profile : 変調プロファイル番号 (pcm2pwm_get_profile_n() 未満、範囲外は既定プロファイル)
+void pcm2pwm_init(uint profile){
+	pwm_prof = pcm2pwm_get_profile(profile);
+	if (pwm_prof == NULL) pwm_prof = pcm2pwm_get_profile(PCM2PWM_PROFILE_DEFAULT);
+	const uint pwm_bit = pwm_prof->pwm_bit;
 
 	// DS/PWM OB演算用オフセット
 	// MSB=1で加算で符号反転する PWMタイプによっては
@@ -102,20 +164,12 @@ void pcm2pwm_init(uint pwm_bit){
 	cfg = interp_default_config();                  // set default config
 	interp_config_set_add_raw(&cfg, true);          // Use ADD_RAW path (as accum[0] += base[0]) 
 	interp_config_set_shift(  &cfg, 0);             // Setting the bit width increased by the Interp processing
-	interp_config_set_mask(   &cfg, 0, 31);         // Setting the 	ch0.d1 = 0;
-	// ΔΣワーククリア
-	for(uint k = 0; k < DS_MAX; k++){
-		ch0.ds[k] = 0;
->>>>>>> HEAD
-e sign-e	ch[0].d1 = 0;
-	ch[1].d1 = 0;	
-	// ΔΣワーククリア
-	for(uint k = 0; k < DS_MAX; k++){
-		ch[0].ds[k] = 0;
-		ch[1].ds[k] = 0;
->>>>>>> 847e407
-                       // Reset
-	interp0->base[2] = ds_pwm_offset;               // DS/PWM OB演算用オフセット
+	interp_config_set_mask(   &cfg, 0, 31);         // Setting the mask (no mask)
+	interp_config_set_signed( &cfg, true);          // Use sign-extended
+	interp_set_config(interp0, 0, &cfg);            // Set interp0 lane0
+	interp0->accum[0] = 0;                          // Reset
+	interp0->base[0]  = 0;                          // Reset
+	interp0->base[2] = (pwm_prof->ds_type == DS_TYPE_CRFB) ? 0 : ds_pwm_offset;	// DS/PWM OB演算用オフセット (CRFB は符号付きで演算する)
 
 	// Interp0 Lane1 : アイドルトーン拡散
 	// 微弱な矩形波(24bitデータのLSB以下)を生成、
@@ -126,7 +180,7 @@ e sign-e	ch[0].d1 = 0;
 	interp_config_set_mask(   &cfg, 6, 6);          // Mask Only bit 6
 	interp_config_set_signed( &cfg, false);         // Use sign-extended
 	interp_set_config(interp0, 1, &cfg);            // Set interp0 lane1
-	interp0->base[1] = 1;                           // Delta Data
+	interp0->base[1] = N_CH;                        // Delta Data (ch毎のブロック変換のため N_CH 倍速で進める)
 	interp0->accum[1]= 0;                           // Start Data
 
 	////////////////////////////////////////////////// interp1 lane0 : the quantizer
@@ -153,76 +207,251 @@ e sign-e	ch[0].d1 = 0;
 }
 
 
-static inline void pcm2pwm(int32_t d0, pcm2pwm_arg_t *ch)
-{
-// x8オーバーサンプラー初期設定
-#if (OS_TYPE == 0)		// SH(サンプルホールド型)
-  interp0->accum[0] = d0 << ds_bitshift;
-  interp0->base[0] = 0;
-#elif (OS_TYPE == 1)	// Liner-Interpolator(直線補間型)
-  interp0->accum[0] = ch->d1 << ds_bitshift;
-  interp0->base[0] = (d0 - ch->d1) << (ds_bitshift - os_bitshift);
-  ch->d1 = d0;
+#if !PICO_NO_HARDWARE
+// pio0 sm0/sm1 fifo 最適化アクセス関数
+// sm0/sm1引数チェック削除とFIFOチェック統合により
+// sm0/sm1間の設定ラグタイムを極力排除する
+#define SM0_SM1_TXFULL (3u << PIO_FSTAT_TXFULL_LSB)
+static inline void pio0_sm01_put_blocking(
+	uint32_t ch0_data,
+	uint32_t ch1_data
+){
+#if 1	// 高速アクセス版
+	// sm0/sm1 FIFO FULL 解除待ちループ
+	while((pio0->fstat & SM0_SM1_TXFULL) != 0){
+		tight_loop_contents();
+	}
+	// sm0/sm1 FIFO レジスタへの連続書き込み
+	pio0->txf[0] = ch0_data;	
+	pio0->txf[1] = ch1_data;
+#else	// 従来版
+	pio_sm_put_blocking(pio0, 0, ch0_data);
+	pio_sm_put_blocking(pio0, 1, ch1_data);
 #endif
-
-  // Pre_Process : Set previous delta-sigma values to interp
-  interp1->base[1] = ch->ds[0];
-
-  uint32_t qt_out;
-    // Delta-Sigma & Bitstream Process 
-    for(uint j = 0; j < os_outer_loop_n; j++){
-      for(uint k = 0; k < os_inner_loop_n; k++){
-        // Dummy read & Get Quantized Data 
-        qt_out = interp1->pop[0];
-        qt_out = interp1->peek[0];
-#if   (DS_ORDER == 0)	// ΔΣなし
-        // d/s (delta-sigma) 
-        // set d/s data to Bitstreamer/Quantizer
-        interp1->base[1] = interp0->pop[2] & pwm_mask;
-#elif (DS_ORDER == 1)	// 1次ΔΣ
-        // d/s (delta-sigma) 
-        ch->ds[1] += -qt_out +interp0->pop[2];
-        // set d/s data to Bitstreamer/Quantizer
-        interp1->base[1] = ch->ds[1] & pwm_mask;
-#elif (DS_ORDER == 2)	// 2次ΔΣ
-        // d/s (delta-sigma) 
-        ch->ds[1] += -qt_out +interp0->pop[2];
-        ch->ds[2] += -qt_out +ch->ds[1];
-        // set d/s data to Bitstreamer/Quantizer
-        interp1->base[1] = ch->ds[2] & pwm_mask;
-#elif (DS_ORDER == 3)	// 3次ΔΣ
-        // d/s (delta-sigma) 
-        ch->ds[1] += -qt_out +interp0->pop[2];
-        ch->ds[2] += -qt_out +ch->ds[1];
-        ch->ds[3] += -qt_out +ch->ds[2];
-        // set d/s data to Bitstreamer/Quantizer
-        interp1->base[1] = ch->ds[3] & pwm_mask;
-#elif (DS_ORDER == 4)	// 4次ΔΣ
-        // d/s (delta-sigma) 
-        ch->ds[1] += -qt_out +interp0->pop[2];
-        ch->ds[2] += -qt_out +ch->ds[1];
-        ch->ds[3] += -qt_out +ch->ds[2];
-        ch->ds[4] += -qt_out +ch->ds[3];
-        // set d/s data to Bitstreamer/Quantizer
-        interp1->base[1] = ch->ds[4] & pwm_mask;
-#elif (DS_ORDER == 5)	// 5次ΔΣ
-        // d/s (delta-sigma) 
-        ch->ds[1] += -qt_out +interp0->pop[2];
-        ch->ds[2] += -qt_out +ch->ds[1];
-        ch->ds[3] += -qt_out +ch->ds[2];
-        ch->ds[4] += -qt_out +ch->ds[3];
-        ch->ds[5] += -qt_out +ch->ds[4];
-        // set d/s data to Bitstreamer/Quantizer
-        interp1->base[1] = ch->ds[5] & pwm_mask;
+}
+#define PCM2PWM_PIO_PUT(l, r)	pio0_sm01_put_blocking((l), (r))
+#else
+#define PCM2PWM_PIO_PUT(l, r)	/*処理なし ホストビルドではPIO出力しない*/
 #endif
-      }
-      // get final PWM Data(4-data/32bit)
-      ch->bs[j] = (interp1->peek[1] >> pwm_bitshift);
-    }
-    // Post process : Save final delta-sigma values
-    ch->ds[0] = interp1->base[1];
+
+/* ブロック単位PWM変換
+ 1ch分の連続 len サンプルを一括してPWM変換する。
+ ΔΣ積分器・直線補間の前回値はローカル変数(レジスタ)に保持し、構造体への退避・復帰と
+ interp0/interp1 の再設定はブロックの前後で1回のみ行う。
+ interp0 lane0(直線補間)の accum[0] は1サンプル分の補間(x4/x8)を終えると次サンプルの始点 d0<<ds_bitshift に
+ 一致するため、サンプル毎の再設定は不要となり base[0](傾き)のみ更新する。
+ interp0 lane1(アイドルトーン拡散)はL/Rで共用のため、ブロック開始時の値を揃え、サンプル毎の進みを
+ N_CH倍(base[1] = N_CH)としてサンプル単位処理時と同一の拡散パターンを得る。
+ p_i は L/R インターリーブ配置(N_CH ワード間隔)、p_bs は ch毎の連続配置(L/R別面)でアクセスする。
+ (ch毎の面を DMA で sm0/sm1 へそのまま転送できる)
+ pio_feed = true の場合、各サンプルのPWM変換後に他chの変換済データ(p_pair)と組にしてPIOへ出力する。
+ (Lch をブロック変換後、Rch のブロック変換と並行してPIOへ供給する)
+ pwm_bit, ds_order, os_type, ds_type は定数で呼び出し、プロファイル毎に特殊化したカーネルを生成する。
+ ds_type = DS_TYPE_CRFB の場合、オーバーサンプラ出力・量子化値・積分器は符号付き(2の補数)で演算し、
+ ビットストリームは出力ワード毎に各PWMデータの最上位ビットを反転して OB(Offset Binary) とする。
+ 積分器過負荷は入力1サンプル毎に量子化器入力で判定する。
+*/
+// CRFB 係数演算 (v >> shift) * mul  係数は定数のため、シフト・加算に展開される
+static inline __attribute__((always_inline)) uint32_t ds_mul(uint32_t v, const ds_coef_t k){
+	return (uint32_t)((int32_t)v >> k.shift) * (uint32_t)(int32_t)k.mul;
+}
+
+// CRFB 積分器更新 (x : オーバーサンプラ出力, qt : 前回の量子化値) 戻り値 : 量子化器入力
+static inline __attribute__((always_inline)) uint32_t ds_crfb_step(uint32_t* ds, uint32_t x, uint32_t qt, const ds_crfb_t* k, const uint ds_order){
+	#pragma GCC unroll 8
+	for(uint n = 1; n <= ds_order; n++){
+		uint32_t in = (n == 1) ? x : ds_mul(ds[n - 1], k->c[n]);
+		if ((n < ds_order) && (k->g[n].mul != 0)) in -= ds_mul(ds[n + 1], k->g[n]);
+		ds[n] += in - (uint32_t)((int32_t)qt >> k->qt_shift[n]);
+	}
+	return ds[ds_order];
+}
+
+static inline __attribute__((always_inline)) void pcm2pwm_block(
+	const int32_t* p_i,		// PCM入力 (N_CH ワード間隔)
+	uint32_t* p_bs,			// ビットストリーム出力 (当該chの面)
+	const uint32_t* p_pair,	// 他chのビットストリーム (pio_feed時にLchとして出力)
+	uint len,				// サンプル数
+	pcm2pwm_arg_t *ch,		// ch状態
+	bool pio_feed,			// PIO出力を行う (Rch処理時のみ)
+	const uint pwm_bit,		// PWM分解能(4~6)
+	const uint ds_order,	// ΔΣ次数(0~DS_ORDER_MAX)
+	const uint os_type,		// x8/x4オーバサンプラ 0:SH(SampleHold) 1:LinerInterpolator(直線補間)
+	const uint ds_type		// ΔΣループフィルタ構成 DS_TYPE_COI / DS_TYPE_CRFB
+){
+	const uint32_t pwm_mask = pwm_get_mask(pwm_bit);
+	const uint32_t bs_sign = (ds_type == DS_TYPE_CRFB) ? pwm_get_sign_mask(pwm_bit) : 0;	// 出力ワードの OB変換
+	const ds_crfb_t* crfb = (ds_type == DS_TYPE_CRFB) ? &ds_crfb[pwm_bit - 4][ds_order] : NULL;
+	const uint32_t pwm_bitshift = pwm_get_bitshift(pwm_bit);
+	const uint os_bitshift = pwm_get_os_bitshift(pwm_bit);
+	const uint os_outer_loop_n = pwm_get_outer_loop_n(pwm_bit);
+
+	uint32_t ds[DS_MAX];	// ΔΣレジスタワーク (レジスタ割付)
+	#pragma GCC unroll 8
+	for(uint n = 0; n <= ds_order; n++) ds[n] = ch->ds[n];
+	int32_t d1 = ch->d1;
+
+	// Pre_Process : 前回のΔΣ値・補間始点を interp に設定
+	if (os_type == 0) {		// SH(サンプルホールド型)
+		interp0->base[0] = 0;
+	} else {				// Liner-Interpolator(直線補間型)
+		interp0->accum[0] = d1 << ds_bitshift;
+	}
+	interp1->base[1] = ds[0];
+
+	while(len--){
+		int32_t d0 = *p_i;
+		p_i += N_CH;
+		// x8オーバーサンプラー設定
+		if (os_type == 0) {		// SH(サンプルホールド型)
+			interp0->accum[0] = d0 << ds_bitshift;
+		} else {				// Liner-Interpolator(直線補間型)
+			interp0->base[0] = (d0 - d1) << (ds_bitshift - os_bitshift);
+			d1 = d0;
+		}
+		// Delta-Sigma & Bitstream Process
+		for(uint j = 0; j < os_outer_loop_n; j++){
+			#pragma GCC unroll 8
+			for(uint k = 0; k < os_inner_loop_n; k++){
+				// Dummy read & Get Quantized Data
+				uint32_t qt_out = interp_pop_lane_result(interp1, 0);
+				qt_out = interp_peek_lane_result(interp1, 0);
+				uint32_t x = interp_pop_full_result(interp0);
+				if (ds_order > 0 && ds_type == DS_TYPE_CRFB) {	// N次ΔΣ CRFB
+					x = ds_crfb_step(ds, x, qt_out, crfb, ds_order);
+				} else if (ds_order > 0) {	// N次ΔΣ ds[n] += -qt + ds[n-1]  (ds_order = 0 : ΔΣなし)
+					ds[1] += -qt_out + x;
+					#pragma GCC unroll 8
+					for(uint n = 2; n <= ds_order; n++) ds[n] += -qt_out + ds[n - 1];
+					x = ds[ds_order];
+				}
+				// set d/s data to Bitstreamer/Quantizer
+				interp1->base[1] = x & pwm_mask;
+			}
+			// get final PWM Data(4-data/32bit)
+			p_bs[j] = (interp_peek_lane_result(interp1, 1) >> pwm_bitshift) ^ bs_sign;
+		}
+		// CRFB 積分器過負荷 : 量子化器入力(最後の x)が ±DS_OVL_LIM を超えたら積分器をリセットする
+		if (ds_order > 0 && ds_type == DS_TYPE_CRFB && ((int32_t)ds[ds_order] + DS_OVL_LIM) > 2 * DS_OVL_LIM) {
+			#pragma GCC unroll 8
+			for(uint n = 1; n <= ds_order; n++) ds[n] = 0;
+			pcm2pwm_overload_n++;
+		}
+		if (pio_feed) {
+			DEBUG_PIN_SET(PIN_PIOT_MEASURE);		// テスト用 pio設定前にH。pioに待たされている時刻測定用
+			for(uint j = 0; j < os_outer_loop_n; j++){
+				PCM2PWM_PIO_PUT(p_pair[j], p_bs[j]);	// LCh/RCh Bitstream を PIO PWMへ出力
+			}
+			DEBUG_PIN_CLR(PIN_PIOT_MEASURE);		// テスト用 pio設定後にL。pioに待たされている時刻測定用
+			p_pair += os_outer_loop_n;
+		}
+		p_bs += os_outer_loop_n;
+	}
+
+	// Post process : Save final delta-sigma values
+	ds[0] = interp1->base[1];
+	#pragma GCC unroll 8
+	for(uint n = 0; n <= ds_order; n++) ch->ds[n] = ds[n];
+	ch->d1 = d1;
+}
+
+// L/R ブロック変換 buf(L,R,L,R,..) len サンプルを PCM2PWM_BLOCK_N 毎に Lch -> Rch の順で変換する
+// 変換結果は bs_l/bs_r に ch毎に時刻順で格納する
+static inline __attribute__((always_inline)) void pcm2pwm_stereo(
+	const int32_t* buf, uint len, uint32_t* bs_l, uint32_t* bs_r, bool pio_feed,
+	const uint pwm_bit, const uint ds_order, const uint os_type, const uint ds_type
+){
+	while(len){
+		uint n = (len < PCM2PWM_BLOCK_N) ? len : PCM2PWM_BLOCK_N;
+		uint32_t v = interp0->accum[1];				// アイドルトーン拡散 L/Rで開始値を揃える
+		pcm2pwm_block(&buf[0], bs_l, NULL, n, &ch[0], false,    pwm_bit, ds_order, os_type, ds_type);
+		interp0->accum[1] = v;
+		pcm2pwm_block(&buf[1], bs_r, bs_l, n, &ch[1], pio_feed, pwm_bit, ds_order, os_type, ds_type);
+		buf += n * N_CH;
+		if (!pio_feed) {							// PIO出力時はブロック毎にbsを再利用
+			bs_l += n * pwm_get_outer_loop_n(pwm_bit);
+			bs_r += n * pwm_get_outer_loop_n(pwm_bit);
+		}
+		len -= n;
+	}
+}
+
+/* 変調プロファイル
+ PWM分解能・ΔΣ次数・オーバーサンプラ方式の有効な組み合わせ(PWM_BIT > DS_ORDER)を全て特殊化カーネルとして生成し、
+ 表 pcm2pwm_profile[] から選択する。プロファイル番号は表の順序。
+ 0~15 は DIPスイッチ(get_dip())で起動時に選択でき、全プロファイルはUART制御コマンドで切り替えられる。
+ 30~ は CRFB ループフィルタ (ds_crfb[] に係数設計のある組み合わせ、直線補間のみ)
+ X(PWM_BIT, DS_ORDER, OS_TYPE, DS_TYPE)  DS_TYPE 0:DS_TYPE_COI 1:DS_TYPE_CRFB
+*/
+#define PCM2PWM_PROFILE_LIST(X)																	\
+	X(6, 5, 1, 0) X(6, 4, 1, 0) X(6, 3, 1, 0) X(6, 2, 1, 0) X(6, 1, 1, 0) X(6, 0, 1, 0)	/*  0~ 5 */	\
+	X(5, 4, 1, 0) X(5, 3, 1, 0) X(5, 2, 1, 0) X(5, 1, 1, 0) X(5, 0, 1, 0)				/*  6~10 */	\
+	X(4, 3, 1, 0) X(4, 2, 1, 0) X(4, 1, 1, 0) X(4, 0, 1, 0)								/* 11~14 */	\
+	X(6, 5, 0, 0) X(6, 4, 0, 0) X(6, 3, 0, 0) X(6, 2, 0, 0) X(6, 1, 0, 0) X(6, 0, 0, 0)	/* 15~20 */	\
+	X(5, 4, 0, 0) X(5, 3, 0, 0) X(5, 2, 0, 0) X(5, 1, 0, 0) X(5, 0, 0, 0)				/* 21~25 */	\
+	X(4, 3, 0, 0) X(4, 2, 0, 0) X(4, 1, 0, 0) X(4, 0, 0, 0)								/* 26~29 */	\
+	X(6, 4, 1, 1) X(6, 3, 1, 1) X(5, 4, 1, 1) X(5, 3, 1, 1) X(4, 3, 1, 1)				/* 30~34 */
+
+#define PCM2PWM_KERNEL(pwm_bit, ds_order, os_type, ds_type)													\
+static void pcm2pwm_stereo_##pwm_bit##_##ds_order##_##os_type##_##ds_type(const int32_t* buf, uint len, uint32_t* bs_l, uint32_t* bs_r, bool pio_feed){	\
+	_Static_assert((pwm_bit) > (ds_order), "PWM_BIT > DS_ORDER");											\
+	_Static_assert((ds_type) == DS_TYPE_COI || (ds_order) <= DS_CRFB_ORDER_MAX, "DS_ORDER <= DS_CRFB_ORDER_MAX");	\
+	pcm2pwm_stereo(buf, len, bs_l, bs_r, pio_feed, pwm_bit, ds_order, os_type, ds_type);					\
+}
+PCM2PWM_PROFILE_LIST(PCM2PWM_KERNEL)
+
+#define PCM2PWM_PROFILE(pwm_bit, ds_order, os_type, ds_type)	\
+	{pwm_bit, ds_order, os_type, ds_type, pcm2pwm_stereo_##pwm_bit##_##ds_order##_##os_type##_##ds_type},
+static const pcm2pwm_profile_t pcm2pwm_profile[] = {
+	PCM2PWM_PROFILE_LIST(PCM2PWM_PROFILE)
+};
+#define PCM2PWM_PROFILE_N	(sizeof(pcm2pwm_profile) / sizeof(pcm2pwm_profile[0]))
+
+// プロファイル数
+uint pcm2pwm_get_profile_n(void){
+	return PCM2PWM_PROFILE_N;
+}
+
+// プロファイル諸元取得 範囲外は NULL
+const pcm2pwm_profile_t* pcm2pwm_get_profile(uint profile){
+	return (profile < PCM2PWM_PROFILE_N) ? &pcm2pwm_profile[profile] : NULL;
+}
+
+// DIPスイッチ値からプロファイル番号を求める
+// DIPスイッチはプルアップのため ON(GND短絡)=0 で読めるので反転し、全OFFで既定プロファイル(0)とする
+uint pcm2pwm_profile_from_dip(uint dip){
+	uint profile = dip ^ (PIN_DIP_MASK >> PIN_DIP_0);
+	return (profile < PCM2PWM_PROFILE_N) ? profile : PCM2PWM_PROFILE_DEFAULT;
+}
+
+// 1サンプル当たりのPIO出力ワード数(1ch分)
+uint pcm2pwm_get_bs_n(void){
+	return pwm_get_outer_loop_n(pwm_prof->pwm_bit);
 }
 
+// PWM変換 フレーム単位処理
+// buf(L,R,L,R,..)を len サンプル分PWM変換し、bs に Lch面(len * pcm2pwm_get_bs_n() ワード)、Rch面の順で格納する
+// 戻り値は bs に格納したワード数 (= len * N_CH * pcm2pwm_get_bs_n())
+// PIOを介さずに変換結果を取り出すためのもので、ホストビルドのベンチマーク・検証から利用する
+uint pcm2pwm_frame(int32_t* buf, uint len, uint32_t* bs){
+	const uint plane = len * pcm2pwm_get_bs_n();
+	pwm_prof->kernel(buf, len, &bs[0], &bs[plane], false);
+	return plane * N_CH;
+}
+
+// 変調プロファイル切替要求 (Core0 -> Core1)
+// 切替は Core1 の再生ループで出力をフェードアウトした後に行う
+static volatile uint pdm_profile_req = PCM2PWM_PROFILE_DEFAULT;
+
+void pdm_output_set_profile(uint profile){
+	if (profile < PCM2PWM_PROFILE_N) pdm_profile_req = profile;
+}
+
+uint pdm_output_get_profile(void){
+	return pdm_profile_req;
+}
+
+#if !PICO_NO_HARDWARE
 // PWM出力ピンのPAD初期化
 void pwm_gpio_init()
 {
@@ -241,44 +470,213 @@ void pwm_gpio_init()
 	}
 }
 
-// pio0 sm0/sm1 fifo 最適化アクセス関数
-// sm0/sm1引数チェック削除とFIFOチェック統合により
-// sm0/sm1間の設定ラグタイムを極力排除する
-#define SM0_SM1_TXFULL (3u << PIO_FSTAT_TXFULL_LSB)
-static inline void pio0_sm01_put_blocking(
-	uint32_t ch0_data,
-	uint32_t ch1_data
-){
-#if 1	// 高速アクセス版
-	// sm0/sm1 FIFO FULL 解除待ちループ
-	while((pio0->fstat & SM0_SM1_TXFULL) != 0){
+#define PDM_FEED_DMA	1	// PIO TX FIFO への供給 0:Core1がFIFO空き待ちしながら書込み 1:DMA(ピンポンバッファ)
+
+#if PDM_FEED_DMA
+/* DMA による PIO 供給
+ Core1 は PDM_DMA_CHUNK_N サンプル毎に PWM変換結果を ピンポンバッファ pdm_dma_bs[面][ch] へ書込み、
+ L/R 1組のDMAチャネル(Lch -> sm0 TX FIFO, Rch -> sm1 TX FIFO, PIO DREQ ペーシング)で転送する。
+ 面毎・ch毎にDMAチャネルを持ち(計4本)、転送中の面のチャネルから次面のチャネルへ CHAIN_TO で連結することで
+ 面の切り替わりで FIFO への供給が途切れないようにする。
+   1. 面 k の転送完了待ち (L/R とも)
+   2. 面 k の連結(面 k -> 面 k^1)を解除する
+      連結起動は面 k の転送完了時に済んでいる。連結を残すと、Core1 の変換遅れで面 k^1 の設定前に面 k が再度起動された場合、
+      その完了で面 k^1 が連結起動される。連結起動では READ_ADDR は再設定されず TRANS_COUNT のみ再設定されるため、
+      面 k^1 はバッファ終端以降を転送してしまう
+   3. 面 k へ PWM変換 (面 k^1 の連結は前回の面 k^1 の手順2で解除済みのため、面 k^1 の完了で変換中の面 k は起動されない)
+   4. 面 k の転送元・転送数を設定し、面 k^1 -> 面 k を連結
+      面 k^1 が既に転送を終えていた場合(Core1 の変換遅れ)は L/R を同時起動する
+      未起動の判定は READ_ADDR が面の先頭のままであることによる
+      (TRANS_COUNT の読出しは転送中の残数で、書込んだ再設定値は読めない。未起動のチャネルは 0 を読む)
+ 変換が間に合わない場合は転送が止まり、PIO は FIFO空(fifo_empty)の中心レベルを出力する。
+ L/R の FIFO は同一周期で消費されるため、同時起動・同一転送数の L/R チャネルは連結起動も揃って行われる。
+ Core1 の待ちは面毎の1回(手順1)のみとなり、サンプル毎の FIFO 空き待ちは無くなる。
+*/
+#define PDM_DMA_CHUNK_N	48							// DMAバッファ1面のサンプル数 (384k : 125us)
+#define PDM_DMA_WORD_N	(PDM_DMA_CHUNK_N * BS_MAX)	// DMAバッファ1面1ch当たりのワード数
+
+static uint32_t pdm_dma_bs[2][N_CH][PDM_DMA_WORD_N];	// ピンポンバッファ [面][ch] 時刻順：LSB First (DMAが読むためストライプ領域)
+static uint pdm_dma_ch[2][N_CH];						// DMAチャネル番号 [面][ch]
+static uint pdm_dma_side = 0;							// 次に変換する面
+static uint32_t pdm_dma_wait;							// 面の転送完了待ち時間の積算 [tick] (PROF_PIO_WAIT)
+
+// CHAIN_TO の変更 (トリガなしエイリアスへの書込み。転送中のチャネルに対しても可)
+static inline void pdm_dma_set_chain(uint dma_ch, uint chain_to){
+	dma_hw->ch[dma_ch].al1_ctrl = (dma_hw->ch[dma_ch].al1_ctrl & ~DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS)
+		| (chain_to << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+}
+
+static inline bool pdm_dma_busy(uint side){
+	return dma_channel_is_busy(pdm_dma_ch[side][0]) || dma_channel_is_busy(pdm_dma_ch[side][1]);
+}
+
+// DMAチャネル初期化 (起動時1回)
+static void pdm_dma_init(void){
+	for(uint k = 0; k < 2; k++){
+		for(uint c = 0; c < N_CH; c++){
+			uint dma_ch = dma_claim_unused_channel(true);
+			dma_channel_config cfg = dma_channel_get_default_config(dma_ch);
+			channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+			channel_config_set_read_increment(&cfg, true);
+			channel_config_set_write_increment(&cfg, false);
+			channel_config_set_dreq(&cfg, pio_get_dreq(pio0, c, true));	// sm0:Lch, sm1:Rch
+			channel_config_set_chain_to(&cfg, dma_ch);						// 自チャネル = 連結なし
+			dma_channel_configure(dma_ch, &cfg, &pio0->txf[c], pdm_dma_bs[k][c], 0, false);
+			pdm_dma_ch[k][c] = dma_ch;
+		}
+	}
+	pdm_dma_side = 0;
+}
+
+// buf(L,R,L,R,..) len サンプルをPWM変換し、DMAでPIOへ供給する
+static void pdm_dma_feed(const int32_t* buf, uint len){
+	const uint bs_n = pcm2pwm_get_bs_n();
+	while(len){
+		const uint k = pdm_dma_side;
+		const uint n = (len < PDM_DMA_CHUNK_N) ? len : PDM_DMA_CHUNK_N;
+
+		uint32_t t = tick_now();
+		while(pdm_dma_busy(k)){
+			tight_loop_contents();
+		}
+		pdm_dma_wait += (tick_now() - t) & TICK_MASK;
+		for(uint c = 0; c < N_CH; c++) pdm_dma_set_chain(pdm_dma_ch[k][c], pdm_dma_ch[k][c]);
+
+		pwm_prof->kernel(buf, n, pdm_dma_bs[k][0], pdm_dma_bs[k][1], false);
+
+		for(uint c = 0; c < N_CH; c++){
+			dma_channel_set_read_addr(pdm_dma_ch[k][c], pdm_dma_bs[k][c], false);
+			dma_channel_set_trans_count(pdm_dma_ch[k][c], n * bs_n, false);
+		}
+		__dmb();	// 変換結果・転送設定の書込み完了後に連結する
+		for(uint c = 0; c < N_CH; c++) pdm_dma_set_chain(pdm_dma_ch[k ^ 1][c], pdm_dma_ch[k][c]);
+		// 連結前に面 k^1 が転送を終えていた場合は連結起動されないため、L/R を同時起動する
+		// (面 k^1 の完了確認後に、面 k が busy でなく READ_ADDR が先頭のままであれば未起動。連結後に終えた場合は面 k が busy か READ_ADDR が進んでいる)
+		if (!pdm_dma_busy(k ^ 1) && !pdm_dma_busy(k)
+			&& dma_hw->ch[pdm_dma_ch[k][0]].read_addr == (uintptr_t)pdm_dma_bs[k][0]) {
+			dma_start_channel_mask((1u << pdm_dma_ch[k][0]) | (1u << pdm_dma_ch[k][1]));
+		}
+		pdm_dma_side = k ^ 1;
+		buf += n * N_CH;
+		len -= n;
+	}
+}
+
+// DMA転送の完了待ち
+static void pdm_dma_drain(void){
+	while(pdm_dma_busy(0) || pdm_dma_busy(1)){
 		tight_loop_contents();
 	}
-	// sm0/sm1 FIFO レジスタへの連続書き込み
-	pio0->txf[0] = ch0_data;	
-	pio0->txf[1] = ch1_data;
-#else	// 従来版
-	pio_sm_put_blocking(pio0, 0, ch0_data);
-	pio_sm_put_blocking(pio0, 1, ch1_data);
+}
+#else
+static uint32_t CORE1_HOT("pdm") pwm_bs[N_CH][PCM2PWM_BLOCK_N * BS_MAX];	// ブロック変換結果 ビットストリーム [ch] 時刻順：LSB First
 #endif
+
+// PWM変換・PIO出力 buf(L,R,L,R,..) len サンプル
+static inline void pdm_feed(const int32_t* buf, uint len){
+#if PDM_FEED_DMA
+	pdm_dma_feed(buf, len);
+#else
+	pwm_prof->kernel(buf, len, pwm_bs[0], pwm_bs[1], true);	// PCM2PWM_BLOCK_N 毎に LCh -> RCh(+PIO出力) の順でPWM変換
+#endif
+}
+
+// キュー消費通知単位[sample] (queue_consume() : ASRCサーボの水位計測分解能)
+#if PDM_FEED_DMA
+#define PDM_FEED_N		PDM_DMA_CHUNK_N
+#else
+#define PDM_FEED_N		48
+#endif
+
+// 後段オーバーサンプリング(os_split)出力バッファ 352.8/384kHz PDM_FEED_N サンプル
+static int32_t CORE1_HOT("pdm") pdm_os_buf[PDM_FEED_N * N_CH];
+
+// Core1 PWM変換・PIO供給の処理サイクル [cycle/sample] (Q8, IIR平均) 0 : 未計測 (再生開始前)
+// PROF_PCM2PWM と同じ区間の計時値(tick_now(), PROF_ENABLE によらない)から求め、Core0 の分担選択(os_split_select())に使う
+#define PDM_CYC_IIR_SHIFT	4
+static volatile uint32_t pdm_cyc_q8 = 0;
+
+uint pdm_output_get_cycle(void){
+	return (pdm_cyc_q8 + 128) >> 8;
+}
+
+// PIO PWMプログラム生成・PIO初期化 (pio_pwm.c)
+// PWM周期は clock_plan.h、6bit は PWM周期 x2・N側ピンを PIO出力とせず GPIO L とする (従来の pio_pwm_6bit.pio と同じ)
+static pio_pwm_config_t pio_pwm_cfg;
+
+static void pdm_pio_init(uint pwm_bit){
+	pio_pwm_param_t param;
+	pio_pwm_param_init(&param, pwm_bit, CLOCK_PLAN_PWM_CYCLE_48, CLOCK_PLAN_PWM_CYCLE_44);
+	if (!pio_pwm_build(&pio_pwm_cfg, &param)) panic("pio_pwm_build %dbit %d/%d", pwm_bit, param.cycle_48, param.cycle_44);
+	pio_pwm_program_init(pio0, &pio_pwm_cfg, PIN_OUTPUT_LP, PIN_OUTPUT_RP, PIN_FS48);
+}
+
+#define PDM_FADE_N		64	// プロファイル切替時のフェードアウト長[sample] (384k : 167us)
+#define PDM_DRAIN_US	10	// PIO OSR内の最終ワード出力待ち時間[us] (1ワード = 4PWM周期 < 3us)
+
+// 変調プロファイル切替
+// 1. 最終入力値(ch[].d1)から0まで直線でフェードアウトし、PWM出力を中心レベルに落とす (work : 無音バッファを作業領域に使用)
+// 2. DMA転送・PIO TX FIFO/OSR を出力しきるのを待つ(以降PIOはFIFO空の中心レベルを出力)
+// 3. PWM分解能が変わる場合はPIOプログラムを再登録する
+//    (全smを停止してから命令メモリを書き換える。初期化中はPWM出力ピンを P/N とも L とするため差動出力は中心レベルのまま
+//     PIN_FS48 は変更しないため、set_dac_fs_group_48k() で選択した 44.1k/48k 系列を保つ)
+// 4. 新プロファイルでPWM変換を初期化する
+static void pdm_output_reload(uint profile, int32_t* work, uint work_len){
+	const uint pwm_bit_old = pwm_prof->pwm_bit;
+	int32_t d[N_CH] = {ch[0].d1, ch[1].d1};
+	for(uint n = 0; n < PDM_FADE_N; ){
+		uint len = 0;
+		for(; (len < work_len) && (n < PDM_FADE_N); len++, n++){
+			for(uint c = 0; c < N_CH; c++) work[len * N_CH + c] = d[c] / PDM_FADE_N * (PDM_FADE_N - 1 - n);
+		}
+		pdm_feed(work, len);
+	}
+	memset(work, 0, sizeof(int32_t) * work_len * N_CH);	// 無音バッファに戻す
+#if PDM_FEED_DMA
+	pdm_dma_drain();
+#endif
+	while(!pio_sm_is_tx_fifo_empty(pio0, 0) || !pio_sm_is_tx_fifo_empty(pio0, 1)){
+		tight_loop_contents();
+	}
+	busy_wait_us(PDM_DRAIN_US);
+
+	const pcm2pwm_profile_t* prof = pcm2pwm_get_profile(profile);
+	if (prof->pwm_bit != pwm_bit_old) {
+		pdm_pio_init(prof->pwm_bit);
+		pwm_gpio_init();
+	}
+	pcm2pwm_init(profile);
 }
 
 // 再生処理
 void pdm_output()
 {
     static bool mute_flag = false;
+	const uint play_thr = queue_get_mode()->play_thr;
 	int32_t mute_buff[24*2] = {0};  // 無音buff 通常buff長(384*2)の1/16(62.5us)
 
-	pio_pwm_program_init(pio0, PIN_OUTPUT_LP, PIN_OUTPUT_RP, PIN_FS48);
-	pcm2pwm_init(PWM_BIT);
+	uint profile = pdm_profile_req;
+	pdm_pio_init(pcm2pwm_get_profile(profile)->pwm_bit);
+	pcm2pwm_init(profile);
 	pwm_gpio_init();
+#if PDM_FEED_DMA
+	pdm_dma_init();
+#endif
+	prof_init_core();
 
     while(1){
+		// 変調プロファイル切替要求 切替後はミュートから再開する
+		if (pdm_profile_req != profile) {
+			profile = pdm_profile_req;
+			pdm_output_reload(profile, mute_buff, sizeof(mute_buff) / (sizeof(int32_t) * 2));
+			mute_flag = true;
+			queue_reset();
+		}
 
 /* <Mute Logic>
          queue_length     A    *                 *         
                 [ms]      |     *               *          
-                          | _ _ _*_ _ _ _ _ _ _*_ _ _ _ _ _ QUEUE_PLAY_THR
+                          | _ _ _*_ _ _ _ _ _ _*_ _ _ _ _ _ play_thr
                         A |       *           *:           
                 Mute    | |        *         * :           
             Hysteresis  | |         *       *  :           
@@ -290,11 +688,11 @@ void pdm_output()
             action         <---play-->:<-mute->:<---play-->
 
 		ミュート有効・解除切り替えは、キュー長によりヒステリシスを持たせている。
-		ミュート有効時はキュー長が充足(queue_length ≧ QUEUE_PLAY_THR)するまでミュート有効を保持する。
+		ミュート有効時はキュー長が充足(queue_length ≧ play_thr)するまでミュート有効を保持する。
 		キュー長が充足したらミュート解除(mute_flag=0)し、キューの再生処理(dequeue～pcm2pwm~PIO)を行う。
 		以降、キュー長がゼロ(queue_length = 0)となるまでミュート解除状態を保持し、キューを再生しきる。
-		本プログラムでは、再生ディレイと安定のバランスを考慮し、QUEUE_PLAY_THR = 4 (≒4ms)とした。
-		キュー長が一定値となるための制御は、Core0側の周波数Feedback側に実装されている。
+		play_thr はキュー動作モード(simple_queue.c)で決まり、ロバストモードは 4スロット(≒4ms)、低遅延モードは 6スロット(≒1.5ms)とした。
+		キュー長が一定値となるための制御は、Core0側の周波数Feedback(USB)・ASRCサーボ(I2S, asrc_servo.c)側に実装されている。
 */
 		// ミュート判定
 		uint32_t queue_length = get_queue_length();
@@ -304,7 +702,7 @@ void pdm_output()
 			queue_reset();
 			pcm2pwm_reset();
 		}
-		else if(queue_length >= QUEUE_PLAY_THR)			// mute解除条件段数
+		else if(queue_length >= play_thr)				// mute解除条件段数
 		{
 			mute_flag = false;
 		}
@@ -323,17 +721,45 @@ void pdm_output()
 		if(mute_flag == false)
 		{
 			dequeue(&buff, &len);	// キューbuff/len取得　失敗時は buff/lenは更新されずミュートバッファのままとなる
-			DEBUG_PIN_SET(PIN_TIME_MEASURE);		// テスト用 オシロ観測用トリガ PCMデータ先頭で1
-			while(len--){		// Buffer loop
-				pcm2pwm(*buff++, &ch[0]);			// LCh PWM変換 結果は構造体 ch[].bs (bitstream)に代入される
-				pcm2pwm(*buff++, &ch[1]);			// RCh PWM変換 結果は構造体 ch[].bs (bitstream)に代入される
-				DEBUG_PIN_SET(PIN_PIOT_MEASURE);	// テスト用 pio設定前にH。pioに待たされている時刻測定用
-				for(uint k = 0; k < os_outer_loop_n; k ++){
-					pio0_sm01_put_blocking(ch[0].bs[k], ch[1].bs[k]);	// LCh/RCh Bitstream を PIO PWMへ出力
+			// Core0/Core1 分担 (dsp.c os_split) スロットのデータは 352.8/384kHz >> split
+			const uint32_t tag = (buff != mute_buff) ? queue_get_tag() : 0;
+			const uint split = os_split_get_tag_split(tag);
+			// 処理時間計測 PWM変換(PIO/DMA待ち・後段オーバーサンプリングを除く)と待ちを分けて記録する
+			// (FIFO空き待ち書込み時はワード毎の待ちを分離できないため、待ちを含めて PROF_PCM2PWM とする)
+			uint32_t t_feed = tick_now();
+			uint32_t t_os = 0;
+#if PDM_FEED_DMA
+			pdm_dma_wait = 0;
+#endif
+			// PWM変換・PIO出力 (DMA時は変換済みの面を順次転送)
+			// キューのスロットは PDM_FEED_N (キューのfsでは PDM_FEED_N >> split) サンプル毎に変換完了を通知する
+			for(uint i = 0; i < len; ){
+				const uint n = (len - i < (PDM_FEED_N >> split)) ? len - i : (PDM_FEED_N >> split);
+				if (split) {
+					uint n_o = n;
+					uint32_t t = tick_now();
+					hbf_oversampler_core1(&buff[i * N_CH], pdm_os_buf, &n_o, tag);
+					t_os += (tick_now() - t) & TICK_MASK;
+					pdm_feed(pdm_os_buf, n_o);
+				} else {
+					pdm_feed(&buff[i * N_CH], n);
 				}
-				DEBUG_PIN_CLR(PIN_PIOT_MEASURE);	// テスト用 pio設定後にL。pioに待たされている時刻測定用
+				if (buff != mute_buff) queue_consume(n, time_us_32());
+				i += n;
+			}
+			t_feed = (tick_now() - t_feed) & TICK_MASK;
+#if PDM_FEED_DMA
+			t_feed -= pdm_dma_wait;
+			prof_record(PROF_PIO_WAIT, pdm_dma_wait);
+#endif
+			t_feed -= t_os;
+			prof_record(PROF_PCM2PWM, t_feed);
+			if (split) prof_record(PROF_OS_CORE1, t_os);
+			if (buff != mute_buff) {
+				const uint32_t cyc_q8 = (t_feed << 8) / (len << split);
+				pdm_cyc_q8 = pdm_cyc_q8 ? pdm_cyc_q8 + (((int32_t)(cyc_q8 - pdm_cyc_q8)) >> PDM_CYC_IIR_SHIFT) : cyc_q8;
 			}
-			DEBUG_PIN_CLR(PIN_TIME_MEASURE);		// テスト用 オシロ観測用トリガ PCMデータ先頭以外で0
 		}
 	}
-}
\ No newline at end of file
+}
+#endif
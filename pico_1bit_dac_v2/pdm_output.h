@@ -1,6 +1,48 @@
 #ifndef _PDM_OUTPUT_H_
 #define _PDM_OUTPUT_H_
 
+#define PCM2PWM_PROFILE_DEFAULT 0	// 既定の変調プロファイル (6bitPWM, 5次ΔΣ, 直線補間)
+
+// ΔΣループフィルタ構成
+#define DS_TYPE_COI		0	// 積分器縦続 ds[n] += -qt + ds[n-1] (係数なし, NTF = (1-z^-1)^N)
+#define DS_TYPE_CRFB	1	// 係数・共振器付き積分器縦続 (NTF零点最適化, 積分器過負荷検出・リセット)
+#define DS_CRFB_ORDER_MAX	4	// DS_TYPE_CRFB の最大次数
+
+// ΔΣ係数 mul / 2^shift ((v >> shift) * mul で演算する。mul = 0 : 係数なし)
+typedef struct {
+	int16_t mul;
+	uint8_t shift;
+} ds_coef_t;
+
+// DS_TYPE_CRFB ループフィルタ係数 (添字 n は積分器番号 1~ds_order)
+typedef struct {
+	uint8_t		order;								// 次数 (0 : 設計なし)
+	ds_coef_t	c[DS_CRFB_ORDER_MAX + 1];			// 段間係数 ds[n-1] -> ds[n] (n >= 2, n = 1 は入力を係数1で加算)
+	ds_coef_t	g[DS_CRFB_ORDER_MAX + 1];			// 共振器係数 ds[n+1] -> ds[n] (前回値を減算)
+	uint8_t		qt_shift[DS_CRFB_ORDER_MAX + 1];	// 量子化値帰還の右シフト (積分器 ds[n] のスケーリング 1/2^qt_shift)
+} ds_crfb_t;
+
+// 変調プロファイル
+typedef struct {
+	uint8_t pwm_bit;	// PWM分解能(4~6) 4~5:x8(cycle = 3.072M) 6:x4(cycle = 1.536M)
+	uint8_t ds_order;	// ΔΣ次数 (PWM_BIT > DS_ORDER)
+	uint8_t os_type;	// オーバサンプラ動作 0:SH(SampleHold) 1:LinerInterpolator(直線補間)
+	uint8_t ds_type;	// ΔΣループフィルタ構成 DS_TYPE_COI / DS_TYPE_CRFB
+	void (*kernel)(const int32_t* buf, uint len, uint32_t* bs_l, uint32_t* bs_r, bool pio_feed);	// L/Rブロック変換カーネル
+} pcm2pwm_profile_t;
+
 void pdm_output(void);
+void pdm_output_set_profile(uint profile);
+uint pdm_output_get_profile(void);
+uint pdm_output_get_cycle(void);
+void pcm2pwm_init(uint profile);
+void pcm2pwm_reset(void);
+uint pcm2pwm_get_profile_n(void);
+const pcm2pwm_profile_t* pcm2pwm_get_profile(uint profile);
+uint pcm2pwm_profile_from_dip(uint dip);
+uint pcm2pwm_get_bs_n(void);
+uint pcm2pwm_frame(int32_t* buf, uint len, uint32_t* bs);
+const ds_crfb_t* pcm2pwm_get_crfb(uint pwm_bit, uint ds_order);
+uint pcm2pwm_get_overload_n(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,451 @@
+/**
+ * @file pio_pwm.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief PIO PWMプログラム生成・PIO初期化
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 生成するプログラムは従来の .pio と同じ2方式 (差動出力 side 1 : P=H/N=L, side 2 : P=L/N=H)
+ *  自己計時 (PIO_PWM_SYNC_SELF, pio_pwm_4bit/5bit.pio と同構成)
+ *   三角波変調 : hi1_loop(H) ~ lo_loop(L) ~ hi2_loop(H) で L を周期中央に置き、code 1 当たり H を step clk 増やす。
+ *   x-- を k回前置して y ループの初期値を下げ、code < k は専用の長ループ(eq0, eq1..)で出力する。
+ *   周期 = 6 + k + dp + step * (2^bit - k)  (dp : jmp pin の遅延) を満たす step(最大), k(最小) を探索する。
+ *   44.1k系は jmp pin (PIN_FS48 = 0) 分岐後の nop で L/H を延長する。
+ *  pacemaker同期 (PIO_PWM_SYNC_PACEMAKER, pio_pwm_6bit.pio と同構成)
+ *   sm2 が半周期毎に irq2/irq3 を切り替え、sm0/sm1 は H -> wait irq2 -> L -> wait irq3 で周期・L/R位相を合わせる。
+ *   L = (2^bit - 1 - code) + 1 ループを isr で求めるため set の即値(5bit)に依らず 7/8bit も生成できる。
+ *   周期 >= 2 * (2^bit + 4) [pio clk]。pacemaker は命令数を抑えるため半周期・延長を割り切る 2^n 分周で動かす。
+ *  FIFO空時は中心レベル(H = L)を出力する。
+ */
+
+#include <string.h>
+#include "pico.h"
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#include "hardware/gpio.h"
+#include "bsp.h"
+#endif
+
+#include "pio_pwm.h"
+
+// side-set値 (sideset_n = 2)
+#define SIDE_0		0	// P=L, N=L (起動時)
+#define SIDE_H		1	// P=H, N=L
+#define SIDE_L		2	// P=L, N=H
+
+// 命令
+#define I_MOV(dst, op, src)	(PIO_OP_MOV | ((dst) << 5) | (op) | (src))
+#define I_SET(dst, v)		(PIO_OP_SET | ((dst) << 5) | (v))
+#define I_OUT(dst, n)		(PIO_OP_OUT | ((dst) << 5) | ((n) & 31))
+#define I_IN(src, n)		(PIO_OP_IN | ((src) << 5) | ((n) & 31))
+#define I_WAIT_IRQ0(n)		(PIO_OP_WAIT | PIO_WAIT_IRQ | (n))	// wait 0 irq n
+#define I_IRQ_SET(n)		(PIO_OP_IRQ | (n))					// irq nowait n
+#define I_IRQ_CLEAR(n)		(PIO_OP_IRQ | PIO_IRQ_CLEAR | (n))	// irq clear n
+
+#define SELF_K_MAX	3	// 自己計時 x-- 前置数の上限
+
+// 生成用ラベル
+enum {
+	L_LO_DEC = 0, L_HI_START, L_HI1_LOOP, L_LO_SET, L_LO_LOOP, L_HI2_LOOP,
+	L_CHECK_FIFO, L_FIFO_EMPTY, L_GET_DATA, L_WAIT_IRQ3, L_CE_HI, L_CE_LO, L_EQ_CHECK,
+	L_GE1, L_EQ_LOOP = L_GE1 + SELF_K_MAX,
+	L_STATE_A = L_EQ_LOOP + SELF_K_MAX, L_STATE_B,
+	L_N
+};
+#define LABEL_NONE	0xff
+
+// 命令列生成 (前方参照のジャンプ先は pwm_asm_end() で解決)
+typedef struct {
+	pio_pwm_prog_t*	prog;
+	uint8_t		label[L_N];
+	uint8_t		fix_at[PIO_PWM_INSN_MAX];
+	uint8_t		fix_label[PIO_PWM_INSN_MAX];
+	uint		fix_n;
+	bool		ok;
+} pwm_asm_t;
+
+static void pwm_asm_begin(pwm_asm_t* a, pio_pwm_prog_t* prog, uint sideset_n, uint clkdiv){
+	memset(prog, 0, sizeof(*prog));
+	prog->sideset_n = sideset_n;
+	prog->clkdiv = clkdiv;
+	memset(a->label, LABEL_NONE, sizeof(a->label));
+	a->prog = prog;
+	a->fix_n = 0;
+	a->ok = true;
+}
+
+static uint pwm_asm_delay_max(const pwm_asm_t* a){
+	return (1u << (5 - a->prog->sideset_n)) - 1;
+}
+
+// 命令追加 範囲外の遅延・命令数超過は生成失敗とする
+static void pwm_asm_put(pwm_asm_t* a, uint16_t insn, uint side, int delay){
+	pio_pwm_prog_t* p = a->prog;
+	if (p->len >= PIO_PWM_INSN_MAX || delay < 0 || delay > (int)pwm_asm_delay_max(a)) {
+		a->ok = false;
+		return;
+	}
+	if (p->sideset_n) insn |= (uint16_t)(side << (13 - p->sideset_n));
+	p->insn[p->len++] = insn | (uint16_t)(delay << 8);
+}
+
+static void pwm_asm_jmp(pwm_asm_t* a, uint cond, uint label, uint side, int delay){
+	if (a->fix_n < PIO_PWM_INSN_MAX) {
+		a->fix_at[a->fix_n] = a->prog->len;
+		a->fix_label[a->fix_n++] = label;
+	}
+	pwm_asm_put(a, PIO_OP_JMP | cond, side, delay);
+}
+
+static void pwm_asm_label(pwm_asm_t* a, uint label){
+	a->label[label] = a->prog->len;
+}
+
+// clk [clk] を遅延付き命令で埋める (先頭は insn, 以降は nop)
+static void pwm_asm_fill(pwm_asm_t* a, uint16_t insn, uint side, uint clk){
+	const uint max = pwm_asm_delay_max(a) + 1;
+	do {
+		const uint c = (clk > max) ? max : clk;
+		pwm_asm_put(a, insn, side, (int)c - 1);
+		insn = PIO_I_NOP;
+		clk -= c;
+	} while(clk > 0 && a->ok);
+}
+
+static bool pwm_asm_end(pwm_asm_t* a, uint entry, uint wrap_target, uint wrap){
+	pio_pwm_prog_t* p = a->prog;
+	for(uint i = 0; i < a->fix_n && a->ok; i++){
+		if (a->label[a->fix_label[i]] == LABEL_NONE) a->ok = false;
+		else p->insn[a->fix_at[i]] |= a->label[a->fix_label[i]];
+	}
+	if (!a->ok || p->len == 0) return false;
+	p->entry = (entry == LABEL_NONE) ? 0 : a->label[entry];
+	p->wrap_target = (wrap_target == LABEL_NONE) ? 0 : a->label[wrap_target];
+	p->wrap = (wrap == LABEL_NONE) ? p->len - 1 : a->label[wrap];
+	return true;
+}
+
+// 長い L/H 区間のループ : (n + 1) * (d + 1) + r = clk を満たす n (≦ 31), d, r (≦ d_max) を d 最小で求める
+static bool loop_fit(uint clk, uint d_max, uint* n, uint* d, uint* r){
+	for(uint dd = 0; dd <= d_max; dd++){
+		uint nn = clk / (dd + 1);
+		if (nn > 32) nn = 32;
+		if (nn == 0) break;
+		const uint rr = clk - nn * (dd + 1);
+		if (rr <= d_max) {
+			*n = nn - 1;
+			*d = dd;
+			*r = rr;
+			return true;
+		}
+	}
+	return false;
+}
+
+// 自己計時 (sm0/sm1 のみ)
+static bool build_self(pio_pwm_config_t* cfg){
+	const pio_pwm_param_t* p = &cfg->param;
+	const uint b = p->pwm_bit, m = 1u << b, c = p->cycle_48;
+	const uint pl = p->pad_lo, ph = p->cycle_44 - p->cycle_48 - pl;
+
+	// step (code 1 当たりの H増分, 偶数), k (x-- 前置数), dp (jmp pin の遅延)
+	uint step = 0, k = 0;
+	int dp = -1;
+	for(uint s = 8; s >= 2 && dp < 0; s -= 2){
+		for(uint kk = 1; kk <= SELF_K_MAX && kk < m && dp < 0; kk++){
+			const int d = (int)c - 6 - (int)kk - (int)(s * (m - kk));
+			const int h0 = 3 + (int)kk - (int)(s * (kk - 1));
+			if (d < 0 || d > 7 || m - 1 - kk > 31 || h0 < 1) continue;
+			// code j < kk : H = out + (j + 1) x x-- + set [+ 遅延] + check_fifo (H が 1 足りない場合は check_fifo を L側で行う)
+			bool eq_ok = true;
+			uint eq_lo_check = 0;
+			for(uint j = 0; j < kk; j++){
+				const int hj = h0 + (int)(s * j);
+				if (hj < (int)j + 3 || hj - (int)j - 4 > 7) eq_ok = false;
+				if (hj == (int)j + 3) eq_lo_check++;
+			}
+			if (!eq_ok || eq_lo_check > 1) continue;
+			step = s;
+			k = kk;
+			dp = d;
+		}
+	}
+	if (dp < 0) return false;
+	const uint h0 = 3 + k - step * (k - 1);
+	const uint top = m - 1 - k;		// lo_loop の y 初期値
+	cfg->h0 = h0;
+	cfg->step = step;
+
+	pwm_asm_t a;
+	pwm_asm_begin(&a, &cfg->pwm, 2, 1);
+	pwm_asm_label(&a, L_LO_DEC);
+	pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_LO_LOOP, SIDE_L, step - 2);
+	pwm_asm_label(&a, L_HI_START);
+	pwm_asm_put(&a, I_MOV(PIO_SRC_DST_Y, PIO_MOV_NONE, PIO_SRC_DST_X), SIDE_H, 0);
+	pwm_asm_label(&a, L_HI1_LOOP);
+	pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_HI1_LOOP, SIDE_H, step / 2 - 1);
+	pwm_asm_label(&a, L_LO_SET);
+	pwm_asm_put(&a, I_SET(PIO_SRC_DST_Y, top), SIDE_L, 0);
+	pwm_asm_label(&a, L_LO_LOOP);
+	pwm_asm_jmp(&a, PIO_JMP_X_NE_Y, L_LO_DEC, SIDE_L, 0);
+	pwm_asm_jmp(&a, PIO_JMP_PIN, L_HI2_LOOP, SIDE_L, dp);
+	if (pl) pwm_asm_fill(&a, PIO_I_NOP, SIDE_L, pl);		// 44.1k系 延長
+	if (ph) pwm_asm_fill(&a, PIO_I_NOP, SIDE_H, ph);
+	pwm_asm_label(&a, L_HI2_LOOP);
+	pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_HI2_LOOP, SIDE_H, step / 2 - 1);
+	pwm_asm_label(&a, L_CHECK_FIFO);
+	pwm_asm_jmp(&a, PIO_JMP_NOT_OSRE, L_GET_DATA, SIDE_H, 0);
+
+	// FIFO空 : x = xc として lo_set に入り、H = c / 2 の中心レベルを出力する
+	// L = jmp(1 + g) + set + (top - xc) * step + x!=y + jmp pin(1 + dp), H = check_fifo + fill + hi2_loop
+	// jmp の遅延 g が最小となる xc を選ぶ
+	const uint hc = c / 2, lc = c - hc;
+	int xc = -1, g = -1;
+	for(int x = (int)top; x >= 0; x--){
+		const int gx = (int)lc - 4 - dp - (int)((top - x) * step);
+		if (gx < 0) break;
+		xc = x;
+		g = gx;
+	}
+	const int fill = (int)hc - 1 - (int)((xc + 1) * step / 2);
+	if (xc < 0 || g > 7 || fill < 1) return false;
+	cfg->h_center = hc;
+	pwm_asm_label(&a, L_FIFO_EMPTY);
+	pwm_asm_fill(&a, I_SET(PIO_SRC_DST_X, xc), SIDE_H, fill);
+	pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_LO_SET, SIDE_L, g);
+
+	// データ取得 code >= k は x = code - k で hi_start へ、code < k は eq_j
+	bool eq_lo_check = false;
+	pwm_asm_label(&a, L_GET_DATA);
+	pwm_asm_put(&a, I_OUT(PIO_SRC_DST_X, b), SIDE_H, 0);
+	for(uint j = 0; j < k; j++){
+		if (j > 0) pwm_asm_label(&a, L_GE1 + j - 1);
+		pwm_asm_jmp(&a, PIO_JMP_X_DEC, (j + 1 < k) ? L_GE1 + j : L_HI_START, SIDE_H, 0);
+		const uint hj = h0 + step * j, lj = c - hj;
+		const bool lo_check = (hj == j + 3);
+		uint n, d, r;
+		if (!loop_fit(lj - (lo_check ? 2 : 1), 7, &n, &d, &r)) return false;
+		pwm_asm_put(&a, I_SET(PIO_SRC_DST_Y, n), SIDE_H, lo_check ? 0 : (int)(hj - j - 4));
+		pwm_asm_label(&a, L_EQ_LOOP + j);
+		pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_EQ_LOOP + j, SIDE_L, d);
+		pwm_asm_jmp(&a, PIO_JMP_PIN, lo_check ? L_EQ_CHECK : L_CHECK_FIFO, SIDE_L, r);
+		// 44.1k系 延長 L : pl, H : ph
+		if (lo_check) {
+			eq_lo_check = true;
+			if (ph >= 2) {
+				pwm_asm_put(&a, PIO_I_NOP, SIDE_L, pl);
+				pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_CHECK_FIFO, SIDE_H, ph - 2);
+			} else if (ph == 1) {
+				pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_CHECK_FIFO, SIDE_L, pl);
+			} else {
+				pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_EQ_CHECK, SIDE_L, pl - 1);
+			}
+		} else if (ph == 0) {
+			pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_CHECK_FIFO, SIDE_L, pl - 1);
+		} else {
+			if (pl) pwm_asm_put(&a, PIO_I_NOP, SIDE_L, pl - 1);
+			pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_CHECK_FIFO, SIDE_H, ph - 1);
+		}
+	}
+	// L側の FIFO確認 FIFO空なら wrap で fifo_empty へ
+	if (eq_lo_check) {
+		pwm_asm_label(&a, L_EQ_CHECK);
+		pwm_asm_jmp(&a, PIO_JMP_NOT_OSRE, L_GET_DATA, SIDE_L, 0);
+		return pwm_asm_end(&a, L_CHECK_FIFO, L_FIFO_EMPTY, L_EQ_CHECK);
+	}
+	return pwm_asm_end(&a, L_CHECK_FIFO, LABEL_NONE, LABEL_NONE);
+}
+
+// pacemaker同期 (sm0/sm1 + sm2)
+static bool build_pacemaker(pio_pwm_config_t* cfg){
+	const pio_pwm_param_t* p = &cfg->param;
+	const uint b = p->pwm_bit, m = 1u << b, c = p->cycle_48;
+	const uint pl = p->pad_lo, ph = p->cycle_44 - p->cycle_48 - pl;
+	const uint s = c / 2;	// pacemaker 1状態 (半周期) [pio clk]
+	if ((c & 1) || s < m + 4) return false;
+	cfg->h0 = s - m + 1;
+	cfg->step = 2;
+	cfg->h_center = s;
+
+	pwm_asm_t a;
+	pwm_asm_begin(&a, &cfg->pwm, 2, 1);
+	pwm_asm_put(&a, I_WAIT_IRQ0(2), SIDE_0, 0);
+	pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_WAIT_IRQ3, SIDE_0, 0);
+	pwm_asm_label(&a, L_GET_DATA);
+	pwm_asm_put(&a, I_OUT(PIO_SRC_DST_X, b), SIDE_H, 0);
+	pwm_asm_label(&a, L_HI_START);
+	pwm_asm_put(&a, I_MOV(PIO_SRC_DST_Y, PIO_MOV_NONE, PIO_SRC_DST_X), SIDE_H, 0);
+	pwm_asm_label(&a, L_HI1_LOOP);
+	pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_HI1_LOOP, SIDE_H, 0);						// code + 1
+	pwm_asm_put(&a, I_WAIT_IRQ0(2), SIDE_L, 0);
+	pwm_asm_put(&a, I_MOV(PIO_SRC_DST_ISR, PIO_MOV_INVERT, PIO_SRC_DST_NULL), SIDE_L, 0);	// isr = 0b11..11
+	pwm_asm_put(&a, I_IN(PIO_SRC_DST_X, b), SIDE_L, 0);							// isr = 0b11..1x..x
+	pwm_asm_put(&a, I_MOV(PIO_SRC_DST_Y, PIO_MOV_INVERT, PIO_SRC_DST_ISR), SIDE_L, 0);	// y = 2^bit - 1 - code
+	pwm_asm_label(&a, L_LO_LOOP);
+	pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_LO_LOOP, SIDE_L, 0);
+	pwm_asm_label(&a, L_WAIT_IRQ3);
+	pwm_asm_put(&a, I_WAIT_IRQ0(3), SIDE_H, 0);
+	pwm_asm_label(&a, L_CHECK_FIFO);
+	pwm_asm_jmp(&a, PIO_JMP_NOT_OSRE, L_GET_DATA, SIDE_H, 0);
+	pwm_asm_label(&a, L_FIFO_EMPTY);
+	bool ok;
+	if (m / 2 - 1 <= 31) {
+		// 中心レベル x = 2^(bit-1) - 1 (+1clk) で wrap -> hi_start
+		pwm_asm_put(&a, I_SET(PIO_SRC_DST_X, m / 2 - 1), SIDE_H, 1);
+		ok = pwm_asm_end(&a, LABEL_NONE, L_HI_START, L_FIFO_EMPTY);
+	} else {
+		// set の即値で中心 code を表せない場合は中心レベルの H/L を固定ループで出力する
+		uint n, d, r;
+		if (!loop_fit(m / 2 + 2, 7, &n, &d, &r)) return false;
+		pwm_asm_put(&a, I_SET(PIO_SRC_DST_Y, n), SIDE_H, r);
+		pwm_asm_label(&a, L_CE_HI);
+		pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_CE_HI, SIDE_H, d);
+		pwm_asm_put(&a, I_WAIT_IRQ0(2), SIDE_L, 0);
+		if (!loop_fit(m / 2 + 2, 7, &n, &d, &r)) return false;
+		pwm_asm_put(&a, I_SET(PIO_SRC_DST_Y, n), SIDE_L, 0);
+		pwm_asm_label(&a, L_CE_LO);
+		pwm_asm_jmp(&a, PIO_JMP_Y_DEC, L_CE_LO, SIDE_L, d);
+		pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_WAIT_IRQ3, SIDE_L, r);
+		ok = pwm_asm_end(&a, LABEL_NONE, LABEL_NONE, LABEL_NONE);
+	}
+	if (!ok) return false;
+
+	// sm2 pacemaker : state_a (irq3 = 1, irq2 = 0) -> state_b (irq2 = 1, irq3 = 0)
+	// 44.1k系は state_a を H側延長, state_b を L側延長だけ伸ばす
+	// 分周 : s, pl, ph を割り切る 2^n (≦ 8, 状態長 4clk 以上)
+	uint pm_div = 1;
+	while(pm_div < 8 && !((s | pl | ph) & pm_div) && s / (2 * pm_div) >= 4) pm_div <<= 1;
+	const uint spm = s / pm_div, pl_pm = pl / pm_div, ph_pm = ph / pm_div;
+	if (spm < 4) return false;
+	pwm_asm_begin(&a, &cfg->pacemaker, 0, pm_div);
+	pwm_asm_label(&a, L_STATE_A);
+	pwm_asm_put(&a, I_IRQ_SET(3), 0, 0);
+	pwm_asm_put(&a, I_IRQ_CLEAR(2), 0, 0);
+	pwm_asm_fill(&a, PIO_I_NOP, 0, spm - 3);
+	pwm_asm_jmp(&a, PIO_JMP_PIN, L_STATE_B, 0, 0);
+	if (ph_pm) pwm_asm_fill(&a, PIO_I_NOP, 0, ph_pm);
+	pwm_asm_label(&a, L_STATE_B);
+	pwm_asm_put(&a, I_IRQ_SET(2), 0, 0);
+	pwm_asm_put(&a, I_IRQ_CLEAR(3), 0, 0);
+	pwm_asm_fill(&a, PIO_I_NOP, 0, spm - 3);
+	if (pl_pm) {
+		pwm_asm_jmp(&a, PIO_JMP_PIN, L_STATE_A, 0, 0);
+		pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_STATE_A, 0, (int)pl_pm - 1);
+	} else {
+		pwm_asm_jmp(&a, PIO_JMP_ALWAYS, L_STATE_A, 0, 0);
+	}
+	return pwm_asm_end(&a, L_STATE_A, LABEL_NONE, LABEL_NONE);
+}
+
+// ファームウェアの PWM構成 (pdm_output.c)
+// cycle_48/44 : 4/5bit の PWM周期 [pio clk]。6bit は x4 オーバーサンプリングのため PWM周期 x2 とし、N側ピンは GPIO L
+// 44.1k系の延長は L/H に等分する
+void pio_pwm_param_init(pio_pwm_param_t* param, uint pwm_bit, uint cycle_48, uint cycle_44){
+	const uint mul = (pwm_bit == 6) ? 2 : 1;
+	memset(param, 0, sizeof(*param));
+	param->pwm_bit = pwm_bit;
+	param->cycle_48 = cycle_48 * mul;
+	param->cycle_44 = cycle_44 * mul;
+	param->pad_lo = (param->cycle_44 > param->cycle_48) ? (param->cycle_44 - param->cycle_48) / 2 : 0;
+	param->sync = PIO_PWM_SYNC_AUTO;
+	param->pin_n = (pwm_bit != 6);
+}
+
+// PIO PWMプログラム生成 生成できない組み合わせは false
+bool pio_pwm_build(pio_pwm_config_t* cfg, const pio_pwm_param_t* param){
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->param = *param;
+	if (param->pwm_bit < PIO_PWM_BIT_MIN || param->pwm_bit > PIO_PWM_BIT_MAX) return false;
+	if (param->cycle_44 <= param->cycle_48 || param->pad_lo > param->cycle_44 - param->cycle_48) return false;
+	cfg->out_thr = 4 * param->pwm_bit;
+
+	bool ok = false;
+	if (param->sync != PIO_PWM_SYNC_PACEMAKER) {
+		cfg->param.sync = PIO_PWM_SYNC_SELF;
+		ok = build_self(cfg);
+	}
+	if (!ok && param->sync != PIO_PWM_SYNC_SELF) {
+		memset(&cfg->pwm, 0, sizeof(cfg->pwm));
+		cfg->param.sync = PIO_PWM_SYNC_PACEMAKER;
+		ok = build_pacemaker(cfg);
+	}
+	return ok && (cfg->pwm.len + cfg->pacemaker.len <= PIO_PWM_INSN_MAX);
+}
+
+// 設計上の H期間 [pio clk]
+uint pio_pwm_high_clk(const pio_pwm_config_t* cfg, uint code, bool fs48){
+	const uint ph = cfg->param.cycle_44 - cfg->param.cycle_48 - cfg->param.pad_lo;
+	return cfg->h0 + cfg->step * code + (fs48 ? 0 : ph);
+}
+
+uint pio_pwm_center_clk(const pio_pwm_config_t* cfg, bool fs48){
+	const uint ph = cfg->param.cycle_44 - cfg->param.cycle_48 - cfg->param.pad_lo;
+	return cfg->h_center + (fs48 ? 0 : ph);
+}
+
+uint pio_pwm_cycle_clk(const pio_pwm_config_t* cfg, bool fs48){
+	return fs48 ? cfg->param.cycle_48 : cfg->param.cycle_44;
+}
+
+#if !PICO_NO_HARDWARE
+// 生成したプログラムで PIO を初期化し sm0(LCh)/sm1(RCh) (+ sm2 pacemaker) を同期スタートする
+// PIN_FS48 は bsp.c で初期化済み (jmp pin 入力としてのみ使い、出力値は変更しない)
+void pio_pwm_program_init(PIO pio, const pio_pwm_config_t* cfg, uint pin_output_lp, uint pin_output_rp, uint pin_fs48){
+	// PWM出力ピンのマスクパタン生成
+	const uint32_t pin_mask = (3u << pin_output_lp) | (3u << pin_output_rp);
+
+	// PWM出力ピンの無効化(ノイズ対策用)
+	// sm停止前にsmが利用するピンの出力をLowに切り替える
+	gpio_init_mask(pin_mask);			// gpio入力に切替(過渡ノイズ防止用)
+	gpio_clr_mask(pin_mask);			// gpio出力値を0に設定
+	gpio_set_dir_out_masked(pin_mask);	// gpio出力に切替
+
+	// 全smの停止とsm命令メモリの消去
+	pio_enable_sm_mask_in_sync(pio, 0);
+	pio_clear_instruction_memory(pio);
+
+	// sm0,sm1へのPWMプログラム登録
+	const pio_program_t pwm = {.instructions = cfg->pwm.insn, .length = cfg->pwm.len, .origin = -1};
+	uint offset = pio_add_program(pio, &pwm);
+	pio_sm_config c = pio_get_default_sm_config();
+	sm_config_set_wrap(&c, offset + cfg->pwm.wrap_target, offset + cfg->pwm.wrap);
+	sm_config_set_out_shift(&c, true, true, cfg->out_thr);	// osr : shift right, autopull, thr = 4 x pwm_bit
+	sm_config_set_in_shift(&c, false, false, 32);			// isr : shift left,  no autopush
+	sm_config_set_sideset(&c, cfg->pwm.sideset_n, false, false);	// use 2-sideset, no msb flag, no direction pin
+	sm_config_set_jmp_pin(&c, pin_fs48);					// for jmp pin command
+	sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);			// Deeper FIFO as we're not doing any RX
+	sm_config_set_clkdiv_int_frac(&c, CLOCK_PLAN_PIO_DIV * cfg->pwm.clkdiv, 0);
+
+	for(uint sm = 0; sm < 2; sm++){
+		uint pin = (sm == 0) ? pin_output_lp : pin_output_rp;	// sm=0:LP,1:RP
+		pio_sm_set_consecutive_pindirs(pio, sm, pin, 2, true);	// pin_base = pin, pin_count = 2, output
+		sm_config_set_sideset_pins(&c, pin);					// for 'side' pins, base=pin_p
+		pio_sm_init(pio, sm, offset + cfg->pwm.entry, &c);		// sm config & goto the entry point
+		pio_sm_clear_fifos(pio, sm);							// flush remain fifo audio data(s)
+	}
+
+	// sm2へのpacemaker設定
+	uint sm_mask = 3;
+	if (cfg->pacemaker.len) {
+		const pio_program_t pm = {.instructions = cfg->pacemaker.insn, .length = cfg->pacemaker.len, .origin = -1};
+		offset = pio_add_program(pio, &pm);
+		c = pio_get_default_sm_config();
+		sm_config_set_wrap(&c, offset + cfg->pacemaker.wrap_target, offset + cfg->pacemaker.wrap);
+		sm_config_set_jmp_pin(&c, pin_fs48);
+		sm_config_set_clkdiv_int_frac(&c, CLOCK_PLAN_PIO_DIV * cfg->pacemaker.clkdiv, 0);
+		pio_sm_init(pio, 2, offset + cfg->pacemaker.entry, &c);
+		sm_mask = 7;
+	}
+
+	// sm0,1(,2)同期スタート
+	pio_enable_sm_mask_in_sync(pio, sm_mask);
+
+	// PWM出力ピンの有効化
+	// sm稼働後にsmが利用するピンの出力をpioモードに切り替える (pin_n = false の N側は GPIO L のまま)
+	pio_gpio_init(pio, pin_output_lp);
+	pio_gpio_init(pio, pin_output_rp);
+	if (cfg->param.pin_n) {
+		pio_gpio_init(pio, pin_output_lp + 1);
+		pio_gpio_init(pio, pin_output_rp + 1);
+	}
+}
+#endif
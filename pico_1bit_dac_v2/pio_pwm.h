@@ -0,0 +1,119 @@
+/**
+ * @file pio_pwm.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief PIO PWMプログラム生成 (PWM分解能・PWM周期・fs系列を指定して sm0/sm1 PWM, sm2 pacemaker を生成)
+ * @version 0.01
+ * @date 2026-10-17
+ * @note pio_pwm_4bit/5bit/6bit.pio を統合し、実行時に命令列を生成する (pdm_output.pio の統合予定を実施)。
+ *       .pio ファイルは参照設計として残し、host/pio_pwm_check で生成結果と波形(コード毎の H:L)を照合する。
+ */
+#ifndef _PIO_PWM_H_
+#define _PIO_PWM_H_
+
+#include "pico.h"
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+#define PIO_PWM_INSN_MAX	32	// PIO命令メモリ (sm0/sm1 PWM + sm2 pacemaker の合計)
+#define PIO_PWM_BIT_MIN		4
+#define PIO_PWM_BIT_MAX		8	// FIFOワード = 4 x PWMデータ
+
+// PWMプログラム構成
+#define PIO_PWM_SYNC_AUTO		0	// 自己計時で生成できなければ pacemaker 同期
+#define PIO_PWM_SYNC_SELF		1	// 自己計時 (sm0/sm1 のみ, 従来の 4/5bit)
+#define PIO_PWM_SYNC_PACEMAKER	2	// sm2 pacemaker の irq2/irq3 で同期 (従来の 6bit)
+
+// PIO 命令エンコード (RP2040 Datasheet 3.4)
+#define PIO_OP_JMP			0x0000
+#define PIO_OP_WAIT			0x2000
+#define PIO_OP_IN			0x4000
+#define PIO_OP_OUT			0x6000
+#define PIO_OP_PUSH_PULL	0x8000
+#define PIO_OP_MOV			0xa000
+#define PIO_OP_IRQ			0xc000
+#define PIO_OP_SET			0xe000
+#define PIO_OP_MASK			0xe000
+
+#define PIO_JMP_ALWAYS		(0 << 5)
+#define PIO_JMP_NOT_X		(1 << 5)	// !x
+#define PIO_JMP_X_DEC		(2 << 5)	// x--
+#define PIO_JMP_NOT_Y		(3 << 5)	// !y
+#define PIO_JMP_Y_DEC		(4 << 5)	// y--
+#define PIO_JMP_X_NE_Y		(5 << 5)	// x!=y
+#define PIO_JMP_PIN			(6 << 5)	// pin
+#define PIO_JMP_NOT_OSRE	(7 << 5)	// !osre
+
+#define PIO_WAIT_GPIO		(0 << 5)
+#define PIO_WAIT_PIN		(1 << 5)
+#define PIO_WAIT_IRQ		(2 << 5)
+#define PIO_WAIT_POL1		(1 << 7)
+
+// in/out/mov/set の src/dst
+#define PIO_SRC_DST_PINS	0
+#define PIO_SRC_DST_X		1
+#define PIO_SRC_DST_Y		2
+#define PIO_SRC_DST_NULL	3
+#define PIO_SRC_DST_PINDIRS	4			// out/set dst
+#define PIO_SRC_DST_PC		5			// out/mov dst
+#define PIO_SRC_DST_STATUS	5			// mov src
+#define PIO_SRC_DST_ISR		6
+#define PIO_SRC_DST_OSR		7
+#define PIO_SRC_DST_EXEC	7			// out dst (mov dst は 4)
+
+#define PIO_MOV_NONE		(0 << 3)
+#define PIO_MOV_INVERT		(1 << 3)	// !src
+#define PIO_MOV_REVERSE		(2 << 3)	// ::src
+
+#define PIO_IRQ_CLEAR		(1 << 6)
+#define PIO_IRQ_WAIT		(1 << 5)
+
+#define PIO_PULL			(1 << 7)
+#define PIO_IF_FULL_EMPTY	(1 << 6)
+#define PIO_BLOCK			(1 << 5)
+
+#define PIO_I_NOP			(PIO_OP_MOV | (PIO_SRC_DST_Y << 5) | PIO_SRC_DST_Y)	// mov y y
+
+// 生成パラメータ
+typedef struct {
+	uint8_t		pwm_bit;	// PWM分解能 (PIO_PWM_BIT_MIN~MAX)
+	uint16_t	cycle_48;	// PWM周期 [pio clk] 48k系   (PIN_FS48 = 1)
+	uint16_t	cycle_44;	// PWM周期 [pio clk] 44.1k系 (PIN_FS48 = 0)  cycle_44 > cycle_48
+	uint8_t		pad_lo;		// 44.1k系の延長 (cycle_44 - cycle_48) のうち L側に置く clk数 (残りは H側, 等分で中心対称)
+	uint8_t		sync;		// PIO_PWM_SYNC_xxx
+	bool		pin_n;		// N側ピン(P+1)も PIO出力とする (false : GPIO L固定)
+} pio_pwm_param_t;
+
+// PIOプログラム (pio_program_t + pioasm の .wrap/.side_set/public entry_point 相当)
+typedef struct {
+	uint16_t	insn[PIO_PWM_INSN_MAX];
+	uint8_t		len;			// 0 : なし
+	uint8_t		wrap_target;	// プログラム先頭からの相対アドレス
+	uint8_t		wrap;
+	uint8_t		entry;
+	uint8_t		sideset_n;		// side-set ビット数 (0 / 2)
+	uint8_t		clkdiv;			// PIOクロック分周 (CLOCK_PLAN_PIO_DIV に掛ける)
+} pio_pwm_prog_t;
+
+// 生成結果
+typedef struct {
+	pio_pwm_param_t	param;
+	pio_pwm_prog_t	pwm;		// sm0 (LCh) / sm1 (RCh)
+	pio_pwm_prog_t	pacemaker;	// sm2 (PIO_PWM_SYNC_PACEMAKER 時のみ)
+	uint8_t		out_thr;		// autopull 閾値 [bit] (4 x pwm_bit)
+	// 設計上の H期間 [pio clk] : H = h0 + step * code (+ 44.1k系は延長の H側)
+	uint16_t	h0;
+	uint8_t		step;
+	uint16_t	h_center;		// FIFO空時の中心レベル (48k系)
+} pio_pwm_config_t;
+
+void pio_pwm_param_init(pio_pwm_param_t* param, uint pwm_bit, uint cycle_48, uint cycle_44);
+bool pio_pwm_build(pio_pwm_config_t* cfg, const pio_pwm_param_t* param);
+uint pio_pwm_high_clk(const pio_pwm_config_t* cfg, uint code, bool fs48);
+uint pio_pwm_center_clk(const pio_pwm_config_t* cfg, bool fs48);
+uint pio_pwm_cycle_clk(const pio_pwm_config_t* cfg, bool fs48);
+#if !PICO_NO_HARDWARE
+void pio_pwm_program_init(PIO pio, const pio_pwm_config_t* cfg, uint pin_output_lp, uint pin_output_rp, uint pin_fs48);
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file prof.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief 処理段毎の処理時間計測
+ * @version 0.01
+ * @date 2026-10-17
+ * @note prof.h のプローブ(PROF_BEGIN/PROF_END)で得た区間時間を、段毎・入力fs毎に集計する。
+ *       実機は SysTick のサイクル数を、ホストは clock_gettime の ns をそのまま記録し、いずれも ns で集計・出力する。
+ *       (実機とホスト(シミュレーション)の結果を同じ書式で比較できる)
+ *       各段の記録は1つのコアに限定されるため、記録処理に排他は行わない。
+ *       prof_reset()/prof_dump() を記録中に呼んだ場合、その時点の1回分の集計が不整合となることがある。
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "bsp.h"
+#include "prof.h"
+
+// 計時開始 各コアで1回呼ぶ (実機 : 呼出しコアの SysTick をフリーラン動作させる。割込みは使用しない)
+void tick_init_core(void){
+#if !PICO_NO_HARDWARE
+	systick_hw->csr = 0;
+	systick_hw->rvr = TICK_MASK;
+	systick_hw->cvr = 0;
+	systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;	// CLK_SYS, 割込みなし
+#endif
+}
+
+#if PROF_ENABLE
+
+// ticks -> ns 換算係数 (16bit固定小数点)
+#if PICO_NO_HARDWARE
+#define PROF_NS_MUL		(1u << 16)
+#else
+#define PROF_NS_MUL		((uint32_t)((1000000000ull << 16) / CLK_SYS))
+#endif
+
+typedef struct {
+	uint32_t	n;
+	uint32_t	min;
+	uint32_t	max;
+	uint64_t	sum;
+	uint32_t	hist[PROF_HIST_N];
+} prof_stat_t;
+
+static prof_stat_t prof_stat[PROF_STAGE_N][PROF_RATE_N];
+static volatile uint prof_rate = PROF_RATE_N - 1;			// 現在の入力fs (Core0で更新、Core1も参照)
+
+static const uint prof_fs_list[PROF_RATE_N] = {44100, 48000, 88200, 96000, 176400, 192000, 352800, 384000};
+
+static const char* const prof_stage_name[PROF_STAGE_N] = {
+	"volume", "hbf1", "hbf2", "hbf3", "hbf strm", "pfir", "iir", "asrc", "dop", "enqueue", "pcm2pwm", "os core1", "pio wait",
+};
+
+// 計測開始 各コアで1回呼ぶ (計時開始と Core0 での記録クリア)
+void prof_init_core(void){
+	tick_init_core();
+	if (get_core_num() == 0) prof_reset();
+}
+
+// 以降の記録を入力fs fs の集計とする (Core0 フォーマット更新時)
+void prof_set_fs(uint fs){
+	for(uint i = 0; i < PROF_RATE_N; i++){
+		if (prof_fs_list[i] == fs) {
+			prof_rate = i;
+			return;
+		}
+	}
+}
+
+void prof_record(prof_stage_t stage, uint32_t ticks){
+	prof_stat_t* s = &prof_stat[stage][prof_rate];
+	uint32_t ns = (uint32_t)(((uint64_t)ticks * PROF_NS_MUL) >> 16);
+	if (s->n == 0 || ns < s->min) s->min = ns;
+	if (ns > s->max) s->max = ns;
+	s->sum += ns;
+	s->n++;
+	int b = (ns == 0) ? 0 : (31 - __builtin_clz(ns)) - PROF_HIST_BIT;
+	if (b < 0) b = 0;
+	if (b > PROF_HIST_N - 1) b = PROF_HIST_N - 1;
+	s->hist[b]++;
+}
+
+void prof_reset(void){
+	memset(prof_stat, 0, sizeof(prof_stat));
+}
+
+// 集計出力 (記録のある段・fsのみ)
+//  stage fs n min avg max [ns] | ヒストグラム bin[0] ~ bin[PROF_HIST_N - 1]
+void prof_dump(void){
+	printf("stage     fs[kHz]        n      min      avg      max [ns] | hist <2^%d, <2^%d, .. >=2^%d ns\n",
+		PROF_HIST_BIT + 1, PROF_HIST_BIT + 2, PROF_HIST_BIT + PROF_HIST_N - 1);
+	for(uint st = 0; st < PROF_STAGE_N; st++){
+		for(uint r = 0; r < PROF_RATE_N; r++){
+			const prof_stat_t* s = &prof_stat[st][r];
+			if (s->n == 0) continue;
+			printf("%-9s %7.1f %8lu %8lu %8lu %8lu      |", prof_stage_name[st], prof_fs_list[r] / 1000.0,
+				(unsigned long)s->n, (unsigned long)s->min, (unsigned long)(s->sum / s->n), (unsigned long)s->max);
+			for(uint b = 0; b < PROF_HIST_N; b++) printf(" %lu", (unsigned long)s->hist[b]);
+			printf("\n");
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef _PROF_H_
+#define _PROF_H_
+
+/* 処理段毎の処理時間計測 (DEBUG_PIN + オシロ観測の代替)
+ 実機 : SysTick (コア毎, CLK_SYS カウント, 24bit) で計時し、記録時に ns へ換算する
+ ホスト : clock_gettime(CLOCK_MONOTONIC) の ns で計時する
+ 段毎・入力fs毎に 回数/min/avg/max[ns] と log2ヒストグラムを保持し、UARTコマンド(t)で出力する。
+ 各段は記録するコアを1つに限定する(Core0 : volume~enqueue, Core1 : pcm2pwm, os core1, pio wait)。
+ 計時(tick_now())は PROF_ENABLE によらず使用でき、Core0/Core1 分担選択(os_split)の処理サイクル計測にも使う。
+*/
+#define PROF_ENABLE		1		// 0:計測なし(プローブはコンパイル時に除去)
+
+#include "pico.h"
+#if PICO_NO_HARDWARE
+#include <time.h>
+#else
+#include "hardware/structs/systick.h"
+#endif
+
+// 計時 (PROF_ENABLE によらず有効) 区間時間は (tick_now() - 開始値) & TICK_MASK
+#if PICO_NO_HARDWARE
+#define TICK_MASK	0xffffffffu
+static inline uint32_t tick_now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+#else
+#define TICK_MASK	0x00ffffffu		// SysTick 24bit (208.8MHz : 80ms で一周)
+static inline uint32_t tick_now(void){
+	return TICK_MASK - systick_hw->cvr;	// ダウンカウンタをアップカウントに変換
+}
+#endif
+
+void tick_init_core(void);
+
+// 計測段
+typedef enum {
+	PROF_VOLUME = 0,	// volume()
+	PROF_HBF1,			// hbf1_x2_oversampler()
+	PROF_HBF2,			// hbf2_x2_oversampler()
+	PROF_HBF3,			// hbf3_x2_oversampler()
+	PROF_HBF_STREAM,	// hbf_stream_oversampler() (HBF_STREAM = 1, 連結2段以上の全段)
+	PROF_PFIR,			// pfir_oversampler() (OVERSAMPLER_TYPE = 1)
+	PROF_IIR,			// iir1~3_x2_oversampler() (低遅延フィルタ, 全段)
+	PROF_ASRC,			// asrc()
+	PROF_DOP,			// dop_decimator()
+	PROF_ENQUEUE,		// queue_acquire() + queue_publish()
+	PROF_PCM2PWM,		// Core1 PWM変換 (1フレーム、PIO/DMA待ち・後段オーバーサンプリングを除く)
+	PROF_OS_CORE1,		// Core1 後段オーバーサンプリング (os_split, 1フレーム)
+	PROF_PIO_WAIT,		// Core1 PIO TX FIFO / DMA転送完了待ち (1フレーム)
+	PROF_STAGE_N
+} prof_stage_t;
+
+#define PROF_RATE_N		8		// 入力fs 44.1k ~ 384k
+#define PROF_HIST_N		16		// ヒストグラム段数 bin[n] : 2^(n+PROF_HIST_BIT) ~ 2^(n+PROF_HIST_BIT+1) ns
+#define PROF_HIST_BIT	8		// bin[0] 上限 512ns 未満, bin[15] 8.4ms 以上
+
+#if PROF_ENABLE
+#define PROF_TICK_MASK	TICK_MASK
+static inline uint32_t prof_now(void){
+	return tick_now();
+}
+
+void prof_init_core(void);
+void prof_set_fs(uint fs);
+void prof_record(prof_stage_t stage, uint32_t ticks);
+void prof_reset(void);
+void prof_dump(void);
+
+// 計測区間 PROF_BEGIN(段) ~ PROF_END(段) (同一ブロック内で対にすること)
+#define PROF_BEGIN(stage)	uint32_t prof_t_##stage = prof_now()
+#define PROF_END(stage)		prof_record((stage), (prof_now() - prof_t_##stage) & PROF_TICK_MASK)
+#else
+#define PROF_TICK_MASK		0
+static inline uint32_t prof_now(void){ return 0; }
+static inline void prof_init_core(void){ tick_init_core(); }
+static inline void prof_set_fs(uint fs){ (void)fs; }
+static inline void prof_record(prof_stage_t stage, uint32_t ticks){ (void)stage; (void)ticks; }
+static inline void prof_reset(void){}
+static inline void prof_dump(void){}
+#define PROF_BEGIN(stage)	/*処理なし*/
+#define PROF_END(stage)		/*処理なし*/
+#endif
+
+#endif
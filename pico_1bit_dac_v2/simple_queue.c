@@ -0,0 +1,192 @@
+/**
+ * @file simple_queue.c
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Core0->Core1 PCMデータキュー管理
+ * @version 0.01
+ * @date 2026-10-17
+ * @note 生産者(Core0)・消費者(Core1)各1本のロックフリー リングキュー。
+ *       各カウンタは書込み側コアを1つに限定し、インデックスはフリーランカウンタの下位bit(段数-1)とする。
+ *         queue_wp : 公開済みスロット数    (Core0のみ更新)
+ *         queue_rp : 取出し済みスロット数  (Core1のみ更新)
+ *         queue_fp : 解放済みスロット数    (Core1のみ更新) Core1が参照中のスロットは未解放
+ *       キュー長 = queue_wp - queue_rp、空きスロット = 段数 - (queue_wp - queue_fp)
+ *       段数・スロット幅は queue_init() で選択したモードにより決まり、スロット領域 queue_pool を段数分に分割して使う。
+ *       水位(サンプル数)は以下のフリーランカウンタの差とする。
+ *         queue_published : 公開済みサンプル数  (Core0のみ更新・参照)
+ *         queue_consumed  : 変換済みサンプル数  (Core1のみ更新) リセットで破棄したスロット分を含む
+ *       queue_consumed と通知時刻 queue_consumed_us の組は、queue_consumed_seq (更新中は奇数) で一貫性を確認して読み出す。
+ *       データ・長さの書込みとカウンタ更新の間、カウンタ読出しとデータ参照の間には __dmb() を置き、
+ *       他方のコアから更新前のデータが見えないようにする。
+ *
+ *       Core0                                Core1
+ *       p = queue_acquire()  空き確認        dequeue(&buf, &len)  前回スロット解放、公開済み確認
+ *       (hbf/asrc が p へ直接出力)            (pcm2pwm が buf を参照)
+ *       queue_publish(len)   公開            ...次回 dequeue() まで buf は上書きされない
+ */
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "simple_queue.h"
+
+static const queue_mode_t queue_mode_list[QUEUE_MODE_N] = {
+//	 name           frame_div     depth  play_thr  fill_target
+	{"robust",      1,            8,     4,        4},	// 1スロット 1ms, 再生開始 4ms
+	{"low latency", QUEUE_LL_DIV, 16,    6,        3},	// 1スロット 0.25ms, 再生開始 1.5ms (1パケット+0.5ms)
+};
+
+static int32_t queue_pool[QUEUE_POOL_N];					// スロット領域 ストライプ領域(既定配置)に置き、Core0書込み・Core1読出しを4バンクに分散する
+static int32_t* queue_buf[QUEUE_DEPTH_MAX];					// スロット先頭
+static uint32_t queue_len[QUEUE_DEPTH_MAX];					// スロット毎のサンプル長
+static uint32_t queue_tag[QUEUE_DEPTH_MAX];					// スロット毎のタグ (データ形式 : dsp.c os_split)
+static uint32_t queue_wr_tag = 0;							// 公開時に付けるタグ (Core0)
+static uint32_t queue_rd_tag = 0;							// 取り出したスロットのタグ (Core1)
+static const queue_mode_t* queue_mode = &queue_mode_list[QUEUE_MODE_ROBUST];
+static uint32_t queue_mask = QUEUE_DEPTH - 1;				// 段数 - 1
+static uint32_t queue_slot_width = QUEUE_SLOT_WIDTH;		// スロット幅[word]
+static volatile uint32_t queue_wp = 0;						// 公開済みスロット数 (Core0)
+static volatile uint32_t queue_rp = 0;						// 取出し済みスロット数 (Core1)
+static volatile uint32_t queue_fp = 0;						// 解放済みスロット数 (Core1)
+static volatile uint32_t queue_published = 0;				// 公開済みサンプル数 (Core0)
+static volatile uint32_t queue_consumed = 0;				// 変換済みサンプル数 (Core1)
+static volatile uint32_t queue_consumed_us = 0;				// queue_consumed 通知時刻[us] (Core1)
+static volatile bool queue_playing = false;					// 再生中 (Core1) 停止中は水位を補間しない
+static volatile uint32_t queue_consumed_seq = 0;			// 上記3変数の更新カウンタ (Core1) 更新中は奇数
+
+// キュー初期化 コア起動前に呼ぶこと mode : queue_mode_id_t
+void queue_init(uint mode){
+	if (mode >= QUEUE_MODE_N) mode = QUEUE_MODE_ROBUST;
+	queue_mode = &queue_mode_list[mode];
+	queue_mask = queue_mode->depth - 1;
+	queue_slot_width = QUEUE_SLOT_WIDTH_DIV(queue_mode->frame_div);
+	for(uint i = 0; i < queue_mode->depth; i++){
+		queue_buf[i] = &queue_pool[i * queue_slot_width];
+	}
+	queue_wp = 0;
+	queue_rp = 0;
+	queue_fp = 0;
+	queue_published = 0;
+	queue_consumed = 0;
+	queue_consumed_us = 0;
+	queue_playing = false;
+	queue_consumed_seq = 0;
+	queue_wr_tag = 0;
+	queue_rd_tag = 0;
+}
+
+// キューリセット (Core1) 未再生のスロットを全て破棄する
+// 消費者側カウンタのみ更新するため、Core0 の書込み中に呼んでもよい
+// 破棄したスロットのサンプル数を変換済みとして計上し、再生停止(水位補間なし)とする
+void queue_reset(void){
+	__dmb();
+	uint32_t wp = queue_wp;
+	__dmb();	// 公開確認後に長さを参照する
+	uint32_t drop = 0;
+	for(uint32_t rp = queue_rp; rp != wp; rp++){
+		drop += queue_len[rp & queue_mask];	// 未解放のため Core0 に上書きされない
+	}
+	queue_consumed_seq++;
+	__dmb();
+	queue_consumed += drop;
+	queue_playing = false;
+	__dmb();
+	queue_consumed_seq++;
+	queue_rp = wp;
+	queue_fp = wp;
+}
+
+// 動作モード
+const queue_mode_t* queue_get_mode(void){
+	return queue_mode;
+}
+
+// スロット幅[word]
+uint32_t get_queue_slot_width(void){
+	return queue_slot_width;
+}
+
+// キュー長 (公開済み・未取出しのスロット数)
+uint32_t get_queue_length(void){
+	return queue_wp - queue_rp;
+}
+
+// 書込みスロット取得 (Core0)
+// 空きスロットが無い場合は NULL を返す。取得したスロットは queue_publish() まで Core1 から見えない
+int32_t* queue_acquire(void){
+	uint32_t wp = queue_wp;
+	if (wp - queue_fp > queue_mask) return NULL;
+	__dmb();	// 解放確認後にスロットへ書き込む
+	return queue_buf[wp & queue_mask];
+}
+
+// 書込みスロット公開 (Core0) len : スロットに書き込んだサンプル長
+void queue_publish(uint32_t len){
+	uint32_t wp = queue_wp;
+	queue_len[wp & queue_mask] = len;
+	queue_tag[wp & queue_mask] = queue_wr_tag;
+	queue_published += len;
+	__dmb();	// データ・長さの書込み完了後に公開する
+	queue_wp = wp + 1;
+}
+
+// キュー取出し (Core1)
+// 前回取り出したスロットを解放し、公開済みスロットがあれば buf/len を更新する。無い場合は buf/len を更新しない
+void dequeue(int32_t** buf, uint32_t* len){
+	uint32_t rp = queue_rp;
+	__dmb();	// 前回スロットの参照完了後に解放する
+	queue_fp = rp;
+	if (queue_wp == rp) return;
+	__dmb();	// 公開確認後にデータを参照する
+	*buf = queue_buf[rp & queue_mask];
+	*len = queue_len[rp & queue_mask];
+	queue_rd_tag = queue_tag[rp & queue_mask];
+	queue_rp = rp + 1;
+}
+
+// 以降に公開するスロットのタグ設定 (Core0)
+void queue_set_tag(uint32_t tag){
+	queue_wr_tag = tag;
+}
+
+// 最後に取り出したスロットのタグ (Core1)
+uint32_t queue_get_tag(void){
+	return queue_rd_tag;
+}
+
+// 変換済み通知 (Core1) n : dequeue() したスロットから変換したサンプル数, t_us : 変換完了時刻[us]
+void queue_consume(uint32_t n, uint32_t t_us){
+	queue_consumed_seq++;
+	__dmb();
+	queue_consumed += n;
+	queue_consumed_us = t_us;
+	queue_playing = true;
+	__dmb();
+	queue_consumed_seq++;
+}
+
+// キュー水位 (Core0) 公開済み・未変換のサンプル数 (QUEUE_FILL_FRAC bit 固定小数点)
+// 再生中は Core1 の最終通知から now_us までに変換されたサンプル数を rate[sample/s] で補間して差し引く
+// 戻り値 : 再生中(Core1がキューを消費中)か否か
+bool queue_get_fill(uint32_t now_us, uint32_t rate, int32_t* p_fill){
+	uint32_t seq, consumed, t_us;
+	bool playing;
+	do {
+		seq = queue_consumed_seq;
+		__dmb();
+		consumed = queue_consumed;
+		t_us = queue_consumed_us;
+		playing = queue_playing;
+		__dmb();
+	} while ((seq & 1) || (seq != queue_consumed_seq));
+
+	int32_t fill = (int32_t)((queue_published - consumed) << QUEUE_FILL_FRAC);
+	if (playing) {
+		uint32_t dt = now_us - t_us;
+		if ((int32_t)dt < 0) dt = 0;	// 通知が now_us 取得後の場合
+		if (dt > QUEUE_FILL_EXTRAP_US) dt = QUEUE_FILL_EXTRAP_US;
+		// rate * 2^(QUEUE_FILL_FRAC + 16) / 10^6 ≒ (rate / 1000) * 16777 (384k : 6.4e6, dt 250us で 32bit に収まる)
+		fill -= (int32_t)((dt * ((rate / 1000) * 16777)) >> 16);
+	}
+	*p_fill = fill;
+	return playing;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file simple_queue.h
+ * @author geachlab, Yasushi MARUISHI
+ * @brief Core0->Core1 PCMデータキュー管理
+ * @version 0.01
+ * @date 2026-10-17
+ * @note Core0(生産者)1本、Core1(消費者)1本のロックフリー リングキュー。
+ *       Core0 は queue_acquire() で書込みスロットを取得し、DSP最終段(hbf/asrc)がスロットへ直接出力した後、
+ *       queue_publish() で公開する(フレームのコピーなし)。
+ *       Core1 は dequeue() でスロットのポインタを取得し、次回の dequeue() まで参照する。
+ *       QUEUE_WIDTH : 1ms分の384kHz/2chデータ (USB 48kHz系 49sample/packet x8 を許容)
+ *       キューの動作モード(queue_mode_t)は起動時に queue_init() で選択する。
+ *         ロバスト : 1スロット = 1パケット(≒1ms)、再生開始 4スロット。ジッタの大きいホスト向け
+ *         低遅延   : 1パケットを QUEUE_LL_DIV 分割したサブフレームを1スロットとし、再生開始・目標水位を浅くする(モニタ用途)
+ *       スロット領域(QUEUE_POOL_N)は両モードで共有し、低遅延モードは小さいスロットを多段に配置する。
+ *       キュー水位(未変換サンプル数)は、Core0 の公開サンプル数と Core1 の変換済みサンプル数(queue_consume()で通知)の差で求める。
+ *       Core1 の通知は PDM_FEED_N サンプル単位のため、Core0 は通知時刻からの経過時間で水位を補間する(ASRCサーボの位相検出)。
+ *       各スロットには公開時のタグ(queue_set_tag())を付け、Core1 は dequeue() 後に queue_get_tag() で参照する。
+ *       (Core0/Core1 のオーバーサンプリング分担 : スロットのデータfs。サンプル数・水位はキューのfsで数える)
+ */
+#ifndef _SIMPLE_QUEUE_H_
+#define _SIMPLE_QUEUE_H_
+
+#include "pico.h"
+
+#define QUEUE_DEPTH		8				// ロバストモードのキュー段数 1段 = 1パケット(≒1ms) 2のべき乗とすること
+#define QUEUE_DEPTH_MAX	16				// 全モード中の最大段数
+#define QUEUE_PACKET_MAX	49			// 1パケットの最大サンプル数 (USB 48kHz系 49sample/packet)
+#define QUEUE_WIDTH		(QUEUE_PACKET_MAX * 8 * 2)	// キュー幅[word] 49sample x8 x2ch
+#define QUEUE_SLOT_WIDTH (QUEUE_WIDTH + 2)	// スロット幅[word] +2はASRCによる1サンプル増加分
+#define QUEUE_POOL_N	(QUEUE_DEPTH * QUEUE_SLOT_WIDTH)	// スロット領域[word]
+#define QUEUE_LL_DIV	4				// 低遅延モードのパケット分割数 (2以上 : dsp_buf_advance() の制約)
+
+// スロット幅[word] パケット分割数 div のサブフレーム(最大 ceil(49/div) sample x8 +1(ASRC)) x2ch
+#define QUEUE_SLOT_WIDTH_DIV(div)	((((QUEUE_PACKET_MAX + (div) - 1) / (div)) * 8 + 1) * 2)
+
+// キュー動作モード
+typedef enum {
+	QUEUE_MODE_ROBUST = 0,
+	QUEUE_MODE_LOW_LATENCY,
+	QUEUE_MODE_N
+} queue_mode_id_t;
+
+typedef struct {
+	const char*	name;
+	uint		frame_div;		// パケット分割数 (1スロット = 1パケット / frame_div)
+	uint		depth;			// キュー段数 (2のべき乗, QUEUE_DEPTH_MAX以下)
+	uint		play_thr;		// 再生開始キュー長 [スロット]
+	uint		fill_target;	// ASRCサーボの目標水位 [スロット] (パケット到着時点の水位)
+} queue_mode_t;
+
+#define QUEUE_FILL_FRAC	8				// queue_get_fill() 水位の小数部bit数
+#define QUEUE_FILL_EXTRAP_US	250		// 水位補間の最大経過時間[us] (Core1停止時に補間し続けないため)
+
+void queue_init(uint mode);
+const queue_mode_t* queue_get_mode(void);
+uint32_t get_queue_slot_width(void);
+void queue_reset(void);
+uint32_t get_queue_length(void);
+int32_t* queue_acquire(void);
+void queue_publish(uint32_t len);
+void dequeue(int32_t** buf, uint32_t* len);
+void queue_set_tag(uint32_t tag);
+uint32_t queue_get_tag(void);
+void queue_consume(uint32_t n, uint32_t t_us);
+bool queue_get_fill(uint32_t now_us, uint32_t rate, int32_t* p_fill);
+
+#endif